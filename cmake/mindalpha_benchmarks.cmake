@@ -0,0 +1,75 @@
+#
+# Copyright 2021 Mobvista
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+
+# The benchmarks are plain executables built from the sources they exercise,
+# so they run without the Python extension module and don't link Python.
+
+set(MINDALPHA_HASH_MAP_SOURCES
+    cpp/mindalpha/stack_trace_utils.cpp
+    cpp/mindalpha/hash_map_engine.cpp
+    cpp/mindalpha/memory_buffer_backend.cpp
+    cpp/mindalpha/memory_buffer.cpp
+    cpp/mindalpha/map_file_header.cpp
+)
+
+set(MINDALPHA_MESSAGE_SOURCES
+    cpp/mindalpha/stack_trace_utils.cpp
+    cpp/mindalpha/thread_utils.cpp
+    cpp/mindalpha/data_type.cpp
+    cpp/mindalpha/node_role.cpp
+    cpp/mindalpha/node_encoding.cpp
+    cpp/mindalpha/node_info.cpp
+    cpp/mindalpha/node_control_command.cpp
+    cpp/mindalpha/node_control.cpp
+    cpp/mindalpha/data_request_command.cpp
+    cpp/mindalpha/data_request.cpp
+    cpp/mindalpha/message_meta.cpp
+    cpp/mindalpha/message.cpp
+    ${PROJECT_BINARY_DIR}/gen/thrift/cpp/mindalpha/message_meta_types.cpp
+)
+
+set(MINDALPHA_TRANSPORT_SOURCES
+    ${MINDALPHA_MESSAGE_SOURCES}
+    cpp/mindalpha/actor_config.cpp
+    cpp/mindalpha/message_transport.cpp
+    cpp/mindalpha/zeromq_transport.cpp
+    cpp/mindalpha/shared_memory_transport.cpp
+    cpp/mindalpha/tcp_transport.cpp
+    cpp/mindalpha/inprocess_transport.cpp
+    cpp/mindalpha/network_utils.cpp
+)
+
+function(add_mindalpha_benchmark name)
+    add_executable(${name} cpp/benchmarks/${name}.cpp ${ARGN})
+    target_compile_features(${name} PRIVATE cxx_std_17)
+    target_include_directories(${name} PRIVATE ${PROJECT_SOURCE_DIR}/cpp)
+    target_include_directories(${name} PRIVATE ${PROJECT_BINARY_DIR}/gen/thrift/cpp)
+    target_link_libraries(${name} PRIVATE
+        json11_static
+        spdlog::spdlog
+        Boost::headers
+        thrift::thrift
+        zmq::libzmq
+        rt
+        pthread
+    )
+endfunction()
+
+add_mindalpha_benchmark(hash_map_benchmark ${MINDALPHA_HASH_MAP_SOURCES})
+add_mindalpha_benchmark(message_meta_benchmark ${MINDALPHA_MESSAGE_SOURCES})
+add_mindalpha_benchmark(transport_benchmark ${MINDALPHA_TRANSPORT_SOURCES})
+add_mindalpha_benchmark(zeromq_fanout_benchmark ${MINDALPHA_TRANSPORT_SOURCES})
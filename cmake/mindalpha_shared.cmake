@@ -37,12 +37,22 @@ add_library(mindalpha_shared SHARED
     cpp/mindalpha/hashtable_helpers.h
     cpp/mindalpha/hash_uniquifier.h
     cpp/mindalpha/hash_uniquifier.cpp
+    cpp/mindalpha/float16.h
     cpp/mindalpha/data_type.h
     cpp/mindalpha/data_type.cpp
     cpp/mindalpha/smart_array.h
+    cpp/mindalpha/memory_buffer_backend.h
+    cpp/mindalpha/memory_buffer_backend.cpp
     cpp/mindalpha/memory_buffer.h
+    cpp/mindalpha/memory_buffer.cpp
     cpp/mindalpha/map_file_header.h
     cpp/mindalpha/map_file_header.cpp
+    cpp/mindalpha/hash_map_engine.h
+    cpp/mindalpha/hash_map_engine.cpp
+    cpp/mindalpha/gradient_codec.h
+    cpp/mindalpha/gradient_codec.cpp
+    cpp/mindalpha/gradient_aggregation.h
+    cpp/mindalpha/gradient_aggregation.cpp
     cpp/mindalpha/array_hash_map.h
     cpp/mindalpha/node_role.h
     cpp/mindalpha/node_role.cpp
@@ -54,6 +64,10 @@ add_library(mindalpha_shared SHARED
     cpp/mindalpha/node_control_command.cpp
     cpp/mindalpha/node_control.h
     cpp/mindalpha/node_control.cpp
+    cpp/mindalpha/data_request_command.h
+    cpp/mindalpha/data_request_command.cpp
+    cpp/mindalpha/data_request.h
+    cpp/mindalpha/data_request.cpp
     cpp/mindalpha/message_meta.h
     cpp/mindalpha/message_meta.cpp
     cpp/mindalpha/message.h
@@ -62,6 +76,11 @@ add_library(mindalpha_shared SHARED
     cpp/mindalpha/actor_config.cpp
     cpp/mindalpha/message_transport.cpp
     cpp/mindalpha/zeromq_transport.cpp
+    cpp/mindalpha/shared_memory_transport.cpp
+    cpp/mindalpha/tcp_transport.cpp
+    cpp/mindalpha/inprocess_transport.cpp
+    cpp/mindalpha/request_executor.cpp
+    cpp/mindalpha/parallel_for.cpp
     cpp/mindalpha/actor_process.cpp
     cpp/mindalpha/node_manager.cpp
     cpp/mindalpha/network_utils.cpp
@@ -75,13 +94,24 @@ add_library(mindalpha_shared SHARED
     ${PROJECT_BINARY_DIR}/gen/thrift/cpp/mindalpha/message_meta_types.cpp
     cpp/mindalpha/dense_tensor_meta.cpp
     cpp/mindalpha/dense_tensor_partition.cpp
+    cpp/mindalpha/native_initializer.cpp
+    cpp/mindalpha/native_updater.cpp
     cpp/mindalpha/sparse_tensor_meta.cpp
     cpp/mindalpha/sparse_tensor_partition.cpp
     cpp/mindalpha/array_hash_map_reader.h
     cpp/mindalpha/array_hash_map_writer.h
     cpp/mindalpha/tensor_partition_store.cpp
     cpp/mindalpha/dense_tensor.cpp
+    cpp/mindalpha/key_partitioner.h
+    cpp/mindalpha/key_partitioner.cpp
+    cpp/mindalpha/key_partition.h
+    cpp/mindalpha/key_partition.cpp
+    cpp/mindalpha/embedding_cache.h
+    cpp/mindalpha/embedding_cache.cpp
+    cpp/mindalpha/embedding_prefetcher.h
+    cpp/mindalpha/embedding_prefetcher.cpp
     cpp/mindalpha/sparse_tensor.cpp
+    cpp/mindalpha/tensor_batch.cpp
     cpp/mindalpha/ps_default_agent.cpp
     cpp/mindalpha/ps_helper.cpp
     cpp/mindalpha/combine_schema.cpp
@@ -100,6 +130,11 @@ target_compile_features(mindalpha_shared PRIVATE cxx_std_17)
 target_compile_definitions(mindalpha_shared PRIVATE DMLC_USE_S3=1)
 target_compile_definitions(mindalpha_shared PRIVATE _MINDALPHA_VERSION="${project_version}")
 target_compile_definitions(mindalpha_shared PRIVATE DBG_MACRO_NO_WARNING)
+if(MINDALPHA_WIDE_HASH_MAP_INDEX)
+    target_compile_definitions(mindalpha_shared PRIVATE MINDALPHA_WIDE_HASH_MAP_INDEX)
+endif()
+set_source_files_properties(cpp/mindalpha/native_updater.cpp cpp/mindalpha/gradient_aggregation.cpp PROPERTIES
+    COMPILE_OPTIONS "-ftree-vectorize;-fno-math-errno;-fno-trapping-math")
 target_include_directories(mindalpha_shared PRIVATE ${PROJECT_SOURCE_DIR}/cpp)
 target_include_directories(mindalpha_shared PRIVATE ${PROJECT_BINARY_DIR}/gen/thrift/cpp)
 target_link_libraries(mindalpha_shared PRIVATE
@@ -112,4 +147,5 @@ target_link_libraries(mindalpha_shared PRIVATE
     Boost::headers
     thrift::thrift
     zmq::libzmq
+    rt
 )
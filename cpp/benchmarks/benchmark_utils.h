@@ -0,0 +1,96 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <mindalpha/actor_config.h>
+#include <mindalpha/message_transport.h>
+#include <mindalpha/network_utils.h>
+
+//
+// ``benchmark_utils.h`` defines helpers shared by the transport benchmarks,
+// which wire nodes together directly instead of going through the
+// coordinator.
+//
+
+namespace mindalpha
+{
+
+struct BenchmarkNode
+{
+    std::shared_ptr<ActorConfig> config;
+    std::unique_ptr<MessageTransport> transport;
+};
+
+// Create and bind a node listening on the loopback interface. ``init`` can
+// adjust the config before the transport is created.
+template<typename Init>
+BenchmarkNode MakeBenchmarkNode(const std::string& type, NodeRole role, int nodeId, Init init)
+{
+    BenchmarkNode node;
+    node.config = std::make_shared<ActorConfig>();
+    node.config->SetTransportType(type);
+    node.config->SetIsLocalMode(type == "InProcess");
+    node.config->SetNodeRole(role);
+    init(*node.config);
+    NodeInfo& info = node.config->GetThisNodeInfo();
+    info.SetRole(role);
+    info.SetNodeId(nodeId);
+    info.SetHostName("127.0.0.1");
+    info.SetPort(network_utils::get_available_port());
+    node.transport = MessageTransport::Create(node.config);
+    node.transport->Start();
+    info.SetPort(node.transport->Bind(info, node.config->GetBindRetry()));
+    return node;
+}
+
+inline BenchmarkNode MakeBenchmarkNode(const std::string& type, NodeRole role, int nodeId)
+{
+    return MakeBenchmarkNode(type, role, nodeId, [](ActorConfig&) { });
+}
+
+inline void SendBenchmarkMessage(MessageTransport& transport, int receiver, int id,
+                                 const SmartArray<uint8_t>& slice)
+{
+    Message msg;
+    msg.GetMessageMeta().SetReceiver(receiver);
+    msg.GetMessageMeta().SetMessageId(id);
+    if (slice.size() > 0)
+        msg.AddSlice(slice);
+    transport.SendMessage(msg);
+}
+
+// Answer every message with an empty one until a message with a negative
+// id arrives.
+inline void RunEchoLoop(MessageTransport& transport)
+{
+    const SmartArray<uint8_t> empty;
+    for (;;)
+    {
+        Message msg;
+        transport.ReceiveMessage(msg);
+        const int id = msg.GetMessageMeta().GetMessageId();
+        if (id < 0)
+            break;
+        SendBenchmarkMessage(transport, msg.GetMessageMeta().GetSender(), id, empty);
+    }
+}
+
+}
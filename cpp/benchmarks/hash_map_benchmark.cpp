@@ -0,0 +1,102 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <mindalpha/array_hash_map.h>
+
+//
+// ``hash_map_benchmark.cpp`` compares the ``ArrayHashMap`` engines on the
+// operations ``SparseTensorPartition`` performs: inserting keys into an
+// empty map, which grows it as needed, then looking up present keys in a
+// random order, one at a time and in batches, and looking up absent keys.
+//
+//     hash_map_benchmark [keys] [values_per_key]
+//
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+template<typename Func>
+double MeasureRate(uint64_t count, Func func)
+{
+    const auto start = Clock::now();
+    func();
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return count / seconds / 1e6;
+}
+
+void Run(mindalpha::HashMapEngine engine, const std::vector<uint64_t>& keys,
+         const std::vector<uint64_t>& hits, const std::vector<uint64_t>& misses,
+         int64_t valuesPerKey)
+{
+    mindalpha::ArrayHashMap<uint64_t, float> map(valuesPerKey, engine);
+    const uint64_t count = keys.size();
+    std::vector<int64_t> out(count);
+    int64_t checksum = 0;
+    const double insert = MeasureRate(count, [&] {
+        for (uint64_t key : keys)
+            checksum += map.FindOrInit(key);
+    });
+    const double find = MeasureRate(count, [&] {
+        for (uint64_t key : hits)
+            checksum += map.Find(key);
+    });
+    const double findBatch = MeasureRate(count, [&] {
+        map.FindBatch(hits.data(), count, out.data());
+    });
+    for (int64_t index : out)
+        checksum += index;
+    const double findMiss = MeasureRate(count, [&] {
+        for (uint64_t key : misses)
+            checksum += map.Find(key);
+    });
+    printf("%-16s insert %7.2f  find %7.2f  find batch %7.2f  find miss %7.2f  Mops/s  (checksum %lld)\n",
+           mindalpha::HashMapEngineToString(engine).c_str(),
+           insert, find, findBatch, findMiss, static_cast<long long>(checksum));
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const uint64_t count = argc > 1 ? std::max(strtoull(argv[1], nullptr, 10), 1ULL) : 10000000;
+    const int64_t valuesPerKey = argc > 2 ? std::max(atoll(argv[2]), 1LL) : 16;
+    std::mt19937_64 engine(20211);
+    std::vector<uint64_t> keys(count);
+    for (uint64_t& key : keys)
+        key = engine();
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    std::shuffle(keys.begin(), keys.end(), engine);
+    std::vector<uint64_t> hits = keys;
+    std::shuffle(hits.begin(), hits.end(), engine);
+    std::vector<uint64_t> misses(keys.size());
+    for (uint64_t& key : misses)
+        key = engine();
+    printf("%zu keys, %lld values per key\n", keys.size(), static_cast<long long>(valuesPerKey));
+    Run(mindalpha::HashMapEngine::Chained, keys, hits, misses, valuesPerKey);
+    Run(mindalpha::HashMapEngine::OpenAddressing, keys, hits, misses, valuesPerKey);
+    return 0;
+}
@@ -0,0 +1,89 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <mindalpha/message_meta.h>
+#include <mindalpha/node_encoding.h>
+
+//
+// ``message_meta_benchmark.cpp`` compares the cost per message of packing
+// and unpacking the meta of a data message as the fixed-layout wire header
+// (``PackAsBuffer``/``UnpackFromBuffer``) and through Thrift
+// (``PackAsThriftBuffer``/``UnpackFromThriftBuffer``). The meta is that of
+// a sparse pull request with a key slice and a value slice.
+//
+//     message_meta_benchmark [iterations]
+//
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+template<typename Pack, typename Unpack>
+void Run(const char* name, int iterations, const mindalpha::MessageMeta& meta, Pack pack, Unpack unpack)
+{
+    const mindalpha::SmartArray<uint8_t> buf = pack(meta);
+    int64_t checksum = 0;
+    const auto start = Clock::now();
+    for (int i = 0; i < iterations; i++)
+        checksum += pack(meta).size();
+    const auto packed = Clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+        mindalpha::MessageMeta copy;
+        unpack(copy, buf);
+        checksum += copy.GetMessageId();
+    }
+    const auto unpacked = Clock::now();
+    printf("%-8s %4zu bytes  pack %7.1f ns  unpack %7.1f ns  (checksum %lld)\n", name, buf.size(),
+           std::chrono::duration<double, std::nano>(packed - start).count() / iterations,
+           std::chrono::duration<double, std::nano>(unpacked - packed).count() / iterations,
+           static_cast<long long>(checksum));
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const int iterations = argc > 1 ? std::max(atoi(argv[1]), 1) : 1000000;
+    mindalpha::MessageMeta meta;
+    meta.SetMessageId(12345);
+    meta.SetSender(mindalpha::WorkerRankToNodeId(3));
+    meta.SetReceiver(mindalpha::ServerRankToNodeId(7));
+    meta.SetIsRequest(true);
+    meta.GetDataRequest().SetCommand(mindalpha::DataRequestCommand::SparsePull);
+    meta.GetDataRequest().SetTensorId(42);
+    meta.GetDataRequest().SetFlag(mindalpha::DataRequest::ReadOnlyFlag, true);
+    meta.AddSliceDataType(mindalpha::DataType::UInt64);
+    meta.AddSliceDataType(mindalpha::DataType::Float32);
+    Run("fixed", iterations, meta,
+        [](const mindalpha::MessageMeta& m) { return m.PackAsBuffer(); },
+        [](mindalpha::MessageMeta& m, const mindalpha::SmartArray<uint8_t>& buf) {
+            m.UnpackFromBuffer(buf.data(), buf.size());
+        });
+    Run("thrift", iterations, meta,
+        [](const mindalpha::MessageMeta& m) { return m.PackAsThriftBuffer(); },
+        [](mindalpha::MessageMeta& m, const mindalpha::SmartArray<uint8_t>& buf) {
+            m.UnpackFromThriftBuffer(buf);
+        });
+    return 0;
+}
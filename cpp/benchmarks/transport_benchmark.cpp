@@ -0,0 +1,114 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <mindalpha/node_encoding.h>
+#include "benchmark_utils.h"
+
+//
+// ``transport_benchmark.cpp`` measures the message transports outside of a
+// PS job. A worker node sends messages carrying one slice to a server node
+// in the same process, which answers each of them with an empty message.
+//
+// For every transport named on the command line it reports the round trip
+// latency of one message at a time and the throughput with a window of
+// messages in flight.
+//
+//     transport_benchmark [slice_bytes] [messages] [transport ...]
+//
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int window_size = 16;
+
+void Run(const std::string& type, size_t sliceBytes, int messages)
+{
+    const int workerId = mindalpha::WorkerRankToNodeId(0);
+    const int serverId = mindalpha::ServerRankToNodeId(0);
+    mindalpha::BenchmarkNode worker = mindalpha::MakeBenchmarkNode(type, mindalpha::NodeRole::Worker, workerId);
+    mindalpha::BenchmarkNode server = mindalpha::MakeBenchmarkNode(type, mindalpha::NodeRole::Server, serverId);
+    worker.transport->Connect(server.config->GetThisNodeInfo());
+    server.transport->Connect(worker.config->GetThisNodeInfo());
+
+    std::thread echo([&server] { mindalpha::RunEchoLoop(*server.transport); });
+
+    mindalpha::SmartArray<uint8_t> slice(sliceBytes);
+    std::fill(slice.begin(), slice.end(), uint8_t(0x5a));
+    std::vector<double> latencies;
+    latencies.reserve(messages);
+    for (int i = 0; i < messages; i++)
+    {
+        const auto start = Clock::now();
+        mindalpha::SendBenchmarkMessage(*worker.transport, serverId, i, slice);
+        mindalpha::Message res;
+        worker.transport->ReceiveMessage(res);
+        latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    const auto start = Clock::now();
+    int sent = 0;
+    for (; sent < std::min(window_size, messages); sent++)
+        mindalpha::SendBenchmarkMessage(*worker.transport, serverId, sent, slice);
+    for (int received = 0; received < messages; received++)
+    {
+        mindalpha::Message res;
+        worker.transport->ReceiveMessage(res);
+        if (sent < messages)
+            mindalpha::SendBenchmarkMessage(*worker.transport, serverId, sent++, slice);
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    mindalpha::SendBenchmarkMessage(*worker.transport, serverId, -1, mindalpha::SmartArray<uint8_t>());
+    echo.join();
+    worker.transport->Stop();
+    server.transport->Stop();
+
+    printf("%-12s %10zu bytes  rtt p50 %8.1f us  p99 %8.1f us  %10.0f msg/s  %8.1f MB/s\n",
+           type.c_str(), sliceBytes,
+           latencies[latencies.size() / 2],
+           latencies[latencies.size() * 99 / 100],
+           messages / seconds,
+           messages * sliceBytes / seconds / (1 << 20));
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t sliceBytes = argc > 1 ? strtoull(argv[1], nullptr, 10) : 4096;
+    const int messages = argc > 2 ? std::max(atoi(argv[2]), 1) : 10000;
+    std::vector<std::string> types;
+    for (int i = 3; i < argc; i++)
+        types.emplace_back(argv[i]);
+    if (types.empty())
+        types = { "ZeroMQ", "TCP" };
+    for (const std::string& type : types)
+        Run(type, sliceBytes, messages);
+    return 0;
+}
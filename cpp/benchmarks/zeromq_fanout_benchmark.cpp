@@ -0,0 +1,113 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <mindalpha/node_encoding.h>
+#include "benchmark_utils.h"
+
+//
+// ``zeromq_fanout_benchmark.cpp`` measures how a worker fans messages out
+// to many servers over ZeroMQ. Several threads of the worker send to every
+// server in turn, as concurrent pulls of different tensors do, while the
+// servers answer each message with an empty one; the reported rate counts
+// responses received by the worker.
+//
+//     zeromq_fanout_benchmark [servers] [threads] [rounds] [slice_bytes] [io_threads]
+//
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+int Argument(int argc, char* argv[], int i, int value)
+{
+    return argc > i ? std::max(atoi(argv[i]), 1) : value;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const int serverCount = Argument(argc, argv, 1, 50);
+    const int threadCount = Argument(argc, argv, 2, 4);
+    const int rounds = Argument(argc, argv, 3, 200);
+    const int sliceBytes = Argument(argc, argv, 4, 1024);
+    const int ioThreads = Argument(argc, argv, 5, 1);
+
+    const int workerId = mindalpha::WorkerRankToNodeId(0);
+    mindalpha::BenchmarkNode worker = mindalpha::MakeBenchmarkNode(
+        "ZeroMQ", mindalpha::NodeRole::Worker, workerId,
+        [ioThreads](mindalpha::ActorConfig& config) { config.SetZeroMQIOThreadCount(ioThreads); });
+    std::vector<mindalpha::BenchmarkNode> servers;
+    std::vector<std::thread> echoes;
+    for (int i = 0; i < serverCount; i++)
+    {
+        servers.push_back(mindalpha::MakeBenchmarkNode(
+            "ZeroMQ", mindalpha::NodeRole::Server, mindalpha::ServerRankToNodeId(i)));
+        mindalpha::BenchmarkNode& server = servers.back();
+        worker.transport->Connect(server.config->GetThisNodeInfo());
+        server.transport->Connect(worker.config->GetThisNodeInfo());
+    }
+    for (mindalpha::BenchmarkNode& server : servers)
+        echoes.emplace_back([&server] { mindalpha::RunEchoLoop(*server.transport); });
+
+    mindalpha::SmartArray<uint8_t> slice(sliceBytes);
+    std::fill(slice.begin(), slice.end(), uint8_t(0x5a));
+    const auto start = Clock::now();
+    std::vector<std::thread> senders;
+    for (int t = 0; t < threadCount; t++)
+        senders.emplace_back([&, t] {
+            for (int r = 0; r < rounds; r++)
+                for (int i = 0; i < serverCount; i++)
+                {
+                    // Start each thread at a different server so they
+                    // don't all wait on the same socket.
+                    const int rank = (i + t) % serverCount;
+                    mindalpha::SendBenchmarkMessage(*worker.transport,
+                        mindalpha::ServerRankToNodeId(rank), r, slice);
+                }
+        });
+    const int64_t total = int64_t(threadCount) * rounds * serverCount;
+    for (int64_t i = 0; i < total; i++)
+    {
+        mindalpha::Message res;
+        worker.transport->ReceiveMessage(res);
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    for (std::thread& sender : senders)
+        sender.join();
+
+    for (int i = 0; i < serverCount; i++)
+        mindalpha::SendBenchmarkMessage(*worker.transport, mindalpha::ServerRankToNodeId(i),
+                                        -1, mindalpha::SmartArray<uint8_t>());
+    for (std::thread& echo : echoes)
+        echo.join();
+    for (mindalpha::BenchmarkNode& server : servers)
+        server.transport->Stop();
+    worker.transport->Stop();
+
+    printf("%d servers  %d threads  %d io threads  %d bytes  %10.0f msg/s  %8.1f MB/s\n",
+           serverCount, threadCount, ioThreads, sliceBytes,
+           total / seconds, total * sliceBytes / seconds / (1 << 20));
+    return 0;
+}
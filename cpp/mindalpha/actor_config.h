@@ -39,6 +39,10 @@ public:
     AgentReadyCallback GetAgentReadyCallback() const { return agent_ready_callback_; }
     void SetAgentReadyCallback(AgentReadyCallback value) { agent_ready_callback_ = std::move(value); }
 
+    // "ZeroMQ", "SharedMemory" to pass messages between nodes on the same
+    // host through shared memory rings, "TCP" to use plain sockets instead
+    // of ZeroMQ, or "InProcess" for local mode jobs, whose actors are
+    // threads of one process.
     const std::string& GetTransportType() const { return transport_type_; }
     void SetTransportType(std::string value) { transport_type_ = std::move(value); }
 
@@ -104,6 +108,30 @@ public:
     int GetWorkerCount() { return worker_count_; }
     void SetWorkerCount(int value) { worker_count_ = value; }
 
+    // Number of threads servers execute requests on, requests are executed
+    // by the receiving thread when it is zero.
+    int GetServerThreadCount() const { return server_thread_count_; }
+    void SetServerThreadCount(int value) { server_thread_count_ = value; }
+
+    // Number of helper threads servers split large sparse pulls and pushes
+    // across, they are processed serially when it is zero.
+    int GetServerParallelThreadCount() const { return server_parallel_thread_count_; }
+    void SetServerParallelThreadCount(int value) { server_parallel_thread_count_ = value; }
+
+    // Number of ZeroMQ background I/O threads of each node.
+    int GetZeroMQIOThreadCount() const { return zeromq_io_thread_count_; }
+    void SetZeroMQIOThreadCount(int value) { zeromq_io_thread_count_ = value; }
+
+    // Size in bytes of each shared memory ring of the "SharedMemory"
+    // transport; larger messages are sent through ZeroMQ.
+    uint64_t GetSharedMemoryRingSize() const { return shared_memory_ring_size_; }
+    void SetSharedMemoryRingSize(uint64_t value) { shared_memory_ring_size_ = value; }
+
+    // Milliseconds a send may wait for room in a shared memory ring, or
+    // for the "TCP" transport to connect to the peer, before it fails.
+    int GetSendTimeout() const { return send_timeout_; }
+    void SetSendTimeout(int value) { send_timeout_ = value; }
+
     std::shared_ptr<ActorConfig> Copy() const { return std::make_shared<ActorConfig>(*this); }
 
 private:
@@ -113,6 +141,7 @@ private:
     static constexpr int default_heartbeat_timeout = 0;
     static constexpr int default_resending_timeout = 1000;
     static constexpr int default_resending_retry = 10;
+    static constexpr int default_send_timeout = 60000;
 
     AgentCreator agent_creator_;
     AgentReadyCallback agent_ready_callback_;
@@ -136,6 +165,11 @@ private:
     int drop_rate_ = 0;
     int server_count_ = 0;
     int worker_count_ = 0;
+    int server_thread_count_ = 0;
+    int server_parallel_thread_count_ = 0;
+    int zeromq_io_thread_count_ = 1;
+    uint64_t shared_memory_ring_size_ = 64 * 1024 * 1024;
+    int send_timeout_ = default_send_timeout;
 };
 
 }
@@ -198,7 +198,10 @@ void ActorProcess::WaitReady()
 bool ActorProcess::HandleDataMessage(Message&& msg)
 {
     auto message = std::make_shared<Message>(std::move(msg));
-    agent_->HandleMessage(message);
+    if (executor_ && message->GetMessageMeta().IsRequest())
+        agent_->DispatchRequest(message, *executor_);
+    else
+        agent_->HandleMessage(message);
     return false;
 }
 
@@ -514,6 +517,15 @@ void ActorProcess::Start()
                 throw std::runtime_error(serr);
             }
             transport_->Connect(coordinator_);
+            // Callbacks of requests sent by the agent run on this thread in
+            // the order their responses complete.
+            completion_executor_ = std::make_unique<RequestExecutor>(1);
+            const int thread_count = config_->GetServerThreadCount();
+            if (role == NodeRole::Server && thread_count > 0)
+                executor_ = std::make_unique<RequestExecutor>(thread_count);
+            const int parallel_thread_count = config_->GetServerParallelThreadCount();
+            if (role == NodeRole::Server && parallel_thread_count > 0)
+                parallel_pool_ = std::make_shared<ParallelForPool>(parallel_thread_count);
             std::packaged_task<void()> task([this] { this->Receiving(); });
             receiver_exit_ = std::make_unique<std::future<void>>(task.get_future());
             std::thread receiver_thread(std::move(task));
@@ -568,6 +580,20 @@ void ActorProcess::Stop()
 {
     if (receiver_exit_)
         receiver_exit_->get();
+    if (executor_)
+    {
+        executor_->Stop();
+        spdlog::info("{} request thread utilization: {}",
+                     config_->GetThisNodeInfo().ToShortString(),
+                     executor_->GetThreadUtilizationString());
+        executor_.reset();
+    }
+    if (completion_executor_)
+    {
+        completion_executor_->Stop();
+        completion_executor_.reset();
+    }
+    parallel_pool_.reset();
     agent_->Finalize();
     agent_->actor_process_ = nullptr;
     agent_.reset();
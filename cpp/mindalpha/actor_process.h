@@ -31,6 +31,8 @@
 #include <mindalpha/actor_config.h>
 #include <mindalpha/message_transport.h>
 #include <mindalpha/node_manager.h>
+#include <mindalpha/request_executor.h>
+#include <mindalpha/parallel_for.h>
 
 namespace mindalpha
 {
@@ -91,6 +93,9 @@ private:
     int init_stage_ = 0;
     NodeInfo coordinator_;
     std::shared_ptr<class PSAgent> agent_;
+    std::unique_ptr<RequestExecutor> executor_;
+    std::unique_ptr<RequestExecutor> completion_executor_;
+    std::shared_ptr<ParallelForPool> parallel_pool_;
 };
 
 }
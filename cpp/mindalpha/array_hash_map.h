@@ -22,11 +22,18 @@
 #include <iostream>
 #include <sstream>
 #include <vector>
+#include <algorithm>
 #include <stdexcept>
 #include <memory>
 #include <utility>
+#include <limits>
+#include <type_traits>
 #include <spdlog/spdlog.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #include <mindalpha/hashtable_helpers.h>
+#include <mindalpha/hash_map_engine.h>
 #include <mindalpha/stack_trace_utils.h>
 #include <mindalpha/memory_buffer.h>
 #include <mindalpha/map_file_header.h>
@@ -37,20 +44,39 @@
 // than ``std::unordered_map``. The hash algorithm is also improved by avoiding
 // modulo of general primes.
 //
+// Keys and values are always stored in dense arrays in insertion order. The
+// hash index built over them is selected by ``HashMapEngine``: ``Chained``
+// uses the ``first_``/``next_`` chain arrays, ``OpenAddressing`` probes
+// cache line sized groups of 7-bit tags with SSE2, each group also holding
+// the slot indices pointing into the dense arrays. The file format is the
+// same for both engines.
+//
+// When the map is full, ``GetOrInit`` doubles it without rebuilding the hash
+// index at once: the old index is migrated a few buckets per insertion, see
+// ``Grow`` and ``RehashStep``, so that lookups and insertions into a large map
+// never stall for a full rehash.
+//
+// ``TIndex`` is the type of the indices into the dense arrays and limits the
+// bucket count to its maximum value. ``uint32_t`` is the default as it halves
+// the memory of the hash index; use ``uint64_t`` for maps larger than that.
+//
 
 namespace mindalpha
 {
 
-template<typename TKey, typename TValue>
+template<typename TKey, typename TValue, typename TIndex = uint32_t>
 class ArrayHashMap
 {
 public:
     ArrayHashMap()
     {
         static_assert(sizeof(TKey) <= sizeof(uint64_t), "invalid key type");
+        static_assert(std::is_same_v<TIndex, uint32_t> || std::is_same_v<TIndex, uint64_t>, "invalid index type");
     }
 
-    explicit ArrayHashMap(int64_t value_count_per_key)
+    explicit ArrayHashMap(int64_t value_count_per_key,
+                          HashMapEngine engine = HashMapEngine::Chained,
+                          MemoryBufferBackend backend = MemoryBufferBackend::Malloc)
         : ArrayHashMap()
     {
         if (value_count_per_key < 0)
@@ -62,6 +88,13 @@ public:
             throw std::runtime_error(serr);
         }
         value_count_per_key_ = static_cast<uint64_t>(value_count_per_key);
+        engine_ = engine;
+        keys_buffer_.SetBackend(backend);
+        values_buffer_.SetBackend(backend);
+        next_buffer_.SetBackend(backend);
+        first_buffer_.SetBackend(backend);
+        groups_buffer_.SetBackend(backend);
+        rehash_groups_buffer_.SetBackend(backend);
     }
 
     ArrayHashMap(ArrayHashMap&& rhs)
@@ -69,23 +102,34 @@ public:
         , values_buffer_(std::move(rhs.values_buffer_))
         , next_buffer_(std::move(rhs.next_buffer_))
         , first_buffer_(std::move(rhs.first_buffer_))
+        , groups_buffer_(std::move(rhs.groups_buffer_))
+        , rehash_groups_buffer_(std::move(rhs.rehash_groups_buffer_))
+        , engine_(rhs.engine_)
         , key_count_(rhs.key_count_)
         , bucket_count_(rhs.bucket_count_)
         , value_count_(rhs.value_count_)
         , value_count_per_key_(rhs.value_count_per_key_)
+        , rehash_bucket_count_(rhs.rehash_bucket_count_)
+        , rehash_cursor_(rhs.rehash_cursor_)
         , keys_(rhs.keys_)
         , values_(rhs.values_)
         , next_(rhs.next_)
         , first_(rhs.first_)
+        , groups_(rhs.groups_)
+        , rehash_groups_(rhs.rehash_groups_)
     {
         rhs.key_count_ = 0;
         rhs.bucket_count_ = 0;
         rhs.value_count_ = 0;
         rhs.value_count_per_key_ = static_cast<uint64_t>(-1);
+        rhs.rehash_bucket_count_ = 0;
+        rhs.rehash_cursor_ = 0;
         rhs.keys_ = nullptr;
         rhs.values_ = nullptr;
         rhs.next_ = nullptr;
         rhs.first_ = nullptr;
+        rhs.groups_ = nullptr;
+        rhs.rehash_groups_ = nullptr;
     }
 
     ~ArrayHashMap()
@@ -94,10 +138,14 @@ public:
         bucket_count_ = 0;
         value_count_ = 0;
         value_count_per_key_ = static_cast<uint64_t>(-1);
+        rehash_bucket_count_ = 0;
+        rehash_cursor_ = 0;
         keys_ = nullptr;
         values_ = nullptr;
         next_ = nullptr;
         first_ = nullptr;
+        groups_ = nullptr;
+        rehash_groups_ = nullptr;
     }
 
     void Swap(ArrayHashMap& other)
@@ -106,19 +154,29 @@ public:
         values_buffer_.Swap(other.values_buffer_);
         next_buffer_.Swap(other.next_buffer_);
         first_buffer_.Swap(other.first_buffer_);
+        groups_buffer_.Swap(other.groups_buffer_);
+        rehash_groups_buffer_.Swap(other.rehash_groups_buffer_);
+        std::swap(engine_, other.engine_);
         std::swap(key_count_, other.key_count_);
         std::swap(bucket_count_, other.bucket_count_);
         std::swap(value_count_, other.value_count_);
         std::swap(value_count_per_key_, other.value_count_per_key_);
+        std::swap(rehash_bucket_count_, other.rehash_bucket_count_);
+        std::swap(rehash_cursor_, other.rehash_cursor_);
         std::swap(keys_, other.keys_);
         std::swap(values_, other.values_);
         std::swap(next_, other.next_);
         std::swap(first_, other.first_);
+        std::swap(groups_, other.groups_);
+        std::swap(rehash_groups_, other.rehash_groups_);
     }
 
     const TKey* GetKeysArray() const { return keys_; }
     const TValue* GetValuesArray() const { return values_; }
 
+    HashMapEngine GetEngine() const { return engine_; }
+    MemoryBufferBackend GetMemoryBufferBackend() const { return keys_buffer_.GetBackend(); }
+
     void Reserve(uint64_t size)
     {
         if (value_count_per_key_ == static_cast<uint64_t>(-1))
@@ -152,26 +210,26 @@ public:
             return;
         }
         const uint64_t bucket_count = HashtableHelpers::GetPowerBucketCount(size);
-        const uint64_t limit = std::numeric_limits<uint32_t>::max();
-        if (bucket_count > limit)
-        {
-            std::string serr;
-            serr.append("store " + std::to_string(size) + " keys ");
-            serr.append("requires " + std::to_string(bucket_count) + " buckets, ");
-            serr.append("but at most " + std::to_string(limit) + " are allowed.\n\n");
-            serr.append(GetStackTrace());
-            spdlog::error(serr);
-            throw std::runtime_error(serr);
-        }
+        CheckBucketCount(size, bucket_count);
         keys_buffer_.Reallocate(bucket_count * sizeof(TKey));
         values_buffer_.Reallocate(bucket_count * value_count_per_key_ * sizeof(TValue));
-        next_buffer_.Reallocate(bucket_count * sizeof(uint32_t));
-        first_buffer_.Reallocate(bucket_count * sizeof(uint32_t));
+        if (engine_ == HashMapEngine::OpenAddressing)
+        {
+            // Reserve one more group so that ``groups_`` can be aligned to cache lines.
+            const uint64_t group_count = GetGroupCount(bucket_count);
+            groups_buffer_.Reallocate((group_count + 1) * sizeof(Group));
+        }
+        else
+        {
+            next_buffer_.Reallocate(bucket_count * sizeof(TIndex));
+            first_buffer_.Reallocate(bucket_count * sizeof(TIndex));
+        }
         bucket_count_ = bucket_count;
         keys_ = static_cast<TKey*>(keys_buffer_.GetPointer());
         values_ = static_cast<TValue*>(values_buffer_.GetPointer());
-        next_ = static_cast<uint32_t*>(next_buffer_.GetPointer());
-        first_ = static_cast<uint32_t*>(first_buffer_.GetPointer());
+        next_ = static_cast<TIndex*>(next_buffer_.GetPointer());
+        first_ = static_cast<TIndex*>(first_buffer_.GetPointer());
+        groups_ = AlignGroups(groups_buffer_.GetPointer());
         BuildHashIndex();
     }
 
@@ -179,9 +237,11 @@ public:
     {
         if (bucket_count_ == 0)
             return -1;
-        const uint32_t nil = uint32_t(-1);
-        const uint64_t bucket = GetBucket(key);
-        uint32_t i = first_[bucket];
+        if (engine_ == HashMapEngine::OpenAddressing)
+            return ProbeSlot(key);
+        const TIndex nil = TIndex(-1);
+        const uint64_t bucket = GetChainBucket(key);
+        TIndex i = first_[bucket];
         while (i != nil)
         {
             if (keys_[i] == key)
@@ -199,6 +259,38 @@ public:
         return index;
     }
 
+    //
+    // Batched versions of ``Find`` and ``FindOrInit``. Keys are processed in
+    // groups of ``kBatchGroupSize``: the hash index entries of all keys in a
+    // group are prefetched first, then the key slots they point to, and only
+    // then the keys are resolved, so that the cache misses of a group overlap
+    // instead of being serialized. ``out`` may alias ``keys``.
+    //
+    void FindBatch(const TKey* keys, uint64_t count, int64_t* out) const
+    {
+        for (uint64_t i = 0; i < count; i += kBatchGroupSize)
+        {
+            const uint64_t n = std::min(kBatchGroupSize, count - i);
+            FindGroup(keys + i, n, out + i);
+        }
+    }
+
+    void FindOrInitBatch(const TKey* keys, uint64_t count, int64_t* out)
+    {
+        TKey group_keys[kBatchGroupSize];
+        for (uint64_t i = 0; i < count; i += kBatchGroupSize)
+        {
+            const uint64_t n = std::min(kBatchGroupSize, count - i);
+            memcpy(group_keys, keys + i, n * sizeof(TKey));
+            FindGroup(group_keys, n, out + i);
+            // Indices into the dense arrays are stable when the map grows,
+            // so missing keys can be inserted after the whole group is resolved.
+            for (uint64_t j = 0; j < n; j++)
+                if (out[i + j] == -1)
+                    out[i + j] = FindOrInit(group_keys[j]);
+        }
+    }
+
     const TValue* Get(TKey key) const
     {
         if (bucket_count_ == 0)
@@ -211,16 +303,10 @@ public:
             spdlog::error(serr);
             throw std::runtime_error(serr);
         }
-        const uint32_t nil = uint32_t(-1);
-        const uint64_t bucket = get_bucket(key);
-        uint32_t i = first_[bucket];
-        while (i != nil)
-        {
-            if (keys_[i] == key)
-                return &values_[i * value_count_per_key_];
-            i = next_[i];
-        }
-        return nullptr;
+        const int64_t i = Find(key);
+        if (i == -1)
+            return nullptr;
+        return &values_[i * value_count_per_key_];
     }
 
     TValue* GetOrInit(TKey key, bool& is_new, int64_t& index)
@@ -233,11 +319,21 @@ public:
             spdlog::error(serr);
             throw std::runtime_error(serr);
         }
-        const uint32_t nil = uint32_t(-1);
-        if (bucket_count_ > 0)
+        const TIndex nil = TIndex(-1);
+        if (bucket_count_ > 0 && engine_ == HashMapEngine::OpenAddressing)
+        {
+            const int64_t i = ProbeSlot(key);
+            if (i != -1)
+            {
+                is_new = false;
+                index = i;
+                return &values_[i * value_count_per_key_];
+            }
+        }
+        else if (bucket_count_ > 0)
         {
-            const uint64_t b = GetBucket(key);
-            uint32_t i = first_[b];
+            const uint64_t b = GetChainBucket(key);
+            TIndex i = first_[b];
             while (i != nil)
             {
                 if (keys_[i] == key)
@@ -249,13 +345,20 @@ public:
                 i = next_[i];
             }
         }
+        if (rehash_bucket_count_ != 0)
+            RehashStep(kRehashStep);
         if (key_count_ == bucket_count_)
             EnsureCapacity();
-        const uint64_t bucket = GetBucket(key);
         index = static_cast<int64_t>(key_count_);
         keys_[index] = key;
-        next_[index] = first_[bucket];
-        first_[bucket] = static_cast<uint32_t>(index);
+        if (engine_ == HashMapEngine::OpenAddressing)
+            InsertSlot(key, static_cast<TIndex>(index));
+        else
+        {
+            const uint64_t bucket = GetChainBucket(key);
+            next_[index] = first_[bucket];
+            first_[bucket] = static_cast<TIndex>(index);
+        }
         is_new = true;
         key_count_++;
         value_count_ += value_count_per_key_;
@@ -287,6 +390,8 @@ public:
         values_buffer_.Deallocate();
         next_buffer_.Deallocate();
         first_buffer_.Deallocate();
+        groups_buffer_.Deallocate();
+        EndRehash();
         key_count_ = 0;
         bucket_count_ = 0;
         value_count_ = 0;
@@ -294,6 +399,7 @@ public:
         values_ = nullptr;
         next_ = nullptr;
         first_ = nullptr;
+        groups_ = nullptr;
     }
 
     template<typename Func>
@@ -348,7 +454,7 @@ public:
             const TValue* values = &values_[i * value_count_per_key_];
             out << key << ": [";
             for (uint64_t j = 0; j < value_count_per_key_; j++)
-                out << (j ? ", " : "") << as_number(values[j]);
+                out << (j ? ", " : "") << AsNumber(values[j]);
             out << "]\n";
         }
     }
@@ -372,7 +478,7 @@ public:
     class iterator
     {
     public:
-        iterator(const ArrayHashMap<TKey, TValue>* map, uint64_t index)
+        iterator(const ArrayHashMap* map, uint64_t index)
             : map_(map), index_(index) { }
 
         iterator& operator++()
@@ -401,7 +507,7 @@ public:
         }
 
     private:
-        const ArrayHashMap<TKey, TValue>* map_;
+        const ArrayHashMap* map_;
         uint64_t index_;
     };
 
@@ -452,6 +558,7 @@ public:
         }
         if (value_count_per_key == static_cast<uint64_t>(-1))
             value_count_per_key = value_count_per_key_;
+        FinishRehash();
         if (value_count_per_key > value_count_per_key_)
         {
             std::string serr;
@@ -465,7 +572,7 @@ public:
         hint.append(path);
         hint.append("\"; ");
         MapFileHeader header;
-        header.FillBasicFields();
+        header.FillBasicFields(DataTypeToCode<TIndex>::value);
         header.key_type = static_cast<uint64_t>(DataTypeToCode<TKey>::value);
         header.value_type = static_cast<uint64_t>(DataTypeToCode<TValue>::value);
         header.key_count = key_count_;
@@ -484,8 +591,13 @@ public:
                 write(static_cast<const void*>(values), value_count_per_key * sizeof(TValue));
             }
         }
-        write(static_cast<const void*>(next_), key_count_ * sizeof(uint32_t));
-        write(static_cast<const void*>(first_), bucket_count_ * sizeof(uint32_t));
+        if (engine_ == HashMapEngine::OpenAddressing)
+            WriteChainedIndex(write);
+        else
+        {
+            write(static_cast<const void*>(next_), key_count_ * sizeof(TIndex));
+            write(static_cast<const void*>(first_), bucket_count_ * sizeof(TIndex));
+        }
     }
 
     template<typename Func>
@@ -558,11 +670,28 @@ public:
         Reserve(header.bucket_count);
         read(static_cast<void*>(keys_), header.key_count * sizeof(TKey), hint, "keys array");
         read(static_cast<void*>(values_), value_count * sizeof(TValue), hint, "values array");
-        read(static_cast<void*>(next_), header.key_count * sizeof(uint32_t), hint, "next array");
-        read(static_cast<void*>(first_), header.bucket_count * sizeof(uint32_t), hint, "first array");
-        key_count_ = header.key_count;
-        bucket_count_ = header.bucket_count;
-        value_count_ = value_count;
+        const DataType index_type = header.GetIndexType();
+        if (engine_ == HashMapEngine::OpenAddressing || index_type != DataTypeToCode<TIndex>::value)
+        {
+            // The chained index stored in the file is useless for open addressing
+            // or when its index type differs from ``TIndex``, skip it and rebuild
+            // the hash index from the keys array.
+            const size_t index_size = DataTypeToSize(index_type);
+            SkipBytes(read, header.key_count * index_size, hint, "next array");
+            SkipBytes(read, header.bucket_count * index_size, hint, "first array");
+            key_count_ = header.key_count;
+            bucket_count_ = header.bucket_count;
+            value_count_ = value_count;
+            BuildHashIndex();
+        }
+        else
+        {
+            read(static_cast<void*>(next_), header.key_count * sizeof(TIndex), hint, "next array");
+            read(static_cast<void*>(first_), header.bucket_count * sizeof(TIndex), hint, "first array");
+            key_count_ = header.key_count;
+            bucket_count_ = header.bucket_count;
+            value_count_ = value_count;
+        }
     }
 
     void SerializeTo(const std::string& path, uint64_t value_count_per_key = static_cast<uint64_t>(-1))
@@ -623,23 +752,71 @@ public:
 private:
     uint64_t GetBucket(TKey key) const
     {
-        return HashtableHelpers::FastModulo(static_cast<uint64_t>(key)) & (bucket_count_ - 1);
+        // ``FastModulo`` keeps only 31 bits, which can not address all the
+        // buckets of a map with ``uint64_t`` indices.
+        if constexpr (std::is_same_v<TIndex, uint64_t>)
+            return HashtableHelpers::MixHash(static_cast<uint64_t>(key)) & (bucket_count_ - 1);
+        else
+            return HashtableHelpers::FastModulo(static_cast<uint64_t>(key)) & (bucket_count_ - 1);
+    }
+
+    // During rehashing, the buckets in ``[rehash_cursor_, rehash_bucket_count_)``
+    // have not been split yet and still chain the keys of both halves.
+    uint64_t GetChainBucket(TKey key) const
+    {
+        const uint64_t bucket = GetBucket(key);
+        if (__builtin_expect(rehash_bucket_count_ != 0, 0))
+        {
+            const uint64_t old_bucket = bucket & (rehash_bucket_count_ - 1);
+            if (old_bucket >= rehash_cursor_)
+                return old_bucket;
+        }
+        return bucket;
+    }
+
+    static void CheckBucketCount(uint64_t size, uint64_t bucket_count)
+    {
+        const uint64_t limit = std::numeric_limits<TIndex>::max();
+        if (bucket_count > limit)
+        {
+            std::string serr;
+            serr.append("store " + std::to_string(size) + " keys ");
+            serr.append("requires " + std::to_string(bucket_count) + " buckets, ");
+            serr.append("but at most " + std::to_string(limit) + " are allowed.\n\n");
+            serr.append(GetStackTrace());
+            spdlog::error(serr);
+            throw std::runtime_error(serr);
+        }
     }
 
     void BuildHashIndex()
     {
-        memset(first_, -1, bucket_count_ * sizeof(uint32_t));
+        EndRehash();
+        if (engine_ == HashMapEngine::OpenAddressing)
+        {
+            ResetGroups(groups_, GetGroupCount(bucket_count_));
+            for (uint64_t i = 0; i < key_count_; i++)
+                InsertSlot(keys_[i], static_cast<TIndex>(i));
+            return;
+        }
+        memset(first_, -1, bucket_count_ * sizeof(TIndex));
         for (uint64_t i = 0; i < key_count_; i++)
         {
             const TKey key = keys_[i];
             const uint64_t bucket = GetBucket(key);
             next_[i] = first_[bucket];
-            first_[bucket] = static_cast<uint32_t>(i);
+            first_[bucket] = static_cast<TIndex>(i);
         }
     }
 
     void EnsureCapacity()
     {
+        FinishRehash();
+        if (bucket_count_ > 0)
+        {
+            Grow();
+            return;
+        }
         uint64_t min_capacity = key_count_ * 2;
         if (min_capacity == 0)
             min_capacity = 1000;
@@ -650,18 +827,358 @@ private:
         Reserve(capacity);
     }
 
+    // Double the bucket count. Unlike ``Reallocate``, the hash index is not
+    // rebuilt here: the chained layout splits the old buckets in place and
+    // open addressing moves the old groups into a fresh table, both in
+    // ``RehashStep`` as keys are inserted. Lookups consult the old buckets
+    // or groups until they are migrated.
+    void Grow()
+    {
+        const uint64_t old_bucket_count = bucket_count_;
+        const uint64_t bucket_count = old_bucket_count * 2;
+        CheckBucketCount(bucket_count, bucket_count);
+        keys_buffer_.Reallocate(bucket_count * sizeof(TKey));
+        values_buffer_.Reallocate(bucket_count * value_count_per_key_ * sizeof(TValue));
+        if (engine_ == HashMapEngine::OpenAddressing)
+        {
+            // Zeroed groups are empty, the pages of a large table are
+            // then cleared lazily by the kernel instead of by ``memset``.
+            const uint64_t group_count = GetGroupCount(bucket_count);
+            rehash_groups_buffer_.Swap(groups_buffer_);
+            rehash_groups_ = groups_;
+            groups_buffer_.AllocateZeroed((group_count + 1) * sizeof(Group));
+            groups_ = AlignGroups(groups_buffer_.GetPointer());
+        }
+        else
+        {
+            // The upper half of ``first_`` is filled as the lower half is split.
+            next_buffer_.Reallocate(bucket_count * sizeof(TIndex));
+            first_buffer_.Reallocate(bucket_count * sizeof(TIndex));
+            next_ = static_cast<TIndex*>(next_buffer_.GetPointer());
+            first_ = static_cast<TIndex*>(first_buffer_.GetPointer());
+        }
+        keys_ = static_cast<TKey*>(keys_buffer_.GetPointer());
+        values_ = static_cast<TValue*>(values_buffer_.GetPointer());
+        bucket_count_ = bucket_count;
+        rehash_bucket_count_ = old_bucket_count;
+        rehash_cursor_ = 0;
+    }
+
+    // Migrate ``steps`` old buckets (chained) or old groups (open addressing).
+    void RehashStep(uint64_t steps)
+    {
+        const TIndex nil = TIndex(-1);
+        if (engine_ == HashMapEngine::OpenAddressing)
+        {
+            const uint64_t group_count = GetGroupCount(rehash_bucket_count_);
+            const uint64_t end = std::min(rehash_cursor_ + steps, group_count);
+            for (uint64_t g = rehash_cursor_; g < end; g++)
+            {
+                const Group& group = rehash_groups_[g];
+                for (uint64_t j = 0; j < kGroupWidth; j++)
+                    if (group.ctrl[j] != kEmptyControl)
+                        InsertSlot(keys_[group.slots[j]], group.slots[j]);
+            }
+            rehash_cursor_ = end;
+            if (end == group_count)
+                EndRehash();
+        }
+        else
+        {
+            const uint64_t end = std::min(rehash_cursor_ + steps, rehash_bucket_count_);
+            // Splitting keeps the order of the chains, so the result is
+            // identical to that of ``BuildHashIndex``.
+            for (uint64_t b = rehash_cursor_; b < end; b++)
+            {
+                TIndex* low = &first_[b];
+                TIndex* high = &first_[b + rehash_bucket_count_];
+                TIndex i = first_[b];
+                while (i != nil)
+                {
+                    if (GetBucket(keys_[i]) == b)
+                    {
+                        *low = i;
+                        low = &next_[i];
+                    }
+                    else
+                    {
+                        *high = i;
+                        high = &next_[i];
+                    }
+                    i = next_[i];
+                }
+                *low = nil;
+                *high = nil;
+            }
+            rehash_cursor_ = end;
+            if (end == rehash_bucket_count_)
+                EndRehash();
+        }
+    }
+
+    void FinishRehash()
+    {
+        if (rehash_bucket_count_ != 0)
+            RehashStep(rehash_bucket_count_);
+    }
+
+    void EndRehash()
+    {
+        rehash_groups_buffer_.Deallocate();
+        rehash_groups_ = nullptr;
+        rehash_bucket_count_ = 0;
+        rehash_cursor_ = 0;
+    }
+
+    // Number of slots in a group, 12 for ``uint32_t`` indices and 6 for ``uint64_t``.
+    static constexpr uint64_t kGroupWidth = (64 - 16) / sizeof(TIndex);
+
+    // A group fills exactly one cache line: ``kGroupWidth`` tag bytes padded
+    // to 16 so that they can be matched by a single SSE2 load, followed by
+    // the indices of the corresponding keys in the dense arrays.
+    struct Group
+    {
+        int8_t ctrl[16];
+        TIndex slots[kGroupWidth];
+    };
+
+    static_assert(sizeof(Group) == 64, "Group must fill exactly one cache line");
+
+    // Open addressing uses one group per ``kGroupWidth * 2 / 3`` buckets, which
+    // gives 1.5 slots per key and the same index memory footprint as the chained
+    // layout. As the load factor is at most 2/3, there is always an empty slot
+    // to terminate probing.
+    static uint64_t GetGroupCount(uint64_t bucket_count)
+    {
+        if (bucket_count == 0)
+            return 0;
+        return std::max(bucket_count / (kGroupWidth * 2 / 3), UINT64_C(1));
+    }
+
+    static Group* AlignGroups(void* ptr)
+    {
+        if (!ptr)
+            return nullptr;
+        const uintptr_t mask = sizeof(Group) - 1;
+        const uintptr_t addr = reinterpret_cast<uintptr_t>(ptr);
+        return reinterpret_cast<Group*>((addr + mask) & ~mask);
+    }
+
+    static void ResetGroups(Group* groups, uint64_t group_count)
+    {
+        if (group_count > 0)
+            memset(groups, kEmptyControl, group_count * sizeof(Group));
+    }
+
+    // Tags of used slots have the high bit set so that they never equal
+    // ``kEmptyControl``, which is zero.
+    static int8_t GetTag(uint64_t hash)
+    {
+        return static_cast<int8_t>(0x80 | (hash & 0x7f));
+    }
+
+    // Return a bit mask with bit ``i`` set if ``ctrl[i] == tag``. The padding
+    // bytes after ``kGroupWidth`` are masked out.
+    static uint32_t MatchGroup(const Group& group, int8_t tag)
+    {
+#if defined(__SSE2__)
+        const __m128i ctrl = _mm_load_si128(reinterpret_cast<const __m128i*>(group.ctrl));
+        const __m128i match = _mm_cmpeq_epi8(ctrl, _mm_set1_epi8(tag));
+        return static_cast<uint32_t>(_mm_movemask_epi8(match)) & kGroupMask;
+#else
+        uint32_t mask = 0;
+        for (uint64_t i = 0; i < kGroupWidth; i++)
+            if (group.ctrl[i] == tag)
+                mask |= UINT32_C(1) << i;
+        return mask;
+#endif
+    }
+
+    // The old groups are left intact while being migrated, so a key not yet
+    // moved to ``groups_`` can always be found in ``rehash_groups_``.
+    int64_t ProbeSlot(TKey key) const
+    {
+        const int64_t i = ProbeGroups(groups_, GetGroupCount(bucket_count_), key);
+        if (i != -1 || !rehash_groups_)
+            return i;
+        return ProbeGroups(rehash_groups_, GetGroupCount(rehash_bucket_count_), key);
+    }
+
+    int64_t ProbeGroups(const Group* groups, uint64_t group_count, TKey key) const
+    {
+        const uint64_t hash = HashtableHelpers::MixHash(static_cast<uint64_t>(key));
+        const int8_t tag = GetTag(hash);
+        const uint64_t group_mask = group_count - 1;
+        uint64_t g = (hash >> 7) & group_mask;
+        for (uint64_t step = 1; ; step++)
+        {
+            const Group& group = groups[g];
+            uint32_t match = MatchGroup(group, tag);
+            while (match)
+            {
+                const TIndex i = group.slots[__builtin_ctz(match)];
+                if (keys_[i] == key)
+                    return static_cast<int64_t>(i);
+                match &= match - 1;
+            }
+            if (MatchGroup(group, kEmptyControl))
+                return -1;
+            // Triangular probing visits every group as the group count is a power of 2.
+            g = (g + step) & group_mask;
+        }
+    }
+
+    void InsertSlot(TKey key, TIndex index)
+    {
+        const uint64_t hash = HashtableHelpers::MixHash(static_cast<uint64_t>(key));
+        const int8_t tag = GetTag(hash);
+        const uint64_t group_mask = GetGroupCount(bucket_count_) - 1;
+        uint64_t g = (hash >> 7) & group_mask;
+        for (uint64_t step = 1; ; step++)
+        {
+            Group& group = groups_[g];
+            const uint32_t empty = MatchGroup(group, kEmptyControl);
+            if (empty)
+            {
+                const int i = __builtin_ctz(empty);
+                group.ctrl[i] = tag;
+                group.slots[i] = index;
+                return;
+            }
+            g = (g + step) & group_mask;
+        }
+    }
+
+    void FindGroup(const TKey* keys, uint64_t count, int64_t* out) const
+    {
+        if (bucket_count_ == 0)
+        {
+            for (uint64_t j = 0; j < count; j++)
+                out[j] = -1;
+            return;
+        }
+        TKey group_keys[kBatchGroupSize];
+        uint64_t heads[kBatchGroupSize];
+        for (uint64_t j = 0; j < count; j++)
+            group_keys[j] = keys[j];
+        if (engine_ == HashMapEngine::OpenAddressing)
+        {
+            const uint64_t group_mask = GetGroupCount(bucket_count_) - 1;
+            for (uint64_t j = 0; j < count; j++)
+            {
+                const uint64_t hash = HashtableHelpers::MixHash(static_cast<uint64_t>(group_keys[j]));
+                heads[j] = hash;
+                __builtin_prefetch(&groups_[(hash >> 7) & group_mask]);
+            }
+            for (uint64_t j = 0; j < count; j++)
+            {
+                const Group& group = groups_[(heads[j] >> 7) & group_mask];
+                const uint32_t match = MatchGroup(group, GetTag(heads[j]));
+                if (match)
+                    __builtin_prefetch(&keys_[group.slots[__builtin_ctz(match)]]);
+            }
+            for (uint64_t j = 0; j < count; j++)
+                out[j] = ProbeSlot(group_keys[j]);
+        }
+        else
+        {
+            const TIndex nil = TIndex(-1);
+            for (uint64_t j = 0; j < count; j++)
+            {
+                heads[j] = GetChainBucket(group_keys[j]);
+                __builtin_prefetch(&first_[heads[j]]);
+            }
+            for (uint64_t j = 0; j < count; j++)
+            {
+                const TIndex i = first_[heads[j]];
+                heads[j] = i;
+                if (i != nil)
+                    __builtin_prefetch(&keys_[i]);
+            }
+            for (uint64_t j = 0; j < count; j++)
+            {
+                TIndex i = static_cast<TIndex>(heads[j]);
+                while (i != nil && keys_[i] != group_keys[j])
+                    i = next_[i];
+                out[j] = i == nil ? -1 : static_cast<int64_t>(i);
+            }
+        }
+    }
+
+    // Produce the ``next``/``first`` arrays of the chained layout so that
+    // files written by both engines are identical.
+    template<typename Func>
+    void WriteChainedIndex(Func write) const
+    {
+        MemoryBuffer first_buffer(bucket_count_ * sizeof(TIndex));
+        TIndex* const first = static_cast<TIndex*>(first_buffer.GetPointer());
+        if (bucket_count_ > 0)
+            memset(first, -1, bucket_count_ * sizeof(TIndex));
+        std::vector<TIndex> next;
+        next.reserve(kChainedIndexBlockSize);
+        for (uint64_t i = 0; i < key_count_; i++)
+        {
+            const uint64_t bucket = GetBucket(keys_[i]);
+            next.push_back(first[bucket]);
+            first[bucket] = static_cast<TIndex>(i);
+            if (next.size() == kChainedIndexBlockSize || i + 1 == key_count_)
+            {
+                write(static_cast<const void*>(next.data()), next.size() * sizeof(TIndex));
+                next.clear();
+            }
+        }
+        write(static_cast<const void*>(first), bucket_count_ * sizeof(TIndex));
+    }
+
+    template<typename Func>
+    static void SkipBytes(Func read, uint64_t size, const std::string& hint, const std::string& what)
+    {
+        std::vector<uint8_t> buffer(std::min(size, kChainedIndexBlockSize * sizeof(uint64_t)));
+        while (size > 0)
+        {
+            const uint64_t n = std::min(size, static_cast<uint64_t>(buffer.size()));
+            read(static_cast<void*>(buffer.data()), n, hint, what);
+            size -= n;
+        }
+    }
+
+    static constexpr uint32_t kGroupMask = (UINT32_C(1) << kGroupWidth) - 1;
+    static constexpr int8_t kEmptyControl = 0;
+    static constexpr uint64_t kChainedIndexBlockSize = 1024 * 1024;
+    static constexpr uint64_t kBatchGroupSize = 16;
+    // Growth happens after as many insertions as there are old buckets, so
+    // migrating at least one old bucket or group per insertion always finishes
+    // rehashing before the next growth.
+    static constexpr uint64_t kRehashStep = 2;
+
     MemoryBuffer keys_buffer_;
     MemoryBuffer values_buffer_;
     MemoryBuffer next_buffer_;
     MemoryBuffer first_buffer_;
+    MemoryBuffer groups_buffer_;
+    MemoryBuffer rehash_groups_buffer_;
+    HashMapEngine engine_ = HashMapEngine::Chained;
     uint64_t key_count_ = 0;
     uint64_t bucket_count_ = 0;
     uint64_t value_count_ = 0;
     uint64_t value_count_per_key_ = static_cast<uint64_t>(-1);
+    uint64_t rehash_bucket_count_ = 0;
+    uint64_t rehash_cursor_ = 0;
     TKey* keys_ = nullptr;
     TValue* values_ = nullptr;
-    uint32_t* next_ = nullptr;
-    uint32_t* first_ = nullptr;
+    TIndex* next_ = nullptr;
+    TIndex* first_ = nullptr;
+    Group* groups_ = nullptr;
+    Group* rehash_groups_ = nullptr;
 };
 
+// Hash map storing the slices of a sparse tensor partition. Configure with
+// ``-DMINDALPHA_WIDE_HASH_MAP_INDEX=ON`` so that a single partition can grow
+// past 2^31 keys, at the cost of 8 more bytes of hash index per bucket.
+#if defined(MINDALPHA_WIDE_HASH_MAP_INDEX)
+using SparseTensorHashMap = ArrayHashMap<uint64_t, uint8_t, uint64_t>;
+#else
+using SparseTensorHashMap = ArrayHashMap<uint64_t, uint8_t>;
+#endif
+
 }
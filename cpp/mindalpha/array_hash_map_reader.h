@@ -30,7 +30,7 @@ class ArrayHashMapReader
 {
 public:
     ArrayHashMapReader(SparseTensorMeta& meta,
-                       ArrayHashMap<uint64_t, uint8_t>& data,
+                       SparseTensorHashMap& data,
                        Stream* stream,
                        bool data_only,
                        bool transform_key,
@@ -212,8 +212,9 @@ private:
                 throw std::runtime_error(serr);
             }
             ParseDataOrStateValues(lineno, fields.at(0), data_count, data_items, true);
-            const size_t state_count = meta_.GetSliceStateLength() / sizeof(TValue);
-            TValue* const state_items = reinterpret_cast<TValue*>(values + meta_.GetSliceDataLength());
+            using TState = typename StateTypeOf<TValue>::type;
+            const size_t state_count = meta_.GetSliceStateLength() / sizeof(TState);
+            TState* const state_items = reinterpret_cast<TState*>(values + meta_.GetSliceStateOffset());
             ParseDataOrStateValues(lineno, fields.at(1), state_count, state_items, false);
             int& age = *reinterpret_cast<int*>(values + meta_.GetSliceAgeOffset());
             ParseAgeValue(lineno, fields.at(2), age);
@@ -248,7 +249,7 @@ private:
         {
             TValue value;
             std::istringstream sin(std::string{strs.at(i)});
-            if (sin >> value)
+            if (ParseValue(sin, value))
                 items[i] = value;
             else
             {
@@ -269,6 +270,25 @@ private:
         }
     }
 
+    template<typename TValue>
+    static bool ParseValue(std::istringstream& sin, TValue& value)
+    {
+        return static_cast<bool>(sin >> value);
+    }
+
+    template<typename THalf>
+    static bool ParseHalfValue(std::istringstream& sin, THalf& value)
+    {
+        float f;
+        if (!(sin >> f))
+            return false;
+        value = THalf(f);
+        return true;
+    }
+
+    static bool ParseValue(std::istringstream& sin, float16& value) { return ParseHalfValue(sin, value); }
+    static bool ParseValue(std::istringstream& sin, bfloat16& value) { return ParseHalfValue(sin, value); }
+
     void ParseAgeValue(size_t lineno, std::string_view text, int& age)
     {
         int value;
@@ -290,7 +310,7 @@ private:
     }
 
     SparseTensorMeta& meta_;
-    ArrayHashMap<uint64_t, uint8_t>& data_;
+    SparseTensorHashMap& data_;
     Stream* stream_;
     bool data_only_;
     bool transform_key_;
@@ -28,7 +28,7 @@ class ArrayHashMapWriter
 {
 public:
     ArrayHashMapWriter(SparseTensorMeta& meta,
-                       ArrayHashMap<uint64_t, uint8_t>& data)
+                       SparseTensorHashMap& data)
         : meta_(meta)
         , data_(data)
     {
@@ -78,8 +78,9 @@ private:
                 Append(sout, buffer, data_items[i]);
             }
             sout.push_back(field_separator);
-            const size_t state_count = meta_.GetSliceStateLength() / sizeof(TValue);
-            const TValue* const state_items = reinterpret_cast<const TValue*>(values + meta_.GetSliceDataLength());
+            using TState = typename StateTypeOf<TValue>::type;
+            const size_t state_count = meta_.GetSliceStateLength() / sizeof(TState);
+            const TState* const state_items = reinterpret_cast<const TState*>(values + meta_.GetSliceStateOffset());
             for (size_t i = 0; i < state_count; i++)
             {
                 if (i > 0)
@@ -110,8 +111,19 @@ private:
         sout.append(buffer, std::sprintf(buffer, "%.15g", value));
     }
 
+    // Enough significant digits to restore the half precision values.
+    static void Append(std::string& sout, char (&buffer)[buffer_size], float16 value)
+    {
+        sout.append(buffer, std::sprintf(buffer, "%.5g", static_cast<float>(value)));
+    }
+
+    static void Append(std::string& sout, char (&buffer)[buffer_size], bfloat16 value)
+    {
+        sout.append(buffer, std::sprintf(buffer, "%.4g", static_cast<float>(value)));
+    }
+
     SparseTensorMeta& meta_;
-    ArrayHashMap<uint64_t, uint8_t>& data_;
+    SparseTensorHashMap& data_;
 };
 
 }
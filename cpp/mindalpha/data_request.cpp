@@ -0,0 +1,52 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <mindalpha/data_request.h>
+
+namespace mindalpha
+{
+
+std::string DataRequest::ToString() const
+{
+    return ToJsonString();
+}
+
+std::string DataRequest::ToJsonString() const
+{
+    return to_json().dump();
+}
+
+json11::Json DataRequest::to_json() const
+{
+    return json11::Json::object
+    {
+        { "command", NullableDataRequestCommandToString(command_) },
+        { "tensor_id", tensor_id_ },
+        { "flags", flags_ },
+    };
+}
+
+DataRequest DataRequest::FromJson(const json11::Json& json)
+{
+    DataRequest request;
+    request.SetCommand(NullableDataRequestCommandFromString(json["command"].string_value()));
+    request.SetTensorId(json["tensor_id"].int_value());
+    request.SetFlags(json["flags"].int_value());
+    return request;
+}
+
+}
@@ -0,0 +1,73 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <json11.hpp>
+#include <mindalpha/data_request_command.h>
+
+//
+// ``data_request.h`` defines class ``DataRequest`` which is the compact
+// binary header of data-plane requests.
+//
+// Pulls and pushes of initialized tensors identify the tensor by the id
+// the server assigned to it at ``DenseInit`` or ``SparseInit`` and pass
+// their options as flags, so the server does not parse a JSON body or
+// hash the tensor name. Control-plane commands keep the JSON body and
+// leave the header empty.
+//
+
+namespace mindalpha
+{
+
+class DataRequest
+{
+public:
+    static constexpr int IsValueFlag = 1;
+    static constexpr int IsStateFlag = 2;
+    static constexpr int ReadOnlyFlag = 4;
+    static constexpr int NanFillFlag = 8;
+
+    bool IsEmpty() const { return command_ == NullDataRequestCommand; }
+
+    DataRequestCommand GetCommand() const { return command_; }
+    void SetCommand(DataRequestCommand value) { command_ = value; }
+
+    int GetTensorId() const { return tensor_id_; }
+    void SetTensorId(int value) { tensor_id_ = value; }
+
+    int GetFlags() const { return flags_; }
+    void SetFlags(int value) { flags_ = value; }
+
+    bool HasFlag(int flag) const { return (flags_ & flag) != 0; }
+    void SetFlag(int flag, bool value) { flags_ = value ? (flags_ | flag) : (flags_ & ~flag); }
+
+    std::string ToString() const;
+    std::string ToJsonString() const;
+    json11::Json to_json() const;
+
+    static DataRequest FromJson(const json11::Json& json);
+
+private:
+    DataRequestCommand command_ = NullDataRequestCommand;
+    int tensor_id_ = -1;
+    int flags_ = 0;
+};
+
+}
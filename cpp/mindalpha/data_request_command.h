@@ -0,0 +1,54 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#pragma once
+
+#include <string>
+
+//
+// ``data_request_command.h`` defines enum ``DataRequestCommand`` which
+// identifies the data-plane commands carried in the binary header of
+// requests, see ``data_request.h``.
+//
+
+namespace mindalpha
+{
+
+#define MINDALPHA_DATA_REQUEST_COMMANDS(X)  \
+    X(DensePush)                            \
+    X(DensePull)                            \
+    X(SparsePush)                           \
+    X(SparsePull)                           \
+    /**/
+
+enum class DataRequestCommand
+{
+#undef MINDALPHA_DATA_REQUEST_COMMAND_DEF
+#define MINDALPHA_DATA_REQUEST_COMMAND_DEF(n) n,
+    MINDALPHA_DATA_REQUEST_COMMANDS(MINDALPHA_DATA_REQUEST_COMMAND_DEF)
+};
+
+constexpr DataRequestCommand NullDataRequestCommand = static_cast<DataRequestCommand>(-1);
+constexpr const char* NullDataRequestCommandString = "null";
+
+std::string DataRequestCommandToString(DataRequestCommand command);
+DataRequestCommand DataRequestCommandFromString(const std::string& str);
+
+std::string NullableDataRequestCommandToString(DataRequestCommand command);
+DataRequestCommand NullableDataRequestCommandFromString(const std::string& str);
+
+}
@@ -86,4 +86,9 @@ size_t DataTypeToSize(DataType type)
     }
 }
 
+DataType DataTypeToStateType(DataType type)
+{
+    return IsHalfDataType(type) ? DataType::Float32 : type;
+}
+
 }
@@ -18,6 +18,7 @@
 
 #include <stdint.h>
 #include <string>
+#include <mindalpha/float16.h>
 
 //
 // ``data_type.h`` defines enum ``DataType`` to represent numeric data types
@@ -50,9 +51,15 @@ namespace mindalpha
     X(double,   float64, Float64)         \
     /**/
 
+#define MINDALPHA_HALF_DATA_TYPES(X)      \
+    X(float16,  float16, Float16)         \
+    X(bfloat16, bfloat16, BFloat16)       \
+    /**/
+
 #define MINDALPHA_DATA_TYPES(X)           \
     MINDALPHA_INTEGRAL_DATA_TYPES(X)      \
     MINDALPHA_FLOATING_DATA_TYPES(X)      \
+    MINDALPHA_HALF_DATA_TYPES(X)          \
     /**/
 
 enum class DataType
@@ -90,6 +97,25 @@ struct DataTypeToCode;
 // Compute the size in bytes of a value of ``type``.
 size_t DataTypeToSize(DataType type);
 
+inline bool IsHalfDataType(DataType type)
+{
+    return type == DataType::Float16 || type == DataType::BFloat16;
+}
+
+// Updater states of half precision tensors are kept in ``float``, so that
+// they accumulate in full precision; other types keep states in their own
+// type. ``StateTypeOf`` is the compile time counterpart.
+DataType DataTypeToStateType(DataType type);
+
+template<typename T>
+struct StateTypeOf
+{
+    using type = T;
+};
+
+template<> struct StateTypeOf<float16> { using type = float; };
+template<> struct StateTypeOf<bfloat16> { using type = float; };
+
 // This function template and two function overloads ensure ``value``
 // can be output as numbers. Output ``int8_t``/``uint8_t`` directly to
 // ``std::ostream`` will cause problems as they are character types
@@ -99,5 +125,7 @@ inline T AsNumber(T value) { return value; }
 
 inline int32_t AsNumber(int8_t value) { return static_cast<int32_t>(value); }
 inline uint32_t AsNumber(uint8_t value) { return static_cast<uint32_t>(value); }
+inline float AsNumber(float16 value) { return static_cast<float>(value); }
+inline float AsNumber(bfloat16 value) { return static_cast<float>(value); }
 
 }
@@ -33,13 +33,15 @@ void DenseTensor::Init(std::function<void()> cb)
     };
     req->GetMessageMeta().SetReceiver(ServerGroup);
     req->GetMessageMeta().SetBody(json.dump());
-    agent_->BroadcastRequest(req, [cb](PSMessage req, std::vector<PSMessage> ress) {
+    agent_->BroadcastRequest(req, [this, cb](PSMessage req, std::vector<PSMessage> ress) {
+        SetTensorIds(ress);
         cb();
     });
 }
 
 void DenseTensor::Dispose(std::function<void()> cb)
 {
+    tensor_ids_.clear();
     PSMessage req = std::make_shared<Message>();
     json11::Json json = json11::Json::object
     {
@@ -54,6 +56,23 @@ void DenseTensor::Dispose(std::function<void()> cb)
 }
 
 void DenseTensor::Push(SmartArray<uint8_t> in, std::function<void()> cb, bool is_value, bool is_state)
+{
+    std::vector<PSMessage> reqs = MakePushRequests(in, is_value, is_state);
+    agent_->SendAllRequests(std::move(reqs), [cb](std::vector<PSMessage> reqs, std::vector<PSMessage> ress) {
+        cb();
+    });
+}
+
+void DenseTensor::Pull(std::function<void(SmartArray<uint8_t> out)> cb, bool is_state)
+{
+    std::vector<PSMessage> reqs = MakePullRequests(is_state);
+    agent_->SendAllRequests(std::move(reqs), [this, cb, is_state](std::vector<PSMessage> reqs, std::vector<PSMessage> ress) {
+        SmartArray<uint8_t> out = CombinePullResponses(ress, is_state);
+        cb(out);
+    });
+}
+
+std::vector<PSMessage> DenseTensor::MakePushRequests(SmartArray<uint8_t> in, bool is_value, bool is_state) const
 {
     const size_t name_hash = GetMeta().GetNameHash();
     const size_t item_size = DataTypeToSize(GetMeta().GetDataType());
@@ -67,29 +86,40 @@ void DenseTensor::Push(SmartArray<uint8_t> in, std::function<void()> cb, bool is
         { "is_value", is_value },
         { "is_state", is_state },
     };
-    std::string command = json.dump();
+    const std::string command = tensor_ids_.empty() ? json.dump() : std::string();
+    const int flags = (is_value ? DataRequest::IsValueFlag : 0) | (is_state ? DataRequest::IsStateFlag : 0);
+    const GradientCodec codec = GetMeta().GetGradientCodec();
+    const DataType data_type = GetMeta().GetDataType();
     std::vector<PSMessage> reqs;
     reqs.reserve(num_parts);
     for (int k = 0; k < num_parts; k++)
     {
         PSMessage req = std::make_shared<Message>();
         req->GetMessageMeta().SetReceiver(ServerRankToNodeId(k));
-        req->GetMessageMeta().SetBody(command);
+        if (tensor_ids_.empty())
+            req->GetMessageMeta().SetBody(command);
+        else
+            SetRequestHeader(req, DataRequestCommand::DensePush, flags, k);
         size_t begin = 0;
         size_t end = 0;
         GetMeta().ComputePartitionShapesWithHash(name_hash, k, begin, end, nullptr, nullptr);
         begin *= slice_length;
         end *= slice_length;
         SmartArray<uint8_t> k_in = in.Slice(begin, end);
-        req->AddTypedSlice(k_in, GetMeta().GetDataType());
+        if (is_value || is_state)
+            req->AddTypedSlice(k_in, data_type);
+        else
+        {
+            SmartArray<uint8_t> grad = gradient_encoder_.Encode(codec, data_type, k_in, DenseGradientRowItems,
+                                                                GetMeta().GetGradientTopKRatio(), k);
+            req->AddTypedSlice(grad, codec == GradientCodec::None ? data_type : DataType::UInt8);
+        }
         reqs.push_back(req);
     }
-    agent_->SendAllRequests(std::move(reqs), [cb](std::vector<PSMessage> reqs, std::vector<PSMessage> ress) {
-        cb();
-    });
+    return reqs;
 }
 
-void DenseTensor::Pull(std::function<void(SmartArray<uint8_t> out)> cb, bool is_state)
+std::vector<PSMessage> DenseTensor::MakePullRequests(bool is_state) const
 {
     json11::Json json = json11::Json::object
     {
@@ -97,33 +127,48 @@ void DenseTensor::Pull(std::function<void(SmartArray<uint8_t> out)> cb, bool is_
         { "name", GetMeta().GetName() },
         { "is_state", is_state },
     };
-    PSMessage req = std::make_shared<Message>();
-    req->GetMessageMeta().SetReceiver(ServerGroup);
-    req->GetMessageMeta().SetBody(json.dump());
-    agent_->BroadcastRequest(req, [this, cb, is_state](PSMessage req, std::vector<PSMessage> ress) {
-        const size_t name_hash = GetMeta().GetNameHash();
-        const size_t item_size = DataTypeToSize(GetMeta().GetDataType());
-        const size_t slice_items = SliceElements(is_state ? GetMeta().GetStateShape() : GetMeta().GetDataShape());
-        const size_t slice_length = item_size * slice_items;
-        const size_t total_items = TotalElements(is_state ? GetMeta().GetStateShape() : GetMeta().GetDataShape());
-        const size_t total_length = item_size * total_items;
-        const int num_parts = GetMeta().GetPartitionCount();
-        SmartArray<uint8_t> out(total_length);
-        for (int k = 0; k < num_parts; k++)
-        {
-            PSMessage res = ress.at(k);
-            SmartArray<uint8_t> k_out = res->GetTypedSlice(0, GetMeta().GetDataType());
-            const int sender = res->GetMessageMeta().GetSender();
-            const int rank = NodeIdToRank(sender);
-            size_t begin = 0;
-            size_t end = 0;
-            GetMeta().ComputePartitionShapesWithHash(name_hash, rank, begin, end, nullptr, nullptr);
-            begin *= slice_length;
-            end *= slice_length;
-            memcpy(out.data() + begin, k_out.data(), end - begin);
-        }
-        cb(out);
-    });
+    const std::string command = tensor_ids_.empty() ? json.dump() : std::string();
+    const int flags = is_state ? DataRequest::IsStateFlag : 0;
+    const int num_parts = GetMeta().GetPartitionCount();
+    std::vector<PSMessage> reqs;
+    reqs.reserve(num_parts);
+    for (int k = 0; k < num_parts; k++)
+    {
+        PSMessage req = std::make_shared<Message>();
+        req->GetMessageMeta().SetReceiver(ServerRankToNodeId(k));
+        if (tensor_ids_.empty())
+            req->GetMessageMeta().SetBody(command);
+        else
+            SetRequestHeader(req, DataRequestCommand::DensePull, flags, k);
+        reqs.push_back(req);
+    }
+    return reqs;
+}
+
+SmartArray<uint8_t> DenseTensor::CombinePullResponses(const std::vector<PSMessage>& ress, bool is_state) const
+{
+    const size_t name_hash = GetMeta().GetNameHash();
+    const size_t item_size = DataTypeToSize(GetMeta().GetDataType());
+    const size_t slice_items = SliceElements(is_state ? GetMeta().GetStateShape() : GetMeta().GetDataShape());
+    const size_t slice_length = item_size * slice_items;
+    const size_t total_items = TotalElements(is_state ? GetMeta().GetStateShape() : GetMeta().GetDataShape());
+    const size_t total_length = item_size * total_items;
+    const int num_parts = GetMeta().GetPartitionCount();
+    SmartArray<uint8_t> out(total_length);
+    for (int k = 0; k < num_parts; k++)
+    {
+        PSMessage res = ress.at(k);
+        SmartArray<uint8_t> k_out = res->GetTypedSlice(0, GetMeta().GetDataType());
+        const int sender = res->GetMessageMeta().GetSender();
+        const int rank = NodeIdToRank(sender);
+        size_t begin = 0;
+        size_t end = 0;
+        GetMeta().ComputePartitionShapesWithHash(name_hash, rank, begin, end, nullptr, nullptr);
+        begin *= slice_length;
+        end *= slice_length;
+        memcpy(out.data() + begin, k_out.data(), end - begin);
+    }
+    return out;
 }
 
 void DenseTensor::PushMeta(const DenseTensorMeta& meta, std::function<void()> cb)
@@ -327,4 +372,29 @@ std::string DenseTensor::GetDenseStatePath(const std::string& dir_path) const
     return file_path;
 }
 
+void DenseTensor::SetTensorIds(const std::vector<PSMessage>& ress)
+{
+    std::vector<int> ids(GetMeta().GetPartitionCount(), -1);
+    for (const PSMessage& res : ress)
+    {
+        const int rank = NodeIdToRank(res->GetMessageMeta().GetSender());
+        const int id = res->GetMessageMeta().GetDataRequest().GetTensorId();
+        if (rank < 0 || rank >= static_cast<int>(ids.size()) || id < 0)
+            return;
+        ids.at(rank) = id;
+    }
+    for (int id : ids)
+        if (id < 0)
+            return;
+    tensor_ids_ = std::move(ids);
+}
+
+void DenseTensor::SetRequestHeader(PSMessage req, DataRequestCommand command, int flags, int rank) const
+{
+    DataRequest& request = req->GetMessageMeta().GetDataRequest();
+    request.SetCommand(command);
+    request.SetTensorId(tensor_ids_.at(rank));
+    request.SetFlags(flags);
+}
+
 }
@@ -17,9 +17,11 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include <functional>
 #include <mindalpha/ps_agent.h>
 #include <mindalpha/smart_array.h>
+#include <mindalpha/data_request.h>
 #include <mindalpha/dense_tensor_meta.h>
 
 namespace mindalpha
@@ -27,6 +29,8 @@ namespace mindalpha
 
 class DenseTensor
 {
+    friend class TensorBatch;
+
 public:
     DenseTensorMeta& GetMeta() { return meta_; }
     const DenseTensorMeta& GetMeta() const { return meta_; }
@@ -35,6 +39,8 @@ public:
     std::shared_ptr<PSAgent> GetAgent() const { return agent_; }
     void SetAgent(std::shared_ptr<PSAgent> value) { agent_ = std::move(value); }
 
+    GradientEncoder& GetGradientEncoder() const { return gradient_encoder_; }
+
     void Init(std::function<void()> cb);
     void Dispose(std::function<void()> cb);
     void Push(SmartArray<uint8_t> in, std::function<void()> cb, bool is_value = false, bool is_state = false);
@@ -45,12 +51,29 @@ public:
     void Save(const std::string& dir_path, std::function<void()> cb);
 
 private:
+    // Build the requests of ``Push`` and ``Pull`` for every server and
+    // assemble the pulled tensor, so that ``TensorBatch`` can fuse them
+    // with the requests of other tensors.
+    std::vector<PSMessage> MakePushRequests(SmartArray<uint8_t> in, bool is_value, bool is_state) const;
+    std::vector<PSMessage> MakePullRequests(bool is_state) const;
+    SmartArray<uint8_t> CombinePullResponses(const std::vector<PSMessage>& ress, bool is_state) const;
+
+    // Ids the servers assigned to the tensor at init, indexed by server
+    // rank; empty if the tensor was not initialized by this object, in which
+    // case pulls and pushes fall back to JSON bodies.
+    void SetTensorIds(const std::vector<PSMessage>& ress);
+    void SetRequestHeader(PSMessage req, DataRequestCommand command, int flags, int rank) const;
+
     std::string GetDenseMetaPath(const std::string& dir_path) const;
     std::string GetDenseDataPath(const std::string& dir_path) const;
     std::string GetDenseStatePath(const std::string& dir_path) const;
 
     DenseTensorMeta meta_;
     std::shared_ptr<PSAgent> agent_;
+    std::vector<int> tensor_ids_;
+    // Pushing is logically const; the encoder only keeps the residuals of
+    // ``GradientCodec::TopK`` and the byte counters.
+    mutable GradientEncoder gradient_encoder_;
 };
 
 }
@@ -123,6 +123,19 @@ void DenseTensorMeta::CheckDenseTensorMeta(int index) const
         spdlog::error(serr);
         throw std::runtime_error(serr);
     }
+    if (IsHalfDataType(GetDataType()))
+    {
+        std::string serr;
+        serr.append("Dense tensor '");
+        serr.append(GetName());
+        serr.append("' can not be of data type ");
+        serr.append(DataTypeToString(GetDataType()));
+        serr.append("; half precision storage is supported by sparse tensors only.\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    CheckGradientCodec(GetName(), GetGradientCodec(), GetDataType(), true, GetGradientTopKRatio());
 }
 
 void DenseTensorMeta::ComputePartitionShapesWithHash(
@@ -209,11 +222,11 @@ void DenseTensorMeta::SetUpdaterByData(std::string data)
         py::object obj = mindalpha::deserialize_pyobject(data);
         MakeUpdaterReady(obj);
         std::shared_ptr<py::object> func = mindalpha::make_shared_pyobject(obj);
-        updater_ = [func](const std::string& name,
-                          mindalpha::SmartArray<uint8_t> param,
-                          mindalpha::SmartArray<uint8_t> grad,
-                          mindalpha::SmartArray<uint8_t> state,
-                          const DenseTensorMeta& meta)
+        DenseUpdater python_updater = [func](const std::string& name,
+                                             mindalpha::SmartArray<uint8_t> param,
+                                             mindalpha::SmartArray<uint8_t> grad,
+                                             mindalpha::SmartArray<uint8_t> state,
+                                             const DenseTensorMeta& meta)
         {
             // Some PyTorch operations such as ``grad.clone()`` and ``XXX + grad``
             // require memory alignment, we use ``SmartArray::Copy`` to use GLIBC allocated
@@ -243,6 +256,25 @@ void DenseTensorMeta::SetUpdaterByData(std::string data)
                         "state"_a=state_arr, "indices"_a=py::none(), "keys"_a=py::none());
             }
         };
+        std::shared_ptr<NativeUpdater> native = MakeNativeUpdater(obj);
+        if (!native)
+            updater_ = std::move(python_updater);
+        else
+        {
+            // Built-in updaters are applied in place without acquiring the GIL,
+            // layouts they don't expect fall back to the Python version.
+            updater_ = [native, python_updater](const std::string& name,
+                                                mindalpha::SmartArray<uint8_t> param,
+                                                mindalpha::SmartArray<uint8_t> grad,
+                                                mindalpha::SmartArray<uint8_t> state,
+                                                const DenseTensorMeta& meta)
+            {
+                if (native->IsSupported(meta))
+                    native->UpdateDense(param, grad, state, meta);
+                else
+                    python_updater(name, param, grad, state, meta);
+            };
+        }
         updater_object_ = std::move(func);
     }
 }
@@ -286,6 +318,8 @@ json11::Json DenseTensorMeta::to_json() const
         { "initializer_data", GetInitializerAsData() },
         { "updater_data", GetUpdaterAsData() },
         { "partition_count", partition_count_ },
+        { "gradient_codec", GradientCodecToString(gradient_codec_) },
+        { "gradient_top_k_ratio", gradient_top_k_ratio_ },
     };
 }
 
@@ -318,6 +352,12 @@ DenseTensorMeta DenseTensorMeta::FromJson(json11::Json json)
     meta.SetInitializerByData(json["initializer_data"].string_value());
     meta.SetUpdaterByData(json["updater_data"].string_value());
     meta.SetPartitionCount(json["partition_count"].int_value());
+    // Meta files saved before gradient codecs were introduced send raw gradients.
+    const std::string& codec = json["gradient_codec"].string_value();
+    if (!codec.empty())
+        meta.SetGradientCodec(GradientCodecFromString(codec));
+    if (json["gradient_top_k_ratio"].is_number())
+        meta.SetGradientTopKRatio(json["gradient_top_k_ratio"].number_value());
     return meta;
 }
 
@@ -336,7 +376,9 @@ bool DenseTensorMeta::operator==(const DenseTensorMeta& rhs) const
         && state_shape_ == rhs.state_shape_
         && GetInitializerAsData() == rhs.GetInitializerAsData()
         && GetUpdaterAsData() == rhs.GetUpdaterAsData()
-        && partition_count_ == rhs.partition_count_;
+        && partition_count_ == rhs.partition_count_
+        && gradient_codec_ == rhs.gradient_codec_
+        && gradient_top_k_ratio_ == rhs.gradient_top_k_ratio_;
 }
 
 }
@@ -23,6 +23,7 @@
 #include <any>
 #include <json11.hpp>
 #include <mindalpha/data_type.h>
+#include <mindalpha/gradient_codec.h>
 #include <mindalpha/smart_array.h>
 #include <mindalpha/string_utils.h>
 
@@ -63,6 +64,13 @@ public:
     int GetPartitionCount() const { return partition_count_; }
     void SetPartitionCount(int value) { partition_count_ = value; }
 
+    GradientCodec GetGradientCodec() const { return gradient_codec_; }
+    void SetGradientCodec(GradientCodec value) { gradient_codec_ = value; }
+
+    // Fraction of the items of a partition ``GradientCodec::TopK`` sends.
+    double GetGradientTopKRatio() const { return gradient_top_k_ratio_; }
+    void SetGradientTopKRatio(double value) { gradient_top_k_ratio_ = value; }
+
     void CheckDenseTensorMeta(int index) const;
 
     void ComputePartitionShapesWithHash(size_t hash, int index, size_t& begin, size_t& end,
@@ -103,6 +111,8 @@ private:
     std::any initializer_object_;
     std::any updater_object_;
     int partition_count_ = -1;
+    GradientCodec gradient_codec_ = GradientCodec::None;
+    double gradient_top_k_ratio_ = 0.01;
 };
 
 }
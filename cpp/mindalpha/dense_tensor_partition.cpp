@@ -65,7 +65,11 @@ void DenseTensorPartition::HandlePush(SmartArray<uint8_t> in, bool is_value, boo
 
 SmartArray<uint8_t> DenseTensorPartition::HandlePull(bool is_state)
 {
-    return is_state ? state_ : data_;
+    // Transports send slices without copying them and the in-process one
+    // hands them to the receiver as is, so the response must not share
+    // the buffer later pushes update in place.
+    const SmartArray<uint8_t>& out = is_state ? state_ : data_;
+    return out.Copy();
 }
 
 void DenseTensorPartition::HandlePushMeta(const DenseTensorMeta& meta)
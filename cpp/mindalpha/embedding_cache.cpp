@@ -0,0 +1,381 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <string.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <mindalpha/embedding_cache.h>
+#include <mindalpha/hashtable_helpers.h>
+#include <mindalpha/stack_trace_utils.h>
+
+namespace mindalpha
+{
+
+std::string CacheEvictionToString(CacheEviction eviction)
+{
+    switch (eviction)
+    {
+#undef MINDALPHA_CACHE_EVICTION_DEF
+#define MINDALPHA_CACHE_EVICTION_DEF(l, u) case CacheEviction::u: return #l;
+    MINDALPHA_CACHE_EVICTIONS(MINDALPHA_CACHE_EVICTION_DEF)
+    default:
+        std::string serr;
+        serr.append("Invalid CacheEviction enum value: ");
+        serr.append(std::to_string(static_cast<int>(eviction)));
+        serr.append(".\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+}
+
+CacheEviction CacheEvictionFromString(const std::string& str)
+{
+#undef MINDALPHA_CACHE_EVICTION_DEF
+#define MINDALPHA_CACHE_EVICTION_DEF(l, u) if (str == #l) return CacheEviction::u;
+    MINDALPHA_CACHE_EVICTIONS(MINDALPHA_CACHE_EVICTION_DEF)
+    std::string serr;
+    serr.append("Invalid CacheEviction enum value: ");
+    serr.append(str);
+    serr.append(".\n\n");
+    serr.append(GetStackTrace());
+    spdlog::error(serr);
+    throw std::runtime_error(serr);
+}
+
+void EmbeddingCache::Configure(size_t capacity, CacheEviction eviction, uint32_t admission_count,
+                               uint64_t max_staleness_steps, uint64_t max_staleness_ms)
+{
+    if (capacity > 0 && max_staleness_steps == 0 && max_staleness_ms == 0)
+    {
+        std::string serr;
+        serr.append("Embedding cache requires max_staleness_steps or max_staleness_ms ");
+        serr.append("to bound the staleness of cached rows.\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    if (capacity >= kNoSlot)
+    {
+        std::string serr;
+        serr.append("Embedding cache capacity ");
+        serr.append(std::to_string(capacity));
+        serr.append(" is too large.\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = capacity;
+    eviction_ = eviction;
+    admission_count_ = admission_count;
+    max_staleness_steps_ = max_staleness_steps;
+    max_staleness_ms_ = max_staleness_ms;
+    row_bytes_ = 0;
+    Reset();
+    enabled_ = capacity > 0;
+}
+
+void EmbeddingCache::Reset()
+{
+    // Rows pulled before the reset must not be cached by ``Fill``.
+    reset_step_ = ++step_;
+    slots_.clear();
+    slot_keys_.clear();
+    slot_steps_.clear();
+    slot_times_.clear();
+    prev_.clear();
+    next_.clear();
+    head_ = kNoSlot;
+    tail_ = kNoSlot;
+    free_slots_.clear();
+    rows_.clear();
+    sketch_.clear();
+    sketch_increments_ = 0;
+    push_steps_.clear();
+    if (capacity_ == 0)
+        return;
+    // About four counters per cached row keep the estimates of the
+    // frequent keys accurate.
+    const size_t width = HashtableHelpers::GetPowerBucketCount(std::max<size_t>(capacity_ * 4, 1024));
+    sketch_.assign(width * kSketchDepth, 0);
+    push_steps_.assign(width, 0);
+    slots_.reserve(capacity_);
+}
+
+uint64_t EmbeddingCache::NowMilliseconds()
+{
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t EmbeddingCache::CountKey(uint64_t key)
+{
+    const size_t width = sketch_.size() / kSketchDepth;
+    const uint64_t hash = HashtableHelpers::MixHash(key);
+    const uint64_t h1 = hash & 0xffffffff;
+    const uint64_t h2 = hash >> 32;
+    // Conservative update: only the smallest counters are incremented, which
+    // limits the overestimation caused by collisions.
+    uint32_t estimate = UINT8_MAX;
+    for (int d = 0; d < kSketchDepth; d++)
+        estimate = std::min<uint32_t>(estimate, sketch_[d * width + ((h1 + d * h2) & (width - 1))]);
+    if (estimate < UINT8_MAX)
+    {
+        for (int d = 0; d < kSketchDepth; d++)
+        {
+            uint8_t& counter = sketch_[d * width + ((h1 + d * h2) & (width - 1))];
+            if (counter == estimate)
+                counter++;
+        }
+        estimate++;
+    }
+    // Halve the counters every ``10 * width`` lookups, so that keys which
+    // stopped appearing lose their advantage.
+    if (++sketch_increments_ >= 10 * width)
+    {
+        for (uint8_t& counter : sketch_)
+            counter >>= 1;
+        sketch_increments_ = 0;
+    }
+    return estimate;
+}
+
+uint32_t EmbeddingCache::EstimateKey(uint64_t key) const
+{
+    const size_t width = sketch_.size() / kSketchDepth;
+    const uint64_t hash = HashtableHelpers::MixHash(key);
+    const uint64_t h1 = hash & 0xffffffff;
+    const uint64_t h2 = hash >> 32;
+    uint32_t estimate = UINT8_MAX;
+    for (int d = 0; d < kSketchDepth; d++)
+        estimate = std::min<uint32_t>(estimate, sketch_[d * width + ((h1 + d * h2) & (width - 1))]);
+    return estimate;
+}
+
+bool EmbeddingCache::IsFresh(uint32_t slot, uint64_t now) const
+{
+    if (max_staleness_steps_ > 0 && step_ - slot_steps_[slot] >= max_staleness_steps_)
+        return false;
+    if (max_staleness_ms_ > 0 && now - slot_times_[slot] >= max_staleness_ms_)
+        return false;
+    return true;
+}
+
+uint64_t& EmbeddingCache::PushStep(uint64_t key)
+{
+    return push_steps_[HashtableHelpers::MixHash(key) & (push_steps_.size() - 1)];
+}
+
+void EmbeddingCache::Unlink(uint32_t slot)
+{
+    const uint32_t p = prev_[slot];
+    const uint32_t n = next_[slot];
+    if (p != kNoSlot)
+        next_[p] = n;
+    else
+        head_ = n;
+    if (n != kNoSlot)
+        prev_[n] = p;
+    else
+        tail_ = p;
+}
+
+void EmbeddingCache::PushFront(uint32_t slot)
+{
+    prev_[slot] = kNoSlot;
+    next_[slot] = head_;
+    if (head_ != kNoSlot)
+        prev_[head_] = slot;
+    head_ = slot;
+    if (tail_ == kNoSlot)
+        tail_ = slot;
+}
+
+void EmbeddingCache::Touch(uint32_t slot)
+{
+    if (head_ == slot)
+        return;
+    Unlink(slot);
+    PushFront(slot);
+}
+
+void EmbeddingCache::Remove(uint32_t slot)
+{
+    slots_.erase(slot_keys_[slot]);
+    Unlink(slot);
+    free_slots_.push_back(slot);
+}
+
+uint32_t EmbeddingCache::Allocate()
+{
+    if (!free_slots_.empty())
+    {
+        const uint32_t slot = free_slots_.back();
+        free_slots_.pop_back();
+        return slot;
+    }
+    if (slot_keys_.size() < capacity_)
+    {
+        const uint32_t slot = static_cast<uint32_t>(slot_keys_.size());
+        slot_keys_.push_back(0);
+        slot_steps_.push_back(0);
+        slot_times_.push_back(0);
+        prev_.push_back(kNoSlot);
+        next_.push_back(kNoSlot);
+        rows_.resize(rows_.size() + row_bytes_);
+        return slot;
+    }
+    uint32_t victim = tail_;
+    if (eviction_ == CacheEviction::Lfu)
+    {
+        // Sample a few slots rather than keeping the slots ordered by
+        // frequency, whose estimates change on every lookup.
+        uint32_t lowest = UINT32_MAX;
+        for (int i = 0; i < kEvictionSamples; i++)
+        {
+            random_state_ ^= random_state_ << 13;
+            random_state_ ^= random_state_ >> 7;
+            random_state_ ^= random_state_ << 17;
+            const uint32_t slot = static_cast<uint32_t>(random_state_ % slot_keys_.size());
+            const uint32_t estimate = EstimateKey(slot_keys_[slot]);
+            if (estimate < lowest)
+            {
+                lowest = estimate;
+                victim = slot;
+            }
+        }
+    }
+    Remove(victim);
+    free_slots_.pop_back();
+    return victim;
+}
+
+std::vector<size_t> EmbeddingCache::Lookup(const uint64_t* keys, size_t count, size_t row_bytes,
+                                           uint8_t* out, uint64_t& step)
+{
+    std::vector<size_t> misses;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (row_bytes_ != row_bytes)
+    {
+        row_bytes_ = row_bytes;
+        Reset();
+    }
+    step = step_;
+    const uint64_t now = max_staleness_ms_ > 0 ? NowMilliseconds() : 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        const uint64_t key = keys[i];
+        CountKey(key);
+        auto it = slots_.find(key);
+        if (it != slots_.end())
+        {
+            const uint32_t slot = it->second;
+            if (IsFresh(slot, now))
+            {
+                memcpy(out + i * row_bytes, rows_.data() + slot * row_bytes, row_bytes);
+                Touch(slot);
+                continue;
+            }
+            Remove(slot);
+        }
+        misses.push_back(i);
+    }
+    const size_t hits = count - misses.size();
+    hits_ += hits;
+    misses_ += misses.size();
+    bytes_saved_ += hits * (sizeof(uint64_t) + row_bytes);
+    return misses;
+}
+
+void EmbeddingCache::Fill(const uint64_t* keys, const std::vector<size_t>& misses, const uint8_t* rows,
+                          size_t row_bytes, uint8_t* out, uint64_t step, bool admit)
+{
+    for (size_t j = 0; j < misses.size(); j++)
+        memcpy(out + misses[j] * row_bytes, rows + j * row_bytes, row_bytes);
+    if (!admit)
+        return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (step < reset_step_ || capacity_ == 0 || row_bytes != row_bytes_)
+        return;
+    const uint64_t now = NowMilliseconds();
+    for (size_t j = 0; j < misses.size(); j++)
+    {
+        const uint64_t key = keys[misses[j]];
+        if (PushStep(key) > step || EstimateKey(key) < admission_count_)
+            continue;
+        uint32_t slot;
+        auto it = slots_.find(key);
+        if (it != slots_.end())
+        {
+            slot = it->second;
+            Touch(slot);
+        }
+        else
+        {
+            slot = Allocate();
+            slot_keys_[slot] = key;
+            slots_.emplace(key, slot);
+            PushFront(slot);
+        }
+        // The row is as old as the pull, not as the last push.
+        slot_steps_[slot] = step;
+        slot_times_[slot] = now;
+        memcpy(rows_.data() + slot * row_bytes, rows + j * row_bytes, row_bytes);
+    }
+}
+
+void EmbeddingCache::Invalidate(const uint64_t* keys, size_t count)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    step_++;
+    if (push_steps_.empty())
+        return;
+    for (size_t i = 0; i < count; i++)
+    {
+        PushStep(keys[i]) = step_;
+        auto it = slots_.find(keys[i]);
+        if (it != slots_.end())
+            Remove(it->second);
+    }
+}
+
+void EmbeddingCache::InvalidateAll()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Reset();
+}
+
+double EmbeddingCache::GetHitRate() const
+{
+    const uint64_t hits = hits_.load();
+    const uint64_t total = hits + misses_.load();
+    if (total == 0)
+        return 0.0;
+    return static_cast<double>(hits) / static_cast<double>(total);
+}
+
+void EmbeddingCache::ResetCounters()
+{
+    hits_ = 0;
+    misses_ = 0;
+    bytes_saved_ = 0;
+}
+
+}
@@ -0,0 +1,161 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//
+// ``embedding_cache.h`` defines class ``EmbeddingCache`` which keeps
+// recently pulled rows of a sparse tensor on a worker, so that the keys
+// appearing in nearly every minibatch are not pulled from their server
+// every time.
+//
+// Cached rows are at most ``max_staleness_steps`` pushes or
+// ``max_staleness_ms`` milliseconds old, and are dropped when the worker
+// pushes their keys. Rows of keys the worker pushes while they are being
+// pulled, and rows of read only pulls, are not cached. Rows pushed by
+// other workers are seen once the staleness bound expires. A key is cached only after it was looked up
+// ``admission_count`` times, counted in a small count-min sketch whose
+// counters are halved periodically, so that one-off keys do not evict
+// frequent ones.
+//
+
+namespace mindalpha
+{
+
+//
+// Use the X Macro technique to simplify code. See the following page
+// for more information about X Macros:
+//
+//   https://en.wikipedia.org/wiki/X_Macro
+//
+// ``Lru`` evicts the least recently used row. ``Lfu`` evicts the least
+// frequent of a few sampled rows according to the sketch.
+//
+
+#define MINDALPHA_CACHE_EVICTIONS(X)           \
+    X(lru, Lru)                                \
+    X(lfu, Lfu)                                \
+    /**/
+
+enum class CacheEviction
+{
+#undef MINDALPHA_CACHE_EVICTION_DEF
+#define MINDALPHA_CACHE_EVICTION_DEF(l, u) u,
+    MINDALPHA_CACHE_EVICTIONS(MINDALPHA_CACHE_EVICTION_DEF)
+};
+
+// Functions to convert ``CacheEviction`` to and from strings.
+std::string CacheEvictionToString(CacheEviction eviction);
+CacheEviction CacheEvictionFromString(const std::string& str);
+
+class EmbeddingCache
+{
+public:
+    // A ``capacity`` of 0 disables the cache and drops the cached rows.
+    void Configure(size_t capacity, CacheEviction eviction, uint32_t admission_count,
+                   uint64_t max_staleness_steps, uint64_t max_staleness_ms);
+
+    bool IsEnabled() const { return enabled_.load(); }
+
+    // Copy the cached rows of ``row_bytes`` of ``keys`` to ``out`` and
+    // return the positions of the keys which must be pulled. ``step`` is
+    // set to pass to ``Fill``.
+    std::vector<size_t> Lookup(const uint64_t* keys, size_t count, size_t row_bytes,
+                               uint8_t* out, uint64_t& step);
+
+    // Copy ``rows`` pulled for the keys at positions ``misses`` to ``out``
+    // and, if ``admit`` is true, cache those admitted. Keys the worker
+    // pushed since ``Lookup`` are not cached, as their pulled rows may
+    // predate the push. Read only pulls pass false for ``admit``, since
+    // servers answer them with zero rows for keys they don't have.
+    void Fill(const uint64_t* keys, const std::vector<size_t>& misses, const uint8_t* rows,
+              size_t row_bytes, uint8_t* out, uint64_t step, bool admit);
+
+    // Drop the rows of the keys the worker pushes and count one step.
+    void Invalidate(const uint64_t* keys, size_t count);
+
+    // Drop all rows, for example when the tensor is cleared or loaded.
+    void InvalidateAll();
+
+    // Keys served from the cache and pulled from servers, and the bytes of
+    // keys and rows not sent because of hits.
+    uint64_t GetHits() const { return hits_.load(); }
+    uint64_t GetMisses() const { return misses_.load(); }
+    uint64_t GetBytesSaved() const { return bytes_saved_.load(); }
+    double GetHitRate() const;
+    void ResetCounters();
+
+private:
+    static constexpr uint32_t kNoSlot = uint32_t(-1);
+    static constexpr int kSketchDepth = 4;
+    static constexpr int kEvictionSamples = 8;
+
+    static uint64_t NowMilliseconds();
+
+    void Reset();
+    uint32_t CountKey(uint64_t key);
+    uint32_t EstimateKey(uint64_t key) const;
+    bool IsFresh(uint32_t slot, uint64_t now) const;
+    uint64_t& PushStep(uint64_t key);
+    void PushFront(uint32_t slot);
+    void Touch(uint32_t slot);
+    void Unlink(uint32_t slot);
+    void Remove(uint32_t slot);
+    uint32_t Allocate();
+
+    std::mutex mutex_;
+    std::atomic<bool> enabled_{false};
+    size_t capacity_ = 0;
+    CacheEviction eviction_ = CacheEviction::Lru;
+    uint32_t admission_count_ = 1;
+    uint64_t max_staleness_steps_ = 0;
+    uint64_t max_staleness_ms_ = 0;
+    size_t row_bytes_ = 0;
+    uint64_t step_ = 0;
+    // Steps of ``Reset`` and of the last push of each key, hashed into a
+    // fixed number of entries. Colliding keys share an entry, which only
+    // keeps more rows out of the cache.
+    uint64_t reset_step_ = 0;
+    std::vector<uint64_t> push_steps_;
+    std::unordered_map<uint64_t, uint32_t> slots_;
+    std::vector<uint64_t> slot_keys_;
+    std::vector<uint64_t> slot_steps_;
+    std::vector<uint64_t> slot_times_;
+    // Doubly linked list of the slots from the most to the least recently used.
+    std::vector<uint32_t> prev_;
+    std::vector<uint32_t> next_;
+    uint32_t head_ = kNoSlot;
+    uint32_t tail_ = kNoSlot;
+    std::vector<uint32_t> free_slots_;
+    std::vector<uint8_t> rows_;
+    std::vector<uint8_t> sketch_;
+    uint64_t sketch_increments_ = 0;
+    uint64_t random_state_ = 0x9e3779b97f4a7c15;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> bytes_saved_{0};
+};
+
+}
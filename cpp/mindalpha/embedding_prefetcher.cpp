@@ -0,0 +1,182 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <stdexcept>
+#include <spdlog/spdlog.h>
+#include <mindalpha/stack_trace_utils.h>
+#include <mindalpha/hash_uniquifier.h>
+#include <mindalpha/ps_agent.h>
+#include <mindalpha/embedding_prefetcher.h>
+
+namespace mindalpha
+{
+
+struct EmbeddingPrefetcher::Task
+{
+    std::shared_ptr<SparseTensor> tensor;
+    std::shared_ptr<const CombineSchema> schema;
+    std::shared_ptr<const IndexBatch> batch;
+    bool feature_offset;
+    bool read_only;
+    bool nan_fill;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+    std::exception_ptr error;
+    PrefetchResult result;
+};
+
+EmbeddingPrefetcher::EmbeddingPrefetcher(size_t depth)
+    : depth_(depth)
+{
+    if (depth_ == 0)
+    {
+        std::string serr;
+        serr.append("prefetch depth must be positive.\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    thread_ = std::thread([this] { Execute(); });
+}
+
+EmbeddingPrefetcher::~EmbeddingPrefetcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+    // Pulls still in flight are not waited for, as this may run with the
+    // GIL held while their completion thread needs it. Their callbacks own
+    // the tasks, which keep the tensors alive until the pulls complete.
+}
+
+size_t EmbeddingPrefetcher::GetPendingCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tasks_.size();
+}
+
+void EmbeddingPrefetcher::Submit(std::shared_ptr<SparseTensor> tensor,
+                                 std::shared_ptr<const CombineSchema> schema,
+                                 std::shared_ptr<const IndexBatch> batch,
+                                 bool feature_offset, bool read_only, bool nan_fill)
+{
+    auto task = std::make_shared<Task>();
+    task->tensor = std::move(tensor);
+    task->schema = std::move(schema);
+    task->batch = std::move(batch);
+    task->feature_offset = feature_offset;
+    task->read_only = read_only;
+    task->nan_fill = nan_fill;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    cv_.notify_all();
+}
+
+PrefetchResult EmbeddingPrefetcher::Take()
+{
+    std::shared_ptr<Task> task;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (tasks_.empty())
+        {
+            std::string serr;
+            serr.append("no minibatch is prefetched; call Submit before Take.\n\n");
+            serr.append(GetStackTrace());
+            spdlog::error(serr);
+            throw std::runtime_error(serr);
+        }
+        task = tasks_.front();
+    }
+    {
+        std::unique_lock<std::mutex> lock(task->mutex);
+        task->cv.wait(lock, [&task] { return task->done; });
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.pop_front();
+        started_--;
+    }
+    cv_.notify_all();
+    task->tensor.reset();
+    task->schema.reset();
+    task->batch.reset();
+    if (task->error)
+        std::rethrow_exception(task->error);
+    return std::move(task->result);
+}
+
+void EmbeddingPrefetcher::Execute()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;)
+    {
+        cv_.wait(lock, [this] {
+            return stopping_ || (started_ < tasks_.size() && started_ < depth_);
+        });
+        if (stopping_)
+            break;
+        std::shared_ptr<Task> task = tasks_.at(started_++);
+        lock.unlock();
+        Run(task);
+        task.reset();
+        lock.lock();
+    }
+}
+
+void EmbeddingPrefetcher::Run(const std::shared_ptr<Task>& task)
+{
+    try
+    {
+        PrefetchResult& result = task->result;
+        auto [indices, offsets] = task->schema->CombineToIndicesAndOffsets(*task->batch, task->feature_offset);
+        SmartArray<uint64_t> keys = SmartArray<uint64_t>::Wrap(HashUniquifier::Uniquify(indices));
+        const SparseTensorMeta& meta = task->tensor->GetMeta();
+        result.indices = std::move(indices);
+        result.offsets = std::move(offsets);
+        result.keys = keys;
+        result.data_type = meta.GetDataType();
+        result.slice_data_shape = meta.GetSliceDataShape();
+        PSAgent::ErrorScope scope([task](std::exception_ptr error) { Finish(*task, error, {}); });
+        task->tensor->Pull(keys.Cast<uint8_t>(), [task](SmartArray<uint8_t> out)
+        {
+            Finish(*task, nullptr, std::move(out));
+        }, task->read_only, task->nan_fill);
+    }
+    catch (...)
+    {
+        Finish(*task, std::current_exception(), {});
+    }
+}
+
+void EmbeddingPrefetcher::Finish(Task& task, std::exception_ptr error, SmartArray<uint8_t> data)
+{
+    std::lock_guard<std::mutex> lock(task.mutex);
+    if (task.done)
+        return;
+    task.error = std::move(error);
+    task.result.data = std::move(data);
+    task.done = true;
+    task.cv.notify_all();
+}
+
+}
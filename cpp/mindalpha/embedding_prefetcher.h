@@ -0,0 +1,107 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <mindalpha/smart_array.h>
+#include <mindalpha/data_type.h>
+#include <mindalpha/combine_schema.h>
+#include <mindalpha/index_batch.h>
+#include <mindalpha/sparse_tensor.h>
+
+//
+// ``embedding_prefetcher.h`` defines class ``EmbeddingPrefetcher`` which
+// prepares the sparse features of future minibatches on a background
+// thread, so that combining, uniquifying and pulling them overlap with
+// the computation of the current minibatch.
+//
+// Tasks are taken in the order they were submitted. At most ``depth``
+// tasks are started and not yet taken, which bounds both the memory held
+// by prefetched rows and their staleness: rows of a task may miss the
+// updates pushed by up to ``depth`` tasks before it.
+//
+// The background thread never touches Python objects. The objects passed
+// to ``Submit`` are released by ``Take`` or by the destructor, on the
+// calling thread, except those of pulls still in flight when the
+// prefetcher is destroyed, which are released on completion.
+//
+
+namespace mindalpha
+{
+
+struct PrefetchResult
+{
+    // Feature hash codes replaced by the positions of their keys in
+    // ``keys``, as ``HashUniquifier::Uniquify`` leaves them.
+    std::vector<uint64_t> indices;
+    std::vector<uint64_t> offsets;
+    SmartArray<uint64_t> keys;
+    SmartArray<uint8_t> data;
+    DataType data_type;
+    std::vector<size_t> slice_data_shape;
+};
+
+class __attribute__((visibility("hidden"))) EmbeddingPrefetcher
+{
+public:
+    explicit EmbeddingPrefetcher(size_t depth);
+    ~EmbeddingPrefetcher();
+
+    EmbeddingPrefetcher(const EmbeddingPrefetcher&) = delete;
+    EmbeddingPrefetcher& operator=(const EmbeddingPrefetcher&) = delete;
+
+    size_t GetDepth() const { return depth_; }
+    size_t GetPendingCount() const;
+
+    // Queue ``batch`` to be combined by ``schema`` and pulled from
+    // ``tensor``. Returns without waiting for the background thread.
+    void Submit(std::shared_ptr<SparseTensor> tensor,
+                std::shared_ptr<const CombineSchema> schema,
+                std::shared_ptr<const IndexBatch> batch,
+                bool feature_offset, bool read_only, bool nan_fill);
+
+    // Wait for the oldest submitted task and return its result. Failures
+    // of the task are rethrown here. Only one thread may call ``Take``.
+    PrefetchResult Take();
+
+private:
+    struct Task;
+
+    void Execute();
+    void Run(const std::shared_ptr<Task>& task);
+    static void Finish(Task& task, std::exception_ptr error, SmartArray<uint8_t> data);
+
+    const size_t depth_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    // Submitted tasks not yet taken; the first ``started_`` ones were
+    // handed to the background thread.
+    std::deque<std::shared_ptr<Task>> tasks_;
+    size_t started_ = 0;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+}
@@ -0,0 +1,124 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+//
+// ``float16.h`` defines the half precision types ``float16`` (IEEE 754
+// binary16) and ``bfloat16`` (the upper half of a ``float``). They are
+// storage formats only: values are converted to ``float`` for arithmetic
+// and rounded to nearest even when stored back.
+//
+
+namespace mindalpha
+{
+
+inline uint16_t FloatToHalfBits(float value)
+{
+    uint32_t x;
+    memcpy(&x, &value, sizeof(x));
+    const uint16_t sign = static_cast<uint16_t>((x >> 16) & 0x8000);
+    x &= 0x7FFFFFFF;
+    if (x >= 0x7F800000)
+        return sign | 0x7C00 | (x > 0x7F800000 ? 0x200 : 0);
+    // At least 65520 rounds to infinity.
+    if (x >= 0x477FF000)
+        return sign | 0x7C00;
+    if (x < 0x38800000)
+    {
+        // Subnormal halves; less than 2^-25 rounds to zero.
+        if (x < 0x33000000)
+            return sign;
+        const uint32_t shift = 126 - (x >> 23);
+        const uint32_t m = (x & 0x7FFFFF) | 0x800000;
+        uint32_t h = m >> shift;
+        const uint32_t rem = m & ((1u << shift) - 1);
+        const uint32_t half = 1u << (shift - 1);
+        if (rem > half || (rem == half && (h & 1)))
+            h++;
+        return sign | static_cast<uint16_t>(h);
+    }
+    uint32_t h = (x - 0x38000000) >> 13;
+    const uint32_t rem = x & 0x1FFF;
+    if (rem > 0x1000 || (rem == 0x1000 && (h & 1)))
+        h++;
+    return sign | static_cast<uint16_t>(h);
+}
+
+inline float HalfBitsToFloat(uint16_t h)
+{
+    const uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+    const uint32_t e = (h >> 10) & 0x1F;
+    const uint32_t m = h & 0x3FF;
+    uint32_t x;
+    if (e == 0x1F)
+        x = sign | 0x7F800000 | (m << 13);
+    else if (e != 0)
+        x = sign | ((e + 112) << 23) | (m << 13);
+    else
+    {
+        const float f = static_cast<float>(m) * (1.0f / 16777216.0f);
+        memcpy(&x, &f, sizeof(x));
+        x |= sign;
+    }
+    float f;
+    memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+inline uint16_t FloatToBFloat16Bits(float value)
+{
+    uint32_t x;
+    memcpy(&x, &value, sizeof(x));
+    if ((x & 0x7FFFFFFF) > 0x7F800000)
+        return static_cast<uint16_t>((x >> 16) | 0x40);
+    x += 0x7FFF + ((x >> 16) & 1);
+    return static_cast<uint16_t>(x >> 16);
+}
+
+inline float BFloat16BitsToFloat(uint16_t h)
+{
+    const uint32_t x = static_cast<uint32_t>(h) << 16;
+    float f;
+    memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+struct float16
+{
+    uint16_t bits;
+
+    float16() = default;
+    explicit float16(float value) : bits(FloatToHalfBits(value)) { }
+    operator float() const { return HalfBitsToFloat(bits); }
+};
+
+struct bfloat16
+{
+    uint16_t bits;
+
+    bfloat16() = default;
+    explicit bfloat16(float value) : bits(FloatToBFloat16Bits(value)) { }
+    operator float() const { return BFloat16BitsToFloat(bits); }
+};
+
+static_assert(sizeof(float16) == 2 && sizeof(bfloat16) == 2, "half types must be 2 bytes");
+
+}
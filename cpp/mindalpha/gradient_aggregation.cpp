@@ -0,0 +1,206 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <string.h>
+#include <spdlog/spdlog.h>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include <mindalpha/gradient_aggregation.h>
+#include <mindalpha/hash_uniquifier.h>
+#include <mindalpha/stack_trace_utils.h>
+
+namespace mindalpha
+{
+
+std::string GradientAggregationToString(GradientAggregation aggregation)
+{
+    switch (aggregation)
+    {
+#undef MINDALPHA_GRADIENT_AGGREGATION_DEF
+#define MINDALPHA_GRADIENT_AGGREGATION_DEF(l, u) case GradientAggregation::u: return #l;
+    MINDALPHA_GRADIENT_AGGREGATIONS(MINDALPHA_GRADIENT_AGGREGATION_DEF)
+    default:
+        std::string serr;
+        serr.append("Invalid GradientAggregation enum value: ");
+        serr.append(std::to_string(static_cast<int>(aggregation)));
+        serr.append(".\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+}
+
+GradientAggregation GradientAggregationFromString(const std::string& str)
+{
+#undef MINDALPHA_GRADIENT_AGGREGATION_DEF
+#define MINDALPHA_GRADIENT_AGGREGATION_DEF(l, u) if (str == #l) return GradientAggregation::u;
+    MINDALPHA_GRADIENT_AGGREGATIONS(MINDALPHA_GRADIENT_AGGREGATION_DEF)
+    std::string serr;
+    serr.append("Invalid GradientAggregation enum value: ");
+    serr.append(str);
+    serr.append(".\n\n");
+    serr.append(GetStackTrace());
+    spdlog::error(serr);
+    throw std::runtime_error(serr);
+}
+
+void CheckGradientAggregation(const std::string& name, GradientAggregation aggregation, DataType type)
+{
+    if (aggregation == GradientAggregation::None)
+        return;
+    if (type != DataType::Float32 && type != DataType::Float64 && !IsHalfDataType(type))
+    {
+        std::string serr;
+        serr.append("Gradient aggregation '");
+        serr.append(GradientAggregationToString(aggregation));
+        serr.append("' of tensor '");
+        serr.append(name);
+        serr.append("' requires floating point data, but the data type is ");
+        serr.append(NullableDataTypeToString(type));
+        serr.append(".\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+}
+
+namespace
+{
+
+// Accumulate row ``i`` of ``in`` into row ``offsets[i]`` of ``acc``. The
+// inner loops have no aliasing and no branches so that they vectorize.
+template<typename T, typename A>
+void SumRows(const uint64_t* offsets, size_t count, const T* in, A* acc, size_t row_items)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        A* __restrict dst = acc + offsets[i] * row_items;
+        const T* __restrict src = in + i * row_items;
+        for (size_t j = 0; j < row_items; j++)
+            dst[j] += static_cast<A>(src[j]);
+    }
+}
+
+template<typename A>
+void DivideRows(const uint64_t* offsets, size_t count, A* acc, size_t unique_count, size_t row_items)
+{
+    std::vector<uint32_t> repeats(unique_count, 0);
+    for (size_t i = 0; i < count; i++)
+        repeats[offsets[i]]++;
+    for (size_t u = 0; u < unique_count; u++)
+    {
+        A* __restrict dst = acc + u * row_items;
+        const A scale = static_cast<A>(1) / static_cast<A>(repeats[u]);
+        for (size_t j = 0; j < row_items; j++)
+            dst[j] *= scale;
+    }
+}
+
+// Half precision rows are accumulated in ``float`` and rounded once at
+// the end, so that summing many rows does not lose precision.
+template<typename T>
+SmartArray<uint8_t> CombineRows(const std::vector<uint64_t>& offsets, size_t unique_count,
+                                const uint8_t* in, size_t row_items, bool mean)
+{
+    using A = typename StateTypeOf<T>::type;
+    const size_t count = offsets.size();
+    const size_t item_count = unique_count * row_items;
+    const T* const src = reinterpret_cast<const T*>(in);
+    SmartArray<uint8_t> out(item_count * sizeof(T));
+    T* const dst = reinterpret_cast<T*>(out.data());
+    if constexpr (std::is_same_v<A, T>)
+    {
+        memset(dst, 0, item_count * sizeof(T));
+        SumRows(offsets.data(), count, src, dst, row_items);
+        if (mean)
+            DivideRows(offsets.data(), count, dst, unique_count, row_items);
+    }
+    else
+    {
+        std::vector<A> acc(item_count, static_cast<A>(0));
+        SumRows(offsets.data(), count, src, acc.data(), row_items);
+        if (mean)
+            DivideRows(offsets.data(), count, acc.data(), unique_count, row_items);
+        for (size_t j = 0; j < item_count; j++)
+            dst[j] = static_cast<T>(acc[j]);
+    }
+    return out;
+}
+
+}
+
+void GradientAggregator::Aggregate(GradientAggregation aggregation, DataType type,
+                                   SmartArray<uint8_t>& keys, SmartArray<uint8_t>& in, size_t row_items)
+{
+    if (aggregation == GradientAggregation::None)
+        return;
+    const size_t count = keys.size() / sizeof(uint64_t);
+    input_keys_ += count;
+    const uint64_t* const k = reinterpret_cast<const uint64_t*>(keys.data());
+    std::vector<uint64_t> offsets(k, k + count);
+    std::vector<uint64_t> unique = HashUniquifier::Uniquify(offsets);
+    const size_t unique_count = unique.size();
+    unique_keys_ += unique_count;
+    if (unique_count == count)
+        return;
+    const bool mean = aggregation == GradientAggregation::Mean;
+    SmartArray<uint8_t> out;
+    switch (type)
+    {
+    case DataType::Float32:
+        out = CombineRows<float>(offsets, unique_count, in.data(), row_items, mean);
+        break;
+    case DataType::Float64:
+        out = CombineRows<double>(offsets, unique_count, in.data(), row_items, mean);
+        break;
+    case DataType::Float16:
+        out = CombineRows<float16>(offsets, unique_count, in.data(), row_items, mean);
+        break;
+    case DataType::BFloat16:
+        out = CombineRows<bfloat16>(offsets, unique_count, in.data(), row_items, mean);
+        break;
+    default:
+        std::string serr;
+        serr.append("Gradient aggregation '");
+        serr.append(GradientAggregationToString(aggregation));
+        serr.append("' does not support data type ");
+        serr.append(DataTypeToString(type));
+        serr.append(".\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    keys = SmartArray<uint8_t>::Wrap(std::move(unique));
+    in = std::move(out);
+}
+
+double GradientAggregator::GetDedupRatio() const
+{
+    const uint64_t unique = unique_keys_.load();
+    if (unique == 0)
+        return 1.0;
+    return static_cast<double>(input_keys_.load()) / static_cast<double>(unique);
+}
+
+void GradientAggregator::ResetCounters()
+{
+    input_keys_ = 0;
+    unique_keys_ = 0;
+}
+
+}
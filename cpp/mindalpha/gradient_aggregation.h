@@ -0,0 +1,84 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <mindalpha/data_type.h>
+#include <mindalpha/smart_array.h>
+
+//
+// ``gradient_aggregation.h`` defines enum ``GradientAggregation`` to
+// represent how workers combine the gradient rows of duplicate keys
+// before pushing a sparse tensor, and class ``GradientAggregator`` which
+// does the combining.
+//
+
+namespace mindalpha
+{
+
+//
+// ``None`` pushes the rows as given. ``Sum`` and ``Mean`` send every key
+// once with the sum or the mean of its rows, which is what the updaters
+// on the servers would see if the duplicate rows were summed there.
+//
+
+#define MINDALPHA_GRADIENT_AGGREGATIONS(X)     \
+    X(none, None)                              \
+    X(sum,  Sum)                               \
+    X(mean, Mean)                              \
+    /**/
+
+enum class GradientAggregation
+{
+#undef MINDALPHA_GRADIENT_AGGREGATION_DEF
+#define MINDALPHA_GRADIENT_AGGREGATION_DEF(l, u) u,
+    MINDALPHA_GRADIENT_AGGREGATIONS(MINDALPHA_GRADIENT_AGGREGATION_DEF)
+};
+
+// Functions to convert ``GradientAggregation`` to and from strings.
+std::string GradientAggregationToString(GradientAggregation aggregation);
+GradientAggregation GradientAggregationFromString(const std::string& str);
+
+// Throw if ``aggregation`` can not be used for the gradients of tensor ``name``.
+void CheckGradientAggregation(const std::string& name, GradientAggregation aggregation, DataType type);
+
+class GradientAggregator
+{
+public:
+    // Combine the rows of ``row_items`` items in ``in`` whose keys repeat
+    // in ``keys``. ``keys`` and ``in`` are replaced by the unique keys in
+    // order of first occurrence and their combined rows; they are kept
+    // as is when ``aggregation`` is ``None`` or no key repeats.
+    void Aggregate(GradientAggregation aggregation, DataType type,
+                   SmartArray<uint8_t>& keys, SmartArray<uint8_t>& in, size_t row_items);
+
+    // Keys given to ``Aggregate`` and keys left after it; their ratio is
+    // the factor by which pushed rows were reduced.
+    uint64_t GetInputKeys() const { return input_keys_.load(); }
+    uint64_t GetUniqueKeys() const { return unique_keys_.load(); }
+    double GetDedupRatio() const;
+    void ResetCounters();
+
+private:
+    std::atomic<uint64_t> input_keys_{0};
+    std::atomic<uint64_t> unique_keys_{0};
+};
+
+}
@@ -0,0 +1,342 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <math.h>
+#include <string.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <mindalpha/gradient_codec.h>
+#include <mindalpha/stack_trace_utils.h>
+
+namespace mindalpha
+{
+
+std::string GradientCodecToString(GradientCodec codec)
+{
+    switch (codec)
+    {
+#undef MINDALPHA_GRADIENT_CODEC_DEF
+#define MINDALPHA_GRADIENT_CODEC_DEF(l, u) case GradientCodec::u: return #l;
+    MINDALPHA_GRADIENT_CODECS(MINDALPHA_GRADIENT_CODEC_DEF)
+    default:
+        std::string serr;
+        serr.append("Invalid GradientCodec enum value: ");
+        serr.append(std::to_string(static_cast<int>(codec)));
+        serr.append(".\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+}
+
+GradientCodec GradientCodecFromString(const std::string& str)
+{
+#undef MINDALPHA_GRADIENT_CODEC_DEF
+#define MINDALPHA_GRADIENT_CODEC_DEF(l, u) if (str == #l) return GradientCodec::u;
+    MINDALPHA_GRADIENT_CODECS(MINDALPHA_GRADIENT_CODEC_DEF)
+    std::string serr;
+    serr.append("Invalid GradientCodec enum value: ");
+    serr.append(str);
+    serr.append(".\n\n");
+    serr.append(GetStackTrace());
+    spdlog::error(serr);
+    throw std::runtime_error(serr);
+}
+
+void CheckGradientCodec(const std::string& name, GradientCodec codec, DataType type,
+                        bool is_dense, double top_k_ratio)
+{
+    if (codec == GradientCodec::None)
+        return;
+    if (type != DataType::Float32 && type != DataType::Float64)
+    {
+        std::string serr;
+        serr.append("Gradient codec '");
+        serr.append(GradientCodecToString(codec));
+        serr.append("' of tensor '");
+        serr.append(name);
+        serr.append("' requires float32 or float64 data, but the data type is ");
+        serr.append(NullableDataTypeToString(type));
+        serr.append(".\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    if (codec == GradientCodec::TopK && !is_dense)
+    {
+        std::string serr;
+        serr.append("Gradient codec 'top_k' of tensor '");
+        serr.append(name);
+        serr.append("' is supported by dense tensors only.\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    if (codec == GradientCodec::TopK && !(top_k_ratio > 0.0 && top_k_ratio <= 1.0))
+    {
+        std::string serr;
+        serr.append("Gradient top k ratio ");
+        serr.append(std::to_string(top_k_ratio));
+        serr.append(" of tensor '");
+        serr.append(name);
+        serr.append("' must be in (0, 1].\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+}
+
+namespace
+{
+
+// Uniform in [0, 1) for stochastic rounding; the quality of
+// ``std::minstd_rand`` is plenty for this and it is cheap to step.
+float NextUniform()
+{
+    thread_local std::minstd_rand engine(std::random_device{}());
+    return static_cast<float>(engine() - engine.min()) /
+           static_cast<float>(engine.max() - engine.min() + 1.0);
+}
+
+void ThrowCorruptedGradient(GradientCodec codec, size_t size, size_t expected)
+{
+    std::string serr;
+    serr.append("Corrupted gradient detected; codec '");
+    serr.append(GradientCodecToString(codec));
+    serr.append("' expects ");
+    serr.append(std::to_string(expected));
+    serr.append(" bytes, but found ");
+    serr.append(std::to_string(size));
+    serr.append(".\n\n");
+    serr.append(GetStackTrace());
+    spdlog::error(serr);
+    throw std::runtime_error(serr);
+}
+
+template<typename H, typename T>
+SmartArray<uint8_t> EncodeCast(const T* data, size_t count)
+{
+    SmartArray<uint8_t> out(count * sizeof(H));
+    H* const half = reinterpret_cast<H*>(out.data());
+    for (size_t i = 0; i < count; i++)
+        half[i] = H(static_cast<float>(data[i]));
+    return out;
+}
+
+template<typename H, typename T>
+void DecodeCast(const uint8_t* in, T* data, size_t count)
+{
+    const H* const half = reinterpret_cast<const H*>(in);
+    for (size_t i = 0; i < count; i++)
+        data[i] = static_cast<T>(static_cast<float>(half[i]));
+}
+
+// ``Int8`` stores the scales of all rows followed by the quantized items.
+template<typename T>
+SmartArray<uint8_t> EncodeInt8(const T* data, size_t count, size_t row_items)
+{
+    const size_t rows = (count + row_items - 1) / row_items;
+    SmartArray<uint8_t> out(rows * sizeof(float) + count);
+    float* const scales = reinterpret_cast<float*>(out.data());
+    int8_t* const quantized = reinterpret_cast<int8_t*>(out.data() + rows * sizeof(float));
+    for (size_t r = 0; r < rows; r++)
+    {
+        const size_t begin = r * row_items;
+        const size_t end = std::min(begin + row_items, count);
+        T max_abs = 0;
+        for (size_t i = begin; i < end; i++)
+            max_abs = std::max(max_abs, static_cast<T>(fabs(data[i])));
+        const float scale = static_cast<float>(max_abs / 127);
+        scales[r] = scale;
+        if (scale == 0.0f || !std::isfinite(scale))
+        {
+            memset(quantized + begin, 0, end - begin);
+            continue;
+        }
+        const float inverse = 1.0f / scale;
+        for (size_t i = begin; i < end; i++)
+        {
+            const float q = floorf(static_cast<float>(data[i]) * inverse + NextUniform());
+            quantized[i] = static_cast<int8_t>(std::min(127.0f, std::max(-127.0f, q)));
+        }
+    }
+    return out;
+}
+
+template<typename T>
+void DecodeInt8(const uint8_t* in, T* data, size_t count, size_t row_items)
+{
+    const size_t rows = (count + row_items - 1) / row_items;
+    const float* const scales = reinterpret_cast<const float*>(in);
+    const int8_t* const quantized = reinterpret_cast<const int8_t*>(in + rows * sizeof(float));
+    for (size_t r = 0; r < rows; r++)
+    {
+        const size_t begin = r * row_items;
+        const size_t end = std::min(begin + row_items, count);
+        const T scale = static_cast<T>(scales[r]);
+        for (size_t i = begin; i < end; i++)
+            data[i] = static_cast<T>(quantized[i]) * scale;
+    }
+}
+
+// ``TopK`` stores the item count, the values and then their indices, so
+// the values stay aligned for both ``float`` and ``double``.
+template<typename T>
+SmartArray<uint8_t> EncodeTopK(const T* data, size_t count, double ratio, std::vector<uint8_t>& residual_buffer)
+{
+    if (residual_buffer.size() != count * sizeof(T))
+        residual_buffer.assign(count * sizeof(T), 0);
+    T* const residual = reinterpret_cast<T*>(residual_buffer.data());
+    for (size_t i = 0; i < count; i++)
+        residual[i] += data[i];
+    const size_t k = std::min(count, std::max<size_t>(1, static_cast<size_t>(ceil(count * ratio))));
+    std::vector<uint32_t> indices(count);
+    for (size_t i = 0; i < count; i++)
+        indices[i] = static_cast<uint32_t>(i);
+    auto greater = [residual](uint32_t a, uint32_t b) { return fabs(residual[a]) > fabs(residual[b]); };
+    if (k < count)
+        std::nth_element(indices.begin(), indices.begin() + k, indices.end(), greater);
+    indices.resize(k);
+    std::sort(indices.begin(), indices.end());
+    SmartArray<uint8_t> out(sizeof(uint64_t) + k * (sizeof(T) + sizeof(uint32_t)));
+    *reinterpret_cast<uint64_t*>(out.data()) = k;
+    T* const values = reinterpret_cast<T*>(out.data() + sizeof(uint64_t));
+    memcpy(out.data() + sizeof(uint64_t) + k * sizeof(T), indices.data(), k * sizeof(uint32_t));
+    for (size_t i = 0; i < k; i++)
+    {
+        values[i] = residual[indices[i]];
+        residual[indices[i]] = 0;
+    }
+    return out;
+}
+
+template<typename T>
+void DecodeTopK(const uint8_t* in, size_t size, T* data, size_t count)
+{
+    const uint64_t k = *reinterpret_cast<const uint64_t*>(in);
+    const size_t expected = sizeof(uint64_t) + k * (sizeof(T) + sizeof(uint32_t));
+    if (k > count || size != expected)
+        ThrowCorruptedGradient(GradientCodec::TopK, size, expected);
+    const T* const values = reinterpret_cast<const T*>(in + sizeof(uint64_t));
+    const uint32_t* const indices = reinterpret_cast<const uint32_t*>(in + sizeof(uint64_t) + k * sizeof(T));
+    memset(data, 0, count * sizeof(T));
+    for (size_t i = 0; i < k; i++)
+    {
+        if (indices[i] >= count)
+            ThrowCorruptedGradient(GradientCodec::TopK, size, expected);
+        data[indices[i]] = values[i];
+    }
+}
+
+template<typename T>
+SmartArray<uint8_t> EncodeTyped(GradientCodec codec, SmartArray<uint8_t> in, size_t row_items,
+                                double top_k_ratio, std::vector<uint8_t>& residual)
+{
+    const T* const data = reinterpret_cast<const T*>(in.data());
+    const size_t count = in.size() / sizeof(T);
+    switch (codec)
+    {
+    case GradientCodec::Float16:
+        return EncodeCast<float16>(data, count);
+    case GradientCodec::BFloat16:
+        return EncodeCast<bfloat16>(data, count);
+    case GradientCodec::Int8:
+        return EncodeInt8(data, count, row_items);
+    case GradientCodec::TopK:
+        return EncodeTopK(data, count, top_k_ratio, residual);
+    default:
+        return in;
+    }
+}
+
+template<typename T>
+SmartArray<uint8_t> DecodeTyped(GradientCodec codec, SmartArray<uint8_t> in, size_t count, size_t row_items)
+{
+    size_t expected = in.size();
+    if (codec == GradientCodec::Float16 || codec == GradientCodec::BFloat16)
+        expected = count * sizeof(uint16_t);
+    else if (codec == GradientCodec::Int8)
+        expected = (count + row_items - 1) / row_items * sizeof(float) + count;
+    else if (codec == GradientCodec::TopK && in.size() < sizeof(uint64_t))
+        expected = sizeof(uint64_t);
+    if (in.size() != expected)
+        ThrowCorruptedGradient(codec, in.size(), expected);
+    SmartArray<uint8_t> out(count * sizeof(T));
+    T* const data = reinterpret_cast<T*>(out.data());
+    switch (codec)
+    {
+    case GradientCodec::Float16:
+        DecodeCast<float16>(in.data(), data, count);
+        break;
+    case GradientCodec::BFloat16:
+        DecodeCast<bfloat16>(in.data(), data, count);
+        break;
+    case GradientCodec::Int8:
+        DecodeInt8(in.data(), data, count, row_items);
+        break;
+    case GradientCodec::TopK:
+        DecodeTopK(in.data(), in.size(), data, count);
+        break;
+    default:
+        return in;
+    }
+    return out;
+}
+
+}
+
+SmartArray<uint8_t> DecodeGradient(GradientCodec codec, DataType type, SmartArray<uint8_t> in,
+                                   size_t item_count, size_t row_items)
+{
+    if (codec == GradientCodec::None)
+        return in;
+    if (type == DataType::Float64)
+        return DecodeTyped<double>(codec, std::move(in), item_count, row_items);
+    return DecodeTyped<float>(codec, std::move(in), item_count, row_items);
+}
+
+SmartArray<uint8_t> GradientEncoder::Encode(GradientCodec codec, DataType type, SmartArray<uint8_t> in,
+                                            size_t row_items, double top_k_ratio, size_t partition)
+{
+    raw_bytes_ += in.size();
+    SmartArray<uint8_t> out;
+    if (codec == GradientCodec::None)
+        out = std::move(in);
+    else
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (residuals_.size() <= partition)
+            residuals_.resize(partition + 1);
+        std::vector<uint8_t>& residual = residuals_.at(partition);
+        if (type == DataType::Float64)
+            out = EncodeTyped<double>(codec, std::move(in), row_items, top_k_ratio, residual);
+        else
+            out = EncodeTyped<float>(codec, std::move(in), row_items, top_k_ratio, residual);
+    }
+    wire_bytes_ += out.size();
+    return out;
+}
+
+void GradientEncoder::ResetCounters()
+{
+    raw_bytes_ = 0;
+    wire_bytes_ = 0;
+}
+
+}
@@ -0,0 +1,104 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <mindalpha/data_type.h>
+#include <mindalpha/smart_array.h>
+
+//
+// ``gradient_codec.h`` defines enum ``GradientCodec`` to represent the ways
+// workers can compress the gradients they push, class ``GradientEncoder``
+// used by workers to encode them and function ``DecodeGradient`` used by
+// servers to restore them before the updaters run.
+//
+
+namespace mindalpha
+{
+
+//
+// Use the X Macro technique to simplify code. See the following page
+// for more information about X Macros:
+//
+//   https://en.wikipedia.org/wiki/X_Macro
+//
+// ``Float16`` and ``BFloat16`` cast every item with round to nearest even.
+// ``Int8`` quantizes every row to 8-bit integers with stochastic rounding
+// and a ``float`` scale per row. ``TopK`` sends the largest items by
+// magnitude with their indices and keeps the rest as a residual added to
+// the next gradient; it is supported by dense tensors only.
+//
+
+#define MINDALPHA_GRADIENT_CODECS(X)           \
+    X(none,     None)                          \
+    X(float16,  Float16)                       \
+    X(bfloat16, BFloat16)                      \
+    X(int8,     Int8)                          \
+    X(top_k,    TopK)                          \
+    /**/
+
+enum class GradientCodec
+{
+#undef MINDALPHA_GRADIENT_CODEC_DEF
+#define MINDALPHA_GRADIENT_CODEC_DEF(l, u) u,
+    MINDALPHA_GRADIENT_CODECS(MINDALPHA_GRADIENT_CODEC_DEF)
+};
+
+// Functions to convert ``GradientCodec`` to and from strings.
+std::string GradientCodecToString(GradientCodec codec);
+GradientCodec GradientCodecFromString(const std::string& str);
+
+// Dense tensors have no natural rows, ``Int8`` scales blocks of this many
+// items instead.
+constexpr size_t DenseGradientRowItems = 256;
+
+// Throw if ``codec`` can not be used for the gradients of tensor ``name``.
+void CheckGradientCodec(const std::string& name, GradientCodec codec, DataType type,
+                        bool is_dense, double top_k_ratio);
+
+// Restore ``item_count`` items of type ``type`` from ``in`` encoded with
+// ``codec`` in rows of ``row_items`` items.
+SmartArray<uint8_t> DecodeGradient(GradientCodec codec, DataType type, SmartArray<uint8_t> in,
+                                   size_t item_count, size_t row_items);
+
+class GradientEncoder
+{
+public:
+    // Encode the gradient ``in`` sent to ``partition``; ``in`` is returned
+    // as is when ``codec`` is ``None``.
+    SmartArray<uint8_t> Encode(GradientCodec codec, DataType type, SmartArray<uint8_t> in,
+                               size_t row_items, double top_k_ratio, size_t partition);
+
+    // Bytes of the gradients given to ``Encode`` and of what it returned,
+    // to measure the savings of a codec.
+    uint64_t GetRawBytes() const { return raw_bytes_.load(); }
+    uint64_t GetWireBytes() const { return wire_bytes_.load(); }
+    void ResetCounters();
+
+private:
+    std::mutex mutex_;
+    std::vector<std::vector<uint8_t>> residuals_;
+    std::atomic<uint64_t> raw_bytes_{0};
+    std::atomic<uint64_t> wire_bytes_{0};
+};
+
+}
@@ -0,0 +1,57 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <stdexcept>
+#include <spdlog/spdlog.h>
+#include <mindalpha/hash_map_engine.h>
+#include <mindalpha/stack_trace_utils.h>
+
+namespace mindalpha
+{
+
+std::string HashMapEngineToString(HashMapEngine engine)
+{
+    switch (engine)
+    {
+#undef MINDALPHA_HASH_MAP_ENGINE_DEF
+#define MINDALPHA_HASH_MAP_ENGINE_DEF(l, u) case HashMapEngine::u: return #l;
+    MINDALPHA_HASH_MAP_ENGINES(MINDALPHA_HASH_MAP_ENGINE_DEF)
+    default:
+        std::string serr;
+        serr.append("Invalid HashMapEngine enum value: ");
+        serr.append(std::to_string(static_cast<int>(engine)));
+        serr.append(".\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+}
+
+HashMapEngine HashMapEngineFromString(const std::string& str)
+{
+#undef MINDALPHA_HASH_MAP_ENGINE_DEF
+#define MINDALPHA_HASH_MAP_ENGINE_DEF(l, u) if (str == #l) return HashMapEngine::u;
+    MINDALPHA_HASH_MAP_ENGINES(MINDALPHA_HASH_MAP_ENGINE_DEF)
+    std::string serr;
+    serr.append("Invalid HashMapEngine enum value: ");
+    serr.append(str);
+    serr.append(".\n\n");
+    serr.append(GetStackTrace());
+    spdlog::error(serr);
+    throw std::runtime_error(serr);
+}
+
+}
@@ -0,0 +1,57 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <string>
+
+//
+// ``hash_map_engine.h`` defines enum ``HashMapEngine`` to represent the
+// hash index layouts supported by ``ArrayHashMap`` and some helper functions
+// to convert ``HashMapEngine`` values.
+//
+
+namespace mindalpha
+{
+
+//
+// Use the X Macro technique to simplify code. See the following page
+// for more information about X Macros:
+//
+//   https://en.wikipedia.org/wiki/X_Macro
+//
+// ``Chained`` resolves collisions through the ``first_``/``next_`` chain
+// arrays; ``OpenAddressing`` probes groups of tag bytes with SIMD
+// instructions in the style of Swiss tables.
+//
+
+#define MINDALPHA_HASH_MAP_ENGINES(X)          \
+    X(chained,         Chained)                \
+    X(open_addressing, OpenAddressing)         \
+    /**/
+
+enum class HashMapEngine
+{
+#undef MINDALPHA_HASH_MAP_ENGINE_DEF
+#define MINDALPHA_HASH_MAP_ENGINE_DEF(l, u) u,
+    MINDALPHA_HASH_MAP_ENGINES(MINDALPHA_HASH_MAP_ENGINE_DEF)
+};
+
+// Functions to convert ``HashMapEngine`` to and from strings.
+std::string HashMapEngineToString(HashMapEngine engine);
+HashMapEngine HashMapEngineFromString(const std::string& str);
+
+}
@@ -51,6 +51,19 @@ public:
             r -= prime;
         return r;
     }
+
+    // ``FastModulo`` keeps only 31 bits, which is not enough for open
+    // addressing where the high bits select the probe group and the low
+    // 7 bits are stored as the tag. This is the finalizer of MurmurHash3.
+    static constexpr uint64_t MixHash(uint64_t a)
+    {
+        a ^= a >> 33;
+        a *= UINT64_C(0xff51afd7ed558ccd);
+        a ^= a >> 33;
+        a *= UINT64_C(0xc4ceb9fe1a85ec53);
+        a ^= a >> 33;
+        return a;
+    }
 };
 
 }
@@ -0,0 +1,207 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <time.h>
+#include <stdlib.h>
+#include <spdlog/spdlog.h>
+#include <stdexcept>
+#include <mindalpha/inprocess_transport.h>
+#include <mindalpha/stack_trace_utils.h>
+
+namespace mindalpha
+{
+
+void InProcessTransport::Mailbox::Push(Message&& msg)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(std::move(msg));
+    }
+    cv_.notify_one();
+}
+
+Message InProcessTransport::Mailbox::Pop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return !queue_.empty(); });
+    Message msg = std::move(queue_.front());
+    queue_.pop_front();
+    return msg;
+}
+
+InProcessTransport::InProcessTransport(std::shared_ptr<ActorConfig> config)
+    : MessageTransport(std::move(config))
+{
+}
+
+std::mutex& InProcessTransport::GetRegistryMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::unordered_map<int, std::shared_ptr<InProcessTransport::Mailbox>>& InProcessTransport::GetRegistry()
+{
+    static std::unordered_map<int, std::shared_ptr<Mailbox>> registry;
+    return registry;
+}
+
+void InProcessTransport::Start()
+{
+}
+
+void InProcessTransport::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(GetRegistryMutex());
+        auto& registry = GetRegistry();
+        auto it = registry.find(port_);
+        if (it != registry.end() && it->second == mailbox_)
+            registry.erase(it);
+    }
+    std::unique_lock<std::shared_mutex> lock(peers_mutex_);
+    peers_.clear();
+    port_ = -1;
+}
+
+int InProcessTransport::Bind(const NodeInfo& node, int maxRetry)
+{
+    // Ports only name mailboxes here; a taken one is retried with a random
+    // port, as ``ZeroMQTransport`` does when binding fails.
+    std::lock_guard<std::mutex> lock(GetRegistryMutex());
+    auto& registry = GetRegistry();
+    int port = node.GetPort();
+    unsigned seed = static_cast<unsigned>(time(nullptr) + port);
+    for (int i = 0; i <= maxRetry; i++)
+    {
+        if (!registry.count(port))
+            break;
+        if (i == maxRetry)
+            port = -1;
+        else
+            port = 10000 + rand_r(&seed) % 40000;
+    }
+    if (port == -1)
+    {
+        std::string serr;
+        serr.append("Fail to bind after retried ");
+        serr.append(std::to_string(maxRetry));
+        serr.append(" times.\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    port_ = port;
+    mailbox_ = std::make_shared<Mailbox>();
+    registry[port] = mailbox_;
+    return port;
+}
+
+void InProcessTransport::Connect(const NodeInfo& node)
+{
+    if (node.GetNodeId() == -1)
+    {
+        std::string serr = "Node id must not be -1.\n\n";
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    if (node.GetPort() == -1)
+    {
+        std::string serr = "Port must not be -1.\n\n";
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    std::shared_ptr<Mailbox> mailbox;
+    {
+        std::lock_guard<std::mutex> lock(GetRegistryMutex());
+        auto& registry = GetRegistry();
+        auto it = registry.find(node.GetPort());
+        if (it == registry.end())
+        {
+            std::string serr;
+            serr.append("Fail to connect to ");
+            serr.append(node.ToString());
+            serr.append(": no node of this process is bound to port ");
+            serr.append(std::to_string(node.GetPort()));
+            serr.append(".\n\n");
+            serr.append(GetStackTrace());
+            spdlog::error(serr);
+            throw std::runtime_error(serr);
+        }
+        mailbox = it->second;
+    }
+    const NodeInfo& thisNode = GetConfig()->GetThisNodeInfo();
+    std::unique_lock<std::shared_mutex> lock(peers_mutex_);
+    // Worker doesn't connect to other workers and
+    // server doesn't connect to other servers.
+    if (node.GetRole() == thisNode.GetRole() &&
+        node.GetNodeId() != thisNode.GetNodeId())
+    {
+        peers_.erase(node.GetNodeId());
+        return;
+    }
+    Peer& peer = peers_[node.GetNodeId()];
+    peer.mailbox = std::move(mailbox);
+    peer.identity = thisNode.GetNodeId();
+}
+
+int64_t InProcessTransport::SendMessage(const Message& msg)
+{
+    const int nodeId = msg.GetMessageMeta().GetReceiver();
+    if (nodeId == -1)
+    {
+        std::string serr = "Receiver id must not be -1.\n\n";
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    Message copy = msg;
+    {
+        std::shared_lock<std::shared_mutex> lock(peers_mutex_);
+        auto it = peers_.find(nodeId);
+        if (it == peers_.end())
+        {
+            std::string serr;
+            serr.append("There is no connection to node ");
+            serr.append(NodeIdToString(nodeId));
+            serr.append(".\n\n");
+            serr.append(GetStackTrace());
+            spdlog::error(serr);
+            throw std::runtime_error(serr);
+        }
+        copy.GetMessageMeta().SetSender(it->second.identity);
+        it->second.mailbox->Push(std::move(copy));
+    }
+    int64_t bytes = msg.GetMessageMeta().GetBody().size();
+    for (const SmartArray<uint8_t>& slice: msg.GetSlices())
+        bytes += slice.size();
+    return bytes;
+}
+
+int64_t InProcessTransport::ReceiveMessage(Message& msg)
+{
+    msg = mailbox_->Pop();
+    msg.GetMessageMeta().SetReceiver(GetConfig()->GetThisNodeInfo().GetNodeId());
+    int64_t bytes = msg.GetMessageMeta().GetBody().size();
+    for (const SmartArray<uint8_t>& slice: msg.GetSlices())
+        bytes += slice.size();
+    return bytes;
+}
+
+}
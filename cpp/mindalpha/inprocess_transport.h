@@ -0,0 +1,84 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <mindalpha/message_transport.h>
+
+//
+// ``inprocess_transport.h`` defines class ``InProcessTransport`` which
+// passes messages between the actors of a local mode job, which run as
+// threads of one process.
+//
+// Each bound node owns a mailbox registered by port in a process-wide
+// table. Sending copies the ``Message`` object into the mailbox of the
+// receiver; slices are shared by reference, so neither the meta nor the
+// data is serialized or copied.
+//
+
+namespace mindalpha
+{
+
+class InProcessTransport : public MessageTransport
+{
+public:
+    explicit InProcessTransport(std::shared_ptr<ActorConfig> config);
+
+    void Start() override;
+    void Stop() override;
+    int Bind(const NodeInfo& node, int maxRetry) override;
+    void Connect(const NodeInfo& node) override;
+    int64_t SendMessage(const Message& msg) override;
+    int64_t ReceiveMessage(Message& msg) override;
+
+private:
+    class Mailbox
+    {
+    public:
+        void Push(Message&& msg);
+        Message Pop();
+
+    private:
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::deque<Message> queue_;
+    };
+
+    // Like a ZeroMQ sender socket, a peer remembers the id this node had
+    // when it connected, which the receiver sees as the sender.
+    struct Peer
+    {
+        std::shared_ptr<Mailbox> mailbox;
+        int identity = -1;
+    };
+
+    static std::mutex& GetRegistryMutex();
+    static std::unordered_map<int, std::shared_ptr<Mailbox>>& GetRegistry();
+
+    int port_ = -1;
+    std::shared_ptr<Mailbox> mailbox_;
+    std::shared_mutex peers_mutex_;
+    std::unordered_map<int, Peer> peers_;
+};
+
+}
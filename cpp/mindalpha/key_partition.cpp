@@ -0,0 +1,104 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <string.h>
+#include <mindalpha/key_partition.h>
+
+namespace mindalpha
+{
+
+namespace
+{
+
+// Every element is written by the scatter pass, so skip the zero
+// filling ``SmartArray(size)`` would do.
+template<typename T>
+SmartArray<T> MakeUninitializedArray(size_t size)
+{
+    return SmartArray<T>::Create(new T[size], size, [](T* data) { delete[] data; });
+}
+
+}
+
+KeyPartition::KeyPartition(SmartArray<uint8_t> keys, const KeyRouter& router)
+{
+    SmartArray<uint64_t> source = keys.Cast<uint64_t>();
+    const size_t key_count = source.size();
+    const size_t part_count = router.GetPartCount();
+    offsets_.assign(part_count + 1, 0);
+    if (part_count == 1)
+    {
+        offsets_.at(1) = key_count;
+        // The request views the caller's keys; servers never modify request
+        // slices, see ``SparseTensorPartition::TransformIndices``.
+        keys_ = source;
+        return;
+    }
+    // The first pass computes the server of every key and counts the keys
+    // of every server.
+    std::vector<uint32_t> parts(key_count);
+    router.Route(source.data(), key_count, parts.data());
+    for (size_t i = 0; i < key_count; i++)
+        offsets_[parts[i] + 1]++;
+    for (size_t k = 0; k < part_count; k++)
+        offsets_[k + 1] += offsets_[k];
+    // The second pass scatters the keys to their grouped positions.
+    keys_ = MakeUninitializedArray<uint64_t>(key_count);
+    order_.resize(key_count);
+    std::vector<size_t> cursors(offsets_.begin(), offsets_.end() - 1);
+    uint64_t* const target = keys_.data();
+    for (size_t i = 0; i < key_count; i++)
+    {
+        const size_t pos = cursors[parts[i]]++;
+        target[pos] = source[i];
+        order_[pos] = i;
+    }
+}
+
+SmartArray<uint8_t> KeyPartition::GroupRows(SmartArray<uint8_t> in, size_t row_bytes) const
+{
+    if (order_.empty())
+        return in;
+    const size_t key_count = order_.size();
+    SmartArray<uint8_t> out = MakeUninitializedArray<uint8_t>(key_count * row_bytes);
+    const uint8_t* const source = in.data();
+    uint8_t* target = out.data();
+    for (size_t pos = 0; pos < key_count; pos++)
+    {
+        memcpy(target, source + order_[pos] * row_bytes, row_bytes);
+        target += row_bytes;
+    }
+    return out;
+}
+
+void KeyPartition::ScatterRows(size_t part, const uint8_t* rows, uint8_t* out, size_t row_bytes) const
+{
+    const size_t begin = offsets_.at(part);
+    const size_t end = offsets_.at(part + 1);
+    if (order_.empty())
+    {
+        memcpy(out + begin * row_bytes, rows, (end - begin) * row_bytes);
+        return;
+    }
+    for (size_t pos = begin; pos < end; pos++)
+    {
+        memcpy(out + order_[pos] * row_bytes, rows, row_bytes);
+        rows += row_bytes;
+    }
+}
+
+}
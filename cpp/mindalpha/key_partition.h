@@ -0,0 +1,74 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <mindalpha/smart_array.h>
+#include <mindalpha/key_partitioner.h>
+
+//
+// ``key_partition.h`` defines class ``KeyPartition`` which groups the keys
+// of a sparse push or pull by the server ``router`` assigns them to.
+//
+// Keys are grouped by a counting sort: a first pass counts the keys of
+// every server, a second one scatters them into a single exactly sized
+// array. The requests to the servers are views of that array, and the
+// position every key came from is kept, so that rows pulled from the
+// servers are put back in place without computing the servers again.
+//
+
+namespace mindalpha
+{
+
+class KeyPartition
+{
+public:
+    KeyPartition(SmartArray<uint8_t> keys, const KeyRouter& router);
+
+    size_t GetPartCount() const { return offsets_.size() - 1; }
+    size_t GetKeyCount() const { return keys_.size(); }
+
+    // The keys owned by server ``part``, in the order they were given.
+    SmartArray<uint64_t> GetPartKeys(size_t part) const
+    {
+        return keys_.Slice(offsets_.at(part), offsets_.at(part + 1));
+    }
+
+    // Reorder ``in``, one row of ``row_bytes`` per key, so that the rows of
+    // each server are consecutive; ``GetPartRows`` views those of ``part``.
+    SmartArray<uint8_t> GroupRows(SmartArray<uint8_t> in, size_t row_bytes) const;
+
+    SmartArray<uint8_t> GetPartRows(SmartArray<uint8_t> grouped, size_t part, size_t row_bytes) const
+    {
+        return grouped.Slice(offsets_.at(part) * row_bytes, offsets_.at(part + 1) * row_bytes);
+    }
+
+    // Copy the rows server ``part`` returned for its keys to the positions
+    // of those keys in ``out``.
+    void ScatterRows(size_t part, const uint8_t* rows, uint8_t* out, size_t row_bytes) const;
+
+private:
+    std::vector<size_t> offsets_;
+    SmartArray<uint64_t> keys_;
+    // Original position of the key at each grouped position; empty when
+    // there is a single server and the grouping is the identity.
+    std::vector<size_t> order_;
+};
+
+}
@@ -0,0 +1,183 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <mindalpha/key_partitioner.h>
+#include <mindalpha/stack_trace_utils.h>
+
+namespace mindalpha
+{
+
+std::string KeyPartitionerToString(KeyPartitioner partitioner)
+{
+    switch (partitioner)
+    {
+#undef MINDALPHA_KEY_PARTITIONER_DEF
+#define MINDALPHA_KEY_PARTITIONER_DEF(l, u) case KeyPartitioner::u: return #l;
+    MINDALPHA_KEY_PARTITIONERS(MINDALPHA_KEY_PARTITIONER_DEF)
+    default:
+        std::string serr;
+        serr.append("Invalid KeyPartitioner enum value: ");
+        serr.append(std::to_string(static_cast<int>(partitioner)));
+        serr.append(".\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+}
+
+KeyPartitioner KeyPartitionerFromString(const std::string& str)
+{
+#undef MINDALPHA_KEY_PARTITIONER_DEF
+#define MINDALPHA_KEY_PARTITIONER_DEF(l, u) if (str == #l) return KeyPartitioner::u;
+    MINDALPHA_KEY_PARTITIONERS(MINDALPHA_KEY_PARTITIONER_DEF)
+    std::string serr;
+    serr.append("Invalid KeyPartitioner enum value: ");
+    serr.append(str);
+    serr.append(".\n\n");
+    serr.append(GetStackTrace());
+    spdlog::error(serr);
+    throw std::runtime_error(serr);
+}
+
+namespace
+{
+
+// Every server owns this many points of the ring, which keeps the loads of
+// the servers within about ten percent of each other.
+constexpr uint32_t RingVirtualNodes = 160;
+
+// The finalizer of SplitMix64, used to spread keys and ring points.
+inline uint64_t MixBits(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= UINT64_C(0xbf58476d1ce4e5b9);
+    x ^= x >> 27;
+    x *= UINT64_C(0x94d049bb133111eb);
+    x ^= x >> 31;
+    return x;
+}
+
+// "A Fast, Minimal Memory, Consistent Hash Algorithm", Lamping and Veach.
+inline uint32_t JumpConsistentHash(uint64_t key, int64_t buckets)
+{
+    int64_t b = -1;
+    int64_t j = 0;
+    while (j < buckets)
+    {
+        b = j;
+        key = key * UINT64_C(2862933555777941757) + 1;
+        j = static_cast<int64_t>((b + 1) * (static_cast<double>(INT64_C(1) << 31) /
+                                            static_cast<double>((key >> 33) + 1)));
+    }
+    return static_cast<uint32_t>(b);
+}
+
+}
+
+KeyRouter::KeyRouter(KeyPartitioner partitioner, size_t part_count)
+    : partitioner_(partitioner)
+    , part_count_(part_count)
+{
+    if (part_count == 0 || part_count > INT32_MAX)
+    {
+        std::string serr;
+        serr.append("Can not route keys to ");
+        serr.append(std::to_string(part_count));
+        serr.append(" partitions.\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    if (partitioner != KeyPartitioner::Ring)
+        return;
+    std::vector<std::pair<uint64_t, uint32_t>> points;
+    points.reserve(part_count * RingVirtualNodes);
+    for (size_t k = 0; k < part_count; k++)
+        for (uint32_t v = 0; v < RingVirtualNodes; v++)
+        {
+            const uint64_t point = MixBits((static_cast<uint64_t>(k) << 32) | v);
+            points.emplace_back(point, static_cast<uint32_t>(k));
+        }
+    std::sort(points.begin(), points.end());
+    // Pad to a power of two with at least one ``UINT64_MAX`` point, so that
+    // the search has a fixed number of steps and always finds a point.
+    // Padding points wrap around to the owner of the first point.
+    size_t size = 1;
+    while (size <= points.size())
+        size *= 2;
+    ring_points_.assign(size, UINT64_MAX);
+    ring_parts_.assign(size, points.front().second);
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        ring_points_[i] = points[i].first;
+        ring_parts_[i] = points[i].second;
+    }
+}
+
+void KeyRouter::Route(const uint64_t* keys, size_t count, uint32_t* parts) const
+{
+    switch (partitioner_)
+    {
+    case KeyPartitioner::Modulo:
+        if ((part_count_ & (part_count_ - 1)) == 0)
+        {
+            const uint64_t mask = part_count_ - 1;
+            for (size_t i = 0; i < count; i++)
+                parts[i] = static_cast<uint32_t>(keys[i] & mask);
+        }
+        else
+        {
+            for (size_t i = 0; i < count; i++)
+                parts[i] = static_cast<uint32_t>(keys[i] % part_count_);
+        }
+        break;
+    case KeyPartitioner::JumpHash:
+        for (size_t i = 0; i < count; i++)
+            parts[i] = JumpConsistentHash(keys[i], static_cast<int64_t>(part_count_));
+        break;
+    case KeyPartitioner::Ring:
+        {
+            // Branch free lower bound: every key takes the same number of
+            // steps, and the comparisons compile to conditional moves.
+            const uint64_t* const points = ring_points_.data();
+            const size_t size = ring_points_.size();
+            for (size_t i = 0; i < count; i++)
+            {
+                const uint64_t hash = MixBits(keys[i]);
+                size_t pos = 0;
+                for (size_t step = size / 2; step > 0; step /= 2)
+                    pos += (points[pos + step - 1] < hash) ? step : 0;
+                parts[i] = ring_parts_[pos];
+            }
+        }
+        break;
+    default:
+        std::string serr;
+        serr.append("Invalid KeyPartitioner enum value: ");
+        serr.append(std::to_string(static_cast<int>(partitioner_)));
+        serr.append(".\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+}
+
+}
@@ -0,0 +1,99 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+//
+// ``key_partitioner.h`` defines enum ``KeyPartitioner`` to represent the
+// ways keys of sparse tensors are assigned to servers, and class
+// ``KeyRouter`` which computes the servers of batches of keys.
+//
+
+namespace mindalpha
+{
+
+//
+// Use the X Macro technique to simplify code. See the following page
+// for more information about X Macros:
+//
+//   https://en.wikipedia.org/wiki/X_Macro
+//
+// ``Modulo`` assigns ``key`` to server ``key % part_count``; changing the
+// number of servers moves almost every key. ``JumpHash`` uses the jump
+// consistent hash of Lamping and Veach, and ``Ring`` a ring of virtual
+// nodes; with both, going from N to N + 1 servers moves about 1/(N + 1)
+// of the keys, all of them to the new server.
+//
+
+#define MINDALPHA_KEY_PARTITIONERS(X)          \
+    X(modulo,    Modulo)                       \
+    X(jump_hash, JumpHash)                     \
+    X(ring,      Ring)                         \
+    /**/
+
+enum class KeyPartitioner
+{
+#undef MINDALPHA_KEY_PARTITIONER_DEF
+#define MINDALPHA_KEY_PARTITIONER_DEF(l, u) u,
+    MINDALPHA_KEY_PARTITIONERS(MINDALPHA_KEY_PARTITIONER_DEF)
+};
+
+// Functions to convert ``KeyPartitioner`` to and from strings.
+std::string KeyPartitionerToString(KeyPartitioner partitioner);
+KeyPartitioner KeyPartitionerFromString(const std::string& str);
+
+// Whether changing the number of servers keeps most keys in place.
+inline bool IsConsistentKeyPartitioner(KeyPartitioner partitioner)
+{
+    return partitioner != KeyPartitioner::Modulo;
+}
+
+class KeyRouter
+{
+public:
+    KeyRouter(KeyPartitioner partitioner, size_t part_count);
+
+    KeyPartitioner GetPartitioner() const { return partitioner_; }
+    size_t GetPartCount() const { return part_count_; }
+
+    // Store the server of each of the ``count`` keys in ``parts``. The
+    // partitioner is dispatched once per batch, and every partitioner runs
+    // a tight loop over the keys with no calls in it.
+    void Route(const uint64_t* keys, size_t count, uint32_t* parts) const;
+
+    uint32_t Route(uint64_t key) const
+    {
+        uint32_t part;
+        Route(&key, 1, &part);
+        return part;
+    }
+
+private:
+    KeyPartitioner partitioner_;
+    size_t part_count_;
+    // Points of the ring sorted and padded with ``UINT64_MAX`` to a power
+    // of two, and the server owning each of them.
+    std::vector<uint64_t> ring_points_;
+    std::vector<uint32_t> ring_parts_;
+};
+
+}
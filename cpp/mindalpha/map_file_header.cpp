@@ -25,13 +25,22 @@ namespace mindalpha
 {
 
 const char map_file_signature[map_file_signature_size] = "\x89MemoryMappedArrayHashMap\0\0\0\0\0\0";
-const uint64_t map_file_version = 0x0000000000000004;
+const uint64_t map_file_version = 0x0000000000000005;
+const uint64_t map_file_uint32_index_version = 0x0000000000000004;
 
-void MapFileHeader::FillBasicFields()
+void MapFileHeader::FillBasicFields(DataType index_type)
 {
     memcpy(signature, map_file_signature, map_file_signature_size);
-    version = map_file_version;
-    reserved_ = 0;
+    if (index_type == DataType::UInt32)
+    {
+        version = map_file_uint32_index_version;
+        this->index_type = 0;
+    }
+    else
+    {
+        version = map_file_version;
+        this->index_type = static_cast<uint64_t>(index_type);
+    }
 }
 
 bool MapFileHeader::IsSignatureValid() const
@@ -39,6 +48,13 @@ bool MapFileHeader::IsSignatureValid() const
     return memcmp(signature, map_file_signature, map_file_signature_size) == 0;
 }
 
+DataType MapFileHeader::GetIndexType() const
+{
+    if (version == map_file_uint32_index_version)
+        return DataType::UInt32;
+    return static_cast<DataType>(index_type);
+}
+
 void MapFileHeader::Validate(const std::string& hint) const
 {
     if (!IsSignatureValid())
@@ -50,11 +66,12 @@ void MapFileHeader::Validate(const std::string& hint) const
         spdlog::error(serr);
         throw std::runtime_error(serr);
     }
-    if (version != map_file_version)
+    if (version != map_file_version && version != map_file_uint32_index_version)
     {
         std::string serr;
         serr.append(hint);
-        serr.append("file version not match, expect " + std::to_string(map_file_version) + ", ");
+        serr.append("file version not match, expect " + std::to_string(map_file_uint32_index_version) + " ");
+        serr.append("or " + std::to_string(map_file_version) + ", ");
         serr.append("found " + std::to_string(version) + ".\n\n");
         serr.append(GetStackTrace());
         spdlog::error(serr);
@@ -82,12 +99,24 @@ void MapFileHeader::Validate(const std::string& hint) const
         spdlog::error(serr);
         throw std::runtime_error(serr);
     }
-    if (reserved_ != 0)
+    if (version == map_file_uint32_index_version && index_type != 0)
+    {
+        std::string serr;
+        serr.append(hint);
+        serr.append("index_type field not zero. ");
+        serr.append("index_type = " + std::to_string(index_type) + ".\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    if (version == map_file_version &&
+        index_type != static_cast<uint64_t>(DataType::UInt32) &&
+        index_type != static_cast<uint64_t>(DataType::UInt64))
     {
         std::string serr;
         serr.append(hint);
-        serr.append("reserved_ field not zero. ");
-        serr.append("reserved_ = " + std::to_string(reserved_) + ".\n\n");
+        serr.append("index_type must be uint32 or uint64. ");
+        serr.append("index_type = " + std::to_string(index_type) + ".\n\n");
         serr.append(GetStackTrace());
         spdlog::error(serr);
         throw std::runtime_error(serr);
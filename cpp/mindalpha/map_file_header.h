@@ -25,6 +25,11 @@
 // file header. For simplicity and efficiency, we assume little endian
 // and do not consider portability.
 //
+// Version 4 files always store the chain indices as ``uint32_t``. Version 5
+// records the index type in ``index_type`` so that maps with more than 2^32
+// buckets can be stored; maps with ``uint32_t`` indices are still written as
+// version 4 to keep them loadable by older releases.
+//
 
 namespace mindalpha
 {
@@ -35,7 +40,7 @@ struct MapFileHeader
 {
     char signature[map_file_signature_size];
     uint64_t version;
-    uint64_t reserved_; // for backward compatibility
+    uint64_t index_type; // zero in version 4, which implies uint32
     uint64_t key_type;
     uint64_t value_type;
     uint64_t key_count;
@@ -43,8 +48,9 @@ struct MapFileHeader
     uint64_t value_count;
     uint64_t value_count_per_key;
 
-    void FillBasicFields();
+    void FillBasicFields(DataType index_type = DataType::UInt32);
     bool IsSignatureValid() const;
+    DataType GetIndexType() const;
     void Validate(const std::string& hint) const;
 };
 
@@ -52,5 +58,6 @@ const uint64_t map_file_header_size = sizeof(MapFileHeader);
 
 extern const char map_file_signature[map_file_signature_size];
 extern const uint64_t map_file_version;
+extern const uint64_t map_file_uint32_index_version;
 
 }
@@ -0,0 +1,258 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <atomic>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <spdlog/spdlog.h>
+#include <mindalpha/memory_buffer.h>
+#include <mindalpha/stack_trace_utils.h>
+
+namespace mindalpha
+{
+
+namespace
+{
+
+constexpr uint64_t huge_page_size = 2 * 1024 * 1024;
+
+std::atomic<uint64_t> buffer_bytes{0};
+std::atomic<uint64_t> peak_buffer_bytes{0};
+
+void UpdateBufferBytes(uint64_t old_size, uint64_t new_size)
+{
+    if (new_size >= old_size)
+    {
+        const uint64_t bytes = buffer_bytes.fetch_add(new_size - old_size) + (new_size - old_size);
+        uint64_t peak = peak_buffer_bytes.load();
+        while (bytes > peak && !peak_buffer_bytes.compare_exchange_weak(peak, bytes))
+            ;
+    }
+    else
+        buffer_bytes.fetch_sub(old_size - new_size);
+}
+
+uint64_t RoundUp(uint64_t size, uint64_t alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+// Read the fields of ``/proc/self/status`` or ``/proc/self/smaps_rollup``
+// which are in the form ``Name:   1024 kB``. Missing fields are left as is.
+template<typename Func>
+void ReadProcFields(const char* path, Func handle)
+{
+    FILE* fin = fopen(path, "r");
+    if (!fin)
+        return;
+    char line[256];
+    char name[64];
+    unsigned long long value;
+    while (fgets(line, sizeof(line), fin))
+        if (sscanf(line, "%63[^:]: %llu kB", name, &value) == 2)
+            handle(std::string(name), static_cast<uint64_t>(value) * 1024);
+    fclose(fin);
+}
+
+}
+
+void MemoryBuffer::SetBackend(MemoryBufferBackend value)
+{
+    if (ptr_)
+    {
+        std::string serr;
+        serr.append("can not change the backend of a non-empty MemoryBuffer ");
+        serr.append("from '" + MemoryBufferBackendToString(backend_) + "' ");
+        serr.append("to '" + MemoryBufferBackendToString(value) + "'.\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    backend_ = value;
+}
+
+void MemoryBuffer::Deallocate()
+{
+    if (ptr_)
+    {
+        if (backend_ == MemoryBufferBackend::Malloc)
+        {
+            free(ptr_);
+            UpdateBufferBytes(size_, 0);
+        }
+        else
+        {
+            munmap(ptr_, mapped_size_);
+            UpdateBufferBytes(mapped_size_, 0);
+        }
+    }
+    ptr_ = nullptr;
+    size_ = 0;
+    mapped_size_ = 0;
+    huge_tlb_ = false;
+}
+
+void MemoryBuffer::Reallocate(uint64_t size)
+{
+    if (size == 0)
+        Deallocate();
+    else if (backend_ == MemoryBufferBackend::Malloc)
+    {
+        void* new_ptr = realloc(ptr_, size);
+        if (!new_ptr)
+            throw std::bad_alloc();
+        UpdateBufferBytes(size_, size);
+        ptr_ = new_ptr;
+        size_ = size;
+    }
+    else if (!ptr_)
+        Map(size);
+    else
+        Remap(size);
+}
+
+void MemoryBuffer::AllocateZeroed(uint64_t size)
+{
+    Deallocate();
+    if (size == 0)
+        return;
+    if (backend_ == MemoryBufferBackend::Malloc)
+    {
+        ptr_ = calloc(1, size);
+        if (!ptr_)
+            throw std::bad_alloc();
+        UpdateBufferBytes(0, size);
+        size_ = size;
+    }
+    else
+    {
+        // Fresh anonymous mappings are always zeroed.
+        Map(size);
+    }
+}
+
+uint64_t MemoryBuffer::GetMappedSize(uint64_t size) const
+{
+    // Rounding large buffers up to whole huge pages lets the kernel back
+    // the tail of the buffer with a huge page too.
+    if (huge_tlb_ || (backend_ != MemoryBufferBackend::Mmap && size >= huge_page_size))
+        return RoundUp(size, huge_page_size);
+    return RoundUp(size, static_cast<uint64_t>(sysconf(_SC_PAGESIZE)));
+}
+
+void MemoryBuffer::Map(uint64_t size)
+{
+    void* ptr = MAP_FAILED;
+    huge_tlb_ = false;
+    if (backend_ == MemoryBufferBackend::HugeTlb)
+    {
+        huge_tlb_ = true;
+        ptr = mmap(nullptr, GetMappedSize(size), PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (ptr == MAP_FAILED)
+            huge_tlb_ = false;
+    }
+    const uint64_t mapped_size = GetMappedSize(size);
+    if (ptr == MAP_FAILED)
+    {
+        ptr = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED)
+            throw std::bad_alloc();
+        if (backend_ != MemoryBufferBackend::Mmap)
+            madvise(ptr, mapped_size, MADV_HUGEPAGE);
+    }
+    UpdateBufferBytes(0, mapped_size);
+    ptr_ = ptr;
+    size_ = size;
+    mapped_size_ = mapped_size;
+}
+
+void MemoryBuffer::Remap(uint64_t size)
+{
+    const uint64_t mapped_size = GetMappedSize(size);
+    if (mapped_size != mapped_size_)
+    {
+        void* ptr = mremap(ptr_, mapped_size_, mapped_size, MREMAP_MAYMOVE);
+        if (ptr == MAP_FAILED)
+        {
+            // Old kernels can not remap ``MAP_HUGETLB`` mappings, copy the
+            // contents to a new mapping instead.
+            MemoryBuffer buffer(backend_);
+            buffer.Map(size);
+            memcpy(buffer.ptr_, ptr_, std::min(size, size_));
+            Swap(buffer);
+            return;
+        }
+        if (!huge_tlb_ && backend_ != MemoryBufferBackend::Mmap)
+            madvise(ptr, mapped_size, MADV_HUGEPAGE);
+        UpdateBufferBytes(mapped_size_, mapped_size);
+        ptr_ = ptr;
+        mapped_size_ = mapped_size;
+    }
+    size_ = size;
+}
+
+double MemoryBufferStats::GetHugePageCoverage() const
+{
+    const uint64_t total = anonymous_bytes + huge_tlb_bytes;
+    if (total == 0)
+        return 0.0;
+    return static_cast<double>(anon_huge_page_bytes + huge_tlb_bytes) / total;
+}
+
+std::string MemoryBufferStats::ToString() const
+{
+    std::ostringstream sout;
+    sout << "buffer_bytes = " << buffer_bytes << ", ";
+    sout << "peak_buffer_bytes = " << peak_buffer_bytes << ", ";
+    sout << "rss_bytes = " << rss_bytes << ", ";
+    sout << "peak_rss_bytes = " << peak_rss_bytes << ", ";
+    sout << "anonymous_bytes = " << anonymous_bytes << ", ";
+    sout << "anon_huge_page_bytes = " << anon_huge_page_bytes << ", ";
+    sout << "huge_tlb_bytes = " << huge_tlb_bytes << ", ";
+    sout << "huge_page_coverage = " << GetHugePageCoverage();
+    return sout.str();
+}
+
+MemoryBufferStats GetMemoryBufferStats()
+{
+    MemoryBufferStats stats;
+    stats.buffer_bytes = buffer_bytes.load();
+    stats.peak_buffer_bytes = peak_buffer_bytes.load();
+    ReadProcFields("/proc/self/status", [&stats](const std::string& name, uint64_t value) {
+        if (name == "VmRSS")
+            stats.rss_bytes = value;
+        else if (name == "VmHWM")
+            stats.peak_rss_bytes = value;
+    });
+    ReadProcFields("/proc/self/smaps_rollup", [&stats](const std::string& name, uint64_t value) {
+        if (name == "Anonymous")
+            stats.anonymous_bytes = value;
+        else if (name == "AnonHugePages")
+            stats.anon_huge_page_bytes = value;
+        else if (name == "Shared_Hugetlb" || name == "Private_Hugetlb")
+            stats.huge_tlb_bytes += value;
+    });
+    return stats;
+}
+
+}
@@ -14,17 +14,25 @@
 // limitations under the License.
 //
 
+
 #pragma once
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <string>
 #include <algorithm>
-#include <new>
+#include <mindalpha/memory_buffer_backend.h>
 
 //
 // ``memory_buffer.h`` defines class ``MemoryBuffer`` which simplifies
 // the calling of C memory management functions in ``ArrayHashMap``.
 //
+// The memory is allocated by one of the ``MemoryBufferBackend`` backends.
+// With the ``mmap`` based backends, ``Reallocate`` grows a buffer with
+// ``mremap`` which moves the pages instead of copying them, so growing a
+// buffer of several GB needs neither a second copy of it nor the time to
+// copy it.
+//
 
 namespace mindalpha
 {
@@ -34,48 +42,35 @@ class MemoryBuffer
 public:
     MemoryBuffer()
     {
-        ptr_ = nullptr;
-        size_ = 0;
+    }
+
+    explicit MemoryBuffer(MemoryBufferBackend backend)
+        : backend_(backend)
+    {
     }
 
     explicit MemoryBuffer(uint64_t size)
     {
-        if (size == 0)
-        {
-            ptr_ = nullptr;
-            size_ = 0;
-        }
-        else
-        {
-            ptr_ = malloc(size);
-            if (!ptr_)
-                throw std::bad_alloc();
-            size_ = size;
-        }
+        Reallocate(size);
     }
 
     MemoryBuffer(MemoryBuffer&& rhs)
     {
-        ptr_ = rhs.ptr_;
-        size_ = rhs.size_;
-        rhs.ptr_ = nullptr;
-        rhs.size_ = 0;
+        Swap(rhs);
     }
 
     ~MemoryBuffer()
     {
-        if (ptr_)
-        {
-            free(ptr_);
-            ptr_ = nullptr;
-        }
-        size_ = 0;
+        Deallocate();
     }
 
     void Swap(MemoryBuffer& other)
     {
         std::swap(ptr_, other.ptr_);
         std::swap(size_, other.size_);
+        std::swap(mapped_size_, other.mapped_size_);
+        std::swap(backend_, other.backend_);
+        std::swap(huge_tlb_, other.huge_tlb_);
     }
 
     void* GetPointer() const
@@ -88,29 +83,55 @@ public:
         return size_;
     }
 
-    void Deallocate()
+    MemoryBufferBackend GetBackend() const
     {
-        MemoryBuffer buf;
-        Swap(buf);
+        return backend_;
     }
 
-    void Reallocate(uint64_t size)
-    {
-        if (size == 0)
-            Deallocate();
-        else
-        {
-            void* new_ptr = realloc(ptr_, size);
-            if (!new_ptr)
-                throw std::bad_alloc();
-            ptr_ = new_ptr;
-            size_ = size;
-        }
-    }
+    // Change the backend of an empty buffer.
+    void SetBackend(MemoryBufferBackend value);
+
+    void Deallocate();
+    void Reallocate(uint64_t size);
+
+    // Replace the contents with ``size`` zero bytes. Unlike ``Reallocate``
+    // followed by ``memset``, large blocks are zeroed lazily by the kernel.
+    void AllocateZeroed(uint64_t size);
 
 private:
-    void* ptr_;
-    uint64_t size_;
+    void Map(uint64_t size);
+    void Remap(uint64_t size);
+    uint64_t GetMappedSize(uint64_t size) const;
+
+    void* ptr_ = nullptr;
+    uint64_t size_ = 0;
+    uint64_t mapped_size_ = 0;
+    MemoryBufferBackend backend_ = MemoryBufferBackend::Malloc;
+    bool huge_tlb_ = false;
 };
 
+//
+// ``MemoryBufferStats`` reports the memory held by all ``MemoryBuffer``
+// objects of the process, together with the process wide resident set
+// size and the part of the anonymous memory backed by huge pages, read
+// from ``/proc/self/status`` and ``/proc/self/smaps_rollup``.
+//
+struct MemoryBufferStats
+{
+    uint64_t buffer_bytes = 0;
+    uint64_t peak_buffer_bytes = 0;
+    uint64_t rss_bytes = 0;
+    uint64_t peak_rss_bytes = 0;
+    uint64_t anonymous_bytes = 0;
+    uint64_t anon_huge_page_bytes = 0;
+    uint64_t huge_tlb_bytes = 0;
+
+    // Fraction of the anonymous memory backed by huge pages.
+    double GetHugePageCoverage() const;
+
+    std::string ToString() const;
+};
+
+MemoryBufferStats GetMemoryBufferStats();
+
 }
@@ -0,0 +1,57 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <stdexcept>
+#include <spdlog/spdlog.h>
+#include <mindalpha/memory_buffer_backend.h>
+#include <mindalpha/stack_trace_utils.h>
+
+namespace mindalpha
+{
+
+std::string MemoryBufferBackendToString(MemoryBufferBackend backend)
+{
+    switch (backend)
+    {
+#undef MINDALPHA_MEMORY_BUFFER_BACKEND_DEF
+#define MINDALPHA_MEMORY_BUFFER_BACKEND_DEF(l, u) case MemoryBufferBackend::u: return #l;
+    MINDALPHA_MEMORY_BUFFER_BACKENDS(MINDALPHA_MEMORY_BUFFER_BACKEND_DEF)
+    default:
+        std::string serr;
+        serr.append("Invalid MemoryBufferBackend enum value: ");
+        serr.append(std::to_string(static_cast<int>(backend)));
+        serr.append(".\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+}
+
+MemoryBufferBackend MemoryBufferBackendFromString(const std::string& str)
+{
+#undef MINDALPHA_MEMORY_BUFFER_BACKEND_DEF
+#define MINDALPHA_MEMORY_BUFFER_BACKEND_DEF(l, u) if (str == #l) return MemoryBufferBackend::u;
+    MINDALPHA_MEMORY_BUFFER_BACKENDS(MINDALPHA_MEMORY_BUFFER_BACKEND_DEF)
+    std::string serr;
+    serr.append("Invalid MemoryBufferBackend enum value: ");
+    serr.append(str);
+    serr.append(".\n\n");
+    serr.append(GetStackTrace());
+    spdlog::error(serr);
+    throw std::runtime_error(serr);
+}
+
+}
@@ -0,0 +1,61 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <string>
+
+//
+// ``memory_buffer_backend.h`` defines enum ``MemoryBufferBackend`` to represent
+// the ways ``MemoryBuffer`` can allocate memory and some helper functions to
+// convert ``MemoryBufferBackend`` values.
+//
+
+namespace mindalpha
+{
+
+//
+// Use the X Macro technique to simplify code. See the following page
+// for more information about X Macros:
+//
+//   https://en.wikipedia.org/wiki/X_Macro
+//
+// ``Malloc`` uses ``malloc``/``realloc``. ``Mmap`` uses anonymous ``mmap``
+// and grows with ``mremap`` so that the pages are moved instead of copied.
+// ``HugePage`` is ``Mmap`` with ``MADV_HUGEPAGE`` to request transparent
+// huge pages; ``HugeTlb`` maps explicit 2MB pages with ``MAP_HUGETLB`` and
+// falls back to ``HugePage`` when no huge pages are reserved.
+//
+
+#define MINDALPHA_MEMORY_BUFFER_BACKENDS(X)    \
+    X(malloc,    Malloc)                       \
+    X(mmap,      Mmap)                         \
+    X(huge_page, HugePage)                     \
+    X(huge_tlb,  HugeTlb)                      \
+    /**/
+
+enum class MemoryBufferBackend
+{
+#undef MINDALPHA_MEMORY_BUFFER_BACKEND_DEF
+#define MINDALPHA_MEMORY_BUFFER_BACKEND_DEF(l, u) u,
+    MINDALPHA_MEMORY_BUFFER_BACKENDS(MINDALPHA_MEMORY_BUFFER_BACKEND_DEF)
+};
+
+// Functions to convert ``MemoryBufferBackend`` to and from strings.
+std::string MemoryBufferBackendToString(MemoryBufferBackend backend);
+MemoryBufferBackend MemoryBufferBackendFromString(const std::string& str);
+
+}
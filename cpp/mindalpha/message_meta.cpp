@@ -14,7 +14,11 @@
 // limitations under the License.
 //
 
+#include <string.h>
+#include <stdexcept>
+#include <spdlog/spdlog.h>
 #include <mindalpha/message_meta.h>
+#include <mindalpha/stack_trace_utils.h>
 #include <thrift/transport/TBufferTransports.h>
 #include <thrift/protocol/TBinaryProtocol.h>
 #include <thrift/protocol/TJSONProtocol.h>
@@ -48,9 +52,112 @@ json11::Json MessageMeta::to_json() const
         { "body", body_ },
         { "slice_data_types", std::move(slice_data_types) },
         { "node_control", node_control_ },
+        { "data_request", data_request_ },
     };
 }
 
+//
+// Layout of the wire header of messages without node control. It is
+// followed by ``slice_count`` bytes of slice data types and then by the
+// body. Fields are in host byte order, as all nodes of a job run on hosts
+// of the same architecture.
+//
+// The magic number tells the header apart from Thrift buffers, which start
+// with the type of the first field; ``version`` must be changed whenever
+// the layout changes.
+//
+struct MessageWireHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    int32_t message_id;
+    int32_t sender;
+    int32_t receiver;
+    uint32_t flags;
+    int32_t data_request_command;
+    int32_t data_request_tensor_id;
+    int32_t data_request_flags;
+    uint32_t slice_count;
+    uint32_t body_length;
+};
+
+constexpr uint32_t MessageWireHeaderMagic = 0x4D41574D; // "MWAM" in little endian
+constexpr uint32_t MessageWireHeaderVersion = 1;
+constexpr uint32_t MessageWireIsRequestFlag = 1;
+constexpr uint32_t MessageWireIsExceptionFlag = 2;
+
+SmartArray<uint8_t> MessageMeta::PackAsBuffer() const
+{
+    if (!GetNodeControl().IsEmpty())
+        return PackAsThriftBuffer();
+    MessageWireHeader header;
+    header.magic = MessageWireHeaderMagic;
+    header.version = MessageWireHeaderVersion;
+    header.message_id = GetMessageId();
+    header.sender = GetSender();
+    header.receiver = GetReceiver();
+    header.flags = (IsRequest() ? MessageWireIsRequestFlag : 0) |
+                   (IsException() ? MessageWireIsExceptionFlag : 0);
+    header.data_request_command = static_cast<int32_t>(GetDataRequest().GetCommand());
+    header.data_request_tensor_id = GetDataRequest().GetTensorId();
+    header.data_request_flags = GetDataRequest().GetFlags();
+    header.slice_count = static_cast<uint32_t>(GetSliceDataTypes().size());
+    header.body_length = static_cast<uint32_t>(GetBody().size());
+    SmartArray<uint8_t> buf(sizeof(header) + header.slice_count + header.body_length);
+    uint8_t* ptr = buf.data();
+    memcpy(ptr, &header, sizeof(header));
+    ptr += sizeof(header);
+    for (DataType type: GetSliceDataTypes())
+        *ptr++ = static_cast<uint8_t>(type);
+    memcpy(ptr, GetBody().data(), header.body_length);
+    return buf;
+}
+
+void MessageMeta::UnpackFromBuffer(const uint8_t* ptr, size_t size)
+{
+    MessageWireHeader header;
+    if (size < sizeof(header) || memcmp(ptr, &MessageWireHeaderMagic, sizeof(uint32_t)) != 0)
+    {
+        UnpackFromThriftBuffer(ptr, size);
+        return;
+    }
+    memcpy(&header, ptr, sizeof(header));
+    if (header.version != MessageWireHeaderVersion ||
+        size != sizeof(header) + header.slice_count + header.body_length)
+    {
+        std::string serr;
+        serr.append("Corrupted message wire header detected; version: ");
+        serr.append(std::to_string(header.version));
+        serr.append(", expected version: ");
+        serr.append(std::to_string(MessageWireHeaderVersion));
+        serr.append(", size: ");
+        serr.append(std::to_string(size));
+        serr.append(", slice count: ");
+        serr.append(std::to_string(header.slice_count));
+        serr.append(", body length: ");
+        serr.append(std::to_string(header.body_length));
+        serr.append(".\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    ptr += sizeof(header);
+    SetMessageId(header.message_id);
+    SetSender(header.sender);
+    SetReceiver(header.receiver);
+    SetIsRequest((header.flags & MessageWireIsRequestFlag) != 0);
+    SetIsException((header.flags & MessageWireIsExceptionFlag) != 0);
+    DataRequest& request = GetDataRequest();
+    request.SetCommand(static_cast<DataRequestCommand>(header.data_request_command));
+    request.SetTensorId(header.data_request_tensor_id);
+    request.SetFlags(header.data_request_flags);
+    ClearSliceDataTypes();
+    for (uint32_t i = 0; i < header.slice_count; i++)
+        AddSliceDataType(static_cast<DataType>(static_cast<int8_t>(*ptr++)));
+    body_.assign(reinterpret_cast<const char*>(ptr), header.body_length);
+    node_control_ = NodeControl();
+}
+
 TMessageMeta MessageMeta::PackAsThriftObject() const
 {
     TMessageMeta meta;
@@ -76,6 +183,10 @@ TMessageMeta MessageMeta::PackAsThriftObject() const
         node.port = n.GetPort();
     }
     meta.control.barrierGroup = control.GetBarrierGroup();
+    const DataRequest& request = GetDataRequest();
+    meta.dataRequest.command = static_cast<TDataRequestCommand::type>(request.GetCommand());
+    meta.dataRequest.tensorId = request.GetTensorId();
+    meta.dataRequest.flags = request.GetFlags();
     return meta;
 }
 
@@ -123,6 +234,10 @@ void MessageMeta::UnpackFromThriftObject(TMessageMeta&& meta)
         control.AddNode(std::move(n));
     }
     control.SetBarrierGroup(meta.control.barrierGroup);
+    DataRequest& request = GetDataRequest();
+    request.SetCommand(static_cast<DataRequestCommand>(meta.dataRequest.command));
+    request.SetTensorId(meta.dataRequest.tensorId);
+    request.SetFlags(meta.dataRequest.flags);
 }
 
 void MessageMeta::UnpackFromThriftJson(const std::string& str)
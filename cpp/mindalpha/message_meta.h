@@ -18,6 +18,7 @@
 
 #include <mindalpha/data_type.h>
 #include <mindalpha/node_control.h>
+#include <mindalpha/data_request.h>
 #include <mindalpha/smart_array.h>
 #include <mindalpha/message_meta_types.h>
 
@@ -59,10 +60,20 @@ public:
     const NodeControl& GetNodeControl() const { return node_control_ ; }
     void SetNodeControl(NodeControl value) { node_control_ = std::move(value); }
 
+    DataRequest& GetDataRequest() { return data_request_; }
+    const DataRequest& GetDataRequest() const { return data_request_; }
+    void SetDataRequest(DataRequest value) { data_request_ = std::move(value); }
+
     std::string ToString() const;
     std::string ToJsonString() const;
     json11::Json to_json() const;
 
+    // Pack as the fixed-layout wire header, or as Thrift if the node
+    // control is not empty, as only the latter carries ``NodeInfo`` lists.
+    // ``UnpackFromBuffer`` accepts both.
+    SmartArray<uint8_t> PackAsBuffer() const;
+    void UnpackFromBuffer(const uint8_t* ptr, size_t size);
+
     TMessageMeta PackAsThriftObject() const;
     std::string PackAsThriftJson() const;
     SmartArray<uint8_t> PackAsThriftBuffer() const;
@@ -82,6 +93,7 @@ private:
     std::string body_;
     std::vector<DataType> slice_data_types_;
     NodeControl node_control_;
+    DataRequest data_request_;
 };
 
 }
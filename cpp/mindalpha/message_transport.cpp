@@ -18,6 +18,9 @@
 #include <spdlog/spdlog.h>
 #include <mindalpha/message_transport.h>
 #include <mindalpha/zeromq_transport.h>
+#include <mindalpha/shared_memory_transport.h>
+#include <mindalpha/tcp_transport.h>
+#include <mindalpha/inprocess_transport.h>
 #include <mindalpha/stack_trace_utils.h>
 
 namespace mindalpha
@@ -33,6 +36,22 @@ std::unique_ptr<MessageTransport> MessageTransport::Create(std::shared_ptr<Actor
     const std::string& type = config->GetTransportType();
     if (type == "ZeroMQ")
         return std::make_unique<ZeroMQTransport>(std::move(config));
+    else if (type == "SharedMemory")
+        return std::make_unique<SharedMemoryTransport>(std::move(config));
+    else if (type == "TCP")
+        return std::make_unique<TcpTransport>(std::move(config));
+    else if (type == "InProcess")
+    {
+        if (!config->IsLocalMode())
+        {
+            std::string serr;
+            serr.append("MessageTransport type 'InProcess' can only be used in local mode.\n\n");
+            serr.append(GetStackTrace());
+            spdlog::error(serr);
+            throw std::runtime_error(serr);
+        }
+        return std::make_unique<InProcessTransport>(std::move(config));
+    }
     else
     {
         std::string serr;
@@ -14,7 +14,9 @@
 // limitations under the License.
 //
 
+#include <future>
 #include <mindalpha/io.h>
+#include <mindalpha/memory_buffer.h>
 #include <mindalpha/ps_agent.h>
 #include <mindalpha/ps_runner.h>
 #include <mindalpha/pybind_utils.h>
@@ -112,6 +114,16 @@ PYBIND11_MODULE(_mindalpha, m)
                                       &mindalpha::ActorConfig::SetServerCount)
         .def_property("worker_count", &mindalpha::ActorConfig::GetWorkerCount,
                                       &mindalpha::ActorConfig::SetWorkerCount)
+        .def_property("server_thread_count", &mindalpha::ActorConfig::GetServerThreadCount,
+                                             &mindalpha::ActorConfig::SetServerThreadCount)
+        .def_property("server_parallel_thread_count", &mindalpha::ActorConfig::GetServerParallelThreadCount,
+                                                      &mindalpha::ActorConfig::SetServerParallelThreadCount)
+        .def_property("zeromq_io_thread_count", &mindalpha::ActorConfig::GetZeroMQIOThreadCount,
+                                                &mindalpha::ActorConfig::SetZeroMQIOThreadCount)
+        .def_property("shared_memory_ring_size", &mindalpha::ActorConfig::GetSharedMemoryRingSize,
+                                                 &mindalpha::ActorConfig::SetSharedMemoryRingSize)
+        .def_property("send_timeout", &mindalpha::ActorConfig::GetSendTimeout,
+                                      &mindalpha::ActorConfig::SetSendTimeout)
         .def("copy", &mindalpha::ActorConfig::Copy)
         ;
 
@@ -180,7 +192,8 @@ PYBIND11_MODULE(_mindalpha, m)
                               self.AddTypedSlice(sa);                                                       \
                           })                                                                                \
                           /**/
-        MINDALPHA_DATA_TYPES(MINDALPHA_DATA_TYPE_DEF)
+        MINDALPHA_INTEGRAL_DATA_TYPES(MINDALPHA_DATA_TYPE_DEF)
+        MINDALPHA_FLOATING_DATA_TYPES(MINDALPHA_DATA_TYPE_DEF)
         .def("copy", &mindalpha::Message::Copy)
         .def("__str__", &mindalpha::Message::ToString)
         ;
@@ -204,17 +217,29 @@ PYBIND11_MODULE(_mindalpha, m)
                             self.Barrier(mindalpha::WorkerGroup);
                         })
         .def("shutdown", &mindalpha::PSAgent::Shutdown)
+        // These keep waiting for the responses so that Python agents can rely
+        // on the callbacks having run when the calls return.
         .def("send_request", [](mindalpha::PSAgent& self,
                                 mindalpha::PSMessage req,
                                 py::object cb)
                              {
                                  auto func = mindalpha::make_shared_pyobject(cb);
                                  py::gil_scoped_release gil;
-                                 self.SendRequest(req, [func](mindalpha::PSMessage req, mindalpha::PSMessage res)
+                                 auto done = std::make_shared<std::promise<void>>();
+                                 std::future<void> future = done->get_future();
                                  {
-                                     py::gil_scoped_acquire gil;
-                                     (*func)(req, res);
-                                 });
+                                     mindalpha::PSAgent::ErrorScope scope([done](std::exception_ptr error)
+                                                                          { done->set_exception(error); });
+                                     self.SendRequest(req, [func, done](mindalpha::PSMessage req, mindalpha::PSMessage res)
+                                     {
+                                         {
+                                             py::gil_scoped_acquire gil;
+                                             (*func)(req, res);
+                                         }
+                                         done->set_value();
+                                     });
+                                 }
+                                 future.get();
                              })
         .def("send_all_requests", [](mindalpha::PSAgent& self,
                                      py::object reqs,
@@ -223,14 +248,24 @@ PYBIND11_MODULE(_mindalpha, m)
                                       auto func = mindalpha::make_shared_pyobject(cb);
                                       std::vector<mindalpha::PSMessage> requests = mindalpha::make_cpp_vector<mindalpha::PSMessage>(reqs);
                                       py::gil_scoped_release gil;
-                                      self.SendAllRequests(std::move(requests), [func](std::vector<mindalpha::PSMessage> reqs,
-                                                                                       std::vector<mindalpha::PSMessage> ress)
+                                      auto done = std::make_shared<std::promise<void>>();
+                                      std::future<void> future = done->get_future();
                                       {
-                                          py::gil_scoped_acquire gil;
-                                          py::list requests = mindalpha::make_python_list(reqs);
-                                          py::list responses = mindalpha::make_python_list(ress);
-                                          (*func)(requests, responses);
-                                      });
+                                          mindalpha::PSAgent::ErrorScope scope([done](std::exception_ptr error)
+                                                                               { done->set_exception(error); });
+                                          self.SendAllRequests(std::move(requests), [func, done](std::vector<mindalpha::PSMessage> reqs,
+                                                                                                 std::vector<mindalpha::PSMessage> ress)
+                                          {
+                                              {
+                                                  py::gil_scoped_acquire gil;
+                                                  py::list requests = mindalpha::make_python_list(reqs);
+                                                  py::list responses = mindalpha::make_python_list(ress);
+                                                  (*func)(requests, responses);
+                                              }
+                                              done->set_value();
+                                          });
+                                      }
+                                      future.get();
                                   })
         .def("broadcast_request", [](mindalpha::PSAgent& self,
                                      mindalpha::PSMessage req,
@@ -238,12 +273,22 @@ PYBIND11_MODULE(_mindalpha, m)
                                   {
                                       auto func = mindalpha::make_shared_pyobject(cb);
                                       py::gil_scoped_release gil;
-                                      self.BroadcastRequest(req, [func](mindalpha::PSMessage req, std::vector<mindalpha::PSMessage> ress)
+                                      auto done = std::make_shared<std::promise<void>>();
+                                      std::future<void> future = done->get_future();
                                       {
-                                          py::gil_scoped_acquire gil;
-                                          py::list responses = mindalpha::make_python_list(ress);
-                                          (*func)(req, responses);
-                                      });
+                                          mindalpha::PSAgent::ErrorScope scope([done](std::exception_ptr error)
+                                                                               { done->set_exception(error); });
+                                          self.BroadcastRequest(req, [func, done](mindalpha::PSMessage req, std::vector<mindalpha::PSMessage> ress)
+                                          {
+                                              {
+                                                  py::gil_scoped_acquire gil;
+                                                  py::list responses = mindalpha::make_python_list(ress);
+                                                  (*func)(req, responses);
+                                              }
+                                              done->set_value();
+                                          });
+                                      }
+                                      future.get();
                                   })
         .def("send_response", &mindalpha::PSAgent::SendResponse)
         .def("__str__", &mindalpha::PSAgent::ToString)
@@ -304,6 +349,20 @@ PYBIND11_MODULE(_mindalpha, m)
                              })
      .def("ensure_local_directory", &mindalpha::EnsureLocalDirectory)
      .def("get_mindalpha_version", []{ return _MINDALPHA_VERSION; })
+     .def("get_memory_buffer_stats", []
+                                     {
+                                         const mindalpha::MemoryBufferStats stats = mindalpha::GetMemoryBufferStats();
+                                         py::dict result;
+                                         result["buffer_bytes"] = stats.buffer_bytes;
+                                         result["peak_buffer_bytes"] = stats.peak_buffer_bytes;
+                                         result["rss_bytes"] = stats.rss_bytes;
+                                         result["peak_rss_bytes"] = stats.peak_rss_bytes;
+                                         result["anonymous_bytes"] = stats.anonymous_bytes;
+                                         result["anon_huge_page_bytes"] = stats.anon_huge_page_bytes;
+                                         result["huge_tlb_bytes"] = stats.huge_tlb_bytes;
+                                         result["huge_page_coverage"] = stats.GetHugePageCoverage();
+                                         return result;
+                                     })
      ;
 
     mindalpha::DefineTensorStoreBindings(m);
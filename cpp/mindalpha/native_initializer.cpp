@@ -0,0 +1,284 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <math.h>
+#include <vector>
+#include <mindalpha/hashtable_helpers.h>
+#include <mindalpha/native_initializer.h>
+#include <mindalpha/sparse_tensor_meta.h>
+#include <mindalpha/string_utils.h>
+
+namespace mindalpha
+{
+
+// The n-th number of a key is a hash of the key seed and n, so the
+// sequence can be reproduced anywhere from the key alone.
+class NativeInitializer::CounterRandom
+{
+public:
+    explicit CounterRandom(uint64_t seed)
+        : seed_(seed)
+    {
+    }
+
+    uint64_t Next()
+    {
+        counter_++;
+        return HashtableHelpers::MixHash(seed_ + counter_ * UINT64_C(0x9e3779b97f4a7c15));
+    }
+
+    // Uniform in [0, 1) with 53 random bits.
+    double NextUniform()
+    {
+        return static_cast<double>(Next() >> 11) * (1.0 / static_cast<double>(UINT64_C(1) << 53));
+    }
+
+    // Standard normal by the Box-Muller transform, which gives two values
+    // per pair of uniform numbers.
+    double NextNormal()
+    {
+        if (has_spare_)
+        {
+            has_spare_ = false;
+            return spare_;
+        }
+        const double u1 = 1.0 - NextUniform();
+        const double u2 = NextUniform();
+        const double r = sqrt(-2.0 * log(u1));
+        spare_ = r * sin(2.0 * M_PI * u2);
+        has_spare_ = true;
+        return r * cos(2.0 * M_PI * u2);
+    }
+
+private:
+    uint64_t seed_;
+    uint64_t counter_ = 0;
+    double spare_ = 0.0;
+    bool has_spare_ = false;
+};
+
+namespace
+{
+
+template<typename Derived>
+class NativeInitializerImpl : public NativeInitializer
+{
+protected:
+    void FillSlice(float* data, size_t n, bool is_bias, CounterRandom& random) const override
+    {
+        static_cast<const Derived*>(this)->Fill(data, n, is_bias, random);
+    }
+
+    void FillSlice(double* data, size_t n, bool is_bias, CounterRandom& random) const override
+    {
+        static_cast<const Derived*>(this)->Fill(data, n, is_bias, random);
+    }
+};
+
+class ConstantInitializer : public NativeInitializerImpl<ConstantInitializer>
+{
+public:
+    explicit ConstantInitializer(double value)
+        : value_(value)
+    {
+    }
+
+    template<typename T>
+    void Fill(T* data, size_t n, bool is_bias, CounterRandom& random) const
+    {
+        const T value = static_cast<T>(value_);
+        for (size_t i = 0; i < n; i++)
+            data[i] = value;
+    }
+
+private:
+    double value_;
+};
+
+class NormalInitializer : public NativeInitializerImpl<NormalInitializer>
+{
+public:
+    NormalInitializer(double mean, double std, bool zero_bias)
+        : mean_(mean)
+        , std_(std)
+        , zero_bias_(zero_bias)
+    {
+    }
+
+    template<typename T>
+    void Fill(T* data, size_t n, bool is_bias, CounterRandom& random) const
+    {
+        if (zero_bias_ && is_bias)
+        {
+            for (size_t i = 0; i < n; i++)
+                data[i] = T(0);
+            return;
+        }
+        for (size_t i = 0; i < n; i++)
+            data[i] = static_cast<T>(mean_ + std_ * random.NextNormal());
+    }
+
+private:
+    double mean_;
+    double std_;
+    bool zero_bias_;
+};
+
+class UniformInitializer : public NativeInitializerImpl<UniformInitializer>
+{
+public:
+    UniformInitializer(double a, double b)
+        : a_(a)
+        , b_(b)
+    {
+    }
+
+    template<typename T>
+    void Fill(T* data, size_t n, bool is_bias, CounterRandom& random) const
+    {
+        for (size_t i = 0; i < n; i++)
+            data[i] = static_cast<T>(a_ + (b_ - a_) * random.NextUniform());
+    }
+
+private:
+    double a_;
+    double b_;
+};
+
+class TruncatedNormalInitializer : public NativeInitializerImpl<TruncatedNormalInitializer>
+{
+public:
+    TruncatedNormalInitializer(double mean, double std, double a, double b)
+        : mean_(mean)
+        , std_(std)
+        , a_(a)
+        , b_(b)
+    {
+    }
+
+    template<typename T>
+    void Fill(T* data, size_t n, bool is_bias, CounterRandom& random) const
+    {
+        // ``a`` and ``b`` are absolute bounds as in ``torch.nn.init.trunc_normal_``,
+        // values outside are redrawn.
+        for (size_t i = 0; i < n; i++)
+        {
+            double x;
+            do
+                x = mean_ + std_ * random.NextNormal();
+            while (x < a_ || x > b_);
+            data[i] = static_cast<T>(x);
+        }
+    }
+
+private:
+    double mean_;
+    double std_;
+    double a_;
+    double b_;
+};
+
+}
+
+bool NativeInitializer::IsSupported(const SparseTensorMeta& meta) const
+{
+    const DataType type = meta.GetDataType();
+    return type == DataType::Float32 || type == DataType::Float64 || IsHalfDataType(type);
+}
+
+template<typename T>
+void NativeInitializer::InitializeSlices(uint64_t seed, uint8_t* data, const uint64_t* keys,
+                                         size_t key_count, bool is_bias,
+                                         const SparseTensorMeta& meta) const
+{
+    const size_t elements = meta.GetSliceDataLength() / sizeof(T);
+    for (size_t i = 0; i < key_count; i++)
+    {
+        CounterRandom random(HashtableHelpers::MixHash(seed ^ keys[i]));
+        T* const slice = reinterpret_cast<T*>(data + meta.GetSliceTotalBytes() * i);
+        FillSlice(slice, elements, is_bias, random);
+    }
+}
+
+template<typename H>
+void NativeInitializer::InitializeHalfSlices(uint64_t seed, uint8_t* data, const uint64_t* keys,
+                                             size_t key_count, bool is_bias,
+                                             const SparseTensorMeta& meta) const
+{
+    // Values are drawn as ``float`` and rounded, so a key gets the same
+    // initial value as in a ``float32`` tensor up to the precision.
+    const size_t elements = meta.GetSliceDataLength() / sizeof(H);
+    std::vector<float> buffer(elements);
+    for (size_t i = 0; i < key_count; i++)
+    {
+        CounterRandom random(HashtableHelpers::MixHash(seed ^ keys[i]));
+        H* const slice = reinterpret_cast<H*>(data + meta.GetSliceTotalBytes() * i);
+        FillSlice(buffer.data(), elements, is_bias, random);
+        for (size_t j = 0; j < elements; j++)
+            slice[j] = H(buffer[j]);
+    }
+}
+
+void NativeInitializer::InitializeSparse(const std::string& name,
+                                         SmartArray<uint8_t> data,
+                                         SmartArray<uint8_t> keys,
+                                         const SparseTensorMeta& meta) const
+{
+    // Mix the tensor name into the seed, so that tensors sharing keys
+    // are not initialized with the same values.
+    const uint64_t seed = HashtableHelpers::MixHash(BKDRHash(name));
+    const bool is_bias = name.size() >= 4 && name.compare(name.size() - 4, 4, "bias") == 0;
+    const uint64_t* const key_data = reinterpret_cast<const uint64_t*>(keys.data());
+    const size_t key_count = keys.size() / sizeof(uint64_t);
+    switch (meta.GetDataType())
+    {
+    case DataType::Float32:
+        InitializeSlices<float>(seed, data.data(), key_data, key_count, is_bias, meta);
+        break;
+    case DataType::Float16:
+        InitializeHalfSlices<float16>(seed, data.data(), key_data, key_count, is_bias, meta);
+        break;
+    case DataType::BFloat16:
+        InitializeHalfSlices<bfloat16>(seed, data.data(), key_data, key_count, is_bias, meta);
+        break;
+    default:
+        InitializeSlices<double>(seed, data.data(), key_data, key_count, is_bias, meta);
+        break;
+    }
+}
+
+std::shared_ptr<NativeInitializer> NativeInitializer::CreateConstant(double value)
+{
+    return std::make_shared<ConstantInitializer>(value);
+}
+
+std::shared_ptr<NativeInitializer> NativeInitializer::CreateNormal(double mean, double std, bool zero_bias)
+{
+    return std::make_shared<NormalInitializer>(mean, std, zero_bias);
+}
+
+std::shared_ptr<NativeInitializer> NativeInitializer::CreateUniform(double a, double b)
+{
+    return std::make_shared<UniformInitializer>(a, b);
+}
+
+std::shared_ptr<NativeInitializer> NativeInitializer::CreateTruncatedNormal(double mean, double std, double a, double b)
+{
+    return std::make_shared<TruncatedNormalInitializer>(mean, std, a, b);
+}
+
+}
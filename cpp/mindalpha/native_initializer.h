@@ -0,0 +1,82 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <mindalpha/smart_array.h>
+
+//
+// ``native_initializer.h`` defines class ``NativeInitializer`` which
+// implements the built-in tensor initializers in ``mindalpha/initializer.py``
+// in C++, so that servers can initialize newly created keys of sparse tensors
+// without acquiring the GIL.
+//
+// Random values are drawn from a counter-based generator seeded with the
+// tensor name and the key, so the initial value of a key does not depend on
+// which server, partition or batch creates it.
+//
+
+namespace mindalpha
+{
+
+class SparseTensorMeta;
+
+class NativeInitializer
+{
+public:
+    virtual ~NativeInitializer() { }
+
+    // Check whether the data type described by ``meta`` can be initialized
+    // natively.
+    bool IsSupported(const SparseTensorMeta& meta) const;
+
+    // Equivalent to ``initialize_sparse`` of the Python class. ``data`` holds
+    // whole slices of the keys in ``keys``, only the data parts are filled.
+    void InitializeSparse(const std::string& name,
+                          SmartArray<uint8_t> data,
+                          SmartArray<uint8_t> keys,
+                          const SparseTensorMeta& meta) const;
+
+    static std::shared_ptr<NativeInitializer> CreateConstant(double value);
+    static std::shared_ptr<NativeInitializer> CreateNormal(double mean, double std, bool zero_bias);
+    static std::shared_ptr<NativeInitializer> CreateUniform(double a, double b);
+    static std::shared_ptr<NativeInitializer> CreateTruncatedNormal(double mean, double std, double a, double b);
+
+protected:
+    class CounterRandom;
+
+    // Fill the ``n`` data elements of one slice, ``is_bias`` tells whether
+    // the tensor name ends with ``bias``.
+    virtual void FillSlice(float* data, size_t n, bool is_bias, CounterRandom& random) const = 0;
+    virtual void FillSlice(double* data, size_t n, bool is_bias, CounterRandom& random) const = 0;
+
+private:
+    template<typename T>
+    void InitializeSlices(uint64_t seed, uint8_t* data, const uint64_t* keys,
+                          size_t key_count, bool is_bias,
+                          const SparseTensorMeta& meta) const;
+
+    template<typename H>
+    void InitializeHalfSlices(uint64_t seed, uint8_t* data, const uint64_t* keys,
+                              size_t key_count, bool is_bias,
+                              const SparseTensorMeta& meta) const;
+};
+
+}
@@ -0,0 +1,397 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <math.h>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <mindalpha/native_updater.h>
+#include <mindalpha/dense_tensor_meta.h>
+#include <mindalpha/sparse_tensor_meta.h>
+#include <mindalpha/stack_trace_utils.h>
+
+//
+// The loops below are written so that the compiler can vectorize them over
+// the embedding dimension; ``native_updater.cpp`` is compiled with
+// ``-ftree-vectorize -fno-math-errno -fno-trapping-math`` for that. Fast math
+// is not enabled and the operations are done in the same order and precision
+// as the torch code in ``updater.py``, so the results are the same as the
+// Python ones.
+//
+
+namespace mindalpha
+{
+
+namespace
+{
+
+template<typename Derived>
+class NativeUpdaterImpl : public NativeUpdater
+{
+protected:
+    void UpdateRow(float* param, const float* grad, float* state, size_t n) const override
+    {
+        static_cast<const Derived*>(this)->Apply(param, grad, state, n);
+    }
+
+    void UpdateRow(double* param, const double* grad, double* state, size_t n) const override
+    {
+        static_cast<const Derived*>(this)->Apply(param, grad, state, n);
+    }
+};
+
+class NoOpUpdater : public NativeUpdaterImpl<NoOpUpdater>
+{
+public:
+    size_t GetStatesPerParam() const override { return 0; }
+
+    template<typename T>
+    void Apply(T* param, const T* grad, T* state, size_t n) const
+    {
+    }
+};
+
+class SGDUpdater : public NativeUpdaterImpl<SGDUpdater>
+{
+public:
+    explicit SGDUpdater(double learning_rate)
+        : learning_rate_(learning_rate)
+    {
+    }
+
+    size_t GetStatesPerParam() const override { return 0; }
+
+    template<typename T>
+    void Apply(T* __restrict param, const T* __restrict grad, T* state, size_t n) const
+    {
+        const T lr = static_cast<T>(learning_rate_);
+        for (size_t i = 0; i < n; i++)
+            param[i] -= lr * grad[i];
+    }
+
+private:
+    double learning_rate_;
+};
+
+class AdaGradUpdater : public NativeUpdaterImpl<AdaGradUpdater>
+{
+public:
+    AdaGradUpdater(double learning_rate, double float_stable_eps, double l2)
+        : learning_rate_(learning_rate)
+        , float_stable_eps_(float_stable_eps)
+        , l2_(l2)
+    {
+    }
+
+    size_t GetStatesPerParam() const override { return 1; }
+
+    template<typename T>
+    void Apply(T* __restrict param, const T* __restrict grad, T* __restrict state, size_t n) const
+    {
+        const T lr = static_cast<T>(learning_rate_);
+        const T eps = static_cast<T>(float_stable_eps_);
+        const T l2 = static_cast<T>(l2_);
+        T* const __restrict square_sum = state;
+        for (size_t i = 0; i < n; i++)
+        {
+            const T g = grad[i] + l2 * param[i];
+            square_sum[i] += g * g;
+            param[i] -= lr * g / sqrt(square_sum[i] + eps);
+        }
+    }
+
+private:
+    double learning_rate_;
+    double float_stable_eps_;
+    double l2_;
+};
+
+class AdamUpdater : public NativeUpdaterImpl<AdamUpdater>
+{
+public:
+    AdamUpdater(double learning_rate, double beta1, double beta2, double epsilon)
+        : learning_rate_(learning_rate)
+        , beta1_(beta1)
+        , beta2_(beta2)
+        , epsilon_(epsilon)
+    {
+    }
+
+    size_t GetStatesPerParam() const override { return 2; }
+
+    template<typename T>
+    void Apply(T* __restrict param, const T* __restrict grad, T* __restrict state, size_t n) const
+    {
+        const T lr = static_cast<T>(learning_rate_);
+        const T beta1 = static_cast<T>(beta1_);
+        const T beta2 = static_cast<T>(beta2_);
+        const T one_minus_beta1 = static_cast<T>(1.0 - beta1_);
+        const T one_minus_beta2 = static_cast<T>(1.0 - beta2_);
+        const T epsilon = static_cast<T>(epsilon_);
+        T* const __restrict m = state;
+        T* const __restrict v = state + n;
+        for (size_t i = 0; i < n; i++)
+        {
+            const T g = grad[i];
+            m[i] = beta1 * m[i] + one_minus_beta1 * g;
+            v[i] = beta2 * v[i] + one_minus_beta2 * g * g;
+            param[i] -= lr * m[i] / (sqrt(v[i]) + epsilon);
+        }
+    }
+
+private:
+    double learning_rate_;
+    double beta1_;
+    double beta2_;
+    double epsilon_;
+};
+
+class FTRLUpdater : public NativeUpdaterImpl<FTRLUpdater>
+{
+public:
+    FTRLUpdater(double l1, double l2, double alpha, double beta)
+        : l1_(l1)
+        , l2_(l2)
+        , alpha_(alpha)
+        , beta_(beta)
+    {
+    }
+
+    size_t GetStatesPerParam() const override { return 2; }
+
+    template<typename T>
+    void Apply(T* __restrict param, const T* __restrict grad, T* __restrict state, size_t n) const
+    {
+        const T l1 = static_cast<T>(l1_);
+        const T l2 = static_cast<T>(l2_);
+        const T alpha = static_cast<T>(alpha_);
+        const T beta = static_cast<T>(beta_);
+        T* const __restrict sn = state;
+        T* const __restrict z = state + n;
+        for (size_t i = 0; i < n; i++)
+        {
+            const T g = grad[i];
+            const T g2 = g * g;
+            const T sigma = (sqrt(sn[i] + g2) - sqrt(sn[i])) / alpha;
+            z[i] = z[i] + g - sigma * param[i];
+            sn[i] = sn[i] + g2;
+            const T sign = z[i] > T(0) ? T(1) : T(-1);
+            const T y = -(z[i] - sign * l1) / ((beta + sqrt(sn[i])) / alpha + l2);
+            param[i] = fabs(z[i]) <= l1 ? T(0) : y;
+        }
+    }
+
+private:
+    double l1_;
+    double l2_;
+    double alpha_;
+    double beta_;
+};
+
+}
+
+bool NativeUpdater::IsSupported(const DenseTensorMeta& meta) const
+{
+    const DataType type = meta.GetDataType();
+    if (type != DataType::Float32 && type != DataType::Float64)
+        return false;
+    // Like the slice shape of sparse tensors, the state shape is the data
+    // shape with the last dimension multiplied by ``states_per_param``.
+    const std::vector<size_t>& data_shape = meta.GetDataShape();
+    const std::vector<size_t>& state_shape = meta.GetStateShape();
+    const size_t states = GetStatesPerParam();
+    if (states == 0)
+        return state_shape.empty();
+    if (data_shape.empty() || state_shape.size() != data_shape.size())
+        return false;
+    for (size_t i = 0; i + 1 < data_shape.size(); i++)
+        if (state_shape.at(i) != data_shape.at(i))
+            return false;
+    return state_shape.back() == data_shape.back() * states;
+}
+
+bool NativeUpdater::IsSupported(const SparseTensorMeta& meta) const
+{
+    const DataType type = meta.GetDataType();
+    if (type != DataType::Float32 && type != DataType::Float64 && !IsHalfDataType(type))
+        return false;
+    const size_t data_items = meta.GetSliceDataLength() / DataTypeToSize(type);
+    const size_t state_items = meta.GetSliceStateLength() / DataTypeToSize(DataTypeToStateType(type));
+    return state_items == data_items * GetStatesPerParam();
+}
+
+template<typename T>
+void NativeUpdater::UpdateRows(T* param, const T* grad, T* state, size_t elements, size_t width) const
+{
+    // Like ``get_state_tensor`` in Python, the states are interleaved along
+    // the last dimension of the data shape.
+    const size_t states = GetStatesPerParam();
+    if (states == 0)
+    {
+        UpdateRow(param, grad, state, elements);
+        return;
+    }
+    for (size_t j = 0; j < elements; j += width)
+        UpdateRow(param + j, grad + j, state + j * states, width);
+}
+
+template<typename T>
+void NativeUpdater::UpdateSlices(uint8_t* param, const uint8_t* grad,
+                                 const uint64_t* indices, size_t index_count,
+                                 const SparseTensorMeta& meta) const
+{
+    using S = typename StateTypeOf<T>::type;
+    constexpr bool is_half = !std::is_same_v<T, S>;
+    const std::vector<size_t>& shape = meta.GetSliceDataShape();
+    const size_t width = shape.empty() ? 1 : shape.back();
+    const size_t elements = meta.GetSliceDataLength() / sizeof(T);
+    const size_t slice_bytes = meta.GetSliceTotalBytes();
+    const size_t prefetch_distance = 4;
+    std::vector<S> param_buffer(is_half ? elements : 0);
+    std::vector<S> grad_buffer(is_half ? elements : 0);
+    for (size_t i = 0; i < index_count; i++)
+    {
+        if (i + prefetch_distance < index_count)
+            __builtin_prefetch(param + slice_bytes * indices[i + prefetch_distance], 1);
+        uint8_t* const slice = param + slice_bytes * indices[i];
+        T* const slice_param = reinterpret_cast<T*>(slice);
+        S* const slice_state = reinterpret_cast<S*>(slice + meta.GetSliceStateOffset());
+        const T* const slice_grad = reinterpret_cast<const T*>(grad) + elements * i;
+        if constexpr (is_half)
+        {
+            // Half precision parameters are widened to ``float``, updated
+            // against the ``float`` states and rounded back.
+            for (size_t j = 0; j < elements; j++)
+            {
+                param_buffer[j] = static_cast<S>(slice_param[j]);
+                grad_buffer[j] = static_cast<S>(slice_grad[j]);
+            }
+            UpdateRows(param_buffer.data(), grad_buffer.data(), slice_state, elements, width);
+            for (size_t j = 0; j < elements; j++)
+                slice_param[j] = T(param_buffer[j]);
+        }
+        else
+            UpdateRows(slice_param, slice_grad, slice_state, elements, width);
+    }
+}
+
+void NativeUpdater::UpdateDense(SmartArray<uint8_t> param,
+                                SmartArray<uint8_t> grad,
+                                SmartArray<uint8_t> state,
+                                const DenseTensorMeta& meta) const
+{
+    if (grad.size() != param.size())
+    {
+        std::string serr;
+        serr.append("Can not update dense tensor '");
+        serr.append(meta.GetName());
+        serr.append("', as the gradient size ");
+        serr.append(std::to_string(grad.size()));
+        serr.append(" does not match the parameter size ");
+        serr.append(std::to_string(param.size()));
+        serr.append(".\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    const std::vector<size_t>& shape = meta.GetDataShape();
+    const size_t width = shape.empty() ? 1 : shape.back();
+    if (meta.GetDataType() == DataType::Float32)
+    {
+        const size_t elements = param.size() / sizeof(float);
+        UpdateRows(reinterpret_cast<float*>(param.data()),
+                   reinterpret_cast<const float*>(grad.data()),
+                   reinterpret_cast<float*>(state.data()),
+                   elements, width);
+    }
+    else
+    {
+        const size_t elements = param.size() / sizeof(double);
+        UpdateRows(reinterpret_cast<double*>(param.data()),
+                   reinterpret_cast<const double*>(grad.data()),
+                   reinterpret_cast<double*>(state.data()),
+                   elements, width);
+    }
+}
+
+void NativeUpdater::UpdateSparse(SmartArray<uint8_t> param,
+                                 SmartArray<uint8_t> grad,
+                                 SmartArray<uint8_t> indices,
+                                 const SparseTensorMeta& meta) const
+{
+    const size_t index_count = indices.size() / sizeof(uint64_t);
+    if (grad.size() != index_count * meta.GetSliceDataLength())
+    {
+        std::string serr;
+        serr.append("Can not update sparse tensor '");
+        serr.append(meta.GetName());
+        serr.append("', as the gradient size ");
+        serr.append(std::to_string(grad.size()));
+        serr.append(" does not match ");
+        serr.append(std::to_string(index_count));
+        serr.append(" slices of ");
+        serr.append(std::to_string(meta.GetSliceDataLength()));
+        serr.append(" bytes.\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    const uint64_t* const index_data = reinterpret_cast<const uint64_t*>(indices.data());
+    switch (meta.GetDataType())
+    {
+    case DataType::Float32:
+        UpdateSlices<float>(param.data(), grad.data(), index_data, index_count, meta);
+        break;
+    case DataType::Float16:
+        UpdateSlices<float16>(param.data(), grad.data(), index_data, index_count, meta);
+        break;
+    case DataType::BFloat16:
+        UpdateSlices<bfloat16>(param.data(), grad.data(), index_data, index_count, meta);
+        break;
+    default:
+        UpdateSlices<double>(param.data(), grad.data(), index_data, index_count, meta);
+        break;
+    }
+}
+
+std::shared_ptr<NativeUpdater> NativeUpdater::CreateNoOp()
+{
+    return std::make_shared<NoOpUpdater>();
+}
+
+std::shared_ptr<NativeUpdater> NativeUpdater::CreateSGD(double learning_rate)
+{
+    return std::make_shared<SGDUpdater>(learning_rate);
+}
+
+std::shared_ptr<NativeUpdater> NativeUpdater::CreateAdaGrad(double learning_rate, double float_stable_eps, double l2)
+{
+    return std::make_shared<AdaGradUpdater>(learning_rate, float_stable_eps, l2);
+}
+
+std::shared_ptr<NativeUpdater> NativeUpdater::CreateAdam(double learning_rate, double beta1, double beta2, double epsilon)
+{
+    return std::make_shared<AdamUpdater>(learning_rate, beta1, beta2, epsilon);
+}
+
+std::shared_ptr<NativeUpdater> NativeUpdater::CreateFTRL(double l1, double l2, double alpha, double beta)
+{
+    return std::make_shared<FTRLUpdater>(l1, l2, alpha, beta);
+}
+
+}
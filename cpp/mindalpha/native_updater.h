@@ -0,0 +1,90 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <mindalpha/smart_array.h>
+
+//
+// ``native_updater.h`` defines class ``NativeUpdater`` which implements the
+// math of the built-in tensor updaters in ``mindalpha/updater.py`` in C++.
+// Servers apply them directly to the partition memory without acquiring
+// the GIL or creating numpy and torch objects.
+//
+
+namespace mindalpha
+{
+
+class DenseTensorMeta;
+class SparseTensorMeta;
+
+class NativeUpdater
+{
+public:
+    virtual ~NativeUpdater() { }
+
+    // The same as ``states_per_param`` of the Python class, zero for none.
+    virtual size_t GetStatesPerParam() const = 0;
+
+    // Check whether the data type and layout described by ``meta`` can be
+    // updated natively.
+    bool IsSupported(const DenseTensorMeta& meta) const;
+    bool IsSupported(const SparseTensorMeta& meta) const;
+
+    // Equivalent to ``update_dense`` of the Python class, ``param``, ``grad``
+    // and ``state`` are the buffers of a dense tensor partition.
+    void UpdateDense(SmartArray<uint8_t> param,
+                     SmartArray<uint8_t> grad,
+                     SmartArray<uint8_t> state,
+                     const DenseTensorMeta& meta) const;
+
+    // Equivalent to ``update_sparse`` of the Python class. ``param`` is the
+    // values array of a sparse tensor partition and ``grad`` holds the
+    // gradients of the slices selected by ``indices``. As with keys pushed by
+    // workers, ``indices`` must not contain duplicates. Half precision
+    // parameters are updated in ``float`` against ``float`` states.
+    void UpdateSparse(SmartArray<uint8_t> param,
+                      SmartArray<uint8_t> grad,
+                      SmartArray<uint8_t> indices,
+                      const SparseTensorMeta& meta) const;
+
+    static std::shared_ptr<NativeUpdater> CreateNoOp();
+    static std::shared_ptr<NativeUpdater> CreateSGD(double learning_rate);
+    static std::shared_ptr<NativeUpdater> CreateAdaGrad(double learning_rate, double float_stable_eps, double l2);
+    static std::shared_ptr<NativeUpdater> CreateAdam(double learning_rate, double beta1, double beta2, double epsilon);
+    static std::shared_ptr<NativeUpdater> CreateFTRL(double l1, double l2, double alpha, double beta);
+
+protected:
+    // Update ``n`` consecutive parameters. ``state`` points to
+    // ``GetStatesPerParam()`` consecutive blocks of ``n`` elements each,
+    // matching ``TensorUpdater.get_state_tensor`` in Python.
+    virtual void UpdateRow(float* param, const float* grad, float* state, size_t n) const = 0;
+    virtual void UpdateRow(double* param, const double* grad, double* state, size_t n) const = 0;
+
+private:
+    template<typename T>
+    void UpdateRows(T* param, const T* grad, T* state, size_t elements, size_t width) const;
+
+    template<typename T>
+    void UpdateSlices(uint8_t* param, const uint8_t* grad,
+                      const uint64_t* indices, size_t index_count,
+                      const SparseTensorMeta& meta) const;
+};
+
+}
@@ -0,0 +1,141 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mindalpha/parallel_for.h>
+
+namespace mindalpha
+{
+
+struct ParallelForPool::Job
+{
+    const Body* body;
+    size_t count;
+    size_t chunk_size;
+    size_t chunk_count;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> finished{0};
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::exception_ptr error;
+};
+
+ParallelForPool::ParallelForPool(int thread_count)
+{
+    threads_.reserve(thread_count);
+    for (int i = 0; i < thread_count; i++)
+        threads_.emplace_back([this] { Execute(); });
+}
+
+ParallelForPool::~ParallelForPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (std::thread& thread : threads_)
+        thread.join();
+}
+
+void ParallelForPool::Work(Job& job)
+{
+    for (;;)
+    {
+        const size_t chunk = job.next.fetch_add(1);
+        if (chunk >= job.chunk_count)
+            return;
+        const size_t begin = chunk * job.chunk_size;
+        const size_t end = std::min(begin + job.chunk_size, job.count);
+        try
+        {
+            (*job.body)(begin, end);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(job.mutex);
+            if (!job.error)
+                job.error = std::current_exception();
+        }
+        if (job.finished.fetch_add(1) + 1 == job.chunk_count)
+        {
+            std::lock_guard<std::mutex> lock(job.mutex);
+            job.cv.notify_all();
+        }
+    }
+}
+
+void ParallelForPool::Execute()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;)
+    {
+        cv_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+        if (stopping_)
+            break;
+        std::shared_ptr<Job> job = jobs_.front();
+        if (job->next >= job->chunk_count)
+        {
+            // All chunks are claimed, the remaining ones are in progress.
+            jobs_.pop_front();
+            continue;
+        }
+        lock.unlock();
+        Work(*job);
+        lock.lock();
+    }
+}
+
+void ParallelForPool::Run(size_t count, size_t chunk_size, const Body& body)
+{
+    if (count == 0)
+        return;
+    chunk_size = std::max<size_t>(chunk_size, 1);
+    const size_t chunk_count = (count + chunk_size - 1) / chunk_size;
+    if (chunk_count == 1 || threads_.empty())
+    {
+        body(0, count);
+        return;
+    }
+    auto job = std::make_shared<Job>();
+    job->body = &body;
+    job->count = count;
+    job->chunk_size = chunk_size;
+    job->chunk_count = chunk_count;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push_back(job);
+    }
+    cv_.notify_all();
+    Work(*job);
+    {
+        std::unique_lock<std::mutex> lock(job->mutex);
+        job->cv.wait(lock, [&job] { return job->finished == job->chunk_count; });
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find(jobs_.begin(), jobs_.end(), job);
+        if (it != jobs_.end())
+            jobs_.erase(it);
+    }
+    if (job->error)
+        std::rethrow_exception(job->error);
+}
+
+}
@@ -0,0 +1,73 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#pragma once
+
+#include <stddef.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//
+// ``parallel_for.h`` defines class ``ParallelForPool`` which splits loops
+// over large requests into chunks and runs them on a pool of helper threads.
+//
+// Chunks are claimed from a shared counter, so threads which finish early
+// take over the remaining chunks of slower ones. The calling thread takes
+// part in its own loop, so ``Run`` makes progress even when all helper
+// threads are busy with loops of other requests.
+//
+
+namespace mindalpha
+{
+
+class ParallelForPool
+{
+public:
+    using Body = std::function<void(size_t begin, size_t end)>;
+
+    explicit ParallelForPool(int thread_count);
+    ~ParallelForPool();
+
+    ParallelForPool(const ParallelForPool&) = delete;
+    ParallelForPool& operator=(const ParallelForPool&) = delete;
+
+    int GetThreadCount() const { return static_cast<int>(threads_.size()); }
+
+    // Call ``body`` on consecutive ranges of at most ``chunk_size`` covering
+    // ``[0, count)`` and wait for all of them. The first exception thrown by
+    // ``body`` is rethrown after all chunks have finished.
+    void Run(size_t count, size_t chunk_size, const Body& body);
+
+private:
+    struct Job;
+
+    void Work(Job& job);
+    void Execute();
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::shared_ptr<Job>> jobs_;
+    bool stopping_ = false;
+    std::vector<std::thread> threads_;
+};
+
+}
@@ -40,6 +40,13 @@ int PSAgent::GetAgentRank() const
     return NodeIdToRank(nodeId);
 }
 
+std::shared_ptr<ParallelForPool> PSAgent::GetParallelForPool() const
+{
+    if (!actor_process_)
+        return nullptr;
+    return actor_process_->parallel_pool_;
+}
+
 void PSAgent::Barrier(int group)
 {
     actor_process_->Barrier(group);
@@ -59,6 +66,19 @@ void PSAgent::Shutdown()
     }
 }
 
+thread_local ErrorCallback PSAgent::ErrorScope::current_;
+
+PSAgent::ErrorScope::ErrorScope(ErrorCallback cb)
+    : saved_(std::move(current_))
+{
+    current_ = std::move(cb);
+}
+
+PSAgent::ErrorScope::~ErrorScope()
+{
+    current_ = std::move(saved_);
+}
+
 void PSAgent::SendRequest(PSMessage req, SingleCallback cb)
 {
     req->GetMessageMeta().SetIsRequest(true);
@@ -76,39 +96,19 @@ void PSAgent::SendRequest(PSMessage req, SingleCallback cb)
         spdlog::error(serr);
         throw std::runtime_error(serr);
     }
-    TrackerEntry entry;
-    entry.total = nodeIds.size();
-    PSMessage response;
+    const int64_t message_id = TrackRequest(nodeIds.size(), [req, cb](std::vector<PSMessage> ress) {
+        cb(req, ress.at(0));
+    });
+    req->GetMessageMeta().SetMessageId(message_id);
+    try
     {
-        std::unique_lock<std::mutex> lock(tracker_mutex_);
-        const int64_t message_id = actor_process_->GetMessageId();
-        req->GetMessageMeta().SetMessageId(message_id);
-        tracker_.insert(std::make_pair(message_id, entry));
         actor_process_->Send(*req);
-        tracker_cv_.wait(lock, [this, message_id] {
-            const TrackerEntry& ent = tracker_.at(message_id);
-            return ent.responses.size() == ent.total;
-        });
-        TrackerEntry& e = tracker_.at(message_id);
-        std::vector<PSMessage> responses = std::move(e.responses);
-        response = responses.at(0);
-        e.Clear();
-        tracker_.erase(message_id);
     }
-    if (response->GetMessageMeta().IsException())
+    catch (...)
     {
-        std::string serr;
-        serr.append(NodeIdToString(response->GetMessageMeta().GetReceiver()));
-        serr.append(": remote node ");
-        serr.append(NodeIdToString(response->GetMessageMeta().GetSender()));
-        serr.append(" returned exception. ");
-        serr.append(response->GetMessageMeta().GetBody());
-        serr.append("\n\n");
-        serr.append(GetStackTrace());
-        spdlog::error(serr);
-        throw std::runtime_error(serr);
+        UntrackRequest(message_id);
+        throw;
     }
-    cb(req, response);
 }
 
 void PSAgent::SendAllRequests(std::vector<PSMessage> reqs, MultipleCallback cb)
@@ -130,45 +130,23 @@ void PSAgent::SendAllRequests(std::vector<PSMessage> reqs, MultipleCallback cb)
             throw std::runtime_error(serr);
         }
     }
-    TrackerEntry entry;
-    entry.total = reqs.size();
-    std::vector<PSMessage> responses;
+    const int64_t message_id = TrackRequest(reqs.size(), [reqs, cb](std::vector<PSMessage> ress) {
+        cb(reqs, std::move(ress));
+    });
+    try
     {
-        std::unique_lock<std::mutex> lock(tracker_mutex_);
-        const int64_t message_id = actor_process_->GetMessageId();
-        tracker_.insert(std::make_pair(message_id, entry));
         for (const PSMessage& req : reqs)
         {
             req->GetMessageMeta().SetIsRequest(true);
             req->GetMessageMeta().SetMessageId(message_id);
             actor_process_->Send(*req);
         }
-        tracker_cv_.wait(lock, [this, message_id] {
-            const TrackerEntry& ent = tracker_.at(message_id);
-            return ent.responses.size() == ent.total;
-        });
-        TrackerEntry& e = tracker_.at(message_id);
-        responses = std::move(e.responses);
-        e.Clear();
-        tracker_.erase(message_id);
     }
-    for (PSMessage& res : responses)
+    catch (...)
     {
-        if (res->GetMessageMeta().IsException())
-        {
-            std::string serr;
-            serr.append(NodeIdToString(res->GetMessageMeta().GetReceiver()));
-            serr.append(": remote node ");
-            serr.append(NodeIdToString(res->GetMessageMeta().GetSender()));
-            serr.append(" returned exception. ");
-            serr.append(res->GetMessageMeta().GetBody());
-            serr.append("\n\n");
-            serr.append(GetStackTrace());
-            spdlog::error(serr);
-            throw std::runtime_error(serr);
-        }
+        UntrackRequest(message_id);
+        throw;
     }
-    cb(std::move(reqs), std::move(responses));
 }
 
 void PSAgent::BroadcastRequest(PSMessage req, BroadcastCallback cb)
@@ -188,45 +166,113 @@ void PSAgent::BroadcastRequest(PSMessage req, BroadcastCallback cb)
         spdlog::error(serr);
         throw std::runtime_error(serr);
     }
-    TrackerEntry entry;
-    entry.total = nodeIds.size();
-    std::vector<PSMessage> responses;
+    const int64_t message_id = TrackRequest(nodeIds.size(), [req, cb](std::vector<PSMessage> ress) {
+        cb(req, std::move(ress));
+    });
+    req->GetMessageMeta().SetMessageId(message_id);
+    try
     {
-        std::unique_lock<std::mutex> lock(tracker_mutex_);
-        const int64_t message_id = actor_process_->GetMessageId();
-        req->GetMessageMeta().SetMessageId(message_id);
-        tracker_.insert(std::make_pair(message_id, entry));
         for (int nodeId: nodeIds)
         {
             req->GetMessageMeta().SetReceiver(nodeId);
             actor_process_->Send(*req);
         }
-        tracker_cv_.wait(lock, [this, message_id] {
-            const TrackerEntry& ent = tracker_.at(message_id);
-            return ent.responses.size() == ent.total;
-        });
-        TrackerEntry& e = tracker_.at(message_id);
-        responses = std::move(e.responses);
-        e.Clear();
-        tracker_.erase(message_id);
     }
-    for (PSMessage& res : responses)
+    catch (...)
+    {
+        UntrackRequest(message_id);
+        throw;
+    }
+}
+
+int64_t PSAgent::TrackRequest(int total, CompletionCallback complete)
+{
+    TrackerEntry entry;
+    entry.total = total;
+    entry.complete = std::move(complete);
+    entry.error = ErrorScope::GetCurrent();
+    const int64_t message_id = actor_process_->GetMessageId();
+    if (total == 0)
+        SubmitCompletion(std::move(entry));
+    else
     {
-        if (res->GetMessageMeta().IsException())
+        std::lock_guard<std::mutex> lock(tracker_mutex_);
+        tracker_.insert(std::make_pair(message_id, std::move(entry)));
+    }
+    return message_id;
+}
+
+void PSAgent::UntrackRequest(int64_t message_id)
+{
+    std::lock_guard<std::mutex> lock(tracker_mutex_);
+    tracker_.erase(message_id);
+}
+
+void PSAgent::SubmitCompletion(TrackerEntry entry)
+{
+    // Callbacks may acquire the GIL or send further requests, so they must
+    // not run on the receiving thread.
+    auto task = std::make_shared<TrackerEntry>(std::move(entry));
+    actor_process_->completion_executor_->Submit({}, [this, task] {
+        CompleteRequest(std::move(*task));
+    });
+}
+
+void PSAgent::CompleteRequest(TrackerEntry entry)
+{
+    ErrorScope scope(entry.error);
+    try
+    {
+        for (PSMessage& res : entry.responses)
         {
-            std::string serr;
-            serr.append(NodeIdToString(res->GetMessageMeta().GetReceiver()));
-            serr.append(": remote node ");
-            serr.append(NodeIdToString(res->GetMessageMeta().GetSender()));
-            serr.append(" returned exception. ");
-            serr.append(res->GetMessageMeta().GetBody());
-            serr.append("\n\n");
-            serr.append(GetStackTrace());
-            spdlog::error(serr);
-            throw std::runtime_error(serr);
+            if (res->GetMessageMeta().IsException())
+            {
+                std::string serr;
+                serr.append(NodeIdToString(res->GetMessageMeta().GetReceiver()));
+                serr.append(": remote node ");
+                serr.append(NodeIdToString(res->GetMessageMeta().GetSender()));
+                serr.append(" returned exception. ");
+                serr.append(res->GetMessageMeta().GetBody());
+                serr.append("\n\n");
+                serr.append(GetStackTrace());
+                spdlog::error(serr);
+                throw std::runtime_error(serr);
+            }
         }
+        entry.complete(std::move(entry.responses));
+    }
+    catch (...)
+    {
+        ReportError(entry.error, std::current_exception());
+    }
+}
+
+void PSAgent::ReportError(const ErrorCallback& error, std::exception_ptr exc) const
+{
+    if (error)
+    {
+        try
+        {
+            error(exc);
+            return;
+        }
+        catch (const std::exception& e)
+        {
+            spdlog::error("{}: Error callback of asynchronous request throws. {}", ToString(), e.what());
+        }
+    }
+    try
+    {
+        std::rethrow_exception(exc);
+    }
+    catch (const std::exception& e)
+    {
+        spdlog::error("{}: Unhandled error of asynchronous request. {}", ToString(), e.what());
+    }
+    catch (...)
+    {
+        spdlog::error("{}: Unhandled error of asynchronous request.", ToString());
     }
-    cb(req, std::move(responses));
 }
 
 void PSAgent::SendResponse(PSMessage req, PSMessage res)
@@ -259,6 +305,12 @@ void PSAgent::SendResponse(PSMessage req, PSMessage res)
     }
 }
 
+void PSAgent::DispatchRequest(PSMessage req, RequestExecutor& executor)
+{
+    const RequestOrdering ordering = GetRequestOrdering(req);
+    executor.Submit(ordering, [this, req] { HandleMessage(req); });
+}
+
 void PSAgent::HandleMessage(PSMessage msg)
 {
     if (msg->GetMessageMeta().IsRequest())
@@ -278,11 +330,23 @@ void PSAgent::HandleMessage(PSMessage msg)
     else
     {
         const int64_t message_id = msg->GetMessageMeta().GetMessageId();
-        std::lock_guard<std::mutex> lock(tracker_mutex_);
-        TrackerEntry& ent = tracker_.at(message_id);
-        ent.responses.push_back(msg);
-        if (ent.responses.size() == ent.total)
-            tracker_cv_.notify_all();
+        TrackerEntry entry;
+        {
+            std::lock_guard<std::mutex> lock(tracker_mutex_);
+            auto it = tracker_.find(message_id);
+            if (it == tracker_.end())
+            {
+                spdlog::warn("{}: Drop response of untracked request {}.", ToString(), message_id);
+                return;
+            }
+            TrackerEntry& ent = it->second;
+            ent.responses.push_back(msg);
+            if (ent.responses.size() < ent.total)
+                return;
+            entry = std::move(ent);
+            tracker_.erase(it);
+        }
+        SubmitCompletion(std::move(entry));
     }
 }
 
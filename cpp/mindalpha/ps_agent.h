@@ -18,13 +18,15 @@
 
 #include <queue>
 #include <vector>
+#include <exception>
 #include <unordered_map>
 #include <memory>
 #include <utility>
 #include <functional>
 #include <mutex>
-#include <condition_variable>
 #include <mindalpha/message.h>
+#include <mindalpha/request_executor.h>
+#include <mindalpha/parallel_for.h>
 
 namespace mindalpha
 {
@@ -33,6 +35,7 @@ using PSMessage = std::shared_ptr<Message>;
 using SingleCallback = std::function<void(PSMessage req, PSMessage res)>;
 using MultipleCallback = std::function<void(std::vector<PSMessage> reqs, std::vector<PSMessage> ress)>;
 using BroadcastCallback = std::function<void(PSMessage req, std::vector<PSMessage> ress)>;
+using ErrorCallback = std::function<void(std::exception_ptr error)>;
 using PSAgentCreator = std::function<std::shared_ptr<class PSAgent>()>;
 
 class PSAgent : public std::enable_shared_from_this<PSAgent>
@@ -44,6 +47,16 @@ public:
 
     virtual void Run() { }
     virtual void HandleRequest(PSMessage req);
+
+    // Servers with ``ActorConfig::GetServerThreadCount`` threads call this
+    // to decide which requests may be handled concurrently. The default puts
+    // all requests in one exclusive group, so they are handled one by one.
+    virtual RequestOrdering GetRequestOrdering(PSMessage req) { return {}; }
+
+    // Submits ``req`` to ``executor``; the default submits it as a whole in
+    // the group given by ``GetRequestOrdering``. Agents may override this to
+    // split a request into tasks of different groups.
+    virtual void DispatchRequest(PSMessage req, RequestExecutor& executor);
     virtual void Finalize() { }
 
     bool IsCoordinator() const { return is_coordinator_; }
@@ -54,9 +67,36 @@ public:
     int GetWorkerCount() const { return worker_count_; }
     int GetAgentRank() const;
 
+    // Helper threads of servers for large requests, null if not configured.
+    std::shared_ptr<ParallelForPool> GetParallelForPool() const;
+
     void Barrier(int group);
     void Shutdown();
 
+    // Failures of requests sent while an ``ErrorScope`` is alive on the
+    // calling thread are passed to its callback. Callbacks of requests run
+    // inside the scope of the request, so requests chained from them report
+    // to the same place. Failures outside any scope are logged.
+    class ErrorScope
+    {
+    public:
+        explicit ErrorScope(ErrorCallback cb);
+        ~ErrorScope();
+
+        ErrorScope(const ErrorScope&) = delete;
+        ErrorScope& operator=(const ErrorScope&) = delete;
+
+        static const ErrorCallback& GetCurrent() { return current_; }
+
+    private:
+        ErrorCallback saved_;
+        static thread_local ErrorCallback current_;
+    };
+
+    // These methods return once the requests are sent. The callbacks are
+    // invoked on the completion thread of the actor process after all the
+    // responses arrive, so many requests can be in flight at the same time.
+    // Callbacks must not block waiting for other requests.
     void SendRequest(PSMessage req, SingleCallback cb);
     void SendAllRequests(std::vector<PSMessage> reqs, MultipleCallback cb);
     void BroadcastRequest(PSMessage req, BroadcastCallback cb);
@@ -68,19 +108,23 @@ public:
 private:
     class ActorProcess* actor_process_ = nullptr;
 
+    using CompletionCallback = std::function<void(std::vector<PSMessage> ress)>;
+
     struct TrackerEntry
     {
         int total = 0;
         std::vector<PSMessage> responses;
-
-        void Clear()
-        {
-            responses.clear();
-        }
+        CompletionCallback complete;
+        ErrorCallback error;
     };
 
+    int64_t TrackRequest(int total, CompletionCallback complete);
+    void UntrackRequest(int64_t message_id);
+    void SubmitCompletion(TrackerEntry entry);
+    void CompleteRequest(TrackerEntry entry);
+    void ReportError(const ErrorCallback& error, std::exception_ptr exc) const;
+
     std::mutex tracker_mutex_;
-    std::condition_variable tracker_cv_;
     std::unordered_map<int64_t, TrackerEntry> tracker_;
 
     bool is_coordinator_ = false;
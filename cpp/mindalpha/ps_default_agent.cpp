@@ -47,6 +47,7 @@ namespace mindalpha
     X(SparseExport)                   \
     X(SparsePruneSmall)               \
     X(SparsePruneOld)                 \
+    X(Batch)                          \
     /**/
 
 enum class PSDefaultAgentCommand
@@ -79,12 +80,86 @@ void PSDefaultAgent::HandleRequest(PSMessage req)
         method(req);
         return;
     }
-    if (!store_)
+    EnsureStore();
+    if (!req->GetMessageMeta().GetDataRequest().IsEmpty())
+    {
+        PSMessage res = ExecuteDataRequest(req);
+        SendResponse(req, res);
+        return;
+    }
+    json11::Json json = ParseCommand(req);
+    if (json["command"].string_value() == "Batch")
+    {
+        std::shared_ptr<Batch> batch = UnpackBatch(req, json);
+        for (size_t i = 0; i < batch->ops.size(); i++)
+            ExecuteBatchOp(batch, i);
+        return;
+    }
+    PSMessage res = ExecuteCommand(json, req);
+    SendResponse(req, res);
+}
+
+void PSDefaultAgent::DispatchRequest(PSMessage req, RequestExecutor& executor)
+{
+    if (!IsServer())
+    {
+        PSAgent::DispatchRequest(req, executor);
+        return;
+    }
+    if (!req->GetMessageMeta().GetDataRequest().IsEmpty())
+    {
+        const RequestOrdering ordering = GetDataRequestOrdering(req->GetMessageMeta().GetDataRequest());
+        executor.Submit(ordering, [this, req] { HandleMessage(req); });
+        return;
+    }
+    std::string err;
+    json11::Json json = json11::Json::parse(req->GetMessageMeta().GetBody(), err);
+    std::shared_ptr<Batch> batch;
+    if (err.empty() && json["command"].string_value() == "Batch")
+    {
+        try
+        {
+            batch = UnpackBatch(req, json);
+        }
+        catch (const std::exception& e)
+        {
+            // ``HandleRequest`` will report the malformed batch.
+        }
+    }
+    if (!batch)
+    {
+        const RequestOrdering ordering = err.empty() ? GetCommandOrdering(json) : RequestOrdering();
+        executor.Submit(ordering, [this, req] { HandleMessage(req); });
+        return;
+    }
+    // The operations of a batch are submitted one by one, so that each of
+    // them is ordered with the other requests on its tensor and operations
+    // on different tensors run in parallel.
+    for (size_t i = 0; i < batch->ops.size(); i++)
+    {
+        const DataRequest& request = batch->requests.at(i)->GetMessageMeta().GetDataRequest();
+        const RequestOrdering ordering = request.IsEmpty() ? GetCommandOrdering(batch->ops.at(i))
+                                                           : GetDataRequestOrdering(request);
+        executor.Submit(ordering, [this, batch, i] {
+            EnsureStore();
+            ExecuteBatchOp(batch, i);
+        });
+    }
+}
+
+void PSDefaultAgent::EnsureStore()
+{
+    std::call_once(store_once_, [this]
     {
         store_ = std::make_unique<TensorPartitionStore>();
         store_->SetPartitionCount(GetServerCount());
         store_->SetPartitionIndex(GetAgentRank());
-    }
+        store_->SetParallelForPool(GetParallelForPool());
+    });
+}
+
+json11::Json PSDefaultAgent::ParseCommand(PSMessage req)
+{
     std::string err;
     const std::string& str = req->GetMessageMeta().GetBody();
     //std::cout << "str: " << str << std::endl;
@@ -101,8 +176,13 @@ void PSDefaultAgent::HandleRequest(PSMessage req)
         spdlog::error(serr);
         throw std::runtime_error(serr);
     }
+    return json;
+}
+
+PSMessage PSDefaultAgent::ExecuteCommand(const json11::Json& json, PSMessage req)
+{
     const std::string& command = json["command"].string_value();
-    //std::cout << "command: " << command << ", str: " << str << std::endl;
+    //std::cout << "command: " << command << std::endl;
     auto it = PSDefaultAgentCommandMap.find(command);
     if (it == PSDefaultAgentCommandMap.end())
     {
@@ -119,16 +199,16 @@ void PSDefaultAgent::HandleRequest(PSMessage req)
         case PSDefaultAgentCommand::DenseInit:
             {
                 DenseTensorMeta meta = DenseTensorMeta::FromJson(json["meta"]);
-                store_->DenseInit(meta);
-                PSAgent::HandleRequest(req);
-                break;
+                const int tensor_id = store_->DenseInit(meta);
+                PSMessage res = std::make_shared<Message>();
+                res->GetMessageMeta().GetDataRequest().SetTensorId(tensor_id);
+                return res;
             }
         case PSDefaultAgentCommand::DenseDispose:
             {
                 const std::string& name = json["name"].string_value();
                 store_->DenseDispose(name);
-                PSAgent::HandleRequest(req);
-                break;
+                return std::make_shared<Message>();
             }
         case PSDefaultAgentCommand::DensePush:
             {
@@ -136,60 +216,54 @@ void PSDefaultAgent::HandleRequest(PSMessage req)
                 const bool is_value = json["is_value"].bool_value();
                 const bool is_state = json["is_state"].bool_value();
                 store_->DensePush(name, req, is_value, is_state);
-                PSAgent::HandleRequest(req);
-                break;
+                return std::make_shared<Message>();
             }
         case PSDefaultAgentCommand::DensePull:
             {
                 const std::string& name = json["name"].string_value();
                 const bool is_state = json["is_state"].bool_value();
                 PSMessage res = store_->DensePull(name, is_state);
-                SendResponse(req, res);
-                break;
+                return res;
             }
         case PSDefaultAgentCommand::DensePushMeta:
             {
                 const std::string& name = json["name"].string_value();
                 DenseTensorMeta meta = DenseTensorMeta::FromJson(json["meta"]);
                 store_->DensePushMeta(name, meta);
-                PSAgent::HandleRequest(req);
-                break;
+                return std::make_shared<Message>();
             }
         case PSDefaultAgentCommand::DensePullMeta:
             {
                 const std::string& name = json["name"].string_value();
                 PSMessage res = store_->DensePullMeta(name);
-                SendResponse(req, res);
-                break;
+                return res;
             }
         case PSDefaultAgentCommand::SparseInit:
             {
                 SparseTensorMeta meta = SparseTensorMeta::FromJson(json["meta"]);
-                store_->SparseInit(meta);
-                PSAgent::HandleRequest(req);
-                break;
+                const int tensor_id = store_->SparseInit(meta);
+                PSMessage res = std::make_shared<Message>();
+                res->GetMessageMeta().GetDataRequest().SetTensorId(tensor_id);
+                return res;
             }
         case PSDefaultAgentCommand::SparseDispose:
             {
                 const std::string& name = json["name"].string_value();
                 store_->SparseDispose(name);
-                PSAgent::HandleRequest(req);
-                break;
+                return std::make_shared<Message>();
             }
         case PSDefaultAgentCommand::SparseClear:
             {
                 const std::string& name = json["name"].string_value();
                 store_->SparseClear(name);
-                PSAgent::HandleRequest(req);
-                break;
+                return std::make_shared<Message>();
             }
         case PSDefaultAgentCommand::SparsePush:
             {
                 const std::string& name = json["name"].string_value();
                 const bool is_value = json["is_value"].bool_value();
                 store_->SparsePush(name, req, is_value);
-                PSAgent::HandleRequest(req);
-                break;
+                return std::make_shared<Message>();
             }
         case PSDefaultAgentCommand::SparsePull:
             {
@@ -197,8 +271,7 @@ void PSDefaultAgent::HandleRequest(PSMessage req)
                 const bool read_only = json["read_only"].bool_value();
                 const bool nan_fill = json["nan_fill"].bool_value();
                 PSMessage res = store_->SparsePull(name, req, read_only, nan_fill);
-                SendResponse(req, res);
-                break;
+                return res;
             }
         case PSDefaultAgentCommand::SparsePushPartition:
             {
@@ -206,8 +279,7 @@ void PSDefaultAgent::HandleRequest(PSMessage req)
                 const bool data_only = json["data_only"].bool_value();
                 const bool skip_existing = json["skip_existing"].bool_value();
                 store_->SparsePushPartition(name, req, data_only, skip_existing);
-                PSAgent::HandleRequest(req);
-                break;
+                return std::make_shared<Message>();
             }
         case PSDefaultAgentCommand::SparsePullPartition:
             {
@@ -216,31 +288,30 @@ void PSDefaultAgent::HandleRequest(PSMessage req)
                 const int index = json["index"].int_value();
                 const int count = json["count"].int_value();
                 PSMessage res = store_->SparsePullPartition(name, data_only, index, count);
-                SendResponse(req, res);
-                break;
+                return res;
             }
         case PSDefaultAgentCommand::SparsePushMeta:
             {
                 const std::string& name = json["name"].string_value();
                 SparseTensorMeta meta = SparseTensorMeta::FromJson(json["meta"]);
                 store_->SparsePushMeta(name, meta);
-                PSAgent::HandleRequest(req);
-                break;
+                return std::make_shared<Message>();
             }
         case PSDefaultAgentCommand::SparsePullMeta:
             {
                 const std::string& name = json["name"].string_value();
                 PSMessage res = store_->SparsePullMeta(name);
-                SendResponse(req, res);
-                break;
+                return res;
             }
         case PSDefaultAgentCommand::SparseLoad:
             {
                 const std::string& name = json["name"].string_value();
                 const std::string& dir_path = json["dir_path"].string_value();
-                store_->SparseLoad(name, dir_path);
-                PSAgent::HandleRequest(req);
-                break;
+                // ``old_partition_count`` is sent only when the partition count changed.
+                const json11::Json& old_count = json["old_partition_count"];
+                const int old_partition_count = old_count.is_number() ? old_count.int_value() : -1;
+                store_->SparseLoad(name, dir_path, old_partition_count);
+                return std::make_shared<Message>();
             }
         case PSDefaultAgentCommand::SparseSave:
             {
@@ -248,32 +319,36 @@ void PSDefaultAgent::HandleRequest(PSMessage req)
                 const std::string& dir_path = json["dir_path"].string_value();
                 const bool text_mode = json["text_mode"].bool_value();
                 store_->SparseSave(name, dir_path, text_mode);
-                PSAgent::HandleRequest(req);
-                break;
+                return std::make_shared<Message>();
             }
         case PSDefaultAgentCommand::SparseExport:
             {
                 const std::string& name = json["name"].string_value();
                 const std::string& dir_path = json["dir_path"].string_value();
                 store_->SparseExport(name, dir_path);
-                PSAgent::HandleRequest(req);
-                break;
+                return std::make_shared<Message>();
             }
         case PSDefaultAgentCommand::SparsePruneSmall:
             {
                 const std::string& name = json["name"].string_value();
                 const double epsilon = json["epsilon"].number_value();
                 store_->SparsePruneSmall(name, epsilon);
-                PSAgent::HandleRequest(req);
-                break;
+                return std::make_shared<Message>();
             }
         case PSDefaultAgentCommand::SparsePruneOld:
             {
                 const std::string& name = json["name"].string_value();
                 const int max_age = json["max_age"].int_value();
                 store_->SparsePruneOld(name, max_age);
-                PSAgent::HandleRequest(req);
-                break;
+                return std::make_shared<Message>();
+            }
+        case PSDefaultAgentCommand::Batch:
+            {
+                std::string serr;
+                serr.append("Batch requests can not be nested.\n\n");
+                serr.append(GetStackTrace());
+                spdlog::error(serr);
+                throw std::runtime_error(serr);
             }
         default:
             {
@@ -288,6 +363,220 @@ void PSDefaultAgent::HandleRequest(PSMessage req)
     }
 }
 
+PSMessage PSDefaultAgent::ExecuteDataRequest(PSMessage req)
+{
+    const DataRequest& request = req->GetMessageMeta().GetDataRequest();
+    const int tensor_id = request.GetTensorId();
+    switch (request.GetCommand())
+    {
+        case DataRequestCommand::DensePush:
+            {
+                const bool is_value = request.HasFlag(DataRequest::IsValueFlag);
+                const bool is_state = request.HasFlag(DataRequest::IsStateFlag);
+                store_->DensePush(tensor_id, req, is_value, is_state);
+                return std::make_shared<Message>();
+            }
+        case DataRequestCommand::DensePull:
+            {
+                const bool is_state = request.HasFlag(DataRequest::IsStateFlag);
+                return store_->DensePull(tensor_id, is_state);
+            }
+        case DataRequestCommand::SparsePush:
+            {
+                const bool is_value = request.HasFlag(DataRequest::IsValueFlag);
+                store_->SparsePush(tensor_id, req, is_value);
+                return std::make_shared<Message>();
+            }
+        case DataRequestCommand::SparsePull:
+            {
+                const bool read_only = request.HasFlag(DataRequest::ReadOnlyFlag);
+                const bool nan_fill = request.HasFlag(DataRequest::NanFillFlag);
+                return store_->SparsePull(tensor_id, req, read_only, nan_fill);
+            }
+        default:
+            {
+                std::string serr;
+                serr.append("Unknown data request command ");
+                serr.append(std::to_string(static_cast<int>(request.GetCommand())));
+                serr.append(".\n\n");
+                serr.append(GetStackTrace());
+                spdlog::error(serr);
+                throw std::runtime_error(serr);
+            }
+    }
+}
+
+std::shared_ptr<PSDefaultAgent::Batch> PSDefaultAgent::UnpackBatch(PSMessage req, const json11::Json& json)
+{
+    const json11::Json::array& ops = json["ops"].array_items();
+    const json11::Json::array& slice_counts = json["slice_counts"].array_items();
+    const std::vector<DataType>& types = req->GetMessageMeta().GetSliceDataTypes();
+    const std::vector<SmartArray<uint8_t>>& slices = req->GetSlices();
+    size_t total = 0;
+    for (const json11::Json& count : slice_counts)
+        total += count.int_value();
+    if (ops.size() != slice_counts.size() || total != slices.size() || total != types.size())
+    {
+        std::string serr;
+        serr.append("Malformed batch request; ");
+        serr.append(std::to_string(ops.size()));
+        serr.append(" operations with ");
+        serr.append(std::to_string(slice_counts.size()));
+        serr.append(" slice counts summing to ");
+        serr.append(std::to_string(total));
+        serr.append(", but the message has ");
+        serr.append(std::to_string(slices.size()));
+        serr.append(" slices.\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    auto batch = std::make_shared<Batch>();
+    batch->req = req;
+    batch->ops = ops;
+    batch->requests.reserve(ops.size());
+    batch->responses.resize(ops.size());
+    batch->remaining = ops.size();
+    size_t offset = 0;
+    for (size_t i = 0; i < ops.size(); i++)
+    {
+        PSMessage op_req = std::make_shared<Message>();
+        op_req->GetMessageMeta().SetSender(req->GetMessageMeta().GetSender());
+        op_req->GetMessageMeta().SetReceiver(req->GetMessageMeta().GetReceiver());
+        op_req->GetMessageMeta().SetIsRequest(true);
+        const json11::Json& data_request = ops.at(i)["data_request"];
+        if (!data_request.is_null())
+            op_req->GetMessageMeta().SetDataRequest(DataRequest::FromJson(data_request));
+        const size_t count = slice_counts.at(i).int_value();
+        for (size_t j = offset; j < offset + count; j++)
+            op_req->AddTypedSlice(slices.at(j), types.at(j));
+        offset += count;
+        batch->requests.push_back(op_req);
+    }
+    return batch;
+}
+
+void PSDefaultAgent::ExecuteBatchOp(const std::shared_ptr<Batch>& batch, size_t index)
+{
+    try
+    {
+        PSMessage op_req = batch->requests.at(index);
+        if (op_req->GetMessageMeta().GetDataRequest().IsEmpty())
+            batch->responses.at(index) = ExecuteCommand(batch->ops.at(index), op_req);
+        else
+            batch->responses.at(index) = ExecuteDataRequest(op_req);
+    }
+    catch (const std::exception& e)
+    {
+        std::lock_guard<std::mutex> lock(batch->mutex);
+        if (batch->error.empty())
+            batch->error = e.what();
+    }
+    if (--batch->remaining > 0)
+        return;
+    if (!batch->error.empty())
+    {
+        // Operations which succeeded are not rolled back.
+        PSMessage exc = std::make_shared<Message>();
+        exc->GetMessageMeta().SetIsException(true);
+        exc->GetMessageMeta().SetBody(batch->error);
+        SendResponse(batch->req, exc);
+        return;
+    }
+    PSMessage res = std::make_shared<Message>();
+    json11::Json::array slice_counts;
+    for (const PSMessage& op_res : batch->responses)
+    {
+        const std::vector<DataType>& types = op_res->GetMessageMeta().GetSliceDataTypes();
+        const std::vector<SmartArray<uint8_t>>& slices = op_res->GetSlices();
+        for (size_t j = 0; j < slices.size(); j++)
+            res->AddTypedSlice(slices.at(j), types.at(j));
+        slice_counts.push_back(static_cast<int>(slices.size()));
+    }
+    json11::Json json = json11::Json::object
+    {
+        { "slice_counts", std::move(slice_counts) },
+    };
+    res->GetMessageMeta().SetBody(json.dump());
+    SendResponse(batch->req, res);
+}
+
+RequestOrdering PSDefaultAgent::GetRequestOrdering(PSMessage req)
+{
+    // Requests are ordered per tensor, malformed ones are put in the default
+    // group and reported by ``HandleRequest``.
+    RequestOrdering ordering;
+    if (!IsServer())
+        return ordering;
+    if (!req->GetMessageMeta().GetDataRequest().IsEmpty())
+        return GetDataRequestOrdering(req->GetMessageMeta().GetDataRequest());
+    std::string err;
+    json11::Json json = json11::Json::parse(req->GetMessageMeta().GetBody(), err);
+    if (!err.empty())
+        return ordering;
+    return GetCommandOrdering(json);
+}
+
+RequestOrdering PSDefaultAgent::GetCommandOrdering(const json11::Json& json)
+{
+    RequestOrdering ordering;
+    auto it = PSDefaultAgentCommandMap.find(json["command"].string_value());
+    if (it == PSDefaultAgentCommandMap.end())
+        return ordering;
+    switch (it->second)
+    {
+        case PSDefaultAgentCommand::DenseInit:
+        case PSDefaultAgentCommand::SparseInit:
+            ordering.key = json["meta"]["name"].string_value();
+            break;
+        case PSDefaultAgentCommand::DensePull:
+        case PSDefaultAgentCommand::DensePullMeta:
+        case PSDefaultAgentCommand::SparsePullPartition:
+        case PSDefaultAgentCommand::SparsePullMeta:
+            ordering.key = json["name"].string_value();
+            ordering.read_only = true;
+            break;
+        case PSDefaultAgentCommand::SparsePull:
+            // Pulls which are not read-only insert the missing keys.
+            ordering.key = json["name"].string_value();
+            ordering.read_only = json["read_only"].bool_value();
+            break;
+        default:
+            ordering.key = json["name"].string_value();
+            break;
+    }
+    return ordering;
+}
+
+RequestOrdering PSDefaultAgent::GetDataRequestOrdering(const DataRequest& request)
+{
+    // Data requests are ordered by the name of their tensor too, so that
+    // they are ordered with the control-plane commands on it. Tensors are
+    // known here, as their ids are only handed out by init.
+    RequestOrdering ordering;
+    EnsureStore();
+    switch (request.GetCommand())
+    {
+        case DataRequestCommand::DensePush:
+            ordering.key = store_->GetDenseName(request.GetTensorId());
+            break;
+        case DataRequestCommand::DensePull:
+            ordering.key = store_->GetDenseName(request.GetTensorId());
+            ordering.read_only = true;
+            break;
+        case DataRequestCommand::SparsePush:
+            ordering.key = store_->GetSparseName(request.GetTensorId());
+            break;
+        case DataRequestCommand::SparsePull:
+            ordering.key = store_->GetSparseName(request.GetTensorId());
+            ordering.read_only = request.HasFlag(DataRequest::ReadOnlyFlag);
+            break;
+        default:
+            break;
+    }
+    return ordering;
+}
+
 void PSDefaultAgent::Finalize()
 {
     // Call the ``_finalize`` method of the Python agent object to remove its
@@ -16,6 +16,11 @@
 
 #pragma once
 
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <json11.hpp>
 #include <pybind11/pybind11.h>
 #include <mindalpha/ps_agent.h>
 #include <mindalpha/tensor_partition_store.h>
@@ -31,11 +36,38 @@ public:
 
     void Run() override;
     void HandleRequest(PSMessage req) override;
+    RequestOrdering GetRequestOrdering(PSMessage req) override;
+    void DispatchRequest(PSMessage req, RequestExecutor& executor) override;
     void Finalize() override;
 
 private:
+    // A ``Batch`` request carries the operations of several tensors, each
+    // using a run of the slices of the message. The response concatenates
+    // the slices of their responses, with counts listed in the body.
+    // Operations with a binary header embed it as ``data_request``.
+    struct Batch
+    {
+        PSMessage req;
+        json11::Json::array ops;
+        std::vector<PSMessage> requests;
+        std::vector<PSMessage> responses;
+        std::atomic<size_t> remaining{0};
+        std::mutex mutex;
+        std::string error;
+    };
+
+    void EnsureStore();
+    json11::Json ParseCommand(PSMessage req);
+    PSMessage ExecuteCommand(const json11::Json& json, PSMessage req);
+    PSMessage ExecuteDataRequest(PSMessage req);
+    std::shared_ptr<Batch> UnpackBatch(PSMessage req, const json11::Json& json);
+    void ExecuteBatchOp(const std::shared_ptr<Batch>& batch, size_t index);
+    static RequestOrdering GetCommandOrdering(const json11::Json& json);
+    RequestOrdering GetDataRequestOrdering(const DataRequest& request);
+
     pybind11::object py_agent_;
     std::unique_ptr<TensorPartitionStore> store_;
+    std::once_flag store_once_;
 };
 
 }
@@ -34,6 +34,7 @@ GetLocalConfig(const std::string &role, PSAgentCreator agent_creator)
     config->SetAgentCreator(std::move(agent_creator));
     if (role.empty()) {
         config->SetIsLocalMode(true);
+        config->SetTransportType("InProcess");
     }
     else {
         if (role == "C") {
@@ -34,6 +34,32 @@ std::shared_ptr<pybind11::object> make_shared_pyobject(pybind11::object obj)
     return std::move(obj_ptr);
 }
 
+std::function<void(std::exception_ptr)> make_error_callback(pybind11::object cb)
+{
+    if (cb.is_none())
+        return {};
+    auto func = make_shared_pyobject(std::move(cb));
+    return [func](std::exception_ptr error)
+    {
+        pybind11::gil_scoped_acquire gil;
+        pybind11::object exc;
+        try
+        {
+            std::rethrow_exception(error);
+        }
+        catch (pybind11::error_already_set& e)
+        {
+            exc = e.value();
+        }
+        catch (const std::exception& e)
+        {
+            pybind11::module builtins = pybind11::module::import("builtins");
+            exc = builtins.attr("RuntimeError")(e.what());
+        }
+        (*func)(exc);
+    };
+}
+
 std::string serialize_pyobject(pybind11::object obj)
 {
     if (obj.is_none())
@@ -77,7 +103,16 @@ pybind11::array make_numpy_array(SmartArray<uint8_t> data, DataType dtype)
         result = arr.attr("view")(#l);                   \
         break;                                           \
         /**/
-    MINDALPHA_DATA_TYPES(MINDALPHA_DATA_TYPE_DEF)
+    MINDALPHA_INTEGRAL_DATA_TYPES(MINDALPHA_DATA_TYPE_DEF)
+    MINDALPHA_FLOATING_DATA_TYPES(MINDALPHA_DATA_TYPE_DEF)
+    case mindalpha::DataType::Float16:
+        result = arr.attr("view")("float16");
+        break;
+    case mindalpha::DataType::BFloat16:
+        // NumPy has no bfloat16, the raw bits are exposed as uint16 and
+        // can be reinterpreted by ``torch.Tensor.view(torch.bfloat16)``.
+        result = arr.attr("view")("uint16");
+        break;
     }
     return result;
 }
@@ -17,6 +17,8 @@
 #pragma once
 
 #include <memory>
+#include <exception>
+#include <functional>
 #include <pybind11/pybind11.h>
 #include <pybind11/functional.h>
 #include <pybind11/numpy.h>
@@ -36,6 +38,10 @@ std::shared_ptr<T> extract_shared_pyobject(pybind11::object obj)
     return std::move(ptr2);
 }
 
+// Wrap the Python callable ``cb`` so that it receives the exception object
+// converted from the C++ exception; an empty function is returned for None.
+std::function<void(std::exception_ptr)> make_error_callback(pybind11::object cb);
+
 std::string serialize_pyobject(pybind11::object obj);
 pybind11::object deserialize_pyobject(const std::string& data);
 
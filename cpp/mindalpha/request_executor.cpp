@@ -0,0 +1,156 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <stdio.h>
+#include <stdexcept>
+#include <spdlog/spdlog.h>
+#include <mindalpha/request_executor.h>
+
+namespace mindalpha
+{
+
+RequestExecutor::RequestExecutor(int thread_count)
+    : busy_nanoseconds_(std::make_unique<std::atomic<int64_t>[]>(thread_count))
+    , start_time_(std::chrono::steady_clock::now())
+{
+    if (thread_count <= 0)
+    {
+        std::string serr;
+        serr.append("RequestExecutor thread count must be positive; ");
+        serr.append(std::to_string(thread_count));
+        serr.append(" is invalid.");
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    threads_.reserve(thread_count);
+    for (int i = 0; i < thread_count; i++)
+    {
+        busy_nanoseconds_[i] = 0;
+        threads_.emplace_back([this, i] { Execute(i); });
+    }
+}
+
+RequestExecutor::~RequestExecutor()
+{
+    Stop();
+}
+
+void RequestExecutor::Submit(const RequestOrdering& ordering, Task task)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Strand& strand = strands_[ordering.key];
+    if (strand.key.empty())
+        strand.key = ordering.key;
+    strand.pending.push_back(Entry{ordering.read_only, std::move(task)});
+    Dispatch(strand);
+}
+
+void RequestExecutor::Dispatch(Strand& strand)
+{
+    // Move the tasks at the front of the strand that can run now to the
+    // ready queue: one exclusive task when nothing is running, or any
+    // number of read-only tasks when no exclusive one is running.
+    while (!strand.pending.empty())
+    {
+        Entry& entry = strand.pending.front();
+        if (strand.running > 0 && (!entry.read_only || strand.running_exclusive))
+            break;
+        strand.running++;
+        strand.running_exclusive = !entry.read_only;
+        ready_.push_back(ReadyTask{&strand, std::move(entry.task)});
+        strand.pending.pop_front();
+        running_++;
+        cv_.notify_one();
+    }
+}
+
+void RequestExecutor::Complete(Strand& strand)
+{
+    running_--;
+    if (--strand.running == 0)
+        strand.running_exclusive = false;
+    Dispatch(strand);
+    if (strand.running == 0 && strand.pending.empty())
+        strands_.erase(strand.key);
+    if (stopping_ && running_ == 0)
+        cv_.notify_all();
+}
+
+void RequestExecutor::Execute(int index)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;)
+    {
+        cv_.wait(lock, [this] { return !ready_.empty() || (stopping_ && running_ == 0); });
+        if (ready_.empty())
+            break;
+        ReadyTask ready = std::move(ready_.front());
+        ready_.pop_front();
+        lock.unlock();
+        const auto begin = std::chrono::steady_clock::now();
+        try
+        {
+            ready.task();
+        }
+        catch (const std::exception& e)
+        {
+            spdlog::error("RequestExecutor: unhandled exception in task of '{}': {}", ready.strand->key, e.what());
+        }
+        const auto end = std::chrono::steady_clock::now();
+        busy_nanoseconds_[index] += std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+        lock.lock();
+        Complete(*ready.strand);
+    }
+}
+
+void RequestExecutor::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_)
+            return;
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (std::thread& thread : threads_)
+        thread.join();
+}
+
+std::vector<double> RequestExecutor::GetThreadUtilization() const
+{
+    const auto now = std::chrono::steady_clock::now();
+    const double elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - start_time_).count();
+    std::vector<double> result(threads_.size());
+    for (size_t i = 0; i < threads_.size(); i++)
+        result[i] = elapsed > 0 ? busy_nanoseconds_[i] / elapsed : 0.0;
+    return result;
+}
+
+std::string RequestExecutor::GetThreadUtilizationString() const
+{
+    std::string str;
+    const std::vector<double> utilization = GetThreadUtilization();
+    for (size_t i = 0; i < utilization.size(); i++)
+    {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%s%.1f%%", i ? " " : "", utilization[i] * 100.0);
+        str.append(buffer);
+    }
+    return str;
+}
+
+}
@@ -0,0 +1,110 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+//
+// ``request_executor.h`` defines class ``RequestExecutor`` which executes
+// the requests received by a server on a pool of threads.
+//
+// Each request carries a ``RequestOrdering``. Requests with the same key
+// (normally the tensor name) are executed in arrival order, except that
+// consecutive read-only requests may run concurrently. Requests with
+// different keys run in parallel.
+//
+
+namespace mindalpha
+{
+
+struct RequestOrdering
+{
+    std::string key;
+    bool read_only = false;
+};
+
+class RequestExecutor
+{
+public:
+    using Task = std::function<void()>;
+
+    explicit RequestExecutor(int thread_count);
+    ~RequestExecutor();
+
+    RequestExecutor(const RequestExecutor&) = delete;
+    RequestExecutor& operator=(const RequestExecutor&) = delete;
+
+    int GetThreadCount() const { return static_cast<int>(threads_.size()); }
+
+    void Submit(const RequestOrdering& ordering, Task task);
+
+    // Wait for all submitted tasks to finish and join the threads.
+    void Stop();
+
+    // Fraction of the time since construction each thread spent executing tasks.
+    std::vector<double> GetThreadUtilization() const;
+    std::string GetThreadUtilizationString() const;
+
+private:
+    struct Entry
+    {
+        bool read_only;
+        Task task;
+    };
+
+    struct Strand
+    {
+        std::string key;
+        std::deque<Entry> pending;
+        int running = 0;
+        bool running_exclusive = false;
+    };
+
+    struct ReadyTask
+    {
+        Strand* strand;
+        Task task;
+    };
+
+    void Dispatch(Strand& strand);
+    void Complete(Strand& strand);
+    void Execute(int index);
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::unordered_map<std::string, Strand> strands_;
+    std::deque<ReadyTask> ready_;
+    int64_t running_ = 0;
+    bool stopping_ = false;
+    std::vector<std::thread> threads_;
+    std::unique_ptr<std::atomic<int64_t>[]> busy_nanoseconds_;
+    std::chrono::steady_clock::time_point start_time_;
+};
+
+}
@@ -0,0 +1,749 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <zmq.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+#include <mindalpha/shared_memory_transport.h>
+#include <mindalpha/node_encoding.h>
+#include <mindalpha/stack_trace_utils.h>
+
+namespace mindalpha
+{
+
+namespace
+{
+
+constexpr uint64_t DoorbellMagic = 0x4C4542444D48534DULL;
+constexpr uint64_t RingMagic = 0x474E49524D48534DULL;
+constexpr uint32_t DoorbellSlotCount = 4096;
+constexpr size_t RingDataOffset = 256;
+constexpr uint64_t MinRingCapacity = 64 * 1024;
+
+// The first word of every record holds its length, rounded up to 8 bytes,
+// plus these flags.
+constexpr uint64_t WrapFlag = 1ULL << 63;
+constexpr uint64_t FragmentFlag = 1ULL << 62;
+constexpr uint64_t LengthMask = FragmentFlag - 1;
+
+// A record is this header followed by the slice sizes, the packed message
+// meta and the slices, each padded to 8 bytes.
+struct RecordHeader
+{
+    uint64_t word;
+    int32_t sender;
+    uint32_t meta_size;
+    uint32_t slice_count;
+    uint32_t reserved;
+};
+
+// A fragment carries the next bytes of a record too large for the ring.
+struct FragmentHeader
+{
+    uint64_t word;
+    uint64_t record_length;
+};
+
+uint64_t Align8(uint64_t size)
+{
+    return (size + 7) & ~uint64_t(7);
+}
+
+void FutexWait(std::atomic<uint32_t>& word, uint32_t value)
+{
+    struct timespec timeout = { 0, 100 * 1000 * 1000 };
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, value, &timeout, nullptr, 0);
+}
+
+void FutexWake(std::atomic<uint32_t>& word)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+// Map the shared memory object ``name``, creating it with ``size`` bytes
+// if ``create`` is true. Return nullptr and set ``size`` to the mapped size
+// otherwise.
+void* MapSharedMemory(const std::string& name, size_t& size, bool create)
+{
+    const int flags = create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR;
+    const int fd = shm_open(name.c_str(), flags, 0600);
+    if (fd == -1)
+        return nullptr;
+    if (create && ftruncate(fd, size) == -1)
+    {
+        close(fd);
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+    if (!create)
+    {
+        struct stat st;
+        if (fstat(fd, &st) == -1)
+        {
+            close(fd);
+            return nullptr;
+        }
+        size = st.st_size;
+    }
+    void* const ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED)
+    {
+        if (create)
+            shm_unlink(name.c_str());
+        return nullptr;
+    }
+    return ptr;
+}
+
+}
+
+struct SharedMemoryTransport::Doorbell
+{
+    uint64_t magic;
+    alignas(64) std::atomic<uint32_t> sequence;
+    std::atomic<uint32_t> sleeping;
+    alignas(64) std::atomic<uint32_t> slot_count;
+    std::atomic<int32_t> slots[DoorbellSlotCount];
+
+    void Ring()
+    {
+        sequence.fetch_add(1);
+        if (sleeping.load())
+            FutexWake(sequence);
+    }
+};
+
+struct SharedMemoryTransport::RingHeader
+{
+    uint64_t magic;
+    uint64_t capacity;
+    alignas(64) std::atomic<uint64_t> head;
+    alignas(64) std::atomic<uint64_t> tail;
+    alignas(64) std::atomic<uint32_t> space_sequence;
+    std::atomic<uint32_t> sender_waiting;
+
+    uint8_t* GetData() { return reinterpret_cast<uint8_t*>(this) + RingDataOffset; }
+};
+
+// Receiver side of a ring. Records are read in order but the views handed
+// out for them may be released in any order; ``tail`` only moves past a
+// record once everything before it has been released.
+class SharedMemoryTransport::RingReader : public std::enable_shared_from_this<RingReader>
+{
+public:
+    RingReader(RingHeader* ring, size_t size)
+        : ring_(ring), size_(size), read_(ring->tail.load())
+    {
+    }
+
+    ~RingReader() { munmap(ring_, size_); }
+
+    RingHeader* GetRing() const { return ring_; }
+
+    uint64_t GetRead() const { return read_; }
+    void SetRead(uint64_t value) { read_ = value; }
+
+    SmartArray<uint8_t>& GetAssembly() { return assembly_; }
+    uint64_t& GetAssembled() { return assembled_; }
+
+    uint64_t AddEntry(uint64_t end, bool released)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.emplace_back(end, released);
+        const uint64_t id = first_id_ + entries_.size() - 1;
+        if (released)
+            Advance();
+        return id;
+    }
+
+    void Release(uint64_t id)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.at(id - first_id_).second = true;
+        Advance();
+    }
+
+private:
+    void Advance()
+    {
+        bool moved = false;
+        uint64_t tail = 0;
+        while (!entries_.empty() && entries_.front().second)
+        {
+            tail = entries_.front().first;
+            entries_.pop_front();
+            first_id_++;
+            moved = true;
+        }
+        if (!moved)
+            return;
+        ring_->tail.store(tail, std::memory_order_release);
+        ring_->space_sequence.fetch_add(1);
+        if (ring_->sender_waiting.exchange(0))
+            FutexWake(ring_->space_sequence);
+    }
+
+    RingHeader* const ring_;
+    const size_t size_;
+    uint64_t read_;
+    SmartArray<uint8_t> assembly_;
+    uint64_t assembled_ = 0;
+    std::mutex mutex_;
+    std::deque<std::pair<uint64_t, bool>> entries_;
+    uint64_t first_id_ = 0;
+};
+
+SharedMemoryTransport::RingWriter::~RingWriter()
+{
+    if (ring)
+        munmap(ring, ring_size);
+    if (doorbell)
+        munmap(doorbell, doorbell_size);
+}
+
+SharedMemoryTransport::SharedMemoryTransport(std::shared_ptr<ActorConfig> config)
+    : ZeroMQTransport(std::move(config))
+{
+}
+
+SharedMemoryTransport::~SharedMemoryTransport()
+{
+    if (drainer_.joinable())
+        Stop();
+}
+
+std::string SharedMemoryTransport::GetDoorbellName(int port)
+{
+    return "/mindalpha-shm-" + std::to_string(port);
+}
+
+std::string SharedMemoryTransport::GetRingName(int receiver_port, int sender_port)
+{
+    return "/mindalpha-shm-" + std::to_string(receiver_port) + "-" + std::to_string(sender_port);
+}
+
+void SharedMemoryTransport::Stop()
+{
+    stopping_.store(true);
+    if (drainer_.joinable())
+    {
+        doorbell_->Ring();
+        drainer_.join();
+    }
+    readers_.clear();
+    if (doorbell_)
+    {
+        munmap(doorbell_, doorbell_size_);
+        shm_unlink(GetDoorbellName(port_).c_str());
+        doorbell_ = nullptr;
+    }
+    if (event_fd_ != -1)
+    {
+        close(event_fd_);
+        event_fd_ = -1;
+    }
+    {
+        std::unique_lock<std::shared_mutex> lock(writers_mutex_);
+        writers_.clear();
+        writers_by_address_.clear();
+        zeromq_addresses_.clear();
+    }
+    port_ = -1;
+    ZeroMQTransport::Stop();
+}
+
+int SharedMemoryTransport::Bind(const NodeInfo& node, int maxRetry)
+{
+    const int port = ZeroMQTransport::Bind(node, maxRetry);
+    size_t size = sizeof(Doorbell);
+    void* const ptr = MapSharedMemory(GetDoorbellName(port), size, true);
+    if (!ptr)
+    {
+        std::string serr;
+        serr.append("Fail to create shared memory doorbell ");
+        serr.append(GetDoorbellName(port));
+        serr.append(", errno: ");
+        serr.append(std::to_string(errno));
+        serr.append(" ");
+        serr.append(strerror(errno));
+        serr.append(".\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    event_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (event_fd_ == -1)
+    {
+        munmap(ptr, size);
+        shm_unlink(GetDoorbellName(port).c_str());
+        std::string serr;
+        serr.append("Fail to create eventfd, errno: ");
+        serr.append(std::to_string(errno));
+        serr.append(" ");
+        serr.append(strerror(errno));
+        serr.append(".\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    doorbell_ = new (ptr) Doorbell();
+    doorbell_size_ = size;
+    port_ = port;
+    // The magic is stored last, so senders never see a half-built doorbell.
+    std::atomic_thread_fence(std::memory_order_release);
+    doorbell_->magic = DoorbellMagic;
+    stopping_.store(false);
+    drainer_ = std::thread(&SharedMemoryTransport::Draining, this);
+    return port;
+}
+
+void SharedMemoryTransport::Connect(const NodeInfo& node)
+{
+    ZeroMQTransport::Connect(node);
+    const NodeInfo& thisNode = GetConfig()->GetThisNodeInfo();
+    // Worker doesn't connect to other workers and
+    // server doesn't connect to other servers.
+    if (node.GetRole() == thisNode.GetRole() &&
+        node.GetNodeId() != thisNode.GetNodeId())
+    {
+        std::unique_lock<std::shared_mutex> lock(writers_mutex_);
+        writers_.erase(node.GetNodeId());
+        return;
+    }
+    if (port_ == -1 || node.GetHostName() != thisNode.GetHostName())
+        return;
+    // Whether a peer is reached through shared memory or ZeroMQ is decided
+    // once per address, so messages to it never switch paths.
+    const std::string address = node.GetAddress();
+    std::unique_lock<std::shared_mutex> lock(writers_mutex_);
+    if (zeromq_addresses_.count(address))
+        return;
+    std::shared_ptr<RingWriter> writer;
+    auto it = writers_by_address_.find(address);
+    if (it != writers_by_address_.end())
+        writer = it->second;
+    else
+    {
+        writer = OpenRingWriter(node);
+        if (!writer)
+        {
+            spdlog::warn("{}: Fail to set up shared memory to {}, use ZeroMQ instead.",
+                         thisNode.ToShortString(), node.ToShortString());
+            zeromq_addresses_.insert(address);
+            return;
+        }
+        writers_by_address_[address] = writer;
+    }
+    writer->identity = thisNode.GetNodeId();
+    writers_[node.GetNodeId()] = std::move(writer);
+}
+
+std::shared_ptr<SharedMemoryTransport::RingWriter> SharedMemoryTransport::OpenRingWriter(const NodeInfo& node)
+{
+    static_assert(sizeof(RingHeader) <= RingDataOffset, "ring header must fit before the ring data");
+    auto writer = std::make_shared<RingWriter>();
+    size_t doorbellSize = 0;
+    void* const doorbell = MapSharedMemory(GetDoorbellName(node.GetPort()), doorbellSize, false);
+    if (!doorbell)
+        return nullptr;
+    writer->doorbell = static_cast<Doorbell*>(doorbell);
+    writer->doorbell_size = doorbellSize;
+    if (doorbellSize < sizeof(Doorbell) || writer->doorbell->magic != DoorbellMagic)
+        return nullptr;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t capacity = std::max(GetConfig()->GetSharedMemoryRingSize(), MinRingCapacity) & ~uint64_t(7);
+    const std::string name = GetRingName(node.GetPort(), port_);
+    size_t ringSize = RingDataOffset + capacity;
+    void* const ring = MapSharedMemory(name, ringSize, true);
+    if (!ring)
+        return nullptr;
+    writer->ring = new (ring) RingHeader();
+    writer->ring_size = ringSize;
+    writer->ring->magic = RingMagic;
+    writer->ring->capacity = capacity;
+    // The ring is complete before the receiver can find it in the slots.
+    const uint32_t slot = writer->doorbell->slot_count.fetch_add(1);
+    if (slot >= DoorbellSlotCount)
+    {
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+    writer->doorbell->slots[slot].store(port_);
+    writer->doorbell->Ring();
+    return writer;
+}
+
+int64_t SharedMemoryTransport::SendMessage(const Message& msg)
+{
+    std::shared_ptr<RingWriter> writer;
+    {
+        std::shared_lock<std::shared_mutex> lock(writers_mutex_);
+        auto it = writers_.find(msg.GetMessageMeta().GetReceiver());
+        if (it != writers_.end())
+            writer = it->second;
+    }
+    if (!writer)
+        return ZeroMQTransport::SendMessage(msg);
+    return WriteMessage(*writer, msg);
+}
+
+bool SharedMemoryTransport::ReserveRing(RingWriter& writer, uint64_t length, Deadline deadline, uint64_t& head)
+{
+    RingHeader* const ring = writer.ring;
+    const uint64_t capacity = ring->capacity;
+    head = ring->head.load(std::memory_order_relaxed);
+    const uint64_t contiguous = capacity - head % capacity;
+    const uint64_t needed = contiguous < length ? contiguous + length : length;
+    for (;;)
+    {
+        const uint32_t sequence = ring->space_sequence.load();
+        if (capacity - (head - ring->tail.load(std::memory_order_acquire)) >= needed)
+            break;
+        ring->sender_waiting.store(1);
+        if (capacity - (head - ring->tail.load(std::memory_order_acquire)) >= needed)
+            break;
+        if (std::chrono::steady_clock::now() >= deadline)
+            return false;
+        FutexWait(ring->space_sequence, sequence);
+    }
+    if (contiguous < length)
+    {
+        // Not enough room before the end of the ring, skip to its start.
+        *reinterpret_cast<uint64_t*>(ring->GetData() + head % capacity) = contiguous | WrapFlag;
+        head += contiguous;
+    }
+    return true;
+}
+
+void SharedMemoryTransport::PublishRing(RingWriter& writer, uint64_t head)
+{
+    writer.ring->head.store(head, std::memory_order_release);
+    writer.doorbell->Ring();
+}
+
+int64_t SharedMemoryTransport::WriteMessage(RingWriter& writer, const Message& msg)
+{
+    static const uint8_t padding[8] = { 0 };
+    const std::vector<SmartArray<uint8_t>>& slices = msg.GetSlices();
+    const SmartArray<uint8_t> meta = msg.GetMessageMeta().PackAsBuffer();
+    std::vector<uint64_t> sizes;
+    sizes.reserve(slices.size());
+    for (const SmartArray<uint8_t>& slice: slices)
+        sizes.push_back(slice.size());
+    RecordHeader header;
+    header.word = 0;
+    header.sender = 0;
+    header.meta_size = static_cast<uint32_t>(meta.size());
+    header.slice_count = static_cast<uint32_t>(slices.size());
+    header.reserved = 0;
+    std::vector<std::pair<const uint8_t*, size_t>> segments;
+    segments.reserve(2 * slices.size() + 4);
+    segments.emplace_back(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+    segments.emplace_back(reinterpret_cast<const uint8_t*>(sizes.data()), sizes.size() * sizeof(uint64_t));
+    segments.emplace_back(meta.data(), meta.size());
+    segments.emplace_back(padding, Align8(meta.size()) - meta.size());
+    int64_t bytes = msg.GetMessageMeta().GetBody().size();
+    for (const SmartArray<uint8_t>& slice: slices)
+    {
+        segments.emplace_back(slice.data(), slice.size());
+        segments.emplace_back(padding, Align8(slice.size()) - slice.size());
+        bytes += slice.size();
+    }
+    uint64_t length = 0;
+    for (const auto& [ptr, size]: segments)
+        length += size;
+    header.word = length;
+
+    // Copy ``size`` bytes of the record, starting at ``offset``, to ``dest``.
+    size_t index = 0;
+    uint64_t skipped = 0;
+    auto copy = [&](uint64_t offset, uint64_t size, uint8_t* dest) {
+        while (skipped + segments[index].second <= offset)
+            skipped += segments[index++].second;
+        uint64_t start = offset - skipped;
+        while (size > 0)
+        {
+            const uint64_t n = std::min(size, segments[index].second - start);
+            memcpy(dest, segments[index].first + start, n);
+            dest += n;
+            size -= n;
+            start += n;
+            if (start == segments[index].second)
+            {
+                skipped += segments[index++].second;
+                start = 0;
+            }
+        }
+    };
+
+    // Waiting for the ring, or for another send to it, is bounded by the
+    // send timeout; the send fails through ``ActorProcess::Send`` after it.
+    const int timeout = GetConfig()->GetSendTimeout();
+    const Deadline deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+    auto fail = [&](const char* reason) {
+        std::string serr;
+        serr.append(GetConfig()->GetThisNodeInfo().ToShortString());
+        serr.append(": Fail to send message to node ");
+        serr.append(NodeIdToString(msg.GetMessageMeta().GetReceiver()));
+        serr.append(" through shared memory, ");
+        serr.append(reason);
+        serr.append(".\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    };
+    std::unique_lock<std::timed_mutex> lock(writer.mutex, deadline);
+    if (!lock.owns_lock())
+        fail(("other sends to the node did not finish in " + std::to_string(timeout) + " ms").c_str());
+    if (writer.broken)
+        fail("the ring is unusable after an unfinished message");
+    header.sender = writer.identity;
+    RingHeader* const ring = writer.ring;
+    const uint64_t capacity = ring->capacity;
+    const std::string full = "the ring had no room for " + std::to_string(timeout) + " ms";
+    if (length <= capacity / 2)
+    {
+        uint64_t head = 0;
+        if (!ReserveRing(writer, length, deadline, head))
+            fail(full.c_str());
+        copy(0, length, ring->GetData() + head % capacity);
+        PublishRing(writer, head + length);
+        return bytes;
+    }
+    const uint64_t maxChunk = (capacity / 2 - sizeof(FragmentHeader)) & ~uint64_t(7);
+    for (uint64_t offset = 0; offset < length;)
+    {
+        const uint64_t chunk = std::min(maxChunk, length - offset);
+        const uint64_t recordLength = sizeof(FragmentHeader) + chunk;
+        uint64_t head = 0;
+        if (!ReserveRing(writer, recordLength, deadline, head))
+        {
+            // The receiver holds the fragments sent so far and can not
+            // tell where the next message starts.
+            if (offset > 0)
+                writer.broken = true;
+            fail(full.c_str());
+        }
+        uint8_t* const ptr = ring->GetData() + head % capacity;
+        FragmentHeader* const fragment = reinterpret_cast<FragmentHeader*>(ptr);
+        fragment->word = recordLength | FragmentFlag;
+        fragment->record_length = length;
+        copy(offset, chunk, ptr + sizeof(FragmentHeader));
+        PublishRing(writer, head + recordLength);
+        offset += chunk;
+    }
+    return bytes;
+}
+
+void SharedMemoryTransport::Draining()
+{
+    while (!stopping_.load())
+    {
+        const uint32_t sequence = doorbell_->sequence.load();
+        AttachRingReaders();
+        bool found = false;
+        for (const std::shared_ptr<RingReader>& reader: readers_)
+            found |= DrainRing(*reader);
+        if (found)
+            continue;
+        doorbell_->sleeping.store(1);
+        if (!stopping_.load())
+            FutexWait(doorbell_->sequence, sequence);
+        doorbell_->sleeping.store(0);
+    }
+}
+
+void SharedMemoryTransport::AttachRingReaders()
+{
+    const uint32_t count = std::min(doorbell_->slot_count.load(), DoorbellSlotCount);
+    while (attached_count_ < count)
+    {
+        const int senderPort = doorbell_->slots[attached_count_].load();
+        if (senderPort == 0)
+            break;
+        attached_count_++;
+        const std::string name = GetRingName(port_, senderPort);
+        size_t size = 0;
+        void* const ptr = MapSharedMemory(name, size, false);
+        if (!ptr)
+        {
+            spdlog::warn("{}: Fail to open shared memory ring {}, errno: {} {}",
+                         GetConfig()->GetThisNodeInfo().ToShortString(), name, errno, strerror(errno));
+            continue;
+        }
+        // Both ends hold the mapping now, the name is no longer needed.
+        shm_unlink(name.c_str());
+        RingHeader* const ring = static_cast<RingHeader*>(ptr);
+        if (size < RingDataOffset || ring->magic != RingMagic || RingDataOffset + ring->capacity > size)
+        {
+            spdlog::warn("{}: Ignore invalid shared memory ring {}",
+                         GetConfig()->GetThisNodeInfo().ToShortString(), name);
+            munmap(ptr, size);
+            continue;
+        }
+        readers_.push_back(std::make_shared<RingReader>(ring, size));
+    }
+}
+
+bool SharedMemoryTransport::DrainRing(RingReader& reader)
+{
+    RingHeader* const ring = reader.GetRing();
+    const uint64_t capacity = ring->capacity;
+    const uint64_t head = ring->head.load(std::memory_order_acquire);
+    uint64_t read = reader.GetRead();
+    if (read == head)
+        return false;
+    std::shared_ptr<RingReader> self = reader.shared_from_this();
+    const int receiver = GetConfig()->GetThisNodeInfo().GetNodeId();
+    while (read < head)
+    {
+        uint8_t* ptr = ring->GetData() + read % capacity;
+        const uint64_t word = *reinterpret_cast<const uint64_t*>(ptr);
+        const uint64_t length = word & LengthMask;
+        read += length;
+        if (word & WrapFlag)
+        {
+            reader.AddEntry(read, true);
+            continue;
+        }
+        // The views of a whole record keep its ring space; reassembled
+        // records, and records that would leave more than half of the ring
+        // pinned, are copied out and their ring space released at once.
+        std::shared_ptr<void> token;
+        if (word & FragmentFlag)
+        {
+            const FragmentHeader* const fragment = reinterpret_cast<const FragmentHeader*>(ptr);
+            SmartArray<uint8_t>& assembly = reader.GetAssembly();
+            uint64_t& assembled = reader.GetAssembled();
+            if (assembled == 0)
+                assembly = SmartArray<uint8_t>(fragment->record_length);
+            const uint64_t chunk = length - sizeof(FragmentHeader);
+            memcpy(assembly.data() + assembled, ptr + sizeof(FragmentHeader), chunk);
+            assembled += chunk;
+            reader.AddEntry(read, true);
+            if (assembled < assembly.size())
+                continue;
+            ptr = assembly.data();
+            token = std::shared_ptr<void>(nullptr, [assembly](void*) { });
+            assembly = SmartArray<uint8_t>();
+            assembled = 0;
+        }
+        else if (read - ring->tail.load(std::memory_order_acquire) > capacity / 2)
+        {
+            SmartArray<uint8_t> record(length);
+            memcpy(record.data(), ptr, length);
+            reader.AddEntry(read, true);
+            ptr = record.data();
+            token = std::shared_ptr<void>(nullptr, [record](void*) { });
+        }
+        else
+        {
+            const uint64_t id = reader.AddEntry(read, false);
+            token = std::shared_ptr<void>(nullptr, [self, id](void*) { self->Release(id); });
+        }
+        const RecordHeader* const header = reinterpret_cast<const RecordHeader*>(ptr);
+        const uint64_t* const sizes = reinterpret_cast<const uint64_t*>(ptr + sizeof(RecordHeader));
+        uint8_t* cursor = ptr + sizeof(RecordHeader) + header->slice_count * sizeof(uint64_t);
+        Message msg;
+        msg.GetMessageMeta().UnpackFromBuffer(cursor, header->meta_size);
+        msg.GetMessageMeta().SetSender(header->sender);
+        msg.GetMessageMeta().SetReceiver(receiver);
+        cursor += Align8(header->meta_size);
+        for (uint32_t i = 0; i < header->slice_count; i++)
+        {
+            msg.AddSlice(SmartArray<uint8_t>::Create(cursor, sizes[i], [token](uint8_t*) { }));
+            cursor += Align8(sizes[i]);
+        }
+        token.reset();
+        Deliver(std::move(msg));
+    }
+    reader.SetRead(read);
+    return true;
+}
+
+void SharedMemoryTransport::Deliver(Message&& msg)
+{
+    {
+        std::lock_guard<std::mutex> lock(inbox_mutex_);
+        inbox_.push_back(std::move(msg));
+    }
+    const uint64_t one = 1;
+    if (write(event_fd_, &one, sizeof(one)) == -1 && errno != EAGAIN)
+        spdlog::warn("{}: Fail to write eventfd, errno: {} {}",
+                     GetConfig()->GetThisNodeInfo().ToShortString(), errno, strerror(errno));
+}
+
+int64_t SharedMemoryTransport::ReceiveMessage(Message& msg)
+{
+    for (;;)
+    {
+        {
+            std::lock_guard<std::mutex> lock(inbox_mutex_);
+            if (!inbox_.empty())
+            {
+                msg = std::move(inbox_.front());
+                inbox_.pop_front();
+                int64_t bytes = msg.GetMessageMeta().GetBody().size();
+                for (const SmartArray<uint8_t>& slice: msg.GetSlices())
+                    bytes += slice.size();
+                return bytes;
+            }
+        }
+        zmq_pollitem_t items[2] = {
+            { GetReceiverSocket(), 0, ZMQ_POLLIN, 0 },
+            { nullptr, event_fd_, ZMQ_POLLIN, 0 },
+        };
+        if (zmq_poll(items, 2, -1) == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            std::string serr;
+            serr.append("Fail to poll for messages, errno: ");
+            serr.append(std::to_string(errno));
+            serr.append(" ");
+            serr.append(zmq_strerror(errno));
+            serr.append(".\n\n");
+            serr.append(GetStackTrace());
+            spdlog::error(serr);
+            throw std::runtime_error(serr);
+        }
+        if (items[1].revents & ZMQ_POLLIN)
+        {
+            uint64_t value;
+            if (read(event_fd_, &value, sizeof(value)) == -1 && errno != EAGAIN)
+                spdlog::warn("{}: Fail to read eventfd, errno: {} {}",
+                             GetConfig()->GetThisNodeInfo().ToShortString(), errno, strerror(errno));
+            continue;
+        }
+        if (items[0].revents & ZMQ_POLLIN)
+            return ZeroMQTransport::ReceiveMessage(msg);
+    }
+}
+
+}
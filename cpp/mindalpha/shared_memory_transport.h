@@ -0,0 +1,125 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <mindalpha/zeromq_transport.h>
+
+//
+// ``shared_memory_transport.h`` defines class ``SharedMemoryTransport``
+// which passes messages between nodes on the same host through rings in
+// ``/dev/shm`` and falls back to ZeroMQ for other nodes.
+//
+// Every ordered pair of co-located nodes has a single-producer ring,
+// created by the sender when it connects to the receiver. The receiver
+// owns a doorbell region listing the rings created for it and holding the
+// futex word senders wake it with. A helper thread of the receiver drains
+// the rings and hands the messages to the receiving thread, which waits on
+// the ZeroMQ socket and an eventfd at once.
+//
+// Slices are written once into the ring and exposed to the receiver as
+// ``SmartArray`` views; ring space is reclaimed in order as the views are
+// released. Records that would leave more than half of a ring pinned by
+// views are copied out instead, so draining always gives senders room
+// back. Messages larger than half a ring are split into fragments and
+// reassembled by the receiver, so they keep their place in the stream.
+//
+// A send that finds no room in the ring within the configured send
+// timeout fails.
+//
+
+namespace mindalpha
+{
+
+class SharedMemoryTransport : public ZeroMQTransport
+{
+public:
+    explicit SharedMemoryTransport(std::shared_ptr<ActorConfig> config);
+    ~SharedMemoryTransport();
+
+    void Stop() override;
+    int Bind(const NodeInfo& node, int maxRetry) override;
+    void Connect(const NodeInfo& node) override;
+    int64_t SendMessage(const Message& msg) override;
+    int64_t ReceiveMessage(Message& msg) override;
+
+private:
+    struct Doorbell;
+    struct RingHeader;
+    class RingReader;
+
+    using Deadline = std::chrono::steady_clock::time_point;
+
+    // Sender side of a ring. ``broken`` is set when a fragmented message
+    // could not be finished, after which the stream can not be resumed.
+    struct RingWriter
+    {
+        std::timed_mutex mutex;
+        RingHeader* ring = nullptr;
+        Doorbell* doorbell = nullptr;
+        size_t ring_size = 0;
+        size_t doorbell_size = 0;
+        int identity = -1;
+        bool broken = false;
+
+        ~RingWriter();
+    };
+
+    std::shared_ptr<RingWriter> OpenRingWriter(const NodeInfo& node);
+    int64_t WriteMessage(RingWriter& writer, const Message& msg);
+    bool ReserveRing(RingWriter& writer, uint64_t length, Deadline deadline, uint64_t& head);
+    void PublishRing(RingWriter& writer, uint64_t head);
+
+    void Draining();
+    void AttachRingReaders();
+    bool DrainRing(RingReader& reader);
+    void Deliver(Message&& msg);
+
+    static std::string GetDoorbellName(int port);
+    static std::string GetRingName(int receiver_port, int sender_port);
+
+    int port_ = -1;
+    Doorbell* doorbell_ = nullptr;
+    size_t doorbell_size_ = 0;
+    uint32_t attached_count_ = 0;
+    std::vector<std::shared_ptr<RingReader>> readers_;
+    std::thread drainer_;
+    std::atomic<bool> stopping_{false};
+
+    int event_fd_ = -1;
+    std::mutex inbox_mutex_;
+    std::deque<Message> inbox_;
+
+    std::shared_mutex writers_mutex_;
+    std::unordered_map<std::string, std::shared_ptr<RingWriter>> writers_by_address_;
+    std::unordered_set<std::string> zeromq_addresses_;
+    std::unordered_map<int, std::shared_ptr<RingWriter>> writers_;
+};
+
+}
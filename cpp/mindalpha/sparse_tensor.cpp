@@ -36,13 +36,15 @@ void SparseTensor::Init(std::function<void()> cb)
     };
     req->GetMessageMeta().SetReceiver(ServerGroup);
     req->GetMessageMeta().SetBody(json.dump());
-    agent_->BroadcastRequest(req, [cb](PSMessage req, std::vector<PSMessage> ress) {
+    agent_->BroadcastRequest(req, [this, cb](PSMessage req, std::vector<PSMessage> ress) {
+        SetTensorIds(ress);
         cb();
     });
 }
 
 void SparseTensor::Dispose(std::function<void()> cb)
 {
+    tensor_ids_.clear();
     PSMessage req = std::make_shared<Message>();
     json11::Json json = json11::Json::object
     {
@@ -58,6 +60,7 @@ void SparseTensor::Dispose(std::function<void()> cb)
 
 void SparseTensor::Clear(std::function<void()> cb)
 {
+    pull_cache_.InvalidateAll();
     PSMessage req = std::make_shared<Message>();
     json11::Json json = json11::Json::object
     {
@@ -73,57 +76,106 @@ void SparseTensor::Clear(std::function<void()> cb)
 
 void SparseTensor::Push(SmartArray<uint8_t> keys, SmartArray<uint8_t> in, std::function<void()> cb, bool is_value)
 {
-    const size_t index_count = keys.size() / sizeof(uint64_t);
-    const uint64_t* const indices = reinterpret_cast<uint64_t*>(keys.data());
-    const uint8_t* source = in.data();
-    const size_t num_parts = GetMeta().GetPartitionCount();
-    std::vector<std::vector<uint64_t>> part_keys(num_parts);
-    std::vector<std::vector<uint8_t>> part_data(num_parts);
-    for (size_t i = 0; i < index_count; i++)
+    std::vector<PSMessage> reqs = MakePushRequests(keys, in, is_value);
+    agent_->SendAllRequests(std::move(reqs), [cb](std::vector<PSMessage> reqs, std::vector<PSMessage> ress) {
+        cb();
+    });
+}
+
+void SparseTensor::Pull(SmartArray<uint8_t> keys, std::function<void(SmartArray<uint8_t> out)> cb, bool read_only, bool nan_fill)
+{
+    // Pulls with ``nan_fill`` bypass the cache, as their rows of missing keys are NaN.
+    if (pull_cache_.IsEnabled() && !nan_fill)
     {
-        const uint64_t key = indices[i];
-        const size_t part = key % num_parts;
-        part_keys.at(part).push_back(key);
-        VectorAppend(part_data.at(part), source, GetMeta().GetSliceDataLength());
-        source += GetMeta().GetSliceDataLength();
+        PullCached(keys, std::move(cb), read_only);
+        return;
     }
+    auto partition = std::make_shared<KeyPartition>(keys, *GetKeyRouter());
+    std::vector<PSMessage> reqs = MakePullRequests(*partition, read_only, nan_fill);
+    agent_->SendAllRequests(std::move(reqs), [this, partition, cb](std::vector<PSMessage> reqs, std::vector<PSMessage> ress) {
+        SmartArray<uint8_t> out = CombinePullResponses(*partition, ress);
+        cb(out);
+    });
+}
+
+void SparseTensor::PullCached(SmartArray<uint8_t> keys, std::function<void(SmartArray<uint8_t> out)> cb, bool read_only)
+{
+    const size_t row_bytes = GetMeta().GetSliceDataLength();
+    const size_t key_count = keys.size() / sizeof(uint64_t);
+    const uint64_t* const indices = reinterpret_cast<const uint64_t*>(keys.data());
+    SmartArray<uint8_t> out(key_count * row_bytes);
+    uint64_t step;
+    auto misses = std::make_shared<std::vector<size_t>>(pull_cache_.Lookup(indices, key_count, row_bytes, out.data(), step));
+    if (misses->empty())
+    {
+        cb(out);
+        return;
+    }
+    SmartArray<uint64_t> miss_keys(misses->size());
+    for (size_t j = 0; j < misses->size(); j++)
+        miss_keys[j] = indices[misses->at(j)];
+    auto partition = std::make_shared<KeyPartition>(miss_keys.Cast<uint8_t>(), *GetKeyRouter());
+    std::vector<PSMessage> reqs = MakePullRequests(*partition, read_only, false);
+    agent_->SendAllRequests(std::move(reqs), [this, keys, out, misses, partition, row_bytes, step, read_only, cb](std::vector<PSMessage> reqs, std::vector<PSMessage> ress) {
+        SmartArray<uint8_t> rows = CombinePullResponses(*partition, ress);
+        SmartArray<uint8_t> result = out;
+        const uint64_t* const indices = reinterpret_cast<const uint64_t*>(keys.data());
+        pull_cache_.Fill(indices, *misses, rows.data(), row_bytes, result.data(), step, !read_only);
+        cb(result);
+    });
+}
+
+std::vector<PSMessage> SparseTensor::MakePushRequests(SmartArray<uint8_t> keys, SmartArray<uint8_t> in, bool is_value) const
+{
+    const size_t num_parts = GetMeta().GetPartitionCount();
+    const DataType data_type = GetMeta().GetDataType();
+    const size_t row_items = GetMeta().GetSliceDataLength() / DataTypeToSize(data_type);
+    // Rows of duplicate keys are combined before partitioning, so that
+    // every key is sent and updated once.
+    if (!is_value)
+        gradient_aggregator_.Aggregate(GetMeta().GetGradientAggregation(), data_type, keys, in, row_items);
+    if (pull_cache_.IsEnabled())
+        pull_cache_.Invalidate(reinterpret_cast<const uint64_t*>(keys.data()), keys.size() / sizeof(uint64_t));
+    const KeyPartition partition(keys, *GetKeyRouter());
+    SmartArray<uint8_t> grouped = partition.GroupRows(in, GetMeta().GetSliceDataLength());
     json11::Json json = json11::Json::object
     {
         { "command", "SparsePush" },
         { "name", GetMeta().GetName() },
         { "is_value", is_value },
     };
-    std::string command = json.dump();
+    const std::string command = tensor_ids_.empty() ? json.dump() : std::string();
+    const int flags = is_value ? DataRequest::IsValueFlag : 0;
+    const GradientCodec codec = GetMeta().GetGradientCodec();
     std::vector<PSMessage> reqs;
     reqs.reserve(num_parts);
     for (size_t k = 0; k < num_parts; k++)
     {
         PSMessage req = std::make_shared<Message>();
         req->GetMessageMeta().SetReceiver(ServerRankToNodeId(k));
-        req->GetMessageMeta().SetBody(command);
-        auto k_keys = SmartArray<uint64_t>::Wrap(std::move(part_keys.at(k)));
-        auto k_in = SmartArray<uint8_t>::Wrap(std::move(part_data.at(k)));
+        if (tensor_ids_.empty())
+            req->GetMessageMeta().SetBody(command);
+        else
+            SetRequestHeader(req, DataRequestCommand::SparsePush, flags, k);
+        SmartArray<uint64_t> k_keys = partition.GetPartKeys(k);
+        SmartArray<uint8_t> k_in = partition.GetPartRows(grouped, k, GetMeta().GetSliceDataLength());
         req->AddTypedSlice(k_keys);
-        req->AddTypedSlice(k_in, GetMeta().GetDataType());
+        if (is_value)
+            req->AddTypedSlice(k_in, data_type);
+        else
+        {
+            // Encoded gradients are opaque bytes until the server decodes them.
+            SmartArray<uint8_t> grad = gradient_encoder_.Encode(codec, data_type, k_in, row_items, 0.0, k);
+            req->AddTypedSlice(grad, codec == GradientCodec::None ? data_type : DataType::UInt8);
+        }
         reqs.push_back(req);
     }
-    agent_->SendAllRequests(std::move(reqs), [cb](std::vector<PSMessage> reqs, std::vector<PSMessage> ress) {
-        cb();
-    });
+    return reqs;
 }
 
-void SparseTensor::Pull(SmartArray<uint8_t> keys, std::function<void(SmartArray<uint8_t> out)> cb, bool read_only, bool nan_fill)
+std::vector<PSMessage> SparseTensor::MakePullRequests(const KeyPartition& partition, bool read_only, bool nan_fill) const
 {
-    const size_t index_count = keys.size() / sizeof(uint64_t);
-    const uint64_t* const indices = reinterpret_cast<uint64_t*>(keys.data());
-    const size_t num_parts = GetMeta().GetPartitionCount();
-    std::vector<std::vector<uint64_t>> part_keys(num_parts);
-    for (size_t i = 0; i < index_count; i++)
-    {
-        const uint64_t key = indices[i];
-        const size_t part = key % num_parts;
-        part_keys.at(part).push_back(key);
-    }
+    const size_t num_parts = partition.GetPartCount();
     json11::Json json = json11::Json::object
     {
         { "command", "SparsePull" },
@@ -131,65 +183,58 @@ void SparseTensor::Pull(SmartArray<uint8_t> keys, std::function<void(SmartArray<
         { "read_only", read_only },
         { "nan_fill", nan_fill },
     };
-    std::string command = json.dump();
+    const std::string command = tensor_ids_.empty() ? json.dump() : std::string();
+    const int flags = (read_only ? DataRequest::ReadOnlyFlag : 0) | (nan_fill ? DataRequest::NanFillFlag : 0);
     std::vector<PSMessage> reqs;
     reqs.reserve(num_parts);
     for (size_t k = 0; k < num_parts; k++)
     {
         PSMessage req = std::make_shared<Message>();
         req->GetMessageMeta().SetReceiver(ServerRankToNodeId(k));
-        req->GetMessageMeta().SetBody(command);
-        auto k_keys = SmartArray<uint64_t>::Wrap(std::move(part_keys.at(k)));
-        req->AddTypedSlice(k_keys);
+        if (tensor_ids_.empty())
+            req->GetMessageMeta().SetBody(command);
+        else
+            SetRequestHeader(req, DataRequestCommand::SparsePull, flags, k);
+        req->AddTypedSlice(partition.GetPartKeys(k));
         reqs.push_back(req);
     }
-    agent_->SendAllRequests(std::move(reqs), [this, keys, cb](std::vector<PSMessage> reqs, std::vector<PSMessage> ress) {
-        const size_t index_count = keys.size() / sizeof(uint64_t);
-        SmartArray<uint8_t> out(index_count * GetMeta().GetSliceDataLength());
-        uint8_t* target = out.data();
-        const uint64_t* const indices = reinterpret_cast<const uint64_t*>(keys.data());
-        const size_t num_parts = GetMeta().GetPartitionCount();
-        std::vector<const uint8_t*> sources(num_parts);
-        for (size_t k = 0; k < ress.size(); k++)
-        {
-            PSMessage res = ress.at(k);
-            const int sender = res->GetMessageMeta().GetSender();
-            const int rank = NodeIdToRank(sender);
-            SmartArray<uint8_t> k_out = res->GetTypedSlice(0, GetMeta().GetDataType());
-            const uint8_t* const source = k_out.data();
-            sources.at(rank) = source;
-        }
-        for (size_t i = 0; i < index_count; i++)
-        {
-            const uint64_t key = indices[i];
-            const size_t part = key % num_parts;
-            const uint8_t*& source = sources.at(part);
-            memcpy(target, source, GetMeta().GetSliceDataLength());
-            target += GetMeta().GetSliceDataLength();
-            source += GetMeta().GetSliceDataLength();
-        }
-        cb(out);
-    });
+    return reqs;
+}
+
+SmartArray<uint8_t> SparseTensor::CombinePullResponses(const KeyPartition& partition, const std::vector<PSMessage>& ress) const
+{
+    const size_t row_bytes = GetMeta().GetSliceDataLength();
+    SmartArray<uint8_t> out(partition.GetKeyCount() * row_bytes);
+    for (size_t k = 0; k < ress.size(); k++)
+    {
+        PSMessage res = ress.at(k);
+        const int sender = res->GetMessageMeta().GetSender();
+        const int rank = NodeIdToRank(sender);
+        SmartArray<uint8_t> k_out = res->GetTypedSlice(0, GetMeta().GetDataType());
+        partition.ScatterRows(rank, k_out.data(), out.data(), row_bytes);
+    }
+    return out;
 }
 
-void SparseTensor::PushPartition(ArrayHashMap<uint64_t, uint8_t>& data, std::function<void()> cb,
-                                 bool data_only, bool skip_existing)
+void SparseTensor::PushPartition(SparseTensorHashMap& data, std::function<void()> cb,
+                                 bool data_only, bool skip_existing, int resident_index)
 {
     const size_t index_count = data.size();
-    const uint64_t* const indices = data.GetKeysArray();
-    const uint8_t* source = data.GetValuesArray();
     const size_t num_parts = GetMeta().GetPartitionCount();
     const size_t vec_length = data_only ? GetMeta().GetSliceDataLength() : GetMeta().GetSliceTotalBytes();
-    std::vector<std::vector<uint64_t>> part_keys(num_parts);
-    std::vector<std::vector<uint8_t>> part_data(num_parts);
-    for (size_t i = 0; i < index_count; i++)
+    auto keys = SmartArray<uint64_t>::Ref(data.GetKeysArray(), index_count).Cast<uint8_t>();
+    auto values = SmartArray<uint8_t>::Ref(data.GetValuesArray(), index_count * vec_length);
+    // ``data`` may be gone before the requests are sent. Grouping copies
+    // the keys and values, except for a single server where it keeps them.
+    if (num_parts == 1)
     {
-        const uint64_t key = indices[i];
-        const size_t part = key % num_parts;
-        part_keys.at(part).push_back(key);
-        VectorAppend(part_data.at(part), source, vec_length);
-        source += vec_length;
+        keys = keys.Copy();
+        values = values.Copy();
     }
+    if (pull_cache_.IsEnabled())
+        pull_cache_.Invalidate(data.GetKeysArray(), index_count);
+    const KeyPartition partition(keys, *GetKeyRouter());
+    SmartArray<uint8_t> grouped = partition.GroupRows(values, vec_length);
     json11::Json json = json11::Json::object
     {
         { "command", "SparsePushPartition" },
@@ -202,21 +247,26 @@ void SparseTensor::PushPartition(ArrayHashMap<uint64_t, uint8_t>& data, std::fun
     reqs.reserve(num_parts);
     for (size_t k = 0; k < num_parts; k++)
     {
+        if (static_cast<int>(k) == resident_index)
+            continue;
         PSMessage req = std::make_shared<Message>();
         req->GetMessageMeta().SetReceiver(ServerRankToNodeId(k));
         req->GetMessageMeta().SetBody(command);
-        auto k_keys = SmartArray<uint64_t>::Wrap(std::move(part_keys.at(k)));
-        auto k_in = SmartArray<uint8_t>::Wrap(std::move(part_data.at(k)));
-        req->AddTypedSlice(k_keys);
-        req->AddTypedSlice(k_in, GetMeta().GetDataType());
+        req->AddTypedSlice(partition.GetPartKeys(k));
+        req->AddTypedSlice(partition.GetPartRows(grouped, k, vec_length), GetMeta().GetDataType());
         reqs.push_back(req);
     }
+    if (reqs.empty())
+    {
+        cb();
+        return;
+    }
     agent_->SendAllRequests(std::move(reqs), [cb](std::vector<PSMessage> reqs, std::vector<PSMessage> ress) {
         cb();
     });
 }
 
-void SparseTensor::PullPartition(ArrayHashMap<uint64_t, uint8_t>& data, std::function<void()> cb,
+void SparseTensor::PullPartition(SparseTensorHashMap& data, std::function<void()> cb,
                                  bool data_only, int index, int count)
 {
     if (index == -1)
@@ -327,9 +377,12 @@ void SparseTensor::Load(const std::string& dir_path, std::function<void()> cb, b
         spdlog::error(serr);
         throw std::runtime_error(serr);
     }
+    pull_cache_.InvalidateAll();
     const int old_part_count = meta.GetPartitionCount();
-    auto load_data_and_state = [this, dir_path, cb, old_part_count] {
-        if (GetMeta().GetPartitionCount() == old_part_count)
+    const KeyPartitioner old_partitioner = meta.GetKeyPartitioner();
+    auto load_data_and_state = [this, dir_path, cb, old_part_count, old_partitioner] {
+        const bool same_partitioner = GetMeta().GetKeyPartitioner() == old_partitioner;
+        if (GetMeta().GetPartitionCount() == old_part_count && same_partitioner)
         {
             // To support sparse tensors repartition, ``if self.agent.rank == 0:`` is not checked in
             // Python code, and we must check this in C++ explicitly.
@@ -352,6 +405,34 @@ void SparseTensor::Load(const std::string& dir_path, std::function<void()> cb, b
                 cb();
             });
         }
+        else if (same_partitioner && IsConsistentKeyPartitioner(old_partitioner))
+        {
+            // The number of servers changed, but most keys stay on the server
+            // with the index of their saved partition. Servers load those keys
+            // themselves, and workers push only the keys that moved.
+            std::string meta_file_path = GetSparseMetaPath(dir_path);
+            auto import_moved = [this, meta_file_path, cb] {
+                ImportPartitions(meta_file_path, cb, false, false, false, "", true);
+            };
+            if (agent_->GetAgentRank() != 0)
+            {
+                import_moved();
+                return;
+            }
+            PSMessage req = std::make_shared<Message>();
+            json11::Json json = json11::Json::object
+            {
+                { "command", "SparseLoad" },
+                { "name", GetMeta().GetName() },
+                { "dir_path", dir_path },
+                { "old_partition_count", old_part_count },
+            };
+            req->GetMessageMeta().SetReceiver(ServerGroup);
+            req->GetMessageMeta().SetBody(json.dump());
+            agent_->BroadcastRequest(req, [import_moved](PSMessage req, std::vector<PSMessage> ress) {
+                import_moved();
+            });
+        }
         else
         {
             // The sparse tensor is repartitioned, all workers need to
@@ -417,6 +498,14 @@ void SparseTensor::Export(const std::string& dir_path, std::function<void()> cb)
 void SparseTensor::ImportFrom(const std::string& meta_file_path, std::function<void()> cb,
                               bool data_only, bool skip_existing,
                               bool transform_key, const std::string& feature_name)
+{
+    ImportPartitions(meta_file_path, cb, data_only, skip_existing, transform_key, feature_name, false);
+}
+
+void SparseTensor::ImportPartitions(const std::string& meta_file_path, std::function<void()> cb,
+                                    bool data_only, bool skip_existing,
+                                    bool transform_key, const std::string& feature_name,
+                                    bool moved_only)
 {
     std::string str = StreamReadAll(meta_file_path);
     SparseTensorMeta meta = SparseTensorMeta::FromJsonString(str);
@@ -440,6 +529,7 @@ void SparseTensor::ImportFrom(const std::string& meta_file_path, std::function<v
         bool skip_existing = false;
         bool transform_key = false;
         std::string feature_name;
+        bool moved_only = false;
         SparseTensorMeta meta;
         SparseTensor* sparse_tensor = nullptr;
         std::vector<int> partition_indices;
@@ -453,7 +543,7 @@ void SparseTensor::ImportFrom(const std::string& meta_file_path, std::function<v
                 return;
             }
             const size_t vec_length = data_only ? meta.GetSliceDataLength() : meta.GetSliceTotalBytes();
-            ArrayHashMap<uint64_t, uint8_t> map(vec_length);
+            SparseTensorHashMap map(vec_length);
             const std::string dir_path = DirName(meta_file_path);
             const int partition_index = partition_indices.at(index++);
             std::string path = GetSparsePath(dir_path, meta, partition_index);
@@ -514,7 +604,9 @@ void SparseTensor::ImportFrom(const std::string& meta_file_path, std::function<v
                 }
                 reader.Read();
             }
-            sparse_tensor->PushPartition(map, [self = shared_from_this()] { (*self)(); }, data_only, skip_existing);
+            const int resident_index = moved_only ? partition_index : -1;
+            sparse_tensor->PushPartition(map, [self = shared_from_this()] { (*self)(); },
+                                         data_only, skip_existing, resident_index);
         }
     };
     auto lambda = std::make_shared<Lambda>();
@@ -524,9 +616,15 @@ void SparseTensor::ImportFrom(const std::string& meta_file_path, std::function<v
     lambda->skip_existing = skip_existing;
     lambda->transform_key = transform_key;
     lambda->feature_name = feature_name;
+    lambda->moved_only = moved_only;
+    // When servers are removed, consistent partitioners move only the keys
+    // of the removed servers; the other saved partitions are left alone.
+    const int new_part_count = GetMeta().GetPartitionCount();
+    const bool shrinking = meta.GetPartitionCount() > new_part_count;
     for (int i = 0; i < meta.GetPartitionCount(); i++)
         if (i % agent_->GetWorkerCount() == agent_->GetAgentRank())
-            lambda->partition_indices.push_back(i);
+            if (!moved_only || !shrinking || i >= new_part_count)
+                lambda->partition_indices.push_back(i);
     lambda->meta = std::move(meta);
     lambda->sparse_tensor = this;
     (*lambda)();
@@ -578,4 +676,39 @@ std::string SparseTensor::GetSparsePath(const std::string& dir_path, const Spars
     return file_path;
 }
 
+std::shared_ptr<const KeyRouter> SparseTensor::GetKeyRouter() const
+{
+    const KeyPartitioner partitioner = GetMeta().GetKeyPartitioner();
+    const size_t part_count = GetMeta().GetPartitionCount();
+    std::lock_guard<std::mutex> lock(key_router_mutex_);
+    if (!key_router_ || key_router_->GetPartitioner() != partitioner || key_router_->GetPartCount() != part_count)
+        key_router_ = std::make_shared<KeyRouter>(partitioner, part_count);
+    return key_router_;
+}
+
+void SparseTensor::SetTensorIds(const std::vector<PSMessage>& ress)
+{
+    std::vector<int> ids(GetMeta().GetPartitionCount(), -1);
+    for (const PSMessage& res : ress)
+    {
+        const int rank = NodeIdToRank(res->GetMessageMeta().GetSender());
+        const int id = res->GetMessageMeta().GetDataRequest().GetTensorId();
+        if (rank < 0 || rank >= static_cast<int>(ids.size()) || id < 0)
+            return;
+        ids.at(rank) = id;
+    }
+    for (int id : ids)
+        if (id < 0)
+            return;
+    tensor_ids_ = std::move(ids);
+}
+
+void SparseTensor::SetRequestHeader(PSMessage req, DataRequestCommand command, int flags, int rank) const
+{
+    DataRequest& request = req->GetMessageMeta().GetDataRequest();
+    request.SetCommand(command);
+    request.SetTensorId(tensor_ids_.at(rank));
+    request.SetFlags(flags);
+}
+
 }
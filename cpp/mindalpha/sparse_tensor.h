@@ -17,17 +17,24 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
+#include <vector>
 #include <functional>
 #include <mindalpha/ps_agent.h>
 #include <mindalpha/smart_array.h>
+#include <mindalpha/data_request.h>
 #include <mindalpha/sparse_tensor_meta.h>
 #include <mindalpha/array_hash_map.h>
+#include <mindalpha/key_partition.h>
+#include <mindalpha/embedding_cache.h>
 
 namespace mindalpha
 {
 
 class SparseTensor
 {
+    friend class TensorBatch;
+
 public:
     SparseTensorMeta& GetMeta() { return meta_; }
     const SparseTensorMeta& GetMeta() const { return meta_; }
@@ -36,6 +43,10 @@ public:
     std::shared_ptr<PSAgent> GetAgent() const { return agent_; }
     void SetAgent(std::shared_ptr<PSAgent> value) { agent_ = std::move(value); }
 
+    GradientEncoder& GetGradientEncoder() const { return gradient_encoder_; }
+    GradientAggregator& GetGradientAggregator() const { return gradient_aggregator_; }
+    EmbeddingCache& GetPullCache() const { return pull_cache_; }
+
     void Init(std::function<void()> cb);
     void Dispose(std::function<void()> cb);
     void Clear(std::function<void()> cb);
@@ -43,9 +54,13 @@ public:
               bool is_value = false);
     void Pull(SmartArray<uint8_t> keys, std::function<void(SmartArray<uint8_t> out)> cb,
               bool read_only = false, bool nan_fill = false);
-    void PushPartition(ArrayHashMap<uint64_t, uint8_t>& data, std::function<void()> cb,
-                       bool data_only = false, bool skip_existing = false);
-    void PullPartition(ArrayHashMap<uint64_t, uint8_t>& data, std::function<void()> cb,
+    // Keys routed to server ``resident_index`` are not sent, as that server
+    // loaded them itself.
+    void PushPartition(SparseTensorHashMap& data, std::function<void()> cb,
+                       bool data_only = false, bool skip_existing = false,
+                       int resident_index = -1);
+    // ``data`` is filled on the completion thread and must outlive ``cb``.
+    void PullPartition(SparseTensorHashMap& data, std::function<void()> cb,
                        bool data_only = false, int index = -1, int count = -1);
     void PushMeta(const SparseTensorMeta& meta, std::function<void()> cb);
     void PullMeta(std::function<void(SparseTensorMeta meta)> cb);
@@ -59,11 +74,49 @@ public:
     void PruneOld(int max_age, std::function<void()> cb);
 
 private:
+    // Build the requests of ``Push`` and ``Pull`` for every server and
+    // assemble the pulled slices, so that ``TensorBatch`` can fuse them
+    // with the requests of other tensors. A pull keeps ``partition`` to
+    // put the pulled slices back in the order of the keys.
+    std::vector<PSMessage> MakePushRequests(SmartArray<uint8_t> keys, SmartArray<uint8_t> in, bool is_value) const;
+    std::vector<PSMessage> MakePullRequests(const KeyPartition& partition, bool read_only, bool nan_fill) const;
+    SmartArray<uint8_t> CombinePullResponses(const KeyPartition& partition, const std::vector<PSMessage>& ress) const;
+
+    // The router of the current partitioner and partition count; it is
+    // rebuilt when either of them changes.
+    std::shared_ptr<const KeyRouter> GetKeyRouter() const;
+
+    // With ``moved_only``, only keys no longer routed to the partition they
+    // were saved in are pushed, and partitions whose keys all stay are not
+    // read at all.
+    void ImportPartitions(const std::string& meta_file_path, std::function<void()> cb,
+                          bool data_only, bool skip_existing,
+                          bool transform_key, const std::string& feature_name,
+                          bool moved_only);
+
+    // Serve the keys cached by ``pull_cache_`` and pull the others.
+    void PullCached(SmartArray<uint8_t> keys, std::function<void(SmartArray<uint8_t> out)> cb, bool read_only);
+
+    // Ids the servers assigned to the tensor at init, indexed by server
+    // rank; empty if the tensor was not initialized by this object, in which
+    // case pulls and pushes fall back to JSON bodies.
+    void SetTensorIds(const std::vector<PSMessage>& ress);
+    void SetRequestHeader(PSMessage req, DataRequestCommand command, int flags, int rank) const;
+
     std::string GetSparseMetaPath(const std::string& dir_path) const;
     static std::string GetSparsePath(const std::string& dir_path, const SparseTensorMeta& meta, int index);
 
     SparseTensorMeta meta_;
     std::shared_ptr<PSAgent> agent_;
+    std::vector<int> tensor_ids_;
+    // Counts the bytes of pushed gradients; mutable as pushing is const.
+    mutable GradientEncoder gradient_encoder_;
+    // Counts the keys of pushed gradients before and after aggregation.
+    mutable GradientAggregator gradient_aggregator_;
+    // Rows pulled recently; mutable as pushing, which invalidates them, is const.
+    mutable EmbeddingCache pull_cache_;
+    mutable std::mutex key_router_mutex_;
+    mutable std::shared_ptr<const KeyRouter> key_router_;
 };
 
 }
@@ -24,6 +24,30 @@
 namespace mindalpha
 {
 
+namespace
+{
+
+// The Python fallbacks view whole slices as numpy arrays of the data type,
+// which can not describe the ``float`` states of half precision tensors.
+void CheckPythonFallback(const SparseTensorMeta& meta, const char* kind)
+{
+    if (!IsHalfDataType(meta.GetDataType()))
+        return;
+    std::string serr;
+    serr.append("Sparse tensor '");
+    serr.append(meta.GetName());
+    serr.append("' of data type ");
+    serr.append(DataTypeToString(meta.GetDataType()));
+    serr.append(" requires a built-in ");
+    serr.append(kind);
+    serr.append(" with a native implementation.\n\n");
+    serr.append(GetStackTrace());
+    spdlog::error(serr);
+    throw std::runtime_error(serr);
+}
+
+}
+
 void SparseTensorMeta::CheckSparseTensorMeta(int index) const
 {
     if (GetName().empty())
@@ -62,15 +86,22 @@ void SparseTensorMeta::CheckSparseTensorMeta(int index) const
         spdlog::error(serr);
         throw std::runtime_error(serr);
     }
+    CheckGradientCodec(GetName(), GetGradientCodec(), GetDataType(), false, 0.0);
+    CheckGradientAggregation(GetName(), GetGradientAggregation(), GetDataType());
 }
 
 void SparseTensorMeta::ComputeSliceInfo()
 {
     const size_t item_size = DataTypeToSize(data_type_);
+    const size_t state_item_size = DataTypeToSize(DataTypeToStateType(data_type_));
+    // States of half precision tensors are ``float``, the data part is
+    // padded so that they are aligned.
+    const size_t state_mask = state_item_size - 1;
     slice_data_length_ = item_size * TotalElements(slice_data_shape_);
-    slice_state_length_ = item_size * TotalElements(slice_state_shape_);
-    const size_t age_offset = slice_data_length_ + slice_state_length_;
-    const size_t age_size = std::max(item_size, sizeof(int));
+    slice_state_offset_ = (slice_data_length_ + state_mask) & ~state_mask;
+    slice_state_length_ = state_item_size * TotalElements(slice_state_shape_);
+    const size_t age_offset = slice_state_offset_ + slice_state_length_;
+    const size_t age_size = std::max(state_item_size, sizeof(int));
     const size_t age_mask = age_size - 1;
     slice_age_offset_ = (age_offset + age_mask) & ~age_mask;
     slice_total_bytes_ = slice_age_offset_ + age_size;
@@ -91,12 +122,18 @@ void SparseTensorMeta::SetInitializerByData(std::string data)
         py::object obj = mindalpha::deserialize_pyobject(data);
         MakeInitializerReady(obj);
         std::shared_ptr<py::object> func = mindalpha::make_shared_pyobject(obj);
-        initializer_ = [func](const std::string& name,
-                              mindalpha::SmartArray<uint8_t> data,
-                              mindalpha::SmartArray<uint8_t> keys,
-                              const SparseTensorMeta& meta)
+        std::shared_ptr<NativeInitializer> native = MakeNativeInitializer(obj);
+        initializer_ = [func, native](const std::string& name,
+                                      mindalpha::SmartArray<uint8_t> data,
+                                      mindalpha::SmartArray<uint8_t> keys,
+                                      const SparseTensorMeta& meta)
         {
+            // Built-in initializers are applied in C++ without acquiring the GIL.
+            if (native && native->IsSupported(meta))
+                native->InitializeSparse(name, data, keys, meta);
+            else
             {
+                CheckPythonFallback(meta, "initializer");
                 py::gil_scoped_acquire gil;
                 const size_t item_size = mindalpha::DataTypeToSize(meta.data_type_);
                 const size_t cols = meta.slice_total_bytes_ / item_size;
@@ -134,6 +171,7 @@ void SparseTensorMeta::SetUpdaterByData(std::string data)
     {
         updater_ = {};
         updater_object_ = {};
+        native_updater_ = {};
     }
     else
     {
@@ -141,13 +179,14 @@ void SparseTensorMeta::SetUpdaterByData(std::string data)
         py::object obj = mindalpha::deserialize_pyobject(data);
         MakeUpdaterReady(obj);
         std::shared_ptr<py::object> func = mindalpha::make_shared_pyobject(obj);
-        updater_ = [func](const std::string& name,
-                          mindalpha::SmartArray<uint8_t> param,
-                          mindalpha::SmartArray<uint8_t> grad,
-                          mindalpha::SmartArray<uint8_t> indices,
-                          mindalpha::SmartArray<uint8_t> keys,
-                          const SparseTensorMeta& meta)
+        SparseUpdater python_updater = [func](const std::string& name,
+                                             mindalpha::SmartArray<uint8_t> param,
+                                             mindalpha::SmartArray<uint8_t> grad,
+                                             mindalpha::SmartArray<uint8_t> indices,
+                                             mindalpha::SmartArray<uint8_t> keys,
+                                             const SparseTensorMeta& meta)
         {
+            CheckPythonFallback(meta, "updater");
             // Some PyTorch operations such as ``grad.clone()`` and ``XXX + grad``
             // require memory alignment, we use ``SmartArray::Copy`` to use GLIBC allocated
             // memory which is 16 bytes aligned.
@@ -190,6 +229,27 @@ void SparseTensorMeta::SetUpdaterByData(std::string data)
                         "state"_a=state_arr, "indices"_a=indices_arr, "keys"_a=keys_arr);
             }
         };
+        std::shared_ptr<NativeUpdater> native = MakeNativeUpdater(obj);
+        native_updater_ = native;
+        if (!native)
+            updater_ = std::move(python_updater);
+        else
+        {
+            // Built-in updaters are applied in C++ without acquiring the GIL,
+            // slice layouts they don't expect fall back to the Python version.
+            updater_ = [native, python_updater](const std::string& name,
+                                                mindalpha::SmartArray<uint8_t> param,
+                                                mindalpha::SmartArray<uint8_t> grad,
+                                                mindalpha::SmartArray<uint8_t> indices,
+                                                mindalpha::SmartArray<uint8_t> keys,
+                                                const SparseTensorMeta& meta)
+            {
+                if (native->IsSupported(meta))
+                    native->UpdateSparse(param, grad, indices, meta);
+                else
+                    python_updater(name, param, grad, indices, keys, meta);
+            };
+        }
         updater_object_ = std::move(func);
     }
 }
@@ -233,6 +293,11 @@ json11::Json SparseTensorMeta::to_json() const
         { "initializer_data", GetInitializerAsData() },
         { "updater_data", GetUpdaterAsData() },
         { "partition_count", partition_count_ },
+        { "hash_map_engine", HashMapEngineToString(hash_map_engine_) },
+        { "memory_buffer_backend", MemoryBufferBackendToString(memory_buffer_backend_) },
+        { "gradient_codec", GradientCodecToString(gradient_codec_) },
+        { "gradient_aggregation", GradientAggregationToString(gradient_aggregation_) },
+        { "key_partitioner", KeyPartitionerToString(key_partitioner_) },
     };
 }
 
@@ -265,6 +330,23 @@ SparseTensorMeta SparseTensorMeta::FromJson(json11::Json json)
     meta.SetInitializerByData(json["initializer_data"].string_value());
     meta.SetUpdaterByData(json["updater_data"].string_value());
     meta.SetPartitionCount(json["partition_count"].int_value());
+    // Meta files saved before ``hash_map_engine`` was introduced use the chained layout.
+    const std::string& engine = json["hash_map_engine"].string_value();
+    if (!engine.empty())
+        meta.SetHashMapEngine(HashMapEngineFromString(engine));
+    const std::string& backend = json["memory_buffer_backend"].string_value();
+    if (!backend.empty())
+        meta.SetMemoryBufferBackend(MemoryBufferBackendFromString(backend));
+    const std::string& codec = json["gradient_codec"].string_value();
+    if (!codec.empty())
+        meta.SetGradientCodec(GradientCodecFromString(codec));
+    const std::string& aggregation = json["gradient_aggregation"].string_value();
+    if (!aggregation.empty())
+        meta.SetGradientAggregation(GradientAggregationFromString(aggregation));
+    // Meta files saved before ``key_partitioner`` was introduced route keys by modulo.
+    const std::string& partitioner = json["key_partitioner"].string_value();
+    if (!partitioner.empty())
+        meta.SetKeyPartitioner(KeyPartitionerFromString(partitioner));
     meta.ComputeSliceInfo();
     return meta;
 }
@@ -292,7 +374,12 @@ bool SparseTensorMeta::operator==(const SparseTensorMeta& rhs) const
         && slice_state_shape_ == rhs.slice_state_shape_
         && GetInitializerAsData() == rhs.GetInitializerAsData()
         && GetUpdaterAsData() == rhs.GetUpdaterAsData()
-        && partition_count_ == rhs.partition_count_;
+        && partition_count_ == rhs.partition_count_
+        && hash_map_engine_ == rhs.hash_map_engine_
+        && memory_buffer_backend_ == rhs.memory_buffer_backend_
+        && gradient_codec_ == rhs.gradient_codec_
+        && gradient_aggregation_ == rhs.gradient_aggregation_
+        && key_partitioner_ == rhs.key_partitioner_;
 }
 
 }
@@ -23,6 +23,12 @@
 #include <any>
 #include <json11.hpp>
 #include <mindalpha/data_type.h>
+#include <mindalpha/gradient_codec.h>
+#include <mindalpha/gradient_aggregation.h>
+#include <mindalpha/key_partitioner.h>
+#include <mindalpha/hash_map_engine.h>
+#include <mindalpha/memory_buffer_backend.h>
+#include <mindalpha/native_updater.h>
 #include <mindalpha/smart_array.h>
 
 namespace mindalpha
@@ -59,15 +65,35 @@ public:
     void SetInitializer(SparseInitializer value) { initializer_ = std::move(value); }
 
     SparseUpdater GetUpdater() const { return updater_; }
-    void SetUpdater(SparseUpdater value) { updater_ = std::move(value); }
+    void SetUpdater(SparseUpdater value) { updater_ = std::move(value); native_updater_ = {}; }
+
+    // The native version of the updater set by ``SetUpdaterByData`` if any,
+    // which can be applied to chunks of a push concurrently.
+    std::shared_ptr<NativeUpdater> GetNativeUpdater() const { return native_updater_; }
 
     int GetPartitionCount() const { return partition_count_; }
     void SetPartitionCount(int value) { partition_count_ = value; }
 
+    HashMapEngine GetHashMapEngine() const { return hash_map_engine_; }
+    void SetHashMapEngine(HashMapEngine value) { hash_map_engine_ = value; }
+
+    MemoryBufferBackend GetMemoryBufferBackend() const { return memory_buffer_backend_; }
+    void SetMemoryBufferBackend(MemoryBufferBackend value) { memory_buffer_backend_ = value; }
+
+    GradientCodec GetGradientCodec() const { return gradient_codec_; }
+    void SetGradientCodec(GradientCodec value) { gradient_codec_ = value; }
+
+    GradientAggregation GetGradientAggregation() const { return gradient_aggregation_; }
+    void SetGradientAggregation(GradientAggregation value) { gradient_aggregation_ = value; }
+
+    KeyPartitioner GetKeyPartitioner() const { return key_partitioner_; }
+    void SetKeyPartitioner(KeyPartitioner value) { key_partitioner_ = value; }
+
     void CheckSparseTensorMeta(int index) const;
     void ComputeSliceInfo();
 
     size_t GetSliceDataLength() const { return slice_data_length_; }
+    size_t GetSliceStateOffset() const { return slice_state_offset_; }
     size_t GetSliceStateLength() const { return slice_state_length_; }
     size_t GetSliceAgeOffset() const { return slice_age_offset_; }
     size_t GetSliceTotalBytes() const { return slice_total_bytes_; }
@@ -99,10 +125,17 @@ private:
     std::vector<size_t> slice_state_shape_;
     SparseInitializer initializer_;
     SparseUpdater updater_;
+    std::shared_ptr<NativeUpdater> native_updater_;
     std::any initializer_object_;
     std::any updater_object_;
     int partition_count_ = -1;
+    HashMapEngine hash_map_engine_ = HashMapEngine::Chained;
+    MemoryBufferBackend memory_buffer_backend_ = MemoryBufferBackend::Malloc;
+    GradientCodec gradient_codec_ = GradientCodec::None;
+    GradientAggregation gradient_aggregation_ = GradientAggregation::None;
+    KeyPartitioner key_partitioner_ = KeyPartitioner::Modulo;
     size_t slice_data_length_ = size_t(-1);
+    size_t slice_state_offset_ = size_t(-1);
     size_t slice_state_length_ = size_t(-1);
     size_t slice_age_offset_ = size_t(-1);
     size_t slice_total_bytes_ = size_t(-1);
@@ -14,6 +14,7 @@
 // limitations under the License.
 //
 
+#include <algorithm>
 #include <stdexcept>
 #include <spdlog/spdlog.h>
 #include <math.h>
@@ -22,6 +23,7 @@
 #include <mindalpha/sparse_tensor_partition.h>
 #include <mindalpha/array_hash_map_reader.h>
 #include <mindalpha/array_hash_map_writer.h>
+#include <mindalpha/hashtable_helpers.h>
 #include <mindalpha/io.h>
 #include <mindalpha/debug.h>
 
@@ -38,120 +40,192 @@ void SparseTensorPartition::AllocateHashMap()
 void SparseTensorPartition::Clear()
 {
     const size_t slice_bytes = GetMeta().GetSliceTotalBytes();
-    ArrayHashMap<uint64_t, uint8_t> map(slice_bytes);
+    SparseTensorHashMap map(slice_bytes, GetMeta().GetHashMapEngine(), GetMeta().GetMemoryBufferBackend());
     data_.Swap(map);
 }
 
 void SparseTensorPartition::HandlePush(SmartArray<uint8_t> keys, SmartArray<uint8_t> in, bool is_value)
 {
-    TransformIndices(keys, false, false);
-    const size_t index_count = keys.size() / sizeof(uint64_t);
-    const uint64_t* const indices = reinterpret_cast<uint64_t*>(keys.data());
+    SmartArray<uint8_t> index_array = TransformIndices(keys, false, false);
+    const size_t index_count = index_array.size() / sizeof(uint64_t);
+    const uint64_t* const indices = reinterpret_cast<uint64_t*>(index_array.data());
+    // Chunks of the request are applied concurrently only when they write
+    // to disjoint slices. Workers may push duplicate keys, e.g. without
+    // gradient aggregation; those requests are applied serially so that
+    // duplicates take effect in request order.
+    const bool unique = !HasDuplicateIndices(indices, index_count);
+    auto for_each_chunk = [this, unique, index_count](const ParallelForPool::Body& body)
+    {
+        if (unique)
+            ForEachChunk(index_count, body);
+        else if (index_count > 0)
+            body(0, index_count);
+    };
     uint8_t* const param_data = const_cast<uint8_t*>(data_.GetValuesArray());
     const size_t param_size = GetMeta().GetSliceTotalBytes() * data_.size();
-    SparseUpdater updater = GetMeta().GetUpdater();
-    if (!updater || is_value)
+    auto reset_age = [this, indices, param_data](size_t begin, size_t end)
     {
-        uint8_t* const target_blob = param_data;
-        const uint8_t* source = in.data();
-        for (size_t i = 0; i < index_count; i++)
+        for (size_t i = begin; i < end; i++)
         {
-            const uint64_t index = indices[i];
-            uint8_t* const target = target_blob + GetMeta().GetSliceTotalBytes() * index;
-            memcpy(target, source, GetMeta().GetSliceDataLength());
-            source += GetMeta().GetSliceDataLength();
+            uint8_t* const target = param_data + GetMeta().GetSliceTotalBytes() * indices[i];
             int& age = *reinterpret_cast<int*>(target + GetMeta().GetSliceAgeOffset());
             age = 0;
         }
+    };
+    SparseUpdater updater = GetMeta().GetUpdater();
+    if (!updater || is_value)
+    {
+        for_each_chunk([&](size_t begin, size_t end)
+        {
+            const uint8_t* source = in.data() + GetMeta().GetSliceDataLength() * begin;
+            for (size_t i = begin; i < end; i++)
+            {
+                uint8_t* const target = param_data + GetMeta().GetSliceTotalBytes() * indices[i];
+                memcpy(target, source, GetMeta().GetSliceDataLength());
+                source += GetMeta().GetSliceDataLength();
+            }
+            reset_age(begin, end);
+        });
+        return;
     }
-    else
+    auto param = SmartArray<uint8_t>::Ref(param_data, param_size);
+    std::shared_ptr<NativeUpdater> native = GetMeta().GetNativeUpdater();
+    if (native && native->IsSupported(GetMeta()))
     {
-        uint8_t* const all_keys_data = reinterpret_cast<uint8_t*>(const_cast<uint64_t*>(data_.GetKeysArray()));
-        const size_t all_keys_size = sizeof(uint64_t) * data_.size();
-        auto all_keys = SmartArray<uint8_t>::Ref(all_keys_data, all_keys_size);
-        auto param = SmartArray<uint8_t>::Ref(param_data, param_size);
-        updater(GetMeta().GetName(), param, in, keys, all_keys, GetMeta());
-        uint8_t* const target_blob = param_data;
-        for (size_t i = 0; i < index_count; i++)
+        // Native updaters update slices independently, so chunks of unique
+        // indices can be applied in parallel.
+        for_each_chunk([&](size_t begin, size_t end)
         {
-            const uint64_t index = indices[i];
-            uint8_t* const target = target_blob + GetMeta().GetSliceTotalBytes() * index;
-            int& age = *reinterpret_cast<int*>(target + GetMeta().GetSliceAgeOffset());
-            age = 0;
-        }
+            const size_t grad_length = GetMeta().GetSliceDataLength();
+            auto grad = SmartArray<uint8_t>::Ref(in.data() + grad_length * begin, grad_length * (end - begin));
+            auto chunk = SmartArray<uint8_t>::Ref(index_array.data() + sizeof(uint64_t) * begin, sizeof(uint64_t) * (end - begin));
+            native->UpdateSparse(param, grad, chunk, GetMeta());
+            reset_age(begin, end);
+        });
+        return;
     }
+    uint8_t* const all_keys_data = reinterpret_cast<uint8_t*>(const_cast<uint64_t*>(data_.GetKeysArray()));
+    const size_t all_keys_size = sizeof(uint64_t) * data_.size();
+    auto all_keys = SmartArray<uint8_t>::Ref(all_keys_data, all_keys_size);
+    updater(GetMeta().GetName(), param, in, index_array, all_keys, GetMeta());
+    for_each_chunk(reset_age);
 }
 
 SmartArray<uint8_t> SparseTensorPartition::HandlePull(SmartArray<uint8_t> keys, bool read_only, bool nan_fill)
 {
-    TransformIndices(keys, true, read_only);
-    const size_t index_count = keys.size() / sizeof(uint64_t);
-    const uint64_t* const indices = reinterpret_cast<uint64_t*>(keys.data());
+    SmartArray<uint8_t> index_array = TransformIndices(keys, true, read_only);
+    const size_t index_count = index_array.size() / sizeof(uint64_t);
+    const uint64_t* const indices = reinterpret_cast<uint64_t*>(index_array.data());
     SmartArray<uint8_t> out(GetMeta().GetSliceDataLength() * index_count);
-    uint8_t* target = out.data();
     const uint8_t* const source_blob = data_.GetValuesArray();
-    for (size_t i = 0; i < index_count; i++)
+    ForEachChunk(index_count, [&](size_t begin, size_t end)
     {
-        const uint64_t index = indices[i];
-        const uint8_t* const source = source_blob + GetMeta().GetSliceTotalBytes() * index;
-        if (index == kNotFoundIndex && nan_fill)
-            FillNaN(target, GetMeta().GetSliceDataLength(), GetMeta().GetDataType());
-        else if (index == kNotFoundIndex || index == kPaddingIndex)
-            memset(target, 0, GetMeta().GetSliceDataLength());
-        else
-            memcpy(target, source, GetMeta().GetSliceDataLength());
-        target += GetMeta().GetSliceDataLength();
-    }
+        uint8_t* target = out.data() + GetMeta().GetSliceDataLength() * begin;
+        for (size_t i = begin; i < end; i++)
+        {
+            const uint64_t index = indices[i];
+            const uint8_t* const source = source_blob + GetMeta().GetSliceTotalBytes() * index;
+            if (index == kNotFoundIndex && nan_fill)
+                FillNaN(target, GetMeta().GetSliceDataLength(), GetMeta().GetDataType());
+            else if (index == kNotFoundIndex || index == kPaddingIndex)
+                memset(target, 0, GetMeta().GetSliceDataLength());
+            else
+                memcpy(target, source, GetMeta().GetSliceDataLength());
+            target += GetMeta().GetSliceDataLength();
+        }
+    });
     return std::move(out);
 }
 
-void SparseTensorPartition::TransformIndices(SmartArray<uint8_t> keys, bool pull, bool read_only)
+SmartArray<uint8_t> SparseTensorPartition::TransformIndices(SmartArray<uint8_t> keys, bool pull, bool read_only)
 {
+    // The request keys are left untouched, they may be shared with the
+    // sender when the transport passes slices by reference.
     const size_t index_count = keys.size() / sizeof(uint64_t);
-    uint64_t* const indices = reinterpret_cast<uint64_t*>(keys.data());
-    if (read_only)
-    {
-        for (size_t i = 0; i < index_count; i++)
-            if (indices[i] == kPaddingKey)
-                indices[i] = kPaddingIndex;
-            else
-                indices[i] = data_.Find(indices[i]);
-    }
-    else
+    const uint64_t* const key_data = reinterpret_cast<const uint64_t*>(keys.data());
+    SmartArray<uint8_t> index_array(sizeof(uint64_t) * index_count);
+    uint64_t* const indices = reinterpret_cast<uint64_t*>(index_array.data());
+    // Existing keys are looked up first, concurrently for large requests.
+    // The positions of missing keys are collected per chunk and inserted
+    // afterwards in request order, so the map never grows while being read
+    // and its layout is the same as if the keys were inserted one by one.
+    const size_t chunk_count = (index_count + kParallelChunkSize - 1) / kParallelChunkSize;
+    std::vector<std::vector<size_t>> missing(read_only ? 0 : chunk_count);
+    ForEachChunk(index_count, [&](size_t begin, size_t end)
     {
-        const size_t old_size = data_.size();
-        if (pull)
+        int64_t found[kLookupBatchSize];
+        std::vector<size_t>* const chunk_missing = read_only ? nullptr : &missing.at(begin / kParallelChunkSize);
+        for (size_t i = begin; i < end; i += kLookupBatchSize)
         {
-            for (size_t i = 0; i < index_count; i++)
-                if (indices[i] == kPaddingKey)
-                    indices[i] = kPaddingIndex;
+            const size_t n = std::min(kLookupBatchSize, end - i);
+            data_.FindBatch(key_data + i, n, found);
+            for (size_t j = 0; j < n; j++)
+                if (pull && key_data[i + j] == kPaddingKey)
+                    indices[i + j] = kPaddingIndex;
+                else if (found[j] != -1 || read_only)
+                    indices[i + j] = found[j];
                 else
-                    indices[i] = data_.FindOrInit(indices[i]);
+                    chunk_missing->push_back(i + j);
         }
+    });
+    if (read_only)
+        return index_array;
+    const size_t old_size = data_.size();
+    for (const std::vector<size_t>& chunk_missing : missing)
+        for (size_t i : chunk_missing)
+            indices[i] = data_.FindOrInit(key_data[i]);
+    if (data_.size() != old_size)
+    {
+        uint8_t* const values = const_cast<uint8_t*>(data_.GetValuesArray());
+        uint8_t* const blob_data = values + GetMeta().GetSliceTotalBytes() * old_size;
+        const size_t blob_size = GetMeta().GetSliceTotalBytes() * (data_.size() - old_size);
+        SparseInitializer initializer = GetMeta().GetInitializer();
+        if (!initializer)
+            memset(blob_data, 0, blob_size);
         else
         {
-            for (size_t i = 0; i < index_count; i++)
-                indices[i] = data_.FindOrInit(indices[i]);
+            uint8_t* const all_keys = reinterpret_cast<uint8_t*>(const_cast<uint64_t*>(data_.GetKeysArray()));
+            uint8_t* const blob_keys_data = all_keys + sizeof(uint64_t) * old_size;
+            const size_t blob_keys_size = sizeof(uint64_t) * (data_.size() - old_size);
+            auto blob = SmartArray<uint8_t>::Ref(blob_data, blob_size);
+            auto blob_keys = SmartArray<uint8_t>::Ref(blob_keys_data, blob_keys_size);
+            initializer(GetMeta().GetName(), blob, blob_keys, GetMeta());
         }
-        if (data_.size() != old_size)
+    }
+    return index_array;
+}
+
+bool SparseTensorPartition::HasDuplicateIndices(const uint64_t* indices, size_t count) const
+{
+    // Small requests are applied serially anyway.
+    if (!parallel_pool_ || count <= kParallelChunkSize)
+        return false;
+    // An open addressing set sized to the request, not to the partition;
+    // push indices are slice positions, which are never ``kEmptySlot``.
+    constexpr uint64_t kEmptySlot = uint64_t(-1);
+    const uint64_t mask = HashtableHelpers::GetPowerBucketCount(count * 2) - 1;
+    std::vector<uint64_t> slots(mask + 1, kEmptySlot);
+    for (size_t i = 0; i < count; i++)
+    {
+        const uint64_t index = indices[i];
+        uint64_t slot = HashtableHelpers::MixHash(index) & mask;
+        while (slots[slot] != kEmptySlot)
         {
-            uint8_t* const values = const_cast<uint8_t*>(data_.GetValuesArray());
-            uint8_t* const blob_data = values + GetMeta().GetSliceTotalBytes() * old_size;
-            const size_t blob_size = GetMeta().GetSliceTotalBytes() * (data_.size() - old_size);
-            SparseInitializer initializer = GetMeta().GetInitializer();
-            if (!initializer)
-                memset(blob_data, 0, blob_size);
-            else
-            {
-                uint8_t* const all_keys = reinterpret_cast<uint8_t*>(const_cast<uint64_t*>(data_.GetKeysArray()));
-                uint8_t* const blob_keys_data = all_keys + sizeof(uint64_t) * old_size;
-                const size_t blob_keys_size = sizeof(uint64_t) * (data_.size() - old_size);
-                auto blob = SmartArray<uint8_t>::Ref(blob_data, blob_size);
-                auto blob_keys = SmartArray<uint8_t>::Ref(blob_keys_data, blob_keys_size);
-                initializer(GetMeta().GetName(), blob, blob_keys, GetMeta());
-            }
+            if (slots[slot] == index)
+                return true;
+            slot = (slot + 1) & mask;
         }
+        slots[slot] = index;
     }
+    return false;
+}
+
+void SparseTensorPartition::ForEachChunk(size_t count, const ParallelForPool::Body& body)
+{
+    if (parallel_pool_ && count > kParallelChunkSize)
+        parallel_pool_->Run(count, kParallelChunkSize, body);
+    else if (count > 0)
+        body(0, count);
 }
 
 void SparseTensorPartition::HandlePushPartition(SmartArray<uint8_t> keys, SmartArray<uint8_t> in, bool data_only, bool skip_existing)
@@ -160,24 +234,37 @@ void SparseTensorPartition::HandlePushPartition(SmartArray<uint8_t> keys, SmartA
     const size_t index_count = keys.size() / sizeof(uint64_t);
     const uint64_t* const indices = reinterpret_cast<uint64_t*>(keys.data());
     const uint8_t* source = in.data();
-    for (size_t i = 0; i < index_count; i++)
+    int64_t found[kLookupBatchSize];
+    for (size_t i = 0; i < index_count; i += kLookupBatchSize)
     {
-        const uint64_t key = indices[i];
-        bool is_new;
-        uint8_t* target = data_.GetOrInit(key, is_new);
-        if (is_new || !skip_existing)
+        const size_t n = std::min(kLookupBatchSize, index_count - i);
+        data_.FindBatch(indices + i, n, found);
+        for (size_t j = 0; j < n; j++)
         {
-            memcpy(target, source, vec_length);
-            if (data_only)
+            const uint64_t key = indices[i + j];
+            bool is_new = false;
+            uint8_t* target;
+            if (found[j] != -1)
             {
-                // When only the data part of the embedding vector is imported,
-                // we set the rest of the embedding vector (state part and age)
-                // to zeros. We do this to make it consistent with the behavior
-                // of initializers.
-                memset(target + GetMeta().GetSliceDataLength(), 0, GetMeta().GetSliceTotalBytes() - GetMeta().GetSliceDataLength());
+                uint8_t* const values = const_cast<uint8_t*>(data_.GetValuesArray());
+                target = values + GetMeta().GetSliceTotalBytes() * found[j];
             }
+            else
+                target = data_.GetOrInit(key, is_new);
+            if (is_new || !skip_existing)
+            {
+                memcpy(target, source, vec_length);
+                if (data_only)
+                {
+                    // When only the data part of the embedding vector is imported,
+                    // we set the rest of the embedding vector (state part and age)
+                    // to zeros. We do this to make it consistent with the behavior
+                    // of initializers.
+                    memset(target + GetMeta().GetSliceDataLength(), 0, GetMeta().GetSliceTotalBytes() - GetMeta().GetSliceDataLength());
+                }
+            }
+            source += vec_length;
         }
-        source += vec_length;
     }
 }
 
@@ -230,9 +317,33 @@ const SparseTensorMeta& SparseTensorPartition::HandlePullMeta()
     return meta_;
 }
 
-void SparseTensorPartition::Load(const std::string& dir_path)
+void SparseTensorPartition::Load(const std::string& dir_path, int old_partition_count)
 {
     std::string path = GetSparsePath(dir_path);
+    if (old_partition_count == -1 || old_partition_count == GetMeta().GetPartitionCount())
+    {
+        ReadPartitionFile(path, data_);
+        return;
+    }
+    if (GetPartitionIndex() >= old_partition_count)
+        return;
+    const size_t slice_bytes = GetMeta().GetSliceTotalBytes();
+    SparseTensorHashMap map(slice_bytes, GetMeta().GetHashMapEngine(), GetMeta().GetMemoryBufferBackend());
+    ReadPartitionFile(path, map);
+    const KeyRouter router(GetMeta().GetKeyPartitioner(), GetMeta().GetPartitionCount());
+    const size_t key_count = map.size();
+    const uint64_t* const keys = map.GetKeysArray();
+    const uint8_t* const values = map.GetValuesArray();
+    std::vector<uint32_t> parts(key_count);
+    router.Route(keys, key_count, parts.data());
+    const uint32_t index = static_cast<uint32_t>(GetPartitionIndex());
+    for (size_t i = 0; i < key_count; i++)
+        if (parts[i] == index)
+            memcpy(data_.GetOrInit(keys[i]), values + slice_bytes * i, slice_bytes);
+}
+
+void SparseTensorPartition::ReadPartitionFile(const std::string& path, SparseTensorHashMap& data)
+{
     auto stream = Stream::Create(path.c_str(), "r", true);
     if (!stream)
     {
@@ -249,12 +360,12 @@ void SparseTensorPartition::Load(const std::string& dir_path)
         throw std::runtime_error(serr);
     }
     std::unique_ptr<Stream> stream_guard(stream);
-    ArrayHashMapReader reader(GetMeta(), data_, stream, false, false, "", path);
+    ArrayHashMapReader reader(GetMeta(), data, stream, false, false, "", path);
     MapFileHeader header;
     if (reader.DetectBinaryMode(header))
     {
         uint64_t offset = sizeof(header);
-        data_.DeserializeWithHeader(path, [stream, &offset](void* ptr, size_t size, const std::string& hint, const std::string& what) {
+        data.DeserializeWithHeader(path, [stream, &offset](void* ptr, size_t size, const std::string& hint, const std::string& what) {
             const size_t nread = stream->Read(ptr, size);
             if (nread != size)
             {
@@ -363,7 +474,7 @@ void SparseTensorPartition::DoPruneSmall(double epsilon)
     data_.Prune([epsilon, m, this](uint64_t i, int64_t key, const uint8_t* values, uint64_t value_count) {
         const T* const param = reinterpret_cast<const T*>(values);
         for (uint64_t k = 0; k < m; k++)
-            if (fabs(param[k]) > epsilon)
+            if (fabs(static_cast<double>(param[k])) > epsilon)
                 return false;
         return true;
     });
@@ -371,12 +482,12 @@ void SparseTensorPartition::DoPruneSmall(double epsilon)
 
 void SparseTensorPartition::PruneSmall(double epsilon)
 {
-    if (GetMeta().GetDataType() != DataType::Float32 &&
-        GetMeta().GetDataType() != DataType::Float64)
+    const DataType type = GetMeta().GetDataType();
+    if (type != DataType::Float32 && type != DataType::Float64 && !IsHalfDataType(type))
     {
         std::string serr;
         serr.append("SparseTensorPartition::PruneSmall only supports ");
-        serr.append("sparse tensors of 'float32' and 'float64'; ");
+        serr.append("sparse tensors of floating point types; ");
         serr.append("the data type of sparse tensor '");
         serr.append(GetMeta().GetName());
         serr.append("' is '");
@@ -386,10 +497,21 @@ void SparseTensorPartition::PruneSmall(double epsilon)
         spdlog::error(serr);
         throw std::runtime_error(serr);
     }
-    if (GetMeta().GetDataType() == DataType::Float32)
+    switch (type)
+    {
+    case DataType::Float32:
         DoPruneSmall<float>(epsilon);
-    else
+        break;
+    case DataType::Float16:
+        DoPruneSmall<float16>(epsilon);
+        break;
+    case DataType::BFloat16:
+        DoPruneSmall<bfloat16>(epsilon);
+        break;
+    default:
         DoPruneSmall<double>(epsilon);
+        break;
+    }
 }
 
 void SparseTensorPartition::PruneOld(int max_age)
@@ -16,8 +16,10 @@
 
 #pragma once
 
+#include <memory>
 #include <mindalpha/sparse_tensor_meta.h>
 #include <mindalpha/array_hash_map.h>
+#include <mindalpha/parallel_for.h>
 
 namespace mindalpha
 {
@@ -32,6 +34,9 @@ public:
     int GetPartitionIndex() const { return partition_index_; }
     void SetPartitionIndex(int value) { partition_index_ = value; }
 
+    std::shared_ptr<ParallelForPool> GetParallelForPool() const { return parallel_pool_; }
+    void SetParallelForPool(std::shared_ptr<ParallelForPool> value) { parallel_pool_ = std::move(value); }
+
     void AllocateHashMap();
     void Clear();
     void HandlePush(SmartArray<uint8_t> keys, SmartArray<uint8_t> in, bool is_value);
@@ -40,7 +45,11 @@ public:
     SmartArray<uint8_t> HandlePullPartition(bool data_only, int index, int count, SmartArray<uint8_t>& keys);
     void HandlePushMeta(const SparseTensorMeta& meta);
     const SparseTensorMeta& HandlePullMeta();
-    void Load(const std::string& dir_path);
+    // When ``old_partition_count`` differs from the current partition
+    // count, only the keys of the saved partition with the same index that
+    // are still routed to this partition are loaded, and they are merged
+    // into the existing ones; workers push the other keys.
+    void Load(const std::string& dir_path, int old_partition_count = -1);
     void Save(const std::string& dir_path, bool text_mode);
     void Export(const std::string& dir_path);
     void PruneSmall(double epsilon);
@@ -50,16 +59,30 @@ private:
     template<typename T>
     void DoPruneSmall(double epsilon);
 
-    void TransformIndices(SmartArray<uint8_t> keys, bool pull, bool read_only);
+    void ReadPartitionFile(const std::string& path, SparseTensorHashMap& data);
+    // Map ``keys`` to the indices of their slices in ``data_``, inserting
+    // missing keys unless ``read_only``; ``keys`` itself is not modified.
+    SmartArray<uint8_t> TransformIndices(SmartArray<uint8_t> keys, bool pull, bool read_only);
+    // Whether ``indices`` of a push contain a slice more than once; only
+    // checked for requests large enough to be split into chunks.
+    bool HasDuplicateIndices(const uint64_t* indices, size_t count) const;
+    void ForEachChunk(size_t count, const ParallelForPool::Body& body);
     std::string GetSparsePath(const std::string& dir_path) const;
     std::string GetSparseExportPath(const std::string& dir_path) const;
 
     static constexpr uint64_t kPaddingKey = 0;
     static constexpr uint64_t kPaddingIndex = uint64_t(-2);
     static constexpr uint64_t kNotFoundIndex = uint64_t(-1);
+    // Number of keys looked up by one ``FindBatch`` call; the map prefetches
+    // them in smaller groups internally.
+    static constexpr size_t kLookupBatchSize = 256;
+    // Number of keys per chunk when large requests are processed by
+    // ``parallel_pool_``; smaller requests are processed serially.
+    static constexpr size_t kParallelChunkSize = 16384;
     SparseTensorMeta meta_;
     int partition_index_ = -1;
-    ArrayHashMap<uint64_t, uint8_t> data_;
+    SparseTensorHashMap data_;
+    std::shared_ptr<ParallelForPool> parallel_pool_;
 };
 
 }
@@ -0,0 +1,608 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <netdb.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <mindalpha/tcp_transport.h>
+#include <mindalpha/stack_trace_utils.h>
+
+namespace mindalpha
+{
+
+namespace
+{
+
+constexpr uint32_t FrameMagic = 0x4D415443;
+constexpr size_t ReceiveBufferSize = 256 * 1024;
+constexpr int MaxEpollEvents = 64;
+
+std::string FormatErrno(int error)
+{
+    return std::to_string(error) + " " + strerror(error);
+}
+
+void SetNoDelay(int fd)
+{
+    const int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+}
+
+TcpTransport::Peer::~Peer()
+{
+    if (fd != -1)
+        close(fd);
+}
+
+TcpTransport::TcpTransport(std::shared_ptr<ActorConfig> config)
+    : MessageTransport(std::move(config))
+{
+}
+
+TcpTransport::~TcpTransport()
+{
+    CloseSockets();
+}
+
+void TcpTransport::Start()
+{
+    if (epoll_fd_ != -1)
+        return;
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ == -1)
+    {
+        std::string serr;
+        serr.append("Fail to create epoll instance, errno: ");
+        serr.append(FormatErrno(errno));
+        serr.append(".\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+}
+
+void TcpTransport::Stop()
+{
+    CloseSockets();
+}
+
+void TcpTransport::CloseSockets()
+{
+    {
+        std::unique_lock<std::shared_mutex> lock(peers_mutex_);
+        peers_.clear();
+    }
+    for (auto&& it: connections_)
+        close(it.first);
+    connections_.clear();
+    ready_.clear();
+    if (listen_fd_ != -1)
+    {
+        close(listen_fd_);
+        listen_fd_ = -1;
+    }
+    if (epoll_fd_ != -1)
+    {
+        close(epoll_fd_);
+        epoll_fd_ = -1;
+    }
+}
+
+int TcpTransport::Bind(const NodeInfo& node, int maxRetry)
+{
+    // Mirror ``ZeroMQTransport``, which listens on all interfaces unless
+    // the node has a host name.
+    std::string hostName = node.GetHostName();
+    const bool useK8s = GetConfig()->UseKubernetes();
+    if (useK8s && node.GetRole() == NodeRole::Coordinator)
+        hostName.clear();
+    int port = node.GetPort();
+    unsigned seed = static_cast<unsigned>(time(nullptr) + port);
+    for (int i = 0; i <= maxRetry; i++)
+    {
+        struct addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = AI_PASSIVE;
+        struct addrinfo* result = nullptr;
+        const std::string service = std::to_string(port);
+        const char* const host = hostName.empty() ? nullptr : hostName.c_str();
+        if (getaddrinfo(host, service.c_str(), &hints, &result) == 0)
+        {
+            for (struct addrinfo* ai = result; ai != nullptr; ai = ai->ai_next)
+            {
+                const int fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+                if (fd == -1)
+                    continue;
+                if (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && listen(fd, SOMAXCONN) == 0)
+                {
+                    listen_fd_ = fd;
+                    break;
+                }
+                close(fd);
+            }
+            freeaddrinfo(result);
+        }
+        if (listen_fd_ != -1)
+            break;
+        if (i == maxRetry)
+            port = -1;
+        else
+            port = 10000 + rand_r(&seed) % 40000;
+    }
+    if (port == -1)
+    {
+        std::string serr;
+        serr.append("Fail to bind after retried ");
+        serr.append(std::to_string(maxRetry));
+        serr.append(" times.\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = listen_fd_;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &event) == -1)
+    {
+        std::string serr;
+        serr.append("Fail to watch the listening socket, errno: ");
+        serr.append(FormatErrno(errno));
+        serr.append(".\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    return port;
+}
+
+void TcpTransport::Connect(const NodeInfo& node)
+{
+    if (node.GetNodeId() == -1)
+    {
+        std::string serr = "Node id must not be -1.\n\n";
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    if (node.GetPort() == -1)
+    {
+        std::string serr = "Port must not be -1.\n\n";
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    if (node.GetHostName().empty())
+    {
+        std::string serr = "Host name must not be empty.\n\n";
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    const int nodeId = node.GetNodeId();
+    std::unique_lock<std::shared_mutex> lock(peers_mutex_);
+    peers_.erase(nodeId);
+    const NodeInfo& thisNode = GetConfig()->GetThisNodeInfo();
+    // Worker doesn't connect to other workers and
+    // server doesn't connect to other servers.
+    if (node.GetRole() == thisNode.GetRole() &&
+        node.GetNodeId() != thisNode.GetNodeId())
+        return;
+    // The connection is opened by the first message, so the peer may
+    // still be starting up, as ZeroMQ allows.
+    auto peer = std::make_shared<Peer>();
+    peer->host_name = node.GetHostName();
+    peer->port = node.GetPort();
+    peer->identity = thisNode.GetNodeId();
+    peers_[nodeId] = std::move(peer);
+}
+
+int TcpTransport::TryConnect(const Peer& peer, int& error)
+{
+    const std::string service = std::to_string(peer.port);
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* result = nullptr;
+    if (getaddrinfo(peer.host_name.c_str(), service.c_str(), &hints, &result) != 0)
+        return -1;
+    int fd = -1;
+    for (struct addrinfo* ai = result; ai != nullptr; ai = ai->ai_next)
+    {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, 0);
+        if (fd == -1)
+        {
+            error = errno;
+            continue;
+        }
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0)
+        {
+            SetNoDelay(fd);
+            break;
+        }
+        error = errno;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+    return fd;
+}
+
+void TcpTransport::OpenConnection(Peer& peer, int nodeId)
+{
+    // Connecting is retried without holding any lock, so sends to other
+    // peers and ``Connect`` are not held up by a peer that is not
+    // listening yet; the send fails once the send timeout has passed.
+    const int timeout = GetConfig()->GetSendTimeout();
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+    int error = 0;
+    for (int attempt = 1; ; attempt++)
+    {
+        const int fd = TryConnect(peer, error);
+        if (fd != -1)
+        {
+            std::lock_guard<std::mutex> peer_lock(peer.mutex);
+            if (peer.fd == -1)
+                peer.fd = fd;
+            else
+                close(fd);
+            return;
+        }
+        if (std::chrono::steady_clock::now() >= deadline)
+            break;
+        if (attempt % 100 == 0)
+            spdlog::warn("{}: Fail to connect to {}:{} after {} attempts, errno: {}",
+                         GetConfig()->GetThisNodeInfo().ToShortString(),
+                         peer.host_name, peer.port, attempt, FormatErrno(error));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    std::string serr = fmt::format("{}: Fail to connect to node {} at {}:{} in {} ms, errno: {}.\n\n{}",
+                                   GetConfig()->GetThisNodeInfo().ToShortString(),
+                                   NodeIdToString(nodeId), peer.host_name, peer.port,
+                                   timeout, FormatErrno(error), GetStackTrace());
+    spdlog::error(serr);
+    throw std::runtime_error(serr);
+}
+
+int64_t TcpTransport::SendMessage(const Message& msg)
+{
+    const int nodeId = msg.GetMessageMeta().GetReceiver();
+    if (nodeId == -1)
+    {
+        std::string serr = "Receiver id must not be -1.\n\n";
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    std::shared_ptr<Peer> peer_ref;
+    {
+        std::shared_lock<std::shared_mutex> lock(peers_mutex_);
+        auto it = peers_.find(nodeId);
+        if (it != peers_.end())
+            peer_ref = it->second;
+    }
+    if (!peer_ref)
+    {
+        std::string serr;
+        serr.append("There is no connection to node ");
+        serr.append(NodeIdToString(nodeId));
+        serr.append(".\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    Peer& peer = *peer_ref;
+    const std::vector<SmartArray<uint8_t>>& slices = msg.GetSlices();
+    const SmartArray<uint8_t> meta = msg.GetMessageMeta().PackAsBuffer();
+    std::vector<uint64_t> sizes;
+    sizes.reserve(slices.size());
+    for (const SmartArray<uint8_t>& slice: slices)
+        sizes.push_back(slice.size());
+    FrameHeader header;
+    header.magic = FrameMagic;
+    header.meta_size = static_cast<uint32_t>(meta.size());
+    header.slice_count = static_cast<uint32_t>(slices.size());
+    std::vector<struct iovec> iovs;
+    iovs.reserve(slices.size() + 3);
+    iovs.push_back({ &header, sizeof(header) });
+    if (!sizes.empty())
+        iovs.push_back({ sizes.data(), sizes.size() * sizeof(uint64_t) });
+    if (meta.size())
+        iovs.push_back({ const_cast<uint8_t*>(meta.data()), meta.size() });
+    for (const SmartArray<uint8_t>& slice: slices)
+        if (slice.size())
+            iovs.push_back({ const_cast<uint8_t*>(slice.data()), slice.size() });
+    int64_t bytes = 0;
+    for (const struct iovec& iov: iovs)
+        bytes += iov.iov_len;
+
+    std::unique_lock<std::mutex> peer_lock(peer.mutex);
+    while (peer.fd == -1)
+    {
+        peer_lock.unlock();
+        OpenConnection(peer, nodeId);
+        peer_lock.lock();
+    }
+    header.sender = peer.identity;
+    size_t index = 0;
+    while (index < iovs.size())
+    {
+        struct msghdr mh;
+        memset(&mh, 0, sizeof(mh));
+        mh.msg_iov = &iovs[index];
+        mh.msg_iovlen = std::min<size_t>(iovs.size() - index, IOV_MAX);
+        const ssize_t n = sendmsg(peer.fd, &mh, MSG_NOSIGNAL);
+        if (n == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            const int error = errno;
+            close(peer.fd);
+            peer.fd = -1;
+            std::string serr = fmt::format("{}: Fail to send message to node {}, errno: {}.\n\n{}",
+                                           GetConfig()->GetThisNodeInfo().ToShortString(),
+                                           NodeIdToString(nodeId), FormatErrno(error), GetStackTrace());
+            spdlog::error(serr);
+            throw std::runtime_error(serr);
+        }
+        // Skip what has been written; a partial write leaves the rest of
+        // the current buffer for the next call.
+        size_t written = static_cast<size_t>(n);
+        while (index < iovs.size() && written >= iovs[index].iov_len)
+            written -= iovs[index++].iov_len;
+        if (written > 0)
+        {
+            iovs[index].iov_base = static_cast<uint8_t*>(iovs[index].iov_base) + written;
+            iovs[index].iov_len -= written;
+        }
+    }
+    return bytes;
+}
+
+void TcpTransport::AcceptConnections()
+{
+    for (;;)
+    {
+        const int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                spdlog::warn("{}: Fail to accept connection, errno: {}",
+                             GetConfig()->GetThisNodeInfo().ToShortString(), FormatErrno(errno));
+            return;
+        }
+        SetNoDelay(fd);
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) == -1)
+        {
+            spdlog::warn("{}: Fail to watch connection, errno: {}",
+                         GetConfig()->GetThisNodeInfo().ToShortString(), FormatErrno(errno));
+            close(fd);
+            continue;
+        }
+        auto conn = std::make_unique<Connection>();
+        conn->fd = fd;
+        conn->buffer.resize(ReceiveBufferSize);
+        connections_[fd] = std::move(conn);
+    }
+}
+
+bool TcpTransport::ReadConnection(Connection& conn)
+{
+    for (;;)
+    {
+        ParseFrames(conn);
+        // Make room in the buffer for the header or prefix being read.
+        size_t need = 0;
+        if (conn.stage == Connection::Stage::Header)
+            need = sizeof(FrameHeader);
+        else if (conn.stage == Connection::Stage::Prefix)
+            need = conn.prefix_size;
+        if (conn.begin == conn.end)
+            conn.begin = conn.end = 0;
+        else if (conn.end == conn.buffer.size() || conn.buffer.size() - conn.begin < need)
+        {
+            memmove(conn.buffer.data(), conn.buffer.data() + conn.begin, conn.end - conn.begin);
+            conn.end -= conn.begin;
+            conn.begin = 0;
+        }
+        if (conn.buffer.size() < need)
+            conn.buffer.resize(need);
+        struct iovec iovs[2];
+        int count = 0;
+        size_t direct = 0;
+        if (conn.stage == Connection::Stage::Slices)
+        {
+            direct = conn.slice.size() - conn.slice_filled;
+            iovs[count++] = { conn.slice.data() + conn.slice_filled, direct };
+        }
+        iovs[count++] = { conn.buffer.data() + conn.end, conn.buffer.size() - conn.end };
+        const ssize_t n = readv(conn.fd, iovs, count);
+        if (n == 0)
+            return false;
+        if (n == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return true;
+            spdlog::warn("{}: Fail to receive from connection, errno: {}",
+                         GetConfig()->GetThisNodeInfo().ToShortString(), FormatErrno(errno));
+            return false;
+        }
+        const size_t toSlice = std::min(static_cast<size_t>(n), direct);
+        conn.slice_filled += toSlice;
+        conn.end += n - toSlice;
+    }
+}
+
+void TcpTransport::ParseFrames(Connection& conn)
+{
+    for (;;)
+    {
+        const size_t available = conn.end - conn.begin;
+        const uint8_t* const ptr = conn.buffer.data() + conn.begin;
+        if (conn.stage == Connection::Stage::Header)
+        {
+            if (available < sizeof(FrameHeader))
+                return;
+            memcpy(&conn.header, ptr, sizeof(FrameHeader));
+            if (conn.header.magic != FrameMagic)
+            {
+                std::string serr;
+                serr.append("Corrupted message detected; invalid frame magic ");
+                serr.append(std::to_string(conn.header.magic));
+                serr.append(".\n\n");
+                serr.append(GetStackTrace());
+                spdlog::error(serr);
+                throw std::runtime_error(serr);
+            }
+            conn.begin += sizeof(FrameHeader);
+            conn.prefix_size = conn.header.slice_count * sizeof(uint64_t) + conn.header.meta_size;
+            conn.bytes = sizeof(FrameHeader) + conn.prefix_size;
+            conn.stage = Connection::Stage::Prefix;
+        }
+        else if (conn.stage == Connection::Stage::Prefix)
+        {
+            if (available < conn.prefix_size)
+                return;
+            conn.slice_sizes.resize(conn.header.slice_count);
+            memcpy(conn.slice_sizes.data(), ptr, conn.header.slice_count * sizeof(uint64_t));
+            const uint8_t* const meta = ptr + conn.header.slice_count * sizeof(uint64_t);
+            conn.message = Message();
+            conn.message.GetMessageMeta().UnpackFromBuffer(meta, conn.header.meta_size);
+            conn.message.GetMessageMeta().SetSender(conn.header.sender);
+            conn.message.GetMessageMeta().SetReceiver(GetConfig()->GetThisNodeInfo().GetNodeId());
+            conn.begin += conn.prefix_size;
+            conn.slice_index = 0;
+            if (conn.header.slice_count)
+            {
+                conn.slice = SmartArray<uint8_t>(conn.slice_sizes[0]);
+                conn.slice_filled = 0;
+            }
+            conn.stage = Connection::Stage::Slices;
+        }
+        else
+        {
+            while (conn.slice_index < conn.header.slice_count)
+            {
+                const size_t count = std::min(conn.end - conn.begin, conn.slice.size() - conn.slice_filled);
+                memcpy(conn.slice.data() + conn.slice_filled, conn.buffer.data() + conn.begin, count);
+                conn.begin += count;
+                conn.slice_filled += count;
+                if (conn.slice_filled < conn.slice.size())
+                    return;
+                conn.bytes += conn.slice.size();
+                conn.message.AddSlice(std::move(conn.slice));
+                conn.slice = SmartArray<uint8_t>();
+                if (++conn.slice_index < conn.header.slice_count)
+                {
+                    conn.slice = SmartArray<uint8_t>(conn.slice_sizes[conn.slice_index]);
+                    conn.slice_filled = 0;
+                }
+            }
+            Message& msg = conn.message;
+            if (msg.GetSlices().size() != msg.GetMessageMeta().GetSliceDataTypes().size())
+            {
+                std::string serr;
+                serr.append("Corrupted message detected; meta indicates ");
+                serr.append(std::to_string(msg.GetMessageMeta().GetSliceDataTypes().size()));
+                serr.append(" slice(s), but found ");
+                serr.append(std::to_string(msg.GetSlices().size()));
+                serr.append(" in the body.\n\n");
+                serr.append(GetStackTrace());
+                spdlog::error(serr);
+                throw std::runtime_error(serr);
+            }
+            ready_.emplace_back(std::move(msg), conn.bytes);
+            conn.message = Message();
+            conn.stage = Connection::Stage::Header;
+        }
+    }
+}
+
+int64_t TcpTransport::ReceiveMessage(Message& msg)
+{
+    while (ready_.empty())
+    {
+        struct epoll_event events[MaxEpollEvents];
+        const int n = epoll_wait(epoll_fd_, events, MaxEpollEvents, -1);
+        if (n == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            std::string serr;
+            serr.append("Fail to wait for messages, errno: ");
+            serr.append(FormatErrno(errno));
+            serr.append(".\n\n");
+            serr.append(GetStackTrace());
+            spdlog::error(serr);
+            throw std::runtime_error(serr);
+        }
+        for (int i = 0; i < n; i++)
+        {
+            const int fd = events[i].data.fd;
+            if (fd == listen_fd_)
+            {
+                AcceptConnections();
+                continue;
+            }
+            auto it = connections_.find(fd);
+            if (it == connections_.end())
+                continue;
+            // Level triggered, a connection not drained here is reported
+            // again by the next ``epoll_wait``.
+            if (!ReadConnection(*it->second))
+            {
+                epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+                close(fd);
+                connections_.erase(it);
+            }
+        }
+    }
+    msg = std::move(ready_.front().first);
+    const int64_t bytes = ready_.front().second;
+    ready_.pop_front();
+    return bytes;
+}
+
+}
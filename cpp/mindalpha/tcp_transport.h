@@ -0,0 +1,123 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#pragma once
+
+#include <stdint.h>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <mindalpha/message_transport.h>
+
+//
+// ``tcp_transport.h`` defines class ``TcpTransport`` which passes messages
+// over plain TCP connections, as an alternative to ``ZeroMQTransport``.
+//
+// Each node connects to a peer lazily on the first message, retrying for
+// up to the configured send timeout without holding any lock, and writes a
+// message as one frame with a single ``sendmsg`` call gathering the frame
+// header, the slice sizes, the packed meta and the slices, so nothing is
+// copied on the sending side.
+//
+// The receiving thread runs an ``epoll`` loop over the listening socket
+// and the accepted connections, which are non-blocking. Small parts of a
+// frame go through a per connection buffer; slices are allocated once
+// their sizes are known and the rest of their bytes is read directly into
+// them.
+//
+
+namespace mindalpha
+{
+
+class TcpTransport : public MessageTransport
+{
+public:
+    explicit TcpTransport(std::shared_ptr<ActorConfig> config);
+    ~TcpTransport();
+
+    void Start() override;
+    void Stop() override;
+    int Bind(const NodeInfo& node, int maxRetry) override;
+    void Connect(const NodeInfo& node) override;
+    int64_t SendMessage(const Message& msg) override;
+    int64_t ReceiveMessage(Message& msg) override;
+
+private:
+    struct FrameHeader
+    {
+        uint32_t magic;
+        int32_t sender;
+        uint32_t meta_size;
+        uint32_t slice_count;
+    };
+
+    // Sending side of the connection to a peer, which remembers the id
+    // this node had when it connected, like a ZeroMQ sender socket. Sends
+    // hold a reference, so the peer outlives ``Connect`` replacing it.
+    struct Peer
+    {
+        std::mutex mutex;
+        std::string host_name;
+        int port = -1;
+        int identity = -1;
+        int fd = -1;
+
+        ~Peer();
+    };
+
+    // Receiving side of an accepted connection.
+    struct Connection
+    {
+        enum class Stage { Header, Prefix, Slices };
+
+        int fd = -1;
+        std::vector<uint8_t> buffer;
+        size_t begin = 0;
+        size_t end = 0;
+        Stage stage = Stage::Header;
+        FrameHeader header;
+        size_t prefix_size = 0;
+        std::vector<uint64_t> slice_sizes;
+        Message message;
+        uint32_t slice_index = 0;
+        SmartArray<uint8_t> slice;
+        size_t slice_filled = 0;
+        int64_t bytes = 0;
+    };
+
+    int TryConnect(const Peer& peer, int& error);
+    void OpenConnection(Peer& peer, int nodeId);
+    void CloseSockets();
+    void AcceptConnections();
+    bool ReadConnection(Connection& conn);
+    void ParseFrames(Connection& conn);
+
+    int listen_fd_ = -1;
+    int epoll_fd_ = -1;
+    std::unordered_map<int, std::unique_ptr<Connection>> connections_;
+    std::deque<std::pair<Message, int64_t>> ready_;
+
+    std::shared_mutex peers_mutex_;
+    std::unordered_map<int, std::shared_ptr<Peer>> peers_;
+};
+
+}
@@ -0,0 +1,191 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <stdexcept>
+#include <unordered_map>
+#include <json11.hpp>
+#include <spdlog/spdlog.h>
+#include <mindalpha/tensor_batch.h>
+#include <mindalpha/stack_trace_utils.h>
+
+namespace mindalpha
+{
+
+void TensorBatch::AddDensePush(DenseTensor& tensor, SmartArray<uint8_t> in, std::function<void()> cb,
+                               bool is_value, bool is_state)
+{
+    Operation op;
+    op.requests = tensor.MakePushRequests(in, is_value, is_state);
+    op.complete = [cb](std::vector<PSMessage> ress) {
+        cb();
+    };
+    operations_.push_back(std::move(op));
+}
+
+void TensorBatch::AddDensePull(DenseTensor& tensor, std::function<void(SmartArray<uint8_t> out)> cb,
+                               bool is_state)
+{
+    Operation op;
+    op.requests = tensor.MakePullRequests(is_state);
+    op.complete = [&tensor, cb, is_state](std::vector<PSMessage> ress) {
+        SmartArray<uint8_t> out = tensor.CombinePullResponses(ress, is_state);
+        cb(out);
+    };
+    operations_.push_back(std::move(op));
+}
+
+void TensorBatch::AddSparsePush(SparseTensor& tensor, SmartArray<uint8_t> keys, SmartArray<uint8_t> in,
+                                std::function<void()> cb, bool is_value)
+{
+    Operation op;
+    op.requests = tensor.MakePushRequests(keys, in, is_value);
+    op.complete = [cb](std::vector<PSMessage> ress) {
+        cb();
+    };
+    operations_.push_back(std::move(op));
+}
+
+void TensorBatch::AddSparsePull(SparseTensor& tensor, SmartArray<uint8_t> keys,
+                                std::function<void(SmartArray<uint8_t> out)> cb,
+                                bool read_only, bool nan_fill)
+{
+    Operation op;
+    auto partition = std::make_shared<KeyPartition>(keys, *tensor.GetKeyRouter());
+    op.requests = tensor.MakePullRequests(*partition, read_only, nan_fill);
+    op.complete = [&tensor, partition, cb](std::vector<PSMessage> ress) {
+        SmartArray<uint8_t> out = tensor.CombinePullResponses(*partition, ress);
+        cb(out);
+    };
+    operations_.push_back(std::move(op));
+}
+
+void TensorBatch::Send(std::function<void()> cb)
+{
+    if (operations_.empty())
+    {
+        cb();
+        return;
+    }
+    auto operations = std::make_shared<std::vector<Operation>>(std::move(operations_));
+    operations_.clear();
+    // The request to a server concatenates the slices of the operations
+    // sending requests to it; the bodies of the operations are embedded as
+    // they are, so they are not parsed and dumped again here.
+    struct Group
+    {
+        PSMessage req;
+        std::string ops;
+        std::string slice_counts;
+        std::vector<size_t> indices;
+    };
+    std::vector<Group> groups;
+    std::unordered_map<int, size_t> group_map;
+    for (size_t i = 0; i < operations->size(); i++)
+    {
+        for (const PSMessage& op_req : operations->at(i).requests)
+        {
+            const int receiver = op_req->GetMessageMeta().GetReceiver();
+            auto it = group_map.find(receiver);
+            if (it == group_map.end())
+            {
+                it = group_map.emplace(receiver, groups.size()).first;
+                groups.emplace_back();
+                groups.back().req = std::make_shared<Message>();
+                groups.back().req->GetMessageMeta().SetReceiver(receiver);
+            }
+            Group& group = groups.at(it->second);
+            const std::vector<DataType>& types = op_req->GetMessageMeta().GetSliceDataTypes();
+            const std::vector<SmartArray<uint8_t>>& slices = op_req->GetSlices();
+            for (size_t j = 0; j < slices.size(); j++)
+                group.req->AddTypedSlice(slices.at(j), types.at(j));
+            if (!group.indices.empty())
+            {
+                group.ops.push_back(',');
+                group.slice_counts.push_back(',');
+            }
+            const DataRequest& request = op_req->GetMessageMeta().GetDataRequest();
+            if (request.IsEmpty())
+                group.ops.append(op_req->GetMessageMeta().GetBody());
+            else
+            {
+                group.ops.append("{\"data_request\":");
+                group.ops.append(request.ToJsonString());
+                group.ops.push_back('}');
+            }
+            group.slice_counts.append(std::to_string(slices.size()));
+            group.indices.push_back(i);
+        }
+    }
+    std::vector<PSMessage> reqs;
+    auto group_indices = std::make_shared<std::unordered_map<int, std::vector<size_t>>>();
+    reqs.reserve(groups.size());
+    for (Group& group : groups)
+    {
+        std::string body;
+        body.append("{\"command\":\"Batch\",\"slice_counts\":[");
+        body.append(group.slice_counts);
+        body.append("],\"ops\":[");
+        body.append(group.ops);
+        body.append("]}");
+        group.req->GetMessageMeta().SetBody(std::move(body));
+        const int receiver = group.req->GetMessageMeta().GetReceiver();
+        group_indices->emplace(receiver, std::move(group.indices));
+        reqs.push_back(group.req);
+    }
+    agent_->SendAllRequests(std::move(reqs), [operations, group_indices, cb](std::vector<PSMessage> reqs,
+                                                                             std::vector<PSMessage> ress) {
+        std::vector<std::vector<PSMessage>> op_ress(operations->size());
+        for (const PSMessage& res : ress)
+        {
+            const int sender = res->GetMessageMeta().GetSender();
+            const std::vector<size_t>& indices = group_indices->at(sender);
+            std::string err;
+            json11::Json json = json11::Json::parse(res->GetMessageMeta().GetBody(), err);
+            const json11::Json::array& slice_counts = json["slice_counts"].array_items();
+            if (!err.empty() || slice_counts.size() != indices.size())
+            {
+                std::string serr;
+                serr.append("Malformed batch response from node ");
+                serr.append(NodeIdToString(sender));
+                serr.append(", expect slice counts of ");
+                serr.append(std::to_string(indices.size()));
+                serr.append(" operations.\n\n");
+                serr.append(GetStackTrace());
+                spdlog::error(serr);
+                throw std::runtime_error(serr);
+            }
+            const std::vector<DataType>& types = res->GetMessageMeta().GetSliceDataTypes();
+            const std::vector<SmartArray<uint8_t>>& slices = res->GetSlices();
+            size_t offset = 0;
+            for (size_t i = 0; i < indices.size(); i++)
+            {
+                PSMessage op_res = std::make_shared<Message>();
+                op_res->GetMessageMeta().SetSender(sender);
+                const size_t count = slice_counts.at(i).int_value();
+                for (size_t j = offset; j < offset + count; j++)
+                    op_res->AddTypedSlice(slices.at(j), types.at(j));
+                offset += count;
+                op_ress.at(indices.at(i)).push_back(op_res);
+            }
+        }
+        for (size_t i = 0; i < operations->size(); i++)
+            operations->at(i).complete(std::move(op_ress.at(i)));
+        cb();
+    });
+}
+
+}
@@ -0,0 +1,76 @@
+//
+// Copyright 2021 Mobvista
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <functional>
+#include <mindalpha/ps_agent.h>
+#include <mindalpha/smart_array.h>
+#include <mindalpha/dense_tensor.h>
+#include <mindalpha/sparse_tensor.h>
+
+//
+// ``tensor_batch.h`` defines class ``TensorBatch`` which fuses the pulls
+// and pushes of several tensors into one ``Batch`` request per server.
+//
+// Operations are added with the ``Add*`` methods and sent together by
+// ``Send``. The callback of every operation is called before ``cb`` of
+// ``Send``; if any operation fails, none of the callbacks are called and
+// the error is reported as for the other asynchronous requests.
+//
+
+namespace mindalpha
+{
+
+class TensorBatch
+{
+public:
+    explicit TensorBatch(std::shared_ptr<PSAgent> agent) : agent_(std::move(agent)) { }
+
+    std::shared_ptr<PSAgent> GetAgent() const { return agent_; }
+
+    size_t GetOperationCount() const { return operations_.size(); }
+
+    void AddDensePush(DenseTensor& tensor, SmartArray<uint8_t> in, std::function<void()> cb,
+                      bool is_value = false, bool is_state = false);
+    void AddDensePull(DenseTensor& tensor, std::function<void(SmartArray<uint8_t> out)> cb,
+                      bool is_state = false);
+    void AddSparsePush(SparseTensor& tensor, SmartArray<uint8_t> keys, SmartArray<uint8_t> in,
+                       std::function<void()> cb, bool is_value = false);
+    void AddSparsePull(SparseTensor& tensor, SmartArray<uint8_t> keys,
+                       std::function<void(SmartArray<uint8_t> out)> cb,
+                       bool read_only = false, bool nan_fill = false);
+
+    // Sends the operations added so far and clears the batch.
+    void Send(std::function<void()> cb);
+
+private:
+    using Completion = std::function<void(std::vector<PSMessage> ress)>;
+
+    struct Operation
+    {
+        std::vector<PSMessage> requests;
+        Completion complete;
+    };
+
+    std::shared_ptr<PSAgent> agent_;
+    std::vector<Operation> operations_;
+};
+
+}
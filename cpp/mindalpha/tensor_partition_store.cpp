@@ -14,17 +14,49 @@
 // limitations under the License.
 //
 
+#include <algorithm>
 #include <stdexcept>
 #include <spdlog/spdlog.h>
 #include <mindalpha/stack_trace_utils.h>
 #include <mindalpha/tensor_partition_store.h>
 #include <mindalpha/io.h>
+#include <mindalpha/tensor_utils.h>
 
 namespace mindalpha
 {
 
-void TensorPartitionStore::DenseInit(const DenseTensorMeta& meta)
+namespace
 {
+
+// Gradients encoded by a ``GradientCodec`` arrive as ``UInt8`` slices and
+// are restored here, before the updater sees them.
+SmartArray<uint8_t> GetDensePushSlice(const DenseTensorPartition& part, PSMessage req, bool is_value, bool is_state)
+{
+    const DenseTensorMeta& meta = part.GetMeta();
+    const GradientCodec codec = meta.GetGradientCodec();
+    if (is_value || is_state || codec == GradientCodec::None)
+        return req->GetTypedSlice(0, meta.GetDataType());
+    SmartArray<uint8_t> in = req->GetTypedSlice(0, DataType::UInt8);
+    const size_t item_count = TotalElements(part.GetPartitionDataShape());
+    return DecodeGradient(codec, meta.GetDataType(), in, item_count, DenseGradientRowItems);
+}
+
+SmartArray<uint8_t> GetSparsePushSlice(const SparseTensorPartition& part, PSMessage req, size_t key_count, bool is_value)
+{
+    const SparseTensorMeta& meta = part.GetMeta();
+    const GradientCodec codec = meta.GetGradientCodec();
+    if (is_value || codec == GradientCodec::None)
+        return req->GetTypedSlice(1, meta.GetDataType());
+    SmartArray<uint8_t> in = req->GetTypedSlice(1, DataType::UInt8);
+    const size_t row_items = meta.GetSliceDataLength() / DataTypeToSize(meta.GetDataType());
+    return DecodeGradient(codec, meta.GetDataType(), in, key_count * row_items, row_items);
+}
+
+}
+
+int TensorPartitionStore::DenseInit(const DenseTensorMeta& meta)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
     if (sparse_store_.count(meta.GetName()))
     {
         std::string serr;
@@ -42,6 +74,8 @@ void TensorPartitionStore::DenseInit(const DenseTensorMeta& meta)
         part.SetMeta(meta);
         part.SetPartitionIndex(partition_index_);
         part.AllocateDataBlock(true);
+        dense_ids_.push_back(&part);
+        return static_cast<int>(dense_ids_.size()) - 1;
     }
     else
     {
@@ -60,11 +94,14 @@ void TensorPartitionStore::DenseInit(const DenseTensorMeta& meta)
             spdlog::error(serr);
             throw std::runtime_error(serr);
         }
+        auto id = std::find(dense_ids_.begin(), dense_ids_.end(), &it->second);
+        return static_cast<int>(id - dense_ids_.begin());
     }
 }
 
 void TensorPartitionStore::DenseDispose(const std::string& name)
 {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
     auto it = dense_store_.find(name);
     if (it == dense_store_.end())
     {
@@ -76,11 +113,13 @@ void TensorPartitionStore::DenseDispose(const std::string& name)
         spdlog::error(serr);
         throw std::runtime_error(serr);
     }
+    std::replace(dense_ids_.begin(), dense_ids_.end(), &it->second, static_cast<DenseTensorPartition*>(nullptr));
     dense_store_.erase(it);
 }
 
 void TensorPartitionStore::DensePush(const std::string& name, PSMessage req, bool is_value, bool is_state)
 {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
     auto it = dense_store_.find(name);
     if (it == dense_store_.end())
     {
@@ -93,12 +132,13 @@ void TensorPartitionStore::DensePush(const std::string& name, PSMessage req, boo
         throw std::runtime_error(serr);
     }
     DenseTensorPartition& part = it->second;
-    SmartArray<uint8_t> in = req->GetTypedSlice(0, part.GetMeta().GetDataType());
+    SmartArray<uint8_t> in = GetDensePushSlice(part, req, is_value, is_state);
     part.HandlePush(in, is_value, is_state);
 }
 
 PSMessage TensorPartitionStore::DensePull(const std::string& name, bool is_state)
 {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
     auto it = dense_store_.find(name);
     if (it == dense_store_.end())
     {
@@ -119,6 +159,7 @@ PSMessage TensorPartitionStore::DensePull(const std::string& name, bool is_state
 
 void TensorPartitionStore::DensePushMeta(const std::string& name, const DenseTensorMeta& meta)
 {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
     auto it = dense_store_.find(name);
     if (it == dense_store_.end())
     {
@@ -136,6 +177,7 @@ void TensorPartitionStore::DensePushMeta(const std::string& name, const DenseTen
 
 PSMessage TensorPartitionStore::DensePullMeta(const std::string& name)
 {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
     auto it = dense_store_.find(name);
     if (it == dense_store_.end())
     {
@@ -154,8 +196,9 @@ PSMessage TensorPartitionStore::DensePullMeta(const std::string& name)
     return res;
 }
 
-void TensorPartitionStore::SparseInit(const SparseTensorMeta& meta)
+int TensorPartitionStore::SparseInit(const SparseTensorMeta& meta)
 {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
     if (dense_store_.count(meta.GetName()))
     {
         std::string serr;
@@ -172,7 +215,10 @@ void TensorPartitionStore::SparseInit(const SparseTensorMeta& meta)
         SparseTensorPartition& part = sparse_store_[meta.GetName()];
         part.SetMeta(meta);
         part.SetPartitionIndex(partition_index_);
+        part.SetParallelForPool(parallel_pool_);
         part.AllocateHashMap();
+        sparse_ids_.push_back(&part);
+        return static_cast<int>(sparse_ids_.size()) - 1;
     }
     else
     {
@@ -191,11 +237,14 @@ void TensorPartitionStore::SparseInit(const SparseTensorMeta& meta)
             spdlog::error(serr);
             throw std::runtime_error(serr);
         }
+        auto id = std::find(sparse_ids_.begin(), sparse_ids_.end(), &it->second);
+        return static_cast<int>(id - sparse_ids_.begin());
     }
 }
 
 void TensorPartitionStore::SparseDispose(const std::string& name)
 {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
     auto it = sparse_store_.find(name);
     if (it == sparse_store_.end())
     {
@@ -207,11 +256,13 @@ void TensorPartitionStore::SparseDispose(const std::string& name)
         spdlog::error(serr);
         throw std::runtime_error(serr);
     }
+    std::replace(sparse_ids_.begin(), sparse_ids_.end(), &it->second, static_cast<SparseTensorPartition*>(nullptr));
     sparse_store_.erase(it);
 }
 
 void TensorPartitionStore::SparseClear(const std::string& name)
 {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
     auto it = sparse_store_.find(name);
     if (it == sparse_store_.end())
     {
@@ -229,6 +280,7 @@ void TensorPartitionStore::SparseClear(const std::string& name)
 
 void TensorPartitionStore::SparsePush(const std::string& name, PSMessage req, bool is_value)
 {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
     auto it = sparse_store_.find(name);
     if (it == sparse_store_.end())
     {
@@ -242,12 +294,13 @@ void TensorPartitionStore::SparsePush(const std::string& name, PSMessage req, bo
     }
     SparseTensorPartition& part = it->second;
     SmartArray<uint8_t> keys = req->GetTypedSlice<uint64_t>(0).Cast<uint8_t>();
-    SmartArray<uint8_t> in = req->GetTypedSlice(1, part.GetMeta().GetDataType());
+    SmartArray<uint8_t> in = GetSparsePushSlice(part, req, keys.size() / sizeof(uint64_t), is_value);
     part.HandlePush(keys, in, is_value);
 }
 
 PSMessage TensorPartitionStore::SparsePull(const std::string& name, PSMessage req, bool read_only, bool nan_fill)
 {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
     auto it = sparse_store_.find(name);
     if (it == sparse_store_.end())
     {
@@ -269,6 +322,7 @@ PSMessage TensorPartitionStore::SparsePull(const std::string& name, PSMessage re
 
 void TensorPartitionStore::SparsePushPartition(const std::string& name, PSMessage req, bool data_only, bool skip_existing)
 {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
     auto it = sparse_store_.find(name);
     if (it == sparse_store_.end())
     {
@@ -288,6 +342,7 @@ void TensorPartitionStore::SparsePushPartition(const std::string& name, PSMessag
 
 PSMessage TensorPartitionStore::SparsePullPartition(const std::string& name, bool data_only, int index, int count)
 {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
     auto it = sparse_store_.find(name);
     if (it == sparse_store_.end())
     {
@@ -310,6 +365,7 @@ PSMessage TensorPartitionStore::SparsePullPartition(const std::string& name, boo
 
 void TensorPartitionStore::SparsePushMeta(const std::string& name, const SparseTensorMeta& meta)
 {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
     auto it = sparse_store_.find(name);
     if (it == sparse_store_.end())
     {
@@ -327,6 +383,7 @@ void TensorPartitionStore::SparsePushMeta(const std::string& name, const SparseT
 
 PSMessage TensorPartitionStore::SparsePullMeta(const std::string& name)
 {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
     auto it = sparse_store_.find(name);
     if (it == sparse_store_.end())
     {
@@ -345,8 +402,9 @@ PSMessage TensorPartitionStore::SparsePullMeta(const std::string& name)
     return res;
 }
 
-void TensorPartitionStore::SparseLoad(const std::string& name, const std::string& dir_path)
+void TensorPartitionStore::SparseLoad(const std::string& name, const std::string& dir_path, int old_partition_count)
 {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
     auto it = sparse_store_.find(name);
     if (it == sparse_store_.end())
     {
@@ -359,11 +417,12 @@ void TensorPartitionStore::SparseLoad(const std::string& name, const std::string
         throw std::runtime_error(serr);
     }
     SparseTensorPartition& part = it->second;
-    part.Load(dir_path);
+    part.Load(dir_path, old_partition_count);
 }
 
 void TensorPartitionStore::SparseSave(const std::string& name, const std::string& dir_path, bool text_mode)
 {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
     auto it = sparse_store_.find(name);
     if (it == sparse_store_.end())
     {
@@ -382,6 +441,7 @@ void TensorPartitionStore::SparseSave(const std::string& name, const std::string
 
 void TensorPartitionStore::SparseExport(const std::string& name, const std::string& dir_path)
 {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
     auto it = sparse_store_.find(name);
     if (it == sparse_store_.end())
     {
@@ -400,6 +460,7 @@ void TensorPartitionStore::SparseExport(const std::string& name, const std::stri
 
 void TensorPartitionStore::SparsePruneSmall(const std::string& name, double epsilon)
 {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
     auto it = sparse_store_.find(name);
     if (it == sparse_store_.end())
     {
@@ -417,6 +478,7 @@ void TensorPartitionStore::SparsePruneSmall(const std::string& name, double epsi
 
 void TensorPartitionStore::SparsePruneOld(const std::string& name, int max_age)
 {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
     auto it = sparse_store_.find(name);
     if (it == sparse_store_.end())
     {
@@ -432,4 +494,88 @@ void TensorPartitionStore::SparsePruneOld(const std::string& name, int max_age)
     part.PruneOld(max_age);
 }
 
+void TensorPartitionStore::DensePush(int tensor_id, PSMessage req, bool is_value, bool is_state)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    DenseTensorPartition& part = GetDensePartition(tensor_id);
+    SmartArray<uint8_t> in = GetDensePushSlice(part, req, is_value, is_state);
+    part.HandlePush(in, is_value, is_state);
+}
+
+PSMessage TensorPartitionStore::DensePull(int tensor_id, bool is_state)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    DenseTensorPartition& part = GetDensePartition(tensor_id);
+    SmartArray<uint8_t> out = part.HandlePull(is_state);
+    PSMessage res = std::make_shared<Message>();
+    res->AddTypedSlice(out, part.GetMeta().GetDataType());
+    return res;
+}
+
+std::string TensorPartitionStore::GetDenseName(int tensor_id)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (tensor_id < 0 || tensor_id >= static_cast<int>(dense_ids_.size()) || !dense_ids_.at(tensor_id))
+        return {};
+    return dense_ids_.at(tensor_id)->GetMeta().GetName();
+}
+
+void TensorPartitionStore::SparsePush(int tensor_id, PSMessage req, bool is_value)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    SparseTensorPartition& part = GetSparsePartition(tensor_id);
+    SmartArray<uint8_t> keys = req->GetTypedSlice<uint64_t>(0).Cast<uint8_t>();
+    SmartArray<uint8_t> in = GetSparsePushSlice(part, req, keys.size() / sizeof(uint64_t), is_value);
+    part.HandlePush(keys, in, is_value);
+}
+
+PSMessage TensorPartitionStore::SparsePull(int tensor_id, PSMessage req, bool read_only, bool nan_fill)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    SparseTensorPartition& part = GetSparsePartition(tensor_id);
+    SmartArray<uint8_t> keys = req->GetTypedSlice<uint64_t>(0).Cast<uint8_t>();
+    SmartArray<uint8_t> out = part.HandlePull(keys, read_only, nan_fill);
+    PSMessage res = std::make_shared<Message>();
+    res->AddTypedSlice(out, part.GetMeta().GetDataType());
+    return res;
+}
+
+std::string TensorPartitionStore::GetSparseName(int tensor_id)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (tensor_id < 0 || tensor_id >= static_cast<int>(sparse_ids_.size()) || !sparse_ids_.at(tensor_id))
+        return {};
+    return sparse_ids_.at(tensor_id)->GetMeta().GetName();
+}
+
+DenseTensorPartition& TensorPartitionStore::GetDensePartition(int tensor_id)
+{
+    if (tensor_id < 0 || tensor_id >= static_cast<int>(dense_ids_.size()) || !dense_ids_.at(tensor_id))
+    {
+        std::string serr;
+        serr.append("Dense tensor with id ");
+        serr.append(std::to_string(tensor_id));
+        serr.append(" does not exist.\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    return *dense_ids_.at(tensor_id);
+}
+
+SparseTensorPartition& TensorPartitionStore::GetSparsePartition(int tensor_id)
+{
+    if (tensor_id < 0 || tensor_id >= static_cast<int>(sparse_ids_.size()) || !sparse_ids_.at(tensor_id))
+    {
+        std::string serr;
+        serr.append("Sparse tensor with id ");
+        serr.append(std::to_string(tensor_id));
+        serr.append(" does not exist.\n\n");
+        serr.append(GetStackTrace());
+        spdlog::error(serr);
+        throw std::runtime_error(serr);
+    }
+    return *sparse_ids_.at(tensor_id);
+}
+
 }
@@ -16,7 +16,9 @@
 
 #pragma once
 
+#include <shared_mutex>
 #include <unordered_map>
+#include <vector>
 #include <mindalpha/message.h>
 #include <mindalpha/ps_agent.h>
 #include <mindalpha/dense_tensor_partition.h>
@@ -34,14 +36,23 @@ public:
     int GetPartitionIndex() const { return partition_index_; }
     void SetPartitionIndex(int value) { partition_index_ = value; }
 
-    void DenseInit(const DenseTensorMeta& meta);
+    std::shared_ptr<ParallelForPool> GetParallelForPool() const { return parallel_pool_; }
+    void SetParallelForPool(std::shared_ptr<ParallelForPool> value) { parallel_pool_ = std::move(value); }
+
+    // Tensors are assigned ids at init, which data-plane requests carry in
+    // their ``DataRequest`` header in place of the tensor name. Ids of
+    // disposed tensors are not reused.
+    int DenseInit(const DenseTensorMeta& meta);
     void DenseDispose(const std::string& name);
     void DensePush(const std::string& name, PSMessage req, bool is_value, bool is_state);
     PSMessage DensePull(const std::string& name, bool is_state);
     void DensePushMeta(const std::string& name, const DenseTensorMeta& meta);
     PSMessage DensePullMeta(const std::string& name);
+    void DensePush(int tensor_id, PSMessage req, bool is_value, bool is_state);
+    PSMessage DensePull(int tensor_id, bool is_state);
+    std::string GetDenseName(int tensor_id);
 
-    void SparseInit(const SparseTensorMeta& meta);
+    int SparseInit(const SparseTensorMeta& meta);
     void SparseDispose(const std::string& name);
     void SparseClear(const std::string& name);
     void SparsePush(const std::string& name, PSMessage req, bool is_value);
@@ -50,17 +61,31 @@ public:
     PSMessage SparsePullPartition(const std::string& name, bool data_only, int index, int count);
     void SparsePushMeta(const std::string& name, const SparseTensorMeta& meta);
     PSMessage SparsePullMeta(const std::string& name);
-    void SparseLoad(const std::string& name, const std::string& dir_path);
+    void SparseLoad(const std::string& name, const std::string& dir_path, int old_partition_count = -1);
     void SparseSave(const std::string& name, const std::string& dir_path, bool text_mode);
     void SparseExport(const std::string& name, const std::string& dir_path);
     void SparsePruneSmall(const std::string& name, double epsilon);
     void SparsePruneOld(const std::string& name, int max_age);
+    void SparsePush(int tensor_id, PSMessage req, bool is_value);
+    PSMessage SparsePull(int tensor_id, PSMessage req, bool read_only, bool nan_fill);
+    std::string GetSparseName(int tensor_id);
 
 private:
+    DenseTensorPartition& GetDensePartition(int tensor_id);
+    SparseTensorPartition& GetSparsePartition(int tensor_id);
+
+    // Servers may handle requests of different tensors concurrently.
+    // Requests of the same tensor are ordered by ``RequestExecutor``, this
+    // mutex only protects the maps below, which are modified by the init
+    // and dispose commands.
+    std::shared_mutex mutex_;
     int partition_count_ = -1;
     int partition_index_ = -1;
+    std::shared_ptr<ParallelForPool> parallel_pool_;
     std::unordered_map<std::string, DenseTensorPartition> dense_store_;
     std::unordered_map<std::string, SparseTensorPartition> sparse_store_;
+    std::vector<DenseTensorPartition*> dense_ids_;
+    std::vector<SparseTensorPartition*> sparse_ids_;
 };
 
 }
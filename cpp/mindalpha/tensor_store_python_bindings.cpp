@@ -17,6 +17,8 @@
 #include <mindalpha/ps_agent.h>
 #include <mindalpha/dense_tensor.h>
 #include <mindalpha/sparse_tensor.h>
+#include <mindalpha/tensor_batch.h>
+#include <mindalpha/embedding_prefetcher.h>
 #include <mindalpha/pybind_utils.h>
 #include <mindalpha/tensor_store_python_bindings.h>
 
@@ -87,13 +89,34 @@ void DefineTensorStoreBindings(pybind11::module& m)
                                          { return self.GetMeta().GetPartitionCount(); },
                                          [](mindalpha::DenseTensor& self, int value)
                                          { self.GetMeta().SetPartitionCount(value); })
+        .def_property("gradient_codec", [](const mindalpha::DenseTensor& self)
+                                        {
+                                            const mindalpha::GradientCodec c = self.GetMeta().GetGradientCodec();
+                                            return mindalpha::GradientCodecToString(c);
+                                        },
+                                        [](mindalpha::DenseTensor& self, const std::string& value)
+                                        {
+                                            const mindalpha::GradientCodec c = mindalpha::GradientCodecFromString(value);
+                                            self.GetMeta().SetGradientCodec(c);
+                                        })
+        .def_property("gradient_top_k_ratio", [](const mindalpha::DenseTensor& self)
+                                              { return self.GetMeta().GetGradientTopKRatio(); },
+                                              [](mindalpha::DenseTensor& self, double value)
+                                              { self.GetMeta().SetGradientTopKRatio(value); })
+        .def_property_readonly("gradient_raw_bytes", [](const mindalpha::DenseTensor& self)
+                                                     { return self.GetGradientEncoder().GetRawBytes(); })
+        .def_property_readonly("gradient_wire_bytes", [](const mindalpha::DenseTensor& self)
+                                                      { return self.GetGradientEncoder().GetWireBytes(); })
+        .def("reset_gradient_byte_counters", [](const mindalpha::DenseTensor& self)
+                                             { self.GetGradientEncoder().ResetCounters(); })
         .def_property("agent", &mindalpha::DenseTensor::GetAgent,
                                &mindalpha::DenseTensor::SetAgent)
         .def("__str__", [](const mindalpha::DenseTensor& self)
                         { return self.GetMeta().ToString(); })
-        .def("init", [](mindalpha::DenseTensor& self, py::object cb)
+        .def("init", [](mindalpha::DenseTensor& self, py::object cb, py::object error_cb)
                      {
                          auto func = mindalpha::make_shared_pyobject(cb);
+                         mindalpha::PSAgent::ErrorScope scope(mindalpha::make_error_callback(error_cb));
                          py::gil_scoped_release gil;
                          self.Init([func]()
                          {
@@ -101,9 +124,10 @@ void DefineTensorStoreBindings(pybind11::module& m)
                              (*func)();
                          });
                      })
-        .def("dispose", [](mindalpha::DenseTensor& self, py::object cb)
+        .def("dispose", [](mindalpha::DenseTensor& self, py::object cb, py::object error_cb)
                         {
                             auto func = mindalpha::make_shared_pyobject(cb);
+                            mindalpha::PSAgent::ErrorScope scope(mindalpha::make_error_callback(error_cb));
                             py::gil_scoped_release gil;
                             self.Dispose([func]()
                             {
@@ -111,13 +135,14 @@ void DefineTensorStoreBindings(pybind11::module& m)
                                 (*func)();
                             });
                         })
-        .def("push", [](mindalpha::DenseTensor& self, py::array in, py::object cb, bool is_value, bool is_state)
+        .def("push", [](mindalpha::DenseTensor& self, py::array in, py::object cb, py::object error_cb, bool is_value, bool is_state)
                      {
                          auto in_obj = mindalpha::make_shared_pyobject(in);
                          void* in_data_ptr = const_cast<void*>(in.data(0));
                          uint8_t* in_data = static_cast<uint8_t*>(in_data_ptr);
                          auto in_array = mindalpha::SmartArray<uint8_t>::Create(in_data, in.nbytes(), [in_obj](uint8_t*) { });
                          auto func = mindalpha::make_shared_pyobject(cb);
+                         mindalpha::PSAgent::ErrorScope scope(mindalpha::make_error_callback(error_cb));
                          py::gil_scoped_release gil;
                          self.Push(in_array, [func]()
                          {
@@ -125,9 +150,10 @@ void DefineTensorStoreBindings(pybind11::module& m)
                              (*func)();
                          }, is_value, is_state);
                      })
-        .def("pull", [](mindalpha::DenseTensor& self, py::object cb, bool is_state)
+        .def("pull", [](mindalpha::DenseTensor& self, py::object cb, py::object error_cb, bool is_state)
                      {
                          auto func = mindalpha::make_shared_pyobject(cb);
+                         mindalpha::PSAgent::ErrorScope scope(mindalpha::make_error_callback(error_cb));
                          py::gil_scoped_release gil;
                          self.Pull([func, &self](mindalpha::SmartArray<uint8_t> out)
                          {
@@ -139,18 +165,20 @@ void DefineTensorStoreBindings(pybind11::module& m)
                              (*func)(out_arr);
                          }, is_state);
                      })
-        .def("load", [](mindalpha::DenseTensor& self,  const std::string& dir_path, py::object cb, bool keep_meta)
+        .def("load", [](mindalpha::DenseTensor& self,  const std::string& dir_path, py::object cb, py::object error_cb, bool keep_meta)
                      {
                          auto func = mindalpha::make_shared_pyobject(cb);
+                         mindalpha::PSAgent::ErrorScope scope(mindalpha::make_error_callback(error_cb));
                          py::gil_scoped_release gil;
                          self.Load(dir_path ,[func]() {
                              py::gil_scoped_acquire gil;
                              (*func)();
                          }, keep_meta);
                      })
-        .def("save", [](mindalpha::DenseTensor& self,  const std::string& dir_path, py::object cb)
+        .def("save", [](mindalpha::DenseTensor& self,  const std::string& dir_path, py::object cb, py::object error_cb)
                      {
                          auto func = mindalpha::make_shared_pyobject(cb);
+                         mindalpha::PSAgent::ErrorScope scope(mindalpha::make_error_callback(error_cb));
                          py::gil_scoped_release gil;
                          self.Save(dir_path, [func]() {
                              py::gil_scoped_acquire gil;
@@ -219,13 +247,95 @@ void DefineTensorStoreBindings(pybind11::module& m)
                                          { return self.GetMeta().GetPartitionCount(); },
                                          [](mindalpha::SparseTensor& self, int value)
                                          { self.GetMeta().SetPartitionCount(value); })
+        .def_property("hash_map_engine", [](const mindalpha::SparseTensor& self)
+                                         {
+                                             const mindalpha::HashMapEngine e = self.GetMeta().GetHashMapEngine();
+                                             return mindalpha::HashMapEngineToString(e);
+                                         },
+                                         [](mindalpha::SparseTensor& self, const std::string& value)
+                                         {
+                                             const mindalpha::HashMapEngine e = mindalpha::HashMapEngineFromString(value);
+                                             self.GetMeta().SetHashMapEngine(e);
+                                         })
+        .def_property("memory_buffer_backend", [](const mindalpha::SparseTensor& self)
+                                               {
+                                                   const mindalpha::MemoryBufferBackend b = self.GetMeta().GetMemoryBufferBackend();
+                                                   return mindalpha::MemoryBufferBackendToString(b);
+                                               },
+                                               [](mindalpha::SparseTensor& self, const std::string& value)
+                                               {
+                                                   const mindalpha::MemoryBufferBackend b = mindalpha::MemoryBufferBackendFromString(value);
+                                                   self.GetMeta().SetMemoryBufferBackend(b);
+                                               })
+        .def_property("gradient_codec", [](const mindalpha::SparseTensor& self)
+                                        {
+                                            const mindalpha::GradientCodec c = self.GetMeta().GetGradientCodec();
+                                            return mindalpha::GradientCodecToString(c);
+                                        },
+                                        [](mindalpha::SparseTensor& self, const std::string& value)
+                                        {
+                                            const mindalpha::GradientCodec c = mindalpha::GradientCodecFromString(value);
+                                            self.GetMeta().SetGradientCodec(c);
+                                        })
+        .def_property_readonly("gradient_raw_bytes", [](const mindalpha::SparseTensor& self)
+                                                     { return self.GetGradientEncoder().GetRawBytes(); })
+        .def_property_readonly("gradient_wire_bytes", [](const mindalpha::SparseTensor& self)
+                                                      { return self.GetGradientEncoder().GetWireBytes(); })
+        .def("reset_gradient_byte_counters", [](const mindalpha::SparseTensor& self)
+                                             { self.GetGradientEncoder().ResetCounters(); })
+        .def_property("gradient_aggregation", [](const mindalpha::SparseTensor& self)
+                                              {
+                                                  const mindalpha::GradientAggregation a = self.GetMeta().GetGradientAggregation();
+                                                  return mindalpha::GradientAggregationToString(a);
+                                              },
+                                              [](mindalpha::SparseTensor& self, const std::string& value)
+                                              {
+                                                  const mindalpha::GradientAggregation a = mindalpha::GradientAggregationFromString(value);
+                                                  self.GetMeta().SetGradientAggregation(a);
+                                              })
+        .def_property("key_partitioner", [](const mindalpha::SparseTensor& self)
+                                         {
+                                             const mindalpha::KeyPartitioner p = self.GetMeta().GetKeyPartitioner();
+                                             return mindalpha::KeyPartitionerToString(p);
+                                         },
+                                         [](mindalpha::SparseTensor& self, const std::string& value)
+                                         {
+                                             const mindalpha::KeyPartitioner p = mindalpha::KeyPartitionerFromString(value);
+                                             self.GetMeta().SetKeyPartitioner(p);
+                                         })
+        .def_property_readonly("push_input_keys", [](const mindalpha::SparseTensor& self)
+                                                  { return self.GetGradientAggregator().GetInputKeys(); })
+        .def_property_readonly("push_unique_keys", [](const mindalpha::SparseTensor& self)
+                                                   { return self.GetGradientAggregator().GetUniqueKeys(); })
+        .def_property_readonly("push_dedup_ratio", [](const mindalpha::SparseTensor& self)
+                                                   { return self.GetGradientAggregator().GetDedupRatio(); })
+        .def("reset_push_key_counters", [](const mindalpha::SparseTensor& self)
+                                        { self.GetGradientAggregator().ResetCounters(); })
+        .def("configure_pull_cache", [](mindalpha::SparseTensor& self, size_t capacity, const std::string& eviction,
+                                        uint32_t admission_count, uint64_t max_staleness_steps, uint64_t max_staleness_ms)
+                                     {
+                                         const mindalpha::CacheEviction e = mindalpha::CacheEvictionFromString(eviction);
+                                         self.GetPullCache().Configure(capacity, e, admission_count,
+                                                                       max_staleness_steps, max_staleness_ms);
+                                     })
+        .def_property_readonly("pull_cache_hits", [](const mindalpha::SparseTensor& self)
+                                                  { return self.GetPullCache().GetHits(); })
+        .def_property_readonly("pull_cache_misses", [](const mindalpha::SparseTensor& self)
+                                                    { return self.GetPullCache().GetMisses(); })
+        .def_property_readonly("pull_cache_hit_rate", [](const mindalpha::SparseTensor& self)
+                                                      { return self.GetPullCache().GetHitRate(); })
+        .def_property_readonly("pull_cache_bytes_saved", [](const mindalpha::SparseTensor& self)
+                                                         { return self.GetPullCache().GetBytesSaved(); })
+        .def("reset_pull_cache_counters", [](const mindalpha::SparseTensor& self)
+                                          { self.GetPullCache().ResetCounters(); })
         .def_property("agent", &mindalpha::SparseTensor::GetAgent,
                                &mindalpha::SparseTensor::SetAgent)
         .def("__str__", [](const mindalpha::SparseTensor& self)
                         { return self.GetMeta().ToString(); })
-        .def("init", [](mindalpha::SparseTensor& self, py::object cb)
+        .def("init", [](mindalpha::SparseTensor& self, py::object cb, py::object error_cb)
                      {
                          auto func = mindalpha::make_shared_pyobject(cb);
+                         mindalpha::PSAgent::ErrorScope scope(mindalpha::make_error_callback(error_cb));
                          py::gil_scoped_release gil;
                          self.Init([func]()
                          {
@@ -233,9 +343,10 @@ void DefineTensorStoreBindings(pybind11::module& m)
                              (*func)();
                          });
                      })
-        .def("dispose", [](mindalpha::SparseTensor& self, py::object cb)
+        .def("dispose", [](mindalpha::SparseTensor& self, py::object cb, py::object error_cb)
                         {
                             auto func = mindalpha::make_shared_pyobject(cb);
+                            mindalpha::PSAgent::ErrorScope scope(mindalpha::make_error_callback(error_cb));
                             py::gil_scoped_release gil;
                             self.Dispose([func]()
                             {
@@ -243,9 +354,10 @@ void DefineTensorStoreBindings(pybind11::module& m)
                                 (*func)();
                             });
                         })
-        .def("clear", [](mindalpha::SparseTensor& self, py::object cb)
+        .def("clear", [](mindalpha::SparseTensor& self, py::object cb, py::object error_cb)
                       {
                           auto func = mindalpha::make_shared_pyobject(cb);
+                          mindalpha::PSAgent::ErrorScope scope(mindalpha::make_error_callback(error_cb));
                           py::gil_scoped_release gil;
                           self.Clear([func]()
                           {
@@ -253,7 +365,7 @@ void DefineTensorStoreBindings(pybind11::module& m)
                               (*func)();
                           });
                       })
-        .def("push", [](mindalpha::SparseTensor& self, py::array keys, py::array in, py::object cb, bool is_value)
+        .def("push", [](mindalpha::SparseTensor& self, py::array keys, py::array in, py::object cb, py::object error_cb, bool is_value)
                      {
                          auto keys_obj = mindalpha::make_shared_pyobject(keys);
                          auto in_obj = mindalpha::make_shared_pyobject(in);
@@ -264,6 +376,7 @@ void DefineTensorStoreBindings(pybind11::module& m)
                          auto keys_array = mindalpha::SmartArray<uint8_t>::Create(keys_data, keys.nbytes(), [keys_obj](uint8_t*) { });
                          auto in_array = mindalpha::SmartArray<uint8_t>::Create(in_data, in.nbytes(), [in_obj](uint8_t*) { });
                          auto func = mindalpha::make_shared_pyobject(cb);
+                         mindalpha::PSAgent::ErrorScope scope(mindalpha::make_error_callback(error_cb));
                          py::gil_scoped_release gil;
                          self.Push(keys_array, in_array, [func]()
                          {
@@ -271,13 +384,14 @@ void DefineTensorStoreBindings(pybind11::module& m)
                              (*func)();
                          }, is_value);
                      })
-        .def("pull", [](mindalpha::SparseTensor& self, py::array keys, py::object cb, bool read_only, bool nan_fill)
+        .def("pull", [](mindalpha::SparseTensor& self, py::array keys, py::object cb, py::object error_cb, bool read_only, bool nan_fill)
                      {
                          auto keys_obj = mindalpha::make_shared_pyobject(keys);
                          void* keys_data_ptr = const_cast<void*>(keys.data(0));
                          uint8_t* keys_data = static_cast<uint8_t*>(keys_data_ptr);
                          auto keys_array = mindalpha::SmartArray<uint8_t>::Create(keys_data, keys.nbytes(), [keys_obj](uint8_t*) { });
                          auto func = mindalpha::make_shared_pyobject(cb);
+                         mindalpha::PSAgent::ErrorScope scope(mindalpha::make_error_callback(error_cb));
                          py::gil_scoped_release gil;
                          self.Pull(keys_array, [func, &self](mindalpha::SmartArray<uint8_t> out)
                          {
@@ -293,56 +407,62 @@ void DefineTensorStoreBindings(pybind11::module& m)
                              (*func)(out_arr);
                          }, read_only, nan_fill);
                      })
-        .def("load", [](mindalpha::SparseTensor& self, const std::string& dir_path, py::object cb, bool keep_meta)
+        .def("load", [](mindalpha::SparseTensor& self, const std::string& dir_path, py::object cb, py::object error_cb, bool keep_meta)
                      {
                          auto func = mindalpha::make_shared_pyobject(cb);
+                         mindalpha::PSAgent::ErrorScope scope(mindalpha::make_error_callback(error_cb));
                          py::gil_scoped_release gil;
                          self.Load(dir_path, [func]() {
                              py::gil_scoped_acquire gil;
                              (*func)();
                          }, keep_meta);
                      })
-        .def("save", [](mindalpha::SparseTensor& self,  const std::string& dir_path, py::object cb, bool text_mode)
+        .def("save", [](mindalpha::SparseTensor& self,  const std::string& dir_path, py::object cb, py::object error_cb, bool text_mode)
                      {
                          auto func = mindalpha::make_shared_pyobject(cb);
+                         mindalpha::PSAgent::ErrorScope scope(mindalpha::make_error_callback(error_cb));
                          py::gil_scoped_release gil;
                          self.Save(dir_path, [func]() {
                              py::gil_scoped_acquire gil;
                              (*func)();
                          }, text_mode);
                      })
-        .def("export", [](mindalpha::SparseTensor& self,  const std::string& dir_path, py::object cb)
+        .def("export", [](mindalpha::SparseTensor& self,  const std::string& dir_path, py::object cb, py::object error_cb)
                      {
                          auto func = mindalpha::make_shared_pyobject(cb);
+                         mindalpha::PSAgent::ErrorScope scope(mindalpha::make_error_callback(error_cb));
                          py::gil_scoped_release gil;
                          self.Export(dir_path, [func]() {
                              py::gil_scoped_acquire gil;
                              (*func)();
                          });
                      })
-        .def("import_from", [](mindalpha::SparseTensor& self, const std::string& meta_file_path, py::object cb,
+        .def("import_from", [](mindalpha::SparseTensor& self, const std::string& meta_file_path, py::object cb, py::object error_cb,
                                bool data_only, bool skip_existing,
                                bool transform_key, const std::string& feature_name)
                             {
                                 auto func = mindalpha::make_shared_pyobject(cb);
+                                mindalpha::PSAgent::ErrorScope scope(mindalpha::make_error_callback(error_cb));
                                 py::gil_scoped_release gil;
                                 self.ImportFrom(meta_file_path, [func]() {
                                     py::gil_scoped_acquire gil;
                                     (*func)();
                                 }, data_only, skip_existing, transform_key, feature_name);
                             })
-        .def("prune_small", [](mindalpha::SparseTensor& self,  double epsilon, py::object cb)
+        .def("prune_small", [](mindalpha::SparseTensor& self,  double epsilon, py::object cb, py::object error_cb)
                      {
                          auto func = mindalpha::make_shared_pyobject(cb);
+                         mindalpha::PSAgent::ErrorScope scope(mindalpha::make_error_callback(error_cb));
                          py::gil_scoped_release gil;
                          self.PruneSmall(epsilon, [func]() {
                              py::gil_scoped_acquire gil;
                              (*func)();
                          });
                      })
-        .def("prune_old", [](mindalpha::SparseTensor& self,  int max_age, py::object cb)
+        .def("prune_old", [](mindalpha::SparseTensor& self,  int max_age, py::object cb, py::object error_cb)
                      {
                          auto func = mindalpha::make_shared_pyobject(cb);
+                         mindalpha::PSAgent::ErrorScope scope(mindalpha::make_error_callback(error_cb));
                          py::gil_scoped_release gil;
                          self.PruneOld(max_age, [func]() {
                              py::gil_scoped_acquire gil;
@@ -351,6 +471,125 @@ void DefineTensorStoreBindings(pybind11::module& m)
                      })
         ;
 
+    py::class_<mindalpha::TensorBatch>(m, "TensorBatch")
+        .def(py::init<std::shared_ptr<mindalpha::PSAgent>>())
+        .def_property_readonly("agent", &mindalpha::TensorBatch::GetAgent)
+        .def("__len__", &mindalpha::TensorBatch::GetOperationCount)
+        .def("add_dense_push", [](mindalpha::TensorBatch& self, mindalpha::DenseTensor& tensor, py::array in, py::object cb, bool is_value, bool is_state)
+                               {
+                                   auto in_obj = mindalpha::make_shared_pyobject(in);
+                                   void* in_data_ptr = const_cast<void*>(in.data(0));
+                                   uint8_t* in_data = static_cast<uint8_t*>(in_data_ptr);
+                                   auto in_array = mindalpha::SmartArray<uint8_t>::Create(in_data, in.nbytes(), [in_obj](uint8_t*) { });
+                                   auto func = mindalpha::make_shared_pyobject(cb);
+                                   self.AddDensePush(tensor, in_array, [func]()
+                                   {
+                                       py::gil_scoped_acquire gil;
+                                       (*func)();
+                                   }, is_value, is_state);
+                               })
+        .def("add_dense_pull", [](mindalpha::TensorBatch& self, mindalpha::DenseTensor& tensor, py::object cb, bool is_state)
+                               {
+                                   auto func = mindalpha::make_shared_pyobject(cb);
+                                   self.AddDensePull(tensor, [func, &tensor](mindalpha::SmartArray<uint8_t> out)
+                                   {
+                                       py::gil_scoped_acquire gil;
+                                       mindalpha::DataType type = tensor.GetMeta().GetDataType();
+                                       py::object out_arr = mindalpha::make_numpy_array(out, type);
+                                       py::tuple shape = mindalpha::make_python_tuple(tensor.GetMeta().GetDataShape());
+                                       out_arr = out_arr.attr("reshape")(shape);
+                                       (*func)(out_arr);
+                                   }, is_state);
+                               })
+        .def("add_sparse_push", [](mindalpha::TensorBatch& self, mindalpha::SparseTensor& tensor, py::array keys, py::array in, py::object cb, bool is_value)
+                                {
+                                    auto keys_obj = mindalpha::make_shared_pyobject(keys);
+                                    auto in_obj = mindalpha::make_shared_pyobject(in);
+                                    void* keys_data_ptr = const_cast<void*>(keys.data(0));
+                                    void* in_data_ptr = const_cast<void*>(in.data(0));
+                                    uint8_t* keys_data = static_cast<uint8_t*>(keys_data_ptr);
+                                    uint8_t* in_data = static_cast<uint8_t*>(in_data_ptr);
+                                    auto keys_array = mindalpha::SmartArray<uint8_t>::Create(keys_data, keys.nbytes(), [keys_obj](uint8_t*) { });
+                                    auto in_array = mindalpha::SmartArray<uint8_t>::Create(in_data, in.nbytes(), [in_obj](uint8_t*) { });
+                                    auto func = mindalpha::make_shared_pyobject(cb);
+                                    self.AddSparsePush(tensor, keys_array, in_array, [func]()
+                                    {
+                                        py::gil_scoped_acquire gil;
+                                        (*func)();
+                                    }, is_value);
+                                })
+        .def("add_sparse_pull", [](mindalpha::TensorBatch& self, mindalpha::SparseTensor& tensor, py::array keys, py::object cb, bool read_only, bool nan_fill)
+                                {
+                                    auto keys_obj = mindalpha::make_shared_pyobject(keys);
+                                    void* keys_data_ptr = const_cast<void*>(keys.data(0));
+                                    uint8_t* keys_data = static_cast<uint8_t*>(keys_data_ptr);
+                                    auto keys_array = mindalpha::SmartArray<uint8_t>::Create(keys_data, keys.nbytes(), [keys_obj](uint8_t*) { });
+                                    auto func = mindalpha::make_shared_pyobject(cb);
+                                    self.AddSparsePull(tensor, keys_array, [func, &tensor](mindalpha::SmartArray<uint8_t> out)
+                                    {
+                                        py::gil_scoped_acquire gil;
+                                        mindalpha::DataType type = tensor.GetMeta().GetDataType();
+                                        py::object out_arr = mindalpha::make_numpy_array(out, type);
+                                        const std::vector<size_t>& slice_shape = tensor.GetMeta().GetSliceDataShape();
+                                        py::tuple shape(1 + slice_shape.size());
+                                        shape[0] = -1;
+                                        for (size_t i = 0; i < slice_shape.size(); i++)
+                                            shape[1 + i] = static_cast<int64_t>(slice_shape.at(i));
+                                        out_arr = out_arr.attr("reshape")(shape);
+                                        (*func)(out_arr);
+                                    }, read_only, nan_fill);
+                                })
+        .def("send", [](mindalpha::TensorBatch& self, py::object cb, py::object error_cb)
+                     {
+                         auto func = mindalpha::make_shared_pyobject(cb);
+                         mindalpha::PSAgent::ErrorScope scope(mindalpha::make_error_callback(error_cb));
+                         py::gil_scoped_release gil;
+                         self.Send([func]()
+                         {
+                             py::gil_scoped_acquire gil;
+                             (*func)();
+                         });
+                     })
+        ;
+
+    py::class_<mindalpha::EmbeddingPrefetcher>(m, "EmbeddingPrefetcher")
+        .def(py::init<size_t>())
+        .def_property_readonly("depth", &mindalpha::EmbeddingPrefetcher::GetDepth)
+        .def("__len__", &mindalpha::EmbeddingPrefetcher::GetPendingCount)
+        .def("submit", [](mindalpha::EmbeddingPrefetcher& self, py::object tensor, py::object schema, py::object batch,
+                          bool feature_offset, bool read_only, bool nan_fill)
+                       {
+                           // ``SparseTensor`` is held by ``std::unique_ptr``, so keep the Python
+                           // object alive instead.
+                           mindalpha::SparseTensor& tensor_ref = tensor.cast<mindalpha::SparseTensor&>();
+                           auto tensor_obj = mindalpha::make_shared_pyobject(tensor);
+                           std::shared_ptr<mindalpha::SparseTensor> tensor_ptr(tensor_obj, &tensor_ref);
+                           auto schema_ptr = mindalpha::extract_shared_pyobject<mindalpha::CombineSchema>(schema);
+                           auto batch_ptr = mindalpha::extract_shared_pyobject<mindalpha::IndexBatch>(batch);
+                           self.Submit(std::move(tensor_ptr), std::move(schema_ptr), std::move(batch_ptr),
+                                       feature_offset, read_only, nan_fill);
+                       })
+        .def("take", [](mindalpha::EmbeddingPrefetcher& self)
+                     {
+                         mindalpha::PrefetchResult result;
+                         {
+                             py::gil_scoped_release gil;
+                             result = self.Take();
+                         }
+                         py::array indices_arr = mindalpha::to_numpy_array(std::move(result.indices));
+                         py::array offsets_arr = mindalpha::to_numpy_array(std::move(result.offsets));
+                         py::array keys_arr = mindalpha::make_numpy_array(result.keys);
+                         py::object data_arr = mindalpha::make_numpy_array(result.data, result.data_type);
+                         const std::vector<size_t>& slice_shape = result.slice_data_shape;
+                         py::tuple shape(1 + slice_shape.size());
+                         shape[0] = -1;
+                         for (size_t i = 0; i < slice_shape.size(); i++)
+                             shape[1 + i] = static_cast<int64_t>(slice_shape.at(i));
+                         data_arr = data_arr.attr("reshape")(shape);
+                         return py::make_tuple(indices_arr, offsets_arr, keys_arr, data_arr);
+                     })
+        ;
+
     py::class_<mindalpha::PSDefaultAgent,
                mindalpha::PyPSDefaultAgent<>,
                std::shared_ptr<mindalpha::PSDefaultAgent>,
@@ -81,7 +81,7 @@ void FillNaNValues(uint8_t* buffer, size_t size)
     T* buf = reinterpret_cast<T*>(buffer);
     const size_t n = size / sizeof(T);
     for (size_t i = 0; i < n; i++)
-        buf[i] = std::numeric_limits<T>::quiet_NaN();
+        buf[i] = static_cast<T>(std::numeric_limits<float>::quiet_NaN());
 }
 
 void FillNaN(uint8_t* buffer, size_t size, DataType type)
@@ -94,9 +94,15 @@ void FillNaN(uint8_t* buffer, size_t size, DataType type)
     case DataType::Float64:
         FillNaNValues<double>(buffer, size);
         break;
+    case DataType::Float16:
+        FillNaNValues<float16>(buffer, size);
+        break;
+    case DataType::BFloat16:
+        FillNaNValues<bfloat16>(buffer, size);
+        break;
     default:
         std::string serr;
-        serr.append("DataType must be float32 or float64 to fill NaN values; ");
+        serr.append("DataType must be a floating point type to fill NaN values; ");
         serr.append(DataTypeToString(type));
         serr.append(" is invalid.\n\n");
         serr.append(GetStackTrace());
@@ -110,9 +116,53 @@ void MakeInitializerReady(pybind11::object initializer)
     fixup_attributes(initializer);
 }
 
+std::shared_ptr<NativeInitializer> MakeNativeInitializer(pybind11::object initializer)
+{
+    // ``XavierTensorInitializer`` is not recognized, as its scale depends on
+    // the number of slices initialized together rather than on each key.
+    namespace py = pybind11;
+    py::module module = py::module::import("mindalpha.initializer");
+    py::handle type = py::type::handle_of(initializer);
+    auto get = [&initializer](const char* name) { return initializer.attr(name).cast<double>(); };
+    if (type.is(module.attr("DefaultTensorInitializer")))
+        return NativeInitializer::CreateNormal(0.0, 1.0, true);
+    if (type.is(module.attr("ZeroTensorInitializer")))
+        return NativeInitializer::CreateConstant(0.0);
+    if (type.is(module.attr("OneTensorInitializer")))
+        return NativeInitializer::CreateConstant(1.0);
+    if (type.is(module.attr("NormalTensorInitializer")))
+        return NativeInitializer::CreateNormal(get("_mean"), get("_var"), true);
+    if (type.is(module.attr("UniformTensorInitializer")))
+        return NativeInitializer::CreateUniform(get("_a"), get("_b"));
+    if (type.is(module.attr("TruncatedNormalTensorInitializer")))
+        return NativeInitializer::CreateTruncatedNormal(get("_mean"), get("_std"), get("_a"), get("_b"));
+    return nullptr;
+}
+
 void MakeUpdaterReady(pybind11::object updater)
 {
     fixup_attributes(updater);
 }
 
+std::shared_ptr<NativeUpdater> MakeNativeUpdater(pybind11::object updater)
+{
+    // Only the exact built-in classes are recognized, subclasses may
+    // override ``update_sparse`` and must be called in Python.
+    namespace py = pybind11;
+    py::module module = py::module::import("mindalpha.updater");
+    py::handle type = py::type::handle_of(updater);
+    auto get = [&updater](const char* name) { return updater.attr(name).cast<double>(); };
+    if (type.is(module.attr("NoOpUpdater")))
+        return NativeUpdater::CreateNoOp();
+    if (type.is(module.attr("SGDTensorUpdater")))
+        return NativeUpdater::CreateSGD(get("_learning_rate"));
+    if (type.is(module.attr("AdaGradTensorUpdater")))
+        return NativeUpdater::CreateAdaGrad(get("_learning_rate"), get("_float_stable_eps"), get("_l2"));
+    if (type.is(module.attr("AdamTensorUpdater")))
+        return NativeUpdater::CreateAdam(get("_learning_rate"), get("_beta1"), get("_beta2"), get("_epsilon"));
+    if (type.is(module.attr("FTRLTensorUpdater")))
+        return NativeUpdater::CreateFTRL(get("_l1"), get("_l2"), get("_alpha"), get("_beta"));
+    return nullptr;
+}
+
 }
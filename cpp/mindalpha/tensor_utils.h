@@ -21,6 +21,8 @@
 #include <vector>
 #include <pybind11/pybind11.h>
 #include <mindalpha/data_type.h>
+#include <mindalpha/native_initializer.h>
+#include <mindalpha/native_updater.h>
 
 namespace mindalpha
 {
@@ -31,6 +33,8 @@ std::string ShapeToString(const std::vector<size_t>& shape);
 std::vector<size_t> ShapeFromString(const std::string& str);
 void FillNaN(uint8_t* buffer, size_t size, DataType type);
 void MakeInitializerReady(pybind11::object initializer);
+std::shared_ptr<NativeInitializer> MakeNativeInitializer(pybind11::object initializer);
 void MakeUpdaterReady(pybind11::object udpater);
+std::shared_ptr<NativeUpdater> MakeNativeUpdater(pybind11::object updater);
 
 }
@@ -46,6 +46,9 @@ void ZeroMQTransport::Start()
             throw std::runtime_error(serr);
         }
         zmq_ctx_set(context_, ZMQ_MAX_SOCKETS, 65536);
+        const int io_threads = GetConfig()->GetZeroMQIOThreadCount();
+        if (io_threads > 0)
+            zmq_ctx_set(context_, ZMQ_IO_THREADS, io_threads);
     }
 }
 
@@ -76,9 +79,11 @@ void ZeroMQTransport::Stop()
         spdlog::error(serr);
         throw std::runtime_error(serr);
     }
+    std::unique_lock<std::shared_mutex> senders_lock(senders_mutex_);
     for (auto&& it: senders_)
     {
-        rc = zmq_setsockopt(it.second, ZMQ_LINGER, &linger, sizeof(linger));
+        std::lock_guard<std::mutex> sender_lock(it.second->mutex);
+        rc = zmq_setsockopt(it.second->socket, ZMQ_LINGER, &linger, sizeof(linger));
         if (rc != 0 && errno != ETERM)
         {
             std::string serr;
@@ -90,7 +95,7 @@ void ZeroMQTransport::Stop()
             spdlog::error(serr);
             throw std::runtime_error(serr);
         }
-        rc = zmq_close(it.second);
+        rc = zmq_close(it.second->socket);
         if (rc != 0)
         {
             std::string serr;
@@ -182,10 +187,12 @@ void ZeroMQTransport::Connect(const NodeInfo& node)
         throw std::runtime_error(serr);
     }
     const int nodeId = node.GetNodeId();
+    std::unique_lock<std::shared_mutex> senders_lock(senders_mutex_);
     auto it = senders_.find(nodeId);
     if (it != senders_.end())
     {
-        int rc = zmq_close(it->second);
+        std::lock_guard<std::mutex> sender_lock(it->second->mutex);
+        int rc = zmq_close(it->second->socket);
         if (rc != 0)
         {
             std::string serr;
@@ -197,6 +204,7 @@ void ZeroMQTransport::Connect(const NodeInfo& node)
             spdlog::error(serr);
             throw std::runtime_error(serr);
         }
+        senders_.erase(it);
     }
     const NodeInfo& thisNode = GetConfig()->GetThisNodeInfo();
     // Worker doesn't connect to other workers and
@@ -235,12 +243,13 @@ void ZeroMQTransport::Connect(const NodeInfo& node)
         spdlog::error(serr);
         throw std::runtime_error(serr);
     }
-    senders_[nodeId] = sender;
+    auto entry = std::make_unique<Sender>();
+    entry->socket = sender;
+    senders_[nodeId] = std::move(entry);
 }
 
 int64_t ZeroMQTransport::SendMessage(const Message& msg)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
     const int nodeId = msg.GetMessageMeta().GetReceiver();
     if (nodeId == -1)
     {
@@ -249,6 +258,7 @@ int64_t ZeroMQTransport::SendMessage(const Message& msg)
         spdlog::error(serr);
         throw std::runtime_error(serr);
     }
+    std::shared_lock<std::shared_mutex> senders_lock(senders_mutex_);
     auto it = senders_.find(nodeId);
     if (it == senders_.end())
     {
@@ -261,8 +271,9 @@ int64_t ZeroMQTransport::SendMessage(const Message& msg)
         throw std::runtime_error(serr);
     }
     const NodeInfo& thisNode = GetConfig()->GetThisNodeInfo();
-    void* const sender = it->second;
-    auto metaPtr = new SmartArray<uint8_t>(msg.GetMessageMeta().PackAsThriftBuffer());
+    std::lock_guard<std::mutex> sender_lock(it->second->mutex);
+    void* const sender = it->second->socket;
+    auto metaPtr = new SmartArray<uint8_t>(msg.GetMessageMeta().PackAsBuffer());
     const size_t metaSize = metaPtr->size();
     zmq_msg_t meta;
     zmq_msg_init_data(&meta, metaPtr->data(), metaSize, [](void* ptr, void* hint) {
@@ -392,11 +403,11 @@ int64_t ZeroMQTransport::ReceiveMessage(Message& msg)
         else if (i == 1)
         {
             // The sender and receiver fields will be overridden by
-            // UnpackFromThriftBuffer, save them and restore them later.
+            // UnpackFromBuffer, save them and restore them later.
             const int sender = msg.GetMessageMeta().GetSender();
             const int receiver = msg.GetMessageMeta().GetReceiver();
             const uint8_t* const ptr = reinterpret_cast<const uint8_t*>(buf);
-            msg.GetMessageMeta().UnpackFromThriftBuffer(ptr, size);
+            msg.GetMessageMeta().UnpackFromBuffer(ptr, size);
             msg.GetMessageMeta().SetSender(sender);
             msg.GetMessageMeta().SetReceiver(receiver);
             const int more = zmq_msg_more(zmsg.get());
@@ -16,7 +16,9 @@
 
 #pragma once
 
+#include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <unordered_map>
 #include <mindalpha/message_transport.h>
 
@@ -35,15 +37,29 @@ public:
     int64_t SendMessage(const Message& msg) override;
     int64_t ReceiveMessage(Message& msg) override;
 
+protected:
+    void* GetReceiverSocket() const { return receiver_; }
+
 private:
     std::string FormatActorAddress(const NodeInfo& node, int port, bool forServer) const;
     std::string FormatActorIdentity(const NodeInfo& node) const;
     int ParseActorIdentity(const char* buf, size_t size) const;
 
+    // ZeroMQ sockets must not be used by several threads at once, so each
+    // peer has its own sender socket guarded by its own mutex; sends to
+    // different peers proceed in parallel. ``senders_mutex_`` only protects
+    // the map, which ``Connect`` modifies.
+    struct Sender
+    {
+        std::mutex mutex;
+        void* socket = nullptr;
+    };
+
     std::mutex mutex_;
     void* context_ = nullptr;
     void* receiver_ = nullptr;
-    std::unordered_map<int, void*> senders_;
+    std::shared_mutex senders_mutex_;
+    std::unordered_map<int, std::unique_ptr<Sender>> senders_;
 };
 
 }
@@ -29,6 +29,8 @@ from .initializer import DefaultTensorInitializer
 from .initializer import ZeroTensorInitializer
 from .initializer import OneTensorInitializer
 from .initializer import NormalTensorInitializer
+from .initializer import UniformTensorInitializer
+from .initializer import TruncatedNormalTensorInitializer
 from .initializer import XavierTensorInitializer
 
 from .updater import TensorUpdater
@@ -95,6 +97,8 @@ from ._mindalpha import get_mindalpha_version
 __version__ = get_mindalpha_version()
 del get_mindalpha_version
 
+from ._mindalpha import get_memory_buffer_stats
+
 from . import nn
 from . import input
 from . import output
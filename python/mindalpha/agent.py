@@ -172,6 +172,16 @@ class Agent(object):
             conf.agent_ready_callback = agent_ready_callback
         conf.server_count = args['server_count']
         conf.worker_count = args['worker_count']
+        conf.server_thread_count = args.get('server_thread_count', 0)
+        conf.server_parallel_thread_count = args.get('server_parallel_thread_count', 0)
+        # Actors of a local mode job are threads of one process, so they
+        # pass messages in process unless told otherwise.
+        conf.is_local_mode = args.get('is_local_mode', False)
+        default_transport_type = 'InProcess' if conf.is_local_mode else 'ZeroMQ'
+        conf.transport_type = args.get('transport_type', default_transport_type)
+        conf.zeromq_io_thread_count = args.get('zeromq_io_thread_count', 1)
+        conf.shared_memory_ring_size = args.get('shared_memory_ring_size', 64 * 1024 * 1024)
+        conf.send_timeout = args.get('send_timeout', 60 * 1000)
         conf.is_message_dumping_enabled = args.get('is_message_dumping_enabled', False)
         return conf
 
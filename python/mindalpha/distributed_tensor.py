@@ -100,14 +100,18 @@ class DistributedTensor(object):
         x.initializer = trainer._get_dense_initializer(self)
         x.updater = trainer._get_dense_updater(self)
         x.partition_count = trainer.agent.server_count
+        x.gradient_codec = getattr(self.item, 'gradient_codec', 'none')
+        x.gradient_top_k_ratio = getattr(self.item, 'gradient_top_k_ratio', 0.01)
         x.agent = trainer.agent._cxx_agent
         loop = asyncio.get_running_loop()
         future = loop.create_future()
         def init_dense_tensor_done():
             self.__handle = x
             loop.call_soon_threadsafe(future.set_result, None)
+        def init_dense_tensor_failed(e):
+            loop.call_soon_threadsafe(future.set_exception, e)
         self._init_tensor_log(x)
-        x.init(init_dense_tensor_done)
+        x.init(init_dense_tensor_done, init_dense_tensor_failed)
         return future
 
     def _init_sparse_tensor(self, trainer):
@@ -119,14 +123,28 @@ class DistributedTensor(object):
         x.initializer = trainer._get_sparse_initializer(self)
         x.updater = trainer._get_sparse_updater(self)
         x.partition_count = trainer.agent.server_count
+        x.hash_map_engine = self.item.hash_map_engine
+        x.memory_buffer_backend = self.item.memory_buffer_backend
+        x.gradient_codec = self.item.gradient_codec
+        x.gradient_aggregation = getattr(self.item, 'gradient_aggregation', 'none')
+        x.key_partitioner = self.item.key_partitioner
+        pull_cache = self.item.pull_cache
+        if pull_cache is not None:
+            x.configure_pull_cache(pull_cache['capacity'],
+                                   pull_cache.get('eviction', 'lru'),
+                                   pull_cache.get('admission_count', 2),
+                                   pull_cache.get('max_staleness_steps', 0),
+                                   pull_cache.get('max_staleness_ms', 0))
         x.agent = trainer.agent._cxx_agent
         loop = asyncio.get_running_loop()
         future = loop.create_future()
         def init_sparse_tensor_done():
             self.__handle = x
             loop.call_soon_threadsafe(future.set_result, None)
+        def init_sparse_tensor_failed(e):
+            loop.call_soon_threadsafe(future.set_exception, e)
         self._init_tensor_log(x)
-        x.init(init_sparse_tensor_done)
+        x.init(init_sparse_tensor_done, init_sparse_tensor_failed)
         return future
 
     def _pull_tensor(self):
@@ -143,7 +161,9 @@ class DistributedTensor(object):
             data = data.view(self.item.shape)
             self.item.data.copy_(data)
             loop.call_soon_threadsafe(future.set_result, None)
-        self._handle.pull(pull_dense_tensor_done, False)
+        def pull_dense_tensor_failed(e):
+            loop.call_soon_threadsafe(future.set_exception, e)
+        self._handle.pull(pull_dense_tensor_done, pull_dense_tensor_failed, False)
         return future
 
     async def _pull_sparse_tensor(self):
@@ -157,25 +177,35 @@ class DistributedTensor(object):
             loop = asyncio.get_running_loop()
             future = loop.create_future()
             def pull_sparse_tensor_done(data):
+                data = op._from_storage_ndarray(data)
                 op._check_dtype_and_shape(keys, data)
                 op._update_data(data)
                 loop.call_soon_threadsafe(future.set_result, None)
-            self._handle.pull(keys, pull_sparse_tensor_done, read_only, nan_fill)
+            def pull_sparse_tensor_failed(e):
+                loop.call_soon_threadsafe(future.set_exception, e)
+            self._handle.pull(keys, pull_sparse_tensor_done, pull_sparse_tensor_failed, read_only, nan_fill)
             return future
         await pull_sparse_tensor()
 
-    def _push_tensor(self, *, is_value=False, skip_no_grad=True):
+    async def _push_tensor(self, *, is_value=False, skip_no_grad=True):
+        future = self._send_push(is_value=is_value, skip_no_grad=skip_no_grad)
+        if future is not None:
+            await future
+
+    def _send_push(self, *, is_value=False, skip_no_grad=True):
+        # Push requests are sent before this returns, so the caller may
+        # wait for the returned future later; None means nothing to push.
         if self.is_dense:
-            return self._push_dense_tensor(is_value=is_value, skip_no_grad=skip_no_grad)
+            return self._send_dense_push(is_value=is_value, skip_no_grad=skip_no_grad)
         else:
-            return self._push_sparse_tensor(is_value=is_value, skip_no_grad=skip_no_grad)
+            return self._send_sparse_push(is_value=is_value, skip_no_grad=skip_no_grad)
 
-    async def _push_dense_tensor(self, *, is_value=False, skip_no_grad=True):
+    def _send_dense_push(self, *, is_value=False, skip_no_grad=True):
         data = self.item
         if self.is_dense_parameter:
             if not is_value and data.grad is None:
                 if skip_no_grad:
-                    return
+                    return None
                 raise RuntimeError(f"the gradient of parameter {self.name!r} is not available")
         # For dense buffers, use .data to fake gradients.
         # But we still need to pass is_value=False, otherwise updaters on server won't be called.
@@ -185,37 +215,44 @@ class DistributedTensor(object):
             future = loop.create_future()
             def push_dense_tensor_done():
                 loop.call_soon_threadsafe(future.set_result, None)
-            self._handle.push(data, push_dense_tensor_done, is_value, False)
+            def push_dense_tensor_failed(e):
+                loop.call_soon_threadsafe(future.set_exception, e)
+            self._handle.push(data, push_dense_tensor_done, push_dense_tensor_failed, is_value, False)
             return future
-        await push_dense_tensor()
+        return push_dense_tensor()
 
-    async def _push_sparse_tensor(self, *, is_value=False, skip_no_grad=True):
+    def _send_sparse_push(self, *, is_value=False, skip_no_grad=True):
         op = self.item
         keys, data = op.keys_and_data
         if keys is None:
-            return
+            return None
         if not is_value and data.grad is None:
             if skip_no_grad:
-                return
+                return None
             raise RuntimeError(f"the gradient of operator {op!r} is not available")
         data = data.data.numpy() if is_value else data.grad.data.numpy()
         op._check_dtype_and_shape(keys, data)
+        data = op._to_storage_ndarray(data)
         def push_sparse_tensor():
             loop = asyncio.get_running_loop()
             future = loop.create_future()
             def push_sparse_tensor_done():
                 loop.call_soon_threadsafe(future.set_result, None)
-            self._handle.push(keys, data, push_sparse_tensor_done, is_value)
+            def push_sparse_tensor_failed(e):
+                loop.call_soon_threadsafe(future.set_exception, e)
+            self._handle.push(keys, data, push_sparse_tensor_done, push_sparse_tensor_failed, is_value)
             return future
-        await push_sparse_tensor()
+        return push_sparse_tensor()
 
     def _load_tensor(self, dir_path, *, keep_meta=False):
         loop = asyncio.get_running_loop()
         future = loop.create_future()
         def load_tensor_done():
             loop.call_soon_threadsafe(future.set_result, None)
+        def load_tensor_failed(e):
+            loop.call_soon_threadsafe(future.set_exception, e)
         dir_path = use_s3(dir_path)
-        self._handle.load(dir_path, load_tensor_done, keep_meta)
+        self._handle.load(dir_path, load_tensor_done, load_tensor_failed, keep_meta)
         return future
 
     def _save_tensor(self, dir_path):
@@ -223,12 +260,14 @@ class DistributedTensor(object):
         future = loop.create_future()
         def save_tensor_done():
             loop.call_soon_threadsafe(future.set_result, None)
+        def save_tensor_failed(e):
+            loop.call_soon_threadsafe(future.set_exception, e)
         dir_path = use_s3(dir_path)
         if self.is_sparse:
             text_mode = self.item.save_as_text
-            self._handle.save(dir_path, save_tensor_done, text_mode)
+            self._handle.save(dir_path, save_tensor_done, save_tensor_failed, text_mode)
         else:
-            self._handle.save(dir_path, save_tensor_done)
+            self._handle.save(dir_path, save_tensor_done, save_tensor_failed)
         return future
 
     def _sparse_tensor_clear(self):
@@ -236,7 +275,9 @@ class DistributedTensor(object):
         future = loop.create_future()
         def sparse_tensor_clear_done():
             loop.call_soon_threadsafe(future.set_result, None)
-        self._handle.clear(sparse_tensor_clear_done)
+        def sparse_tensor_clear_failed(e):
+            loop.call_soon_threadsafe(future.set_exception, e)
+        self._handle.clear(sparse_tensor_clear_done, sparse_tensor_clear_failed)
         return future
 
     def _sparse_tensor_export(self, dir_path):
@@ -244,8 +285,10 @@ class DistributedTensor(object):
         future = loop.create_future()
         def sparse_tensor_export_done():
             loop.call_soon_threadsafe(future.set_result, None)
+        def sparse_tensor_export_failed(e):
+            loop.call_soon_threadsafe(future.set_exception, e)
         dir_path = use_s3(dir_path)
-        self._handle.export(dir_path, sparse_tensor_export_done)
+        self._handle.export(dir_path, sparse_tensor_export_done, sparse_tensor_export_failed)
         return future
 
     def _sparse_tensor_import_from(self, meta_file_path, *,
@@ -255,8 +298,10 @@ class DistributedTensor(object):
         future = loop.create_future()
         def sparse_tensor_import_from_done():
             loop.call_soon_threadsafe(future.set_result, None)
+        def sparse_tensor_import_from_failed(e):
+            loop.call_soon_threadsafe(future.set_exception, e)
         meta_file_path = use_s3(meta_file_path)
-        self._handle.import_from(meta_file_path, sparse_tensor_import_from_done,
+        self._handle.import_from(meta_file_path, sparse_tensor_import_from_done, sparse_tensor_import_from_failed,
                                  data_only, skip_existing,
                                  transform_key, feature_name)
         return future
@@ -266,7 +311,9 @@ class DistributedTensor(object):
         future = loop.create_future()
         def sparse_tensor_prune_small_done():
             loop.call_soon_threadsafe(future.set_result, None)
-        self._handle.prune_small(epsilon, sparse_tensor_prune_small_done)
+        def sparse_tensor_prune_small_failed(e):
+            loop.call_soon_threadsafe(future.set_exception, e)
+        self._handle.prune_small(epsilon, sparse_tensor_prune_small_done, sparse_tensor_prune_small_failed)
         return future
 
     def _sparse_tensor_prune_old(self, max_age):
@@ -274,5 +321,7 @@ class DistributedTensor(object):
         future = loop.create_future()
         def sparse_tensor_prune_old_done():
             loop.call_soon_threadsafe(future.set_result, None)
-        self._handle.prune_old(max_age, sparse_tensor_prune_old_done)
+        def sparse_tensor_prune_old_failed(e):
+            loop.call_soon_threadsafe(future.set_exception, e)
+        self._handle.prune_old(max_age, sparse_tensor_prune_old_done, sparse_tensor_prune_old_failed)
         return future
@@ -37,6 +37,9 @@ class DistributedTrainer(object):
         self._updater = updater
         self._initializer = initializer
         self._skip_no_grad = True
+        self._delayed_push = False
+        self._push_loop = None
+        self._pending_push = None
 
     @property
     def model(self):
@@ -62,8 +65,36 @@ class DistributedTrainer(object):
     def skip_no_grad(self, value):
         self._skip_no_grad = value
 
+    @property
+    def delayed_push(self):
+        return self._delayed_push
+
+    @delayed_push.setter
+    def delayed_push(self, value):
+        # With delayed push, ``train`` returns once the gradients are sent
+        # and their acknowledgements are waited for by the next ``train``,
+        # so the round trip overlaps with the next minibatch.
+        if not isinstance(value, bool):
+            raise TypeError(f"delayed_push must be bool; {value!r} is invalid")
+        if not value:
+            self.flush()
+        self._delayed_push = value
+
+    def flush(self):
+        # Wait for the push of the last minibatch under delayed push.
+        # Call this before reading parameters back from the servers.
+        if self._pending_push is None:
+            return
+        futures = self._pending_push
+        self._pending_push = None
+        self._push_loop.run_until_complete(asyncio.gather(*futures))
+
+    async def _send_push_requests(self):
+        return self.model._send_push_requests(skip_no_grad=self.skip_no_grad)
+
     def _get_dtype_name(self, tensor):
-        return str(tensor.item.dtype).rpartition('.')[-1]
+        dtype = getattr(tensor.item, 'storage_dtype', tensor.item.dtype)
+        return str(dtype).rpartition('.')[-1]
 
     def _get_dense_initializer(self, tensor):
         initializer = getattr(tensor.item, 'initializer', None)
@@ -142,6 +173,7 @@ class DistributedTrainer(object):
         self.agent.barrier()
 
     def load(self, dir_path, *, keep_meta=False):
+        self.flush()
         # When spare tensors are repartitioned, we need to make
         # sure sparse tensors are cleared, as ``import_from``
         # won't clear or override existing keys. Make sure this
@@ -160,6 +192,7 @@ class DistributedTrainer(object):
         self.agent.barrier()
 
     def save(self, dir_path):
+        self.flush()
         self.agent.barrier()
         if self.agent.rank == 0:
             asyncio.run(self.model._save_tensors(dir_path))
@@ -170,6 +203,14 @@ class DistributedTrainer(object):
             message = "model is in evaluation mode, can not train it; "
             message += "call the 'train' method to set it in training mode explicitly"
             raise RuntimeError(message)
+        # Gradients of dense parameters are zeroed in place, so the push
+        # reading them must be complete first.
+        self.flush()
         self.model._zero_grad()
         loss.backward()
-        asyncio.run(self.model._push_tensors(skip_no_grad=self.skip_no_grad))
+        if not self.delayed_push:
+            asyncio.run(self.model._push_tensors(skip_no_grad=self.skip_no_grad))
+            return
+        if self._push_loop is None:
+            self._push_loop = asyncio.new_event_loop()
+        self._pending_push = self._push_loop.run_until_complete(self._send_push_requests())
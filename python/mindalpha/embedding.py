@@ -34,6 +34,7 @@ class EmbeddingOperator(torch.nn.Module):
                  combine_schema_file_path=None,
                  delimiter=None,
                  dtype=torch.float32,
+                 storage_dtype=None,
                  requires_grad=True,
                  updater=None,
                  initializer=None,
@@ -42,6 +43,11 @@ class EmbeddingOperator(torch.nn.Module):
                  use_nan_fill=False,
                  save_as_text=False,
                  embedding_bag_mode='sum',
+                 hash_map_engine='chained',
+                 memory_buffer_backend='malloc',
+                 gradient_codec='none',
+                 key_partitioner='modulo',
+                 pull_cache=None,
                 ):
         if embedding_size is not None:
             if not isinstance(embedding_size, int) or embedding_size <= 0:
@@ -57,6 +63,8 @@ class EmbeddingOperator(torch.nn.Module):
                 raise TypeError(f"delimiter must be string of length 1; {delimiter!r} is invalid")
         if dtype not in (torch.float32, torch.float64):
             raise TypeError(f"dtype must be one of: torch.float32, torch.float64; {dtype!r} is invalid")
+        if storage_dtype is not None and storage_dtype not in (torch.float16, torch.bfloat16):
+            raise TypeError(f"storage_dtype must be one of: None, torch.float16, torch.bfloat16; {storage_dtype!r} is invalid")
         if updater is not None:
             if not isinstance(updater, TensorUpdater):
                 raise TypeError(f"updater must be TensorUpdater; {updater!r} is invalid")
@@ -67,12 +75,18 @@ class EmbeddingOperator(torch.nn.Module):
             if not isinstance(alternative_column_name_file_path, str) or not file_exists(alternative_column_name_file_path):
                 raise RuntimeError(f"alternative column name file {alternative_column_name_file_path!r} not found")
         self._check_embedding_bag_mode(embedding_bag_mode)
+        self._check_hash_map_engine(hash_map_engine)
+        self._check_memory_buffer_backend(memory_buffer_backend)
+        self._check_gradient_codec(gradient_codec)
+        self._check_key_partitioner(key_partitioner)
+        self._check_pull_cache(pull_cache)
         super().__init__()
         self._embedding_size = embedding_size
         self._column_name_file_path = column_name_file_path
         self._combine_schema_file_path = combine_schema_file_path
         self._delimiter = delimiter
         self._dtype = dtype
+        self._storage_dtype = storage_dtype
         self._requires_grad = requires_grad
         self._updater = updater
         self._initializer = initializer
@@ -83,6 +97,11 @@ class EmbeddingOperator(torch.nn.Module):
         self._use_nan_fill = use_nan_fill
         self._save_as_text = save_as_text
         self._embedding_bag_mode = embedding_bag_mode
+        self._hash_map_engine = hash_map_engine
+        self._memory_buffer_backend = memory_buffer_backend
+        self._gradient_codec = gradient_codec
+        self._key_partitioner = key_partitioner
+        self._pull_cache = pull_cache
         self._distributed_tensor = None
         self._combine_schema_source = None
         self._combine_schema = None
@@ -132,6 +151,8 @@ class EmbeddingOperator(torch.nn.Module):
             args.append(f"delimiter={self._delimiter!r}")
         if self._dtype is not None and self._dtype is not torch.float32:
             args.append(f"dtype={self._dtype}")
+        if self._storage_dtype is not None:
+            args.append(f"storage_dtype={self._storage_dtype}")
         if not self._requires_grad:
             args.append("requires_grad=False")
         if self._updater is not None:
@@ -146,6 +167,16 @@ class EmbeddingOperator(torch.nn.Module):
             args.append(f"use_nan_fill={self._use_nan_fill!r}")
         if self._save_as_text:
             args.append(f"save_as_text={self._save_as_text!r}")
+        if self._hash_map_engine != 'chained':
+            args.append(f"hash_map_engine={self._hash_map_engine!r}")
+        if self._memory_buffer_backend != 'malloc':
+            args.append(f"memory_buffer_backend={self._memory_buffer_backend!r}")
+        if self._gradient_codec != 'none':
+            args.append(f"gradient_codec={self._gradient_codec!r}")
+        if self._key_partitioner != 'modulo':
+            args.append(f"key_partitioner={self._key_partitioner!r}")
+        if self._pull_cache is not None:
+            args.append(f"pull_cache={self._pull_cache!r}")
         return f"{self.__class__.__name__}({', '.join(args)})"
 
     @property
@@ -292,6 +323,11 @@ class EmbeddingOperator(torch.nn.Module):
     def dtype(self):
         return self._dtype
 
+    @property
+    @torch.jit.unused
+    def storage_dtype(self):
+        return self._storage_dtype or self._dtype
+
     @property
     @torch.jit.unused
     def requires_grad(self):
@@ -370,6 +406,61 @@ class EmbeddingOperator(torch.nn.Module):
     def embedding_bag_mode(self, value):
         self._embedding_bag_mode = value
 
+    @property
+    @torch.jit.unused
+    def hash_map_engine(self):
+        return self._hash_map_engine
+
+    @hash_map_engine.setter
+    @torch.jit.unused
+    def hash_map_engine(self, value):
+        self._check_hash_map_engine(value)
+        self._hash_map_engine = value
+
+    @property
+    @torch.jit.unused
+    def memory_buffer_backend(self):
+        return self._memory_buffer_backend
+
+    @memory_buffer_backend.setter
+    @torch.jit.unused
+    def memory_buffer_backend(self, value):
+        self._check_memory_buffer_backend(value)
+        self._memory_buffer_backend = value
+
+    @property
+    @torch.jit.unused
+    def gradient_codec(self):
+        return self._gradient_codec
+
+    @gradient_codec.setter
+    @torch.jit.unused
+    def gradient_codec(self, value):
+        self._check_gradient_codec(value)
+        self._gradient_codec = value
+
+    @property
+    @torch.jit.unused
+    def key_partitioner(self):
+        return self._key_partitioner
+
+    @key_partitioner.setter
+    @torch.jit.unused
+    def key_partitioner(self, value):
+        self._check_key_partitioner(value)
+        self._key_partitioner = value
+
+    @property
+    @torch.jit.unused
+    def pull_cache(self):
+        return self._pull_cache
+
+    @pull_cache.setter
+    @torch.jit.unused
+    def pull_cache(self, value):
+        self._check_pull_cache(value)
+        self._pull_cache = value
+
     @property
     @torch.jit.unused
     def _is_clean(self):
@@ -465,6 +556,27 @@ class EmbeddingOperator(torch.nn.Module):
             return
         raise RuntimeError(f"keys and data of {self!r} must be both None or both not None")
 
+    @torch.jit.unused
+    def _from_storage_ndarray(self, data):
+        # Half precision data pulled from servers is widened to ``dtype``;
+        # bfloat16 arrives as uint16 as numpy has no bfloat16.
+        if self._storage_dtype is None:
+            return data
+        if self._storage_dtype is torch.bfloat16:
+            data = torch.from_numpy(data.view(numpy.int16)).view(torch.bfloat16)
+        else:
+            data = torch.from_numpy(data)
+        return data.to(self._dtype).numpy()
+
+    @torch.jit.unused
+    def _to_storage_ndarray(self, data):
+        if self._storage_dtype is None:
+            return data
+        data = torch.from_numpy(data).to(self._storage_dtype)
+        if self._storage_dtype is torch.bfloat16:
+            return data.view(torch.int16).numpy().view(numpy.uint16)
+        return data.numpy()
+
     @torch.jit.unused
     def _update_data(self, data):
         self._data = torch.from_numpy(data)
@@ -493,11 +605,77 @@ class EmbeddingOperator(torch.nn.Module):
         self._indices, self._indices_meta = self._do_combine(ndarrays)
         self._keys = self._uniquify_hash_codes(self._indices)
 
+    @torch.jit.unused
+    def _prefetch_indices_and_offsets(self, prefetcher, ndarrays, feature_offset):
+        # Splitting the columns needs the GIL, the rest is done by the
+        # background thread of ``prefetcher``.
+        delim = self._checked_get_delimiter()
+        batch = IndexBatch(ndarrays, delim)
+        read_only = not self.training or not self.requires_grad
+        nan_fill = read_only and self.use_nan_fill
+        handle = self._distributed_tensor._handle
+        prefetcher.submit(handle, self._combine_schema, batch, feature_offset, read_only, nan_fill)
+
+    @torch.jit.unused
+    def _do_prefetch(self, prefetcher, ndarrays):
+        raise NotImplementedError
+
+    @torch.jit.unused
+    def _prefetch(self, prefetcher, ndarrays):
+        self._ensure_combine_schema_loaded()
+        self._do_prefetch(prefetcher, ndarrays)
+
+    @torch.jit.unused
+    def _take_prefetched(self, prefetcher):
+        indices, offsets, keys, data = prefetcher.take()
+        data = self._from_storage_ndarray(data)
+        self._check_dtype_and_shape(keys, data)
+        self._clean()
+        self._indices, self._indices_meta, self._keys = indices, offsets, keys
+        self._update_data(data)
+
     @torch.jit.unused
     def _check_embedding_bag_mode(self, mode):
         if mode not in ('mean', 'sum', 'max'):
             raise ValueError(f"embedding bag mode must be one of: 'mean', 'sum', 'max'; {mode!r} is invalid")
 
+    @torch.jit.unused
+    def _check_hash_map_engine(self, engine):
+        if engine not in ('chained', 'open_addressing'):
+            raise ValueError(f"hash map engine must be one of: 'chained', 'open_addressing'; {engine!r} is invalid")
+
+    @torch.jit.unused
+    def _check_memory_buffer_backend(self, backend):
+        if backend not in ('malloc', 'mmap', 'huge_page', 'huge_tlb'):
+            raise ValueError(f"memory buffer backend must be one of: 'malloc', 'mmap', 'huge_page', 'huge_tlb'; "
+                             f"{backend!r} is invalid")
+
+    @torch.jit.unused
+    def _check_gradient_codec(self, codec):
+        if codec not in ('none', 'float16', 'bfloat16', 'int8'):
+            raise ValueError(f"gradient codec must be one of: 'none', 'float16', 'bfloat16', 'int8'; {codec!r} is invalid")
+
+    @torch.jit.unused
+    def _check_key_partitioner(self, partitioner):
+        if partitioner not in ('modulo', 'jump_hash', 'ring'):
+            raise ValueError(f"key partitioner must be one of: 'modulo', 'jump_hash', 'ring'; {partitioner!r} is invalid")
+
+    @torch.jit.unused
+    def _check_pull_cache(self, cache):
+        if cache is None:
+            return
+        keys = ('capacity', 'eviction', 'admission_count', 'max_staleness_steps', 'max_staleness_ms')
+        if not isinstance(cache, dict) or not set(cache).issubset(keys):
+            raise TypeError(f"pull_cache must be None or dict with keys in {keys!r}; {cache!r} is invalid")
+        capacity = cache.get('capacity')
+        if not isinstance(capacity, int) or capacity <= 0:
+            raise ValueError(f"pull_cache capacity must be positive integer; {capacity!r} is invalid")
+        eviction = cache.get('eviction', 'lru')
+        if eviction not in ('lru', 'lfu'):
+            raise ValueError(f"pull_cache eviction must be one of: 'lru', 'lfu'; {eviction!r} is invalid")
+        if not cache.get('max_staleness_steps') and not cache.get('max_staleness_ms'):
+            raise ValueError(f"pull_cache requires max_staleness_steps or max_staleness_ms; {cache!r} is invalid")
+
     @torch.jit.unused
     def _compute_sum_concat(self):
         self._check_embedding_bag_mode(self.embedding_bag_mode)
@@ -611,6 +789,10 @@ class EmbeddingSumConcat(EmbeddingOperator):
     def _do_combine(self, ndarrays):
         return self._combine_to_indices_and_offsets(ndarrays, True)
 
+    @torch.jit.unused
+    def _do_prefetch(self, prefetcher, ndarrays):
+        return self._prefetch_indices_and_offsets(prefetcher, ndarrays, True)
+
     @torch.jit.unused
     def _do_compute(self):
         return self._compute_sum_concat()
@@ -625,6 +807,10 @@ class EmbeddingRangeSum(EmbeddingOperator):
     def _do_combine(self, ndarrays):
         return self._combine_to_indices_and_offsets(ndarrays, False)
 
+    @torch.jit.unused
+    def _do_prefetch(self, prefetcher, ndarrays):
+        return self._prefetch_indices_and_offsets(prefetcher, ndarrays, False)
+
     @torch.jit.unused
     def _do_compute(self):
         return self._compute_range_sum()
@@ -639,6 +825,10 @@ class EmbeddingLookup(EmbeddingOperator):
     def _do_combine(self, ndarrays):
         return self._combine_to_indices_and_offsets(ndarrays, True)
 
+    @torch.jit.unused
+    def _do_prefetch(self, prefetcher, ndarrays):
+        return self._prefetch_indices_and_offsets(prefetcher, ndarrays, True)
+
     @torch.jit.unused
     def _do_compute(self):
         return self._compute_embedding_lookup()
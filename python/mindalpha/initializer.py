@@ -121,6 +121,68 @@ class NormalTensorInitializer(TensorInitializer):
         else:
             torch.nn.init.normal_(data, self._mean, self._var)
 
+class UniformTensorInitializer(TensorInitializer):
+    def __init__(self, a=0.0, b=1.0):
+        if not isinstance(a, float):
+            message = "a must be float; "
+            message += "%r is invalid" % a
+            raise ValueError(message)
+        if not isinstance(b, float) or b <= a:
+            message = "b must be float greater than a; "
+            message += "%r is invalid" % b
+            raise ValueError(message)
+        self._a = a
+        self._b = b
+
+    def __repr__(self):
+        return '%s(%r, %r)' % (self.__class__.__name__,
+                               self._a,
+                               self._b)
+
+    def initialize_dense(self, name, data):
+        self.initialize_tensor(name, data)
+
+    def initialize_sparse(self, name, data, keys):
+        self.initialize_tensor(name, data)
+
+    def initialize_tensor(self, name, data):
+        torch.nn.init.uniform_(data, self._a, self._b)
+
+class TruncatedNormalTensorInitializer(TensorInitializer):
+    def __init__(self, mean=0.0, std=1.0, a=-2.0, b=2.0):
+        if not isinstance(mean, float):
+            message = "mean must be float; "
+            message += "%r is invalid" % mean
+            raise ValueError(message)
+        if not isinstance(std, float) or std <= 0.0:
+            message = "std must be positive float; "
+            message += "%r is invalid" % std
+            raise ValueError(message)
+        if not isinstance(a, float) or not isinstance(b, float) or not (a <= mean <= b) or a == b:
+            message = "a and b must be floats with a <= mean <= b and a < b; "
+            message += "%r and %r are invalid" % (a, b)
+            raise ValueError(message)
+        self._mean = mean
+        self._std = std
+        self._a = a
+        self._b = b
+
+    def __repr__(self):
+        return '%s(%r, %r, %r, %r)' % (self.__class__.__name__,
+                                       self._mean,
+                                       self._std,
+                                       self._a,
+                                       self._b)
+
+    def initialize_dense(self, name, data):
+        self.initialize_tensor(name, data)
+
+    def initialize_sparse(self, name, data, keys):
+        self.initialize_tensor(name, data)
+
+    def initialize_tensor(self, name, data):
+        torch.nn.init.trunc_normal_(data, self._mean, self._std, self._a, self._b)
+
 class XavierTensorInitializer(TensorInitializer):
     def __init__(self, activation_type='relu', distribution_type='uniform'):
         if distribution_type not in ('uniform', 'normal'):
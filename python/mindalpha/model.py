@@ -217,13 +217,15 @@ class Model(object):
             futures.append(future)
         await asyncio.gather(*futures)
 
-    async def _pull_tensors(self, *, force_mode=False):
+    async def _pull_tensors(self, *, force_mode=False, dense_only=False):
         futures = []
         for tensor in self._tensors:
             if not force_mode:
                 # Pulling dense parameters in prediction mode is redundant.
                 if not self.training and tensor.is_dense:
                     continue
+            if dense_only and not tensor.is_dense:
+                continue
             if not tensor.is_backing:
                 future = tensor._pull_tensor()
                 futures.append(future)
@@ -237,6 +239,17 @@ class Model(object):
                 futures.append(future)
         await asyncio.gather(*futures)
 
+    def _send_push_requests(self, *, skip_no_grad=True):
+        # Must be called with an event loop running; the returned futures
+        # complete on that loop.
+        futures = []
+        for tensor in self._tensors:
+            if not tensor.is_backing:
+                future = tensor._send_push(skip_no_grad=skip_no_grad)
+                if future is not None:
+                    futures.append(future)
+        return futures
+
     async def _clear_tensors(self):
         pass
 
@@ -405,13 +418,46 @@ class SparseModel(Model):
         super().__init__(agent, module, experiment_name, model_version, name_prefix)
         self._embedding_operators = []
         self._cast_operators = []
+        self._prefetch_depth = 1
+        self._prefetcher = None
+        self._prefetched = collections.deque()
 
     def get_submodel(self, submodule, name_prefix):
         submodel = super().get_submodel(submodule, name_prefix)
         submodel._embedding_operators = self._filter_tensor_list(self._embedding_operators, name_prefix)
         submodel._cast_operators = self._filter_tensor_list(self._cast_operators, name_prefix)
+        submodel._prefetch_depth = self._prefetch_depth
+        submodel._prefetcher = None
+        submodel._prefetched = collections.deque()
         return submodel
 
+    @property
+    def prefetch_depth(self):
+        return self._prefetch_depth
+
+    @prefetch_depth.setter
+    def prefetch_depth(self, value):
+        if not isinstance(value, int) or value <= 0:
+            raise TypeError(f"prefetch_depth must be positive integer; {value!r} is invalid")
+        if self._prefetched:
+            raise RuntimeError("can not change prefetch_depth while minibatches are prefetched")
+        self._prefetch_depth = value
+        self._prefetcher = None
+
+    def prefetch(self, ndarrays):
+        # Combine, uniquify and pull the sparse features of a later minibatch
+        # on a background thread while the current one computes. Passing the
+        # same ``ndarrays`` to ``__call__`` consumes the result; minibatches
+        # must be consumed in the order they are prefetched. Prefetched rows
+        # may miss the updates of up to ``prefetch_depth`` minibatches.
+        operators = [tensor.item for tensor in self._embedding_operators if not tensor.is_backing]
+        if self._prefetcher is None:
+            depth = self._prefetch_depth * max(len(operators), 1)
+            self._prefetcher = _mindalpha.EmbeddingPrefetcher(depth)
+        for op in operators:
+            op._prefetch(self._prefetcher, ndarrays)
+        self._prefetched.append(ndarrays)
+
     def _collect_embedding_operators(self):
         for name, mod in self.module.named_modules():
             if isinstance(mod, EmbeddingOperator):
@@ -524,8 +570,23 @@ class SparseModel(Model):
             if not tensor.is_backing:
                 tensor.item._combine(ndarrays)
 
-    def _execute_pull(self):
-        asyncio.run(self._pull_tensors())
+    def _execute_take_prefetched(self, ndarrays):
+        if self._prefetched[0] is not ndarrays:
+            raise RuntimeError("ndarrays is not the oldest prefetched minibatch")
+        self._prefetched.popleft()
+        try:
+            for tensor in self._embedding_operators:
+                if not tensor.is_backing:
+                    tensor.item._take_prefetched(self._prefetcher)
+        except:
+            # The remaining tasks are out of step with the minibatches,
+            # drop them all.
+            self._prefetcher = None
+            self._prefetched.clear()
+            raise
+
+    def _execute_pull(self, *, dense_only=False):
+        asyncio.run(self._pull_tensors(dense_only=dense_only))
 
     def _execute_compute(self):
         for tensor in self._embedding_operators:
@@ -537,8 +598,12 @@ class SparseModel(Model):
             mod._cast(ndarrays)
 
     def __call__(self, ndarrays):
-        self._execute_combine(ndarrays)
-        self._execute_pull()
+        if self._prefetched:
+            self._execute_take_prefetched(ndarrays)
+            self._execute_pull(dense_only=True)
+        else:
+            self._execute_combine(ndarrays)
+            self._execute_pull()
         self._execute_compute()
         self._execute_cast(ndarrays)
         fake_input = torch.tensor(0.0)
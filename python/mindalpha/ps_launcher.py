@@ -19,6 +19,12 @@ class PSLauncher(object):
         self._agent_class = None
         self._worker_count = None
         self._server_count = None
+        self._server_thread_count = None
+        self._server_parallel_thread_count = None
+        self._transport_type = None
+        self._zeromq_io_thread_count = None
+        self._shared_memory_ring_size = None
+        self._send_timeout = None
         self._job_name = None
         self._keep_session = None
         self._spark_log_level = None
@@ -33,6 +39,22 @@ class PSLauncher(object):
             help="PS worker count")
         parser.add_argument('-s', '--server-count', type=int, required=True,
             help="PS server count")
+        parser.add_argument('-t', '--server-thread-count', type=int, default=0,
+            help="PS server request thread count; default to 0, handling requests in the receiving thread")
+        parser.add_argument('-p', '--server-parallel-thread-count', type=int, default=0,
+            help="PS server helper thread count for large requests; default to 0, processing them serially")
+        parser.add_argument('--transport-type', type=str, default='ZeroMQ',
+            choices=('ZeroMQ', 'SharedMemory', 'TCP'),
+            help="message transport between nodes; SharedMemory uses /dev/shm rings "
+                 "between nodes on the same host and ZeroMQ otherwise, TCP uses plain "
+                 "sockets instead of ZeroMQ; default to ZeroMQ")
+        parser.add_argument('--zeromq-io-thread-count', type=int, default=1,
+            help="ZeroMQ I/O thread count of each node; default to 1")
+        parser.add_argument('--shared-memory-ring-size', type=int, default=64 * 1024 * 1024,
+            help="size in bytes of each shared memory ring; default to 64 MiB")
+        parser.add_argument('--send-timeout', type=int, default=60 * 1000,
+            help="milliseconds a send may wait for room in a shared memory ring, "
+                 "or for a TCP connection to the peer, before it fails; default to 60000")
         parser.add_argument('-j', '--job-name', type=str, required=True,
             help="Spark job name")
         parser.add_argument('-k', '--keep-session', action='store_true',
@@ -46,6 +68,12 @@ class PSLauncher(object):
         self._agent_class = args.agent_class
         self._worker_count = self._get_node_count(args, 'worker')
         self._server_count = self._get_node_count(args, 'server')
+        self._server_thread_count = args.server_thread_count
+        self._server_parallel_thread_count = args.server_parallel_thread_count
+        self._transport_type = args.transport_type
+        self._zeromq_io_thread_count = args.zeromq_io_thread_count
+        self._shared_memory_ring_size = args.shared_memory_ring_size
+        self._send_timeout = args.send_timeout
         self._job_name = args.job_name
         self._keep_session = args.keep_session
         self._spark_log_level = args.spark_log_level
@@ -140,6 +168,12 @@ class PSLauncher(object):
             args = dict()
             args['worker_count'] = self._worker_count
             args['server_count'] = self._server_count
+            args['server_thread_count'] = self._server_thread_count
+            args['server_parallel_thread_count'] = self._server_parallel_thread_count
+            args['transport_type'] = self._transport_type
+            args['zeromq_io_thread_count'] = self._zeromq_io_thread_count
+            args['shared_memory_ring_size'] = self._shared_memory_ring_size
+            args['send_timeout'] = self._send_timeout
             args['agent_attributes'] = self._agent_attributes
             asyncio.run(class_._launch(args, spark_session, self))
         finally:
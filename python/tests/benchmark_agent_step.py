@@ -0,0 +1,80 @@
+#
+# Copyright 2021 Mobvista
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+
+# Measure the per-step latency of a worker that pulls and then pushes many
+# dense tensors, with the requests of a step issued one at a time, as the
+# blocking PSAgent calls used to force, and all in flight at once.
+#
+# Run with ``python python/tests/benchmark_agent_step.py`` from the repo
+# root; it needs the ``_mindalpha`` extension to be built.
+
+import argparse
+import time
+import numpy
+from local_job import run_local_job
+from local_job import start
+from local_job import wait
+from test_local_mode import make_dense_tensor
+
+def run_step(tensors, value, concurrent):
+    pulls = [lambda done, failed, x=x: x.pull(done, failed, False) for x in tensors]
+    pushes = [lambda done, failed, x=x: x.push(value, done, failed, True, False) for x in tensors]
+    for ops in pulls, pushes:
+        if concurrent:
+            for future in [start(op) for op in ops]:
+                future.result()
+        else:
+            for op in ops:
+                wait(op)
+
+def measure(tensors, value, concurrent, steps):
+    run_step(tensors, value, concurrent)
+    latencies = []
+    for i in range(steps):
+        begin = time.perf_counter()
+        run_step(tensors, value, concurrent)
+        latencies.append(time.perf_counter() - begin)
+    return numpy.array(latencies) * 1000.0
+
+def main():
+    parser = argparse.ArgumentParser(description='PSAgent per-step latency benchmark')
+    parser.add_argument('--tensors', type=int, default=50)
+    parser.add_argument('--rows', type=int, default=256)
+    parser.add_argument('--cols', type=int, default=64)
+    parser.add_argument('--servers', type=int, default=4)
+    parser.add_argument('--steps', type=int, default=100)
+    parser.add_argument('--transport', type=str, default='InProcess')
+    args = parser.parse_args()
+    shape = args.rows, args.cols
+    value = numpy.ones(shape, dtype=numpy.float32)
+    def body(agent):
+        tensors = [make_dense_tensor(agent, 'step_benchmark_%d' % i, shape) for i in range(args.tensors)]
+        results = dict()
+        for mode, concurrent in ('sequential', False), ('concurrent', True):
+            results[mode] = measure(tensors, value, concurrent, args.steps)
+        for x in tensors:
+            wait(lambda done, failed: x.dispose(done, failed))
+        return results
+    results = run_local_job(body, server_count=args.servers, transport_type=args.transport)
+    print('%d tensors of %dx%d float32, %d servers, %s transport' %
+          (args.tensors, args.rows, args.cols, args.servers, args.transport))
+    for mode, latencies in results.items():
+        print('%-10s  mean %8.2f ms  p50 %8.2f ms  p99 %8.2f ms' %
+              (mode, latencies.mean(), numpy.percentile(latencies, 50), numpy.percentile(latencies, 99)))
+
+if __name__ == '__main__':
+    main()
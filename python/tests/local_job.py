@@ -0,0 +1,64 @@
+#
+# Copyright 2021 Mobvista
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+
+# Helpers to run a local mode PS job inside a test. The coordinator, the
+# servers and the workers are threads of the test process and, unless the
+# test asks for another transport, pass messages in process.
+
+import concurrent.futures
+from mindalpha.agent import Agent
+from mindalpha._mindalpha import PSRunner
+from mindalpha.network_utils import get_available_endpoint
+
+def run_local_job(body, **args):
+    # Run ``body(agent)`` on the coordinator of a local mode job and return
+    # its result once all the nodes have stopped. ``args`` override the
+    # actor config arguments accepted by ``Agent._get_actor_config``.
+    outcome = dict()
+    class JobAgent(Agent):
+        def run(self):
+            try:
+                outcome['result'] = body(self)
+            except BaseException as e:
+                outcome['error'] = e
+    ip, port = get_available_endpoint()
+    job_args = dict(root_uri=ip,
+                    root_port=port,
+                    node_role='Coordinator',
+                    server_count=1,
+                    worker_count=1,
+                    is_local_mode=True,
+                    agent_creator=JobAgent._create_agent)
+    job_args.update(args)
+    conf = Agent._get_actor_config(job_args)
+    PSRunner.run_ps(conf)
+    if 'error' in outcome:
+        raise outcome['error']
+    return outcome.get('result')
+
+def start(op):
+    # ``op(done, failed)`` issues an asynchronous tensor operation with the
+    # given callbacks; return a future for what it passes to ``done``.
+    future = concurrent.futures.Future()
+    def done(*result):
+        future.set_result(result[0] if result else None)
+    op(done, future.set_exception)
+    return future
+
+def wait(op):
+    # Issue ``op`` like ``start`` does and wait for its result.
+    return start(op).result()
@@ -0,0 +1,88 @@
+#
+# Copyright 2021 Mobvista
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+
+# Check that local mode jobs run on the in-process transport by default
+# and that tensors work over it.
+#
+# Run with ``python -m unittest discover python/tests``; it needs the
+# ``_mindalpha`` extension to be built.
+
+import unittest
+import numpy
+from mindalpha.agent import Agent
+from mindalpha._mindalpha import DenseTensor
+from local_job import run_local_job
+from local_job import wait
+
+def make_dense_tensor(agent, name, shape):
+    x = DenseTensor()
+    x.name = name
+    x.data_type = 'float32'
+    x.data_shape = shape
+    x.state_shape = ()
+    x.partition_count = agent.server_count
+    x.agent = agent._cxx_agent
+    wait(lambda done, failed: x.init(done, failed))
+    return x
+
+class LocalModeTest(unittest.TestCase):
+    def test_default_transport(self):
+        args = dict(root_uri='localhost',
+                    root_port=0,
+                    node_role='Coordinator',
+                    server_count=1,
+                    worker_count=1)
+        self.assertEqual(Agent._get_actor_config(args).transport_type, 'ZeroMQ')
+        args.update(is_local_mode=True)
+        self.assertEqual(Agent._get_actor_config(args).transport_type, 'InProcess')
+        args.update(transport_type='ZeroMQ')
+        self.assertEqual(Agent._get_actor_config(args).transport_type, 'ZeroMQ')
+
+    def test_dense_push_pull(self):
+        value = numpy.arange(32, dtype=numpy.float32).reshape(8, 4)
+        def body(agent):
+            x = make_dense_tensor(agent, 'local_mode_dense', value.shape)
+            wait(lambda done, failed: x.push(value, done, failed, True, False))
+            pulled = wait(lambda done, failed: x.pull(done, failed, False))
+            pulled = pulled.copy()
+            wait(lambda done, failed: x.dispose(done, failed))
+            return pulled
+        pulled = run_local_job(body, server_count=2)
+        self.assertTrue(numpy.array_equal(pulled, value))
+
+    def test_dense_pull_is_not_changed_by_later_push(self):
+        # Send a push right behind each pull. Servers handle them in order,
+        # so the pulled values must be the ones from before the push, even
+        # when the response is combined after the push has been applied.
+        shape = 1024, 1024
+        def body(agent):
+            x = make_dense_tensor(agent, 'local_mode_dense_race', shape)
+            mismatches = 0
+            for i in range(20):
+                value = numpy.full(shape, i, dtype=numpy.float32)
+                wait(lambda done, failed: x.push(value, done, failed, True, False))
+                pulls = []
+                x.pull(lambda data: pulls.append(data.copy()), None, False)
+                wait(lambda done, failed: x.push(value + 1, done, failed, True, False))
+                if len(pulls) != 1 or not numpy.array_equal(pulls[0], value):
+                    mismatches += 1
+            wait(lambda done, failed: x.dispose(done, failed))
+            return mismatches
+        self.assertEqual(run_local_job(body, server_count=1), 0)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,151 @@
+#
+# Copyright 2021 Mobvista
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+
+# Check that the native sparse updaters applied by servers produce the same
+# bits as the Python versions in ``mindalpha/updater.py``. The gradients are
+# pushed to sparse tensors of a local mode job, so the rows go through the
+# same partitioning and server push path as in training. Half precision
+# data is compared against the Python updaters run in float32 and rounded
+# back, which is how the native kernels define it.
+#
+# Run with ``python -m unittest discover python/tests``; it needs the
+# ``_mindalpha`` extension to be built.
+
+import unittest
+import numpy
+import torch
+from mindalpha._mindalpha import SparseTensor
+from mindalpha.updater import SGDTensorUpdater
+from mindalpha.updater import AdaGradTensorUpdater
+from mindalpha.updater import AdamTensorUpdater
+from mindalpha.updater import FTRLTensorUpdater
+from local_job import run_local_job
+from local_job import wait
+
+UPDATERS = {
+    'sgd' : lambda: SGDTensorUpdater(0.1),
+    'adagrad' : lambda: AdaGradTensorUpdater(0.1, 1e-6, 0.01),
+    'adam' : lambda: AdamTensorUpdater(0.01),
+    'ftrl' : lambda: FTRLTensorUpdater(0.5, 1.0, 0.5, 1.0),
+}
+DATA_TYPES = 'float32', 'float64', 'float16', 'bfloat16'
+WIDTHS = 1, 7, 16, 33
+SLICE_ROWS = 1, 3
+TABLE_ROWS = 64
+ROUNDS = 20
+SERVER_COUNT = 2
+
+def to_storage(tensor, data_type):
+    if data_type == 'bfloat16':
+        return tensor.to(torch.bfloat16).view(torch.int16).numpy().view(numpy.uint16)
+    return tensor.to(getattr(torch, data_type)).numpy()
+
+def widen(array, data_type):
+    if data_type == 'bfloat16':
+        return torch.from_numpy(array.view(numpy.int16)).view(torch.bfloat16).float().numpy()
+    if data_type == 'float16':
+        return array.astype(numpy.float32)
+    return array
+
+def same_bits(x, y):
+    return x.shape == y.shape and numpy.array_equal(x.view(numpy.uint8), y.view(numpy.uint8))
+
+class Case(object):
+    def __init__(self, name, data_type, width, slice_rows):
+        self.name = name
+        self.data_type = data_type
+        self.width = width
+        self.slice_rows = slice_rows
+        self.slice_shape = (width,) if slice_rows == 1 else (slice_rows, width)
+        self.keys = numpy.arange(1, TABLE_ROWS + 1, dtype=numpy.uint64)
+        rng = numpy.random.default_rng(width * 10 + slice_rows)
+        self.data = to_storage(torch.from_numpy(rng.standard_normal((TABLE_ROWS,) + self.slice_shape)), data_type)
+        self.rounds = []
+        for _ in range(ROUNDS):
+            indices = rng.permutation(TABLE_ROWS)[:TABLE_ROWS // 2].astype(numpy.uint64)
+            grad = to_storage(torch.from_numpy(rng.standard_normal((len(indices),) + self.slice_shape)), data_type)
+            self.rounds.append((indices, grad))
+
+    def __str__(self):
+        return 'native_updater_%s_%s_%d_%d' % (self.name, self.data_type, self.width, self.slice_rows)
+
+    def get_state_shape(self, updater):
+        states = updater.states_per_param or 0
+        if not states:
+            return None
+        return self.slice_shape[:-1] + (self.width * states,)
+
+    def run_on_servers(self, agent):
+        updater = UPDATERS[self.name]()
+        state_shape = self.get_state_shape(updater)
+        x = SparseTensor()
+        x.name = str(self)
+        x.data_type = self.data_type
+        x.slice_data_shape = self.slice_shape
+        x.slice_state_shape = state_shape or ()
+        x.updater = updater
+        x.partition_count = agent.server_count
+        x.gradient_aggregation = 'none'
+        x.agent = agent._cxx_agent
+        wait(lambda done, failed: x.init(done, failed))
+        wait(lambda done, failed: x.push(self.keys, self.data, done, failed, True))
+        for indices, grad in self.rounds:
+            keys = self.keys[indices.astype(numpy.int64)]
+            wait(lambda done, failed: x.push(keys, grad, done, failed, False))
+        data = wait(lambda done, failed: x.pull(self.keys, done, failed, True, False))
+        data = numpy.ascontiguousarray(data).view(self.data.dtype).reshape(self.data.shape).copy()
+        wait(lambda done, failed: x.dispose(done, failed))
+        return data
+
+    def run_in_python(self):
+        updater = UPDATERS[self.name]()
+        state_shape = self.get_state_shape(updater)
+        state = None
+        if state_shape is not None:
+            state_dtype = numpy.float64 if self.data_type == 'float64' else numpy.float32
+            state = numpy.zeros((TABLE_ROWS,) + state_shape, dtype=state_dtype)
+        is_half = self.data_type in ('float16', 'bfloat16')
+        data = self.data.copy()
+        for indices, grad in self.rounds:
+            param = widen(data, self.data_type)
+            keys = self.keys[indices.astype(numpy.int64)]
+            updater(str(self), param, widen(grad, self.data_type), state, indices, keys)
+            if is_half:
+                data = to_storage(torch.from_numpy(param), self.data_type)
+        return data
+
+def make_cases():
+    cases = []
+    for name in UPDATERS:
+        for data_type in DATA_TYPES:
+            for width in WIDTHS:
+                for slice_rows in SLICE_ROWS:
+                    cases.append(Case(name, data_type, width, slice_rows))
+    return cases
+
+class NativeUpdaterTest(unittest.TestCase):
+    def test_equivalence(self):
+        cases = make_cases()
+        def body(agent):
+            return [case.run_on_servers(agent) for case in cases]
+        results = run_local_job(body, server_count=SERVER_COUNT)
+        for case, data in zip(cases, results):
+            with self.subTest(case=str(case)):
+                self.assertTrue(same_bits(data, case.run_in_python()))
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,88 @@
+#
+# Copyright 2021 Mobvista
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+
+# Check that servers splitting large sparse pushes across helper threads
+# give the same result as applying them serially, also when the keys of a
+# push repeat.
+#
+# Run with ``python -m unittest discover python/tests``; it needs the
+# ``_mindalpha`` extension to be built.
+
+import unittest
+import numpy
+from mindalpha._mindalpha import SparseTensor
+from mindalpha.updater import SGDTensorUpdater
+from local_job import run_local_job
+from local_job import wait
+
+WIDTH = 8
+KEY_COUNT = 5000
+PUSH_ROWS = 40000
+
+def make_push(seed):
+    # More rows than a parallel chunk, so the push is large enough to be
+    # split, with every key repeated several times.
+    rng = numpy.random.default_rng(seed)
+    keys = rng.integers(1, KEY_COUNT + 1, PUSH_ROWS).astype(numpy.uint64)
+    rows = rng.standard_normal((PUSH_ROWS, WIDTH)).astype(numpy.float32)
+    return keys, rows
+
+def push_and_pull(parallel_thread_count, is_value):
+    keys, rows = make_push(1)
+    pull_keys = numpy.arange(1, KEY_COUNT + 1, dtype=numpy.uint64)
+    def body(agent):
+        x = SparseTensor()
+        x.name = 'sparse_push_duplicates'
+        x.data_type = 'float32'
+        x.slice_data_shape = WIDTH,
+        x.slice_state_shape = ()
+        x.updater = SGDTensorUpdater(0.1)
+        x.partition_count = agent.server_count
+        x.gradient_aggregation = 'none'
+        x.agent = agent._cxx_agent
+        wait(lambda done, failed: x.init(done, failed))
+        for _ in range(3):
+            wait(lambda done, failed: x.push(keys, rows, done, failed, is_value))
+        data = wait(lambda done, failed: x.pull(pull_keys, done, failed, True, False))
+        data = data.reshape(KEY_COUNT, WIDTH).copy()
+        wait(lambda done, failed: x.dispose(done, failed))
+        return data
+    return run_local_job(body, server_parallel_thread_count=parallel_thread_count)
+
+def same_bits(x, y):
+    return x.shape == y.shape and numpy.array_equal(x.view(numpy.uint8), y.view(numpy.uint8))
+
+class SparsePushTest(unittest.TestCase):
+    def test_duplicate_values(self):
+        # The last row of a key wins, as when the rows are written in order.
+        keys, rows = make_push(1)
+        unique_keys, reversed_index = numpy.unique(keys[::-1], return_index=True)
+        expected = numpy.zeros((KEY_COUNT, WIDTH), dtype=numpy.float32)
+        expected[unique_keys.astype(numpy.int64) - 1] = rows[PUSH_ROWS - 1 - reversed_index]
+        serial = push_and_pull(0, True)
+        parallel = push_and_pull(4, True)
+        self.assertTrue(same_bits(serial, expected))
+        self.assertTrue(same_bits(parallel, serial))
+
+    def test_duplicate_gradients(self):
+        # Every row of a key is applied, in request order.
+        serial = push_and_pull(0, False)
+        parallel = push_and_pull(4, False)
+        self.assertTrue(same_bits(parallel, serial))
+
+if __name__ == '__main__':
+    unittest.main()
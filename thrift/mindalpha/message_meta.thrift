@@ -67,6 +67,24 @@ enum TDataType
     UInt64 = 7;
     Float32 = 8;
     Float64 = 9;
+    Float16 = 10;
+    BFloat16 = 11;
+}
+
+enum TDataRequestCommand
+{
+    Null = -1;
+    DensePush = 0;
+    DensePull = 1;
+    SparsePush = 2;
+    SparsePull = 3;
+}
+
+struct TDataRequest
+{
+    1: required TDataRequestCommand command;
+    2: required i32 tensorId;
+    3: required i32 flags;
 }
 
 struct TMessageMeta
@@ -79,4 +97,5 @@ struct TMessageMeta
     6: required string body;
     7: required list<TDataType> sliceDataTypes;
     8: required TNodeControl control;
+    9: required TDataRequest dataRequest;
 }